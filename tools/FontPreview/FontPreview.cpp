@@ -0,0 +1,162 @@
+/*
+ * FontPreview - draws text with the GUI's glyph cache into a grey scale
+ * PGM image, to check how a skin font looks without an Xbox.
+ *
+ *   FontPreview [-bold] [-italic] [-right] [-center] [-width <pixels> [-truncate|-wrap]]
+ *               <font file> <size> <text> <output file>
+ *
+ * The text is laid out exactly as the GUI does it, "\n" starts a new line.
+ * Statistics of the glyph and layout caches are printed afterwards.
+ */
+
+#include "TextLayoutCache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#define PREVIEW_PAGE_SIZE 512
+
+static void Usage()
+{
+	printf("Usage: FontPreview [-bold] [-italic] [-right] [-center] [-width <pixels> [-truncate|-wrap]]\n");
+	printf("                   <font file> <size> <text> <output file>\n");
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned int dwStyle = GLYPH_STYLE_NORMAL;
+	int iAlign = GLYPH_ALIGN_LEFT;
+	int iOverflow = GLYPH_OVERFLOW_NONE;
+	float fMaxWidth = 0.0f;
+	std::vector<std::string> args;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-bold") == 0)
+			dwStyle |= GLYPH_STYLE_BOLD;
+		else if (strcmp(argv[i], "-italic") == 0)
+			dwStyle |= GLYPH_STYLE_ITALIC;
+		else if (strcmp(argv[i], "-right") == 0)
+			iAlign = GLYPH_ALIGN_RIGHT;
+		else if (strcmp(argv[i], "-center") == 0)
+			iAlign = GLYPH_ALIGN_CENTER;
+		else if (strcmp(argv[i], "-truncate") == 0)
+			iOverflow = GLYPH_OVERFLOW_TRUNCATE;
+		else if (strcmp(argv[i], "-wrap") == 0)
+			iOverflow = GLYPH_OVERFLOW_WRAP;
+		else if (strcmp(argv[i], "-width") == 0 && i + 1 < argc)
+			fMaxWidth = (float)atof(argv[++i]);
+		else
+			args.push_back(argv[i]);
+	}
+
+	if (args.size() != 4)
+	{
+		Usage();
+		return 1;
+	}
+
+	float fSize = (float)atof(args[1].c_str());
+	if (fSize <= 0)
+	{
+		Usage();
+		return 1;
+	}
+
+	// Byte per character like the GUI's labels, with \n as a line break
+	std::wstring strText;
+	for (size_t i = 0; i < args[2].size(); i++)
+	{
+		if (args[2][i] == '\\' && i + 1 < args[2].size() && args[2][i + 1] == 'n')
+		{
+			strText += L'\n';
+			i++;
+		}
+		else
+			strText += (wchar_t)(unsigned char)args[2][i];
+	}
+
+	CGlyphCache cache(PREVIEW_PAGE_SIZE, PREVIEW_PAGE_SIZE);
+	int iFace = cache.LoadFace(args[0]);
+	if (iFace < 0)
+	{
+		fprintf(stderr, "Unable to load %s\n", args[0].c_str());
+		return 1;
+	}
+
+	// Twice, the second time comes through the ref as it does for an unchanged label
+	CTextLayoutCache layouts(cache);
+	CTextLayoutCache::Ref ref;
+	const TextLayout* pLayout = NULL;
+	for (int iPass = 0; iPass < 2; iPass++)
+	{
+		pLayout = layouts.Get(ref);
+		if (!pLayout)
+			pLayout = layouts.Get(iFace, fSize, dwStyle, iAlign, fMaxWidth, iOverflow, strText, &ref);
+		if (!pLayout)
+		{
+			fprintf(stderr, "The text needs more glyphs than fit in the glyph page\n");
+			return 1;
+		}
+	}
+
+	int iMargin = (int)fSize;
+	int iImageWidth = (int)pLayout->fWidth + 2 * iMargin;
+	int iImageHeight = (int)pLayout->fHeight + 2 * iMargin;
+	std::vector<unsigned char> image(iImageWidth * iImageHeight, 0);
+
+	int iOriginX = iMargin;
+	if (iAlign == GLYPH_ALIGN_RIGHT)
+		iOriginX += (int)pLayout->fWidth;
+	else if (iAlign == GLYPH_ALIGN_CENTER)
+		iOriginX += (int)(pLayout->fWidth / 2);
+
+	for (size_t q = 0; q < pLayout->quads.size(); q++)
+	{
+		const GlyphQuad& quad = pLayout->quads[q];
+		int iSourceX = (int)(quad.u1 * cache.GetWidth() + 0.5f);
+		int iSourceY = (int)(quad.v1 * cache.GetHeight() + 0.5f);
+
+		for (int y = 0; y < (int)quad.fHeight; y++)
+		{
+			for (int x = 0; x < (int)quad.fWidth; x++)
+			{
+				int iDestX = iOriginX + (int)quad.fPosX + x;
+				int iDestY = iMargin + (int)quad.fPosY + y;
+				if (iDestX < 0 || iDestY < 0 || iDestX >= iImageWidth || iDestY >= iImageHeight)
+					continue;
+
+				// Blended like the GUI draws white text
+				unsigned char& dest = image[iDestY * iImageWidth + iDestX];
+				int iCoverage = cache.GetPixels()[(iSourceY + y) * cache.GetWidth() + iSourceX + x];
+				dest = (unsigned char)(dest + (255 - dest) * iCoverage / 255);
+			}
+		}
+	}
+
+	FILE* fd = fopen(args[3].c_str(), "wb");
+	if (!fd)
+	{
+		fprintf(stderr, "Unable to create %s\n", args[3].c_str());
+		return 1;
+	}
+
+	fprintf(fd, "P5\n%d %d\n255\n", iImageWidth, iImageHeight);
+	fwrite(&image[0], image.size(), 1, fd);
+	fclose(fd);
+
+	GlyphCacheStats stats;
+	cache.GetStats(stats);
+	TextLayoutStats layoutStats;
+	layouts.GetStats(layoutStats);
+	printf("%ux%u image, %.0fx%.0f text in %u line(s)%s\n", iImageWidth, iImageHeight, pLayout->fWidth, pLayout->fHeight,
+		(unsigned int)pLayout->lineWidths.size(), pLayout->bTruncated ? ", truncated" : "");
+	printf("glyphs: %u in the page, %u hit(s), %u rendered; layouts: %u hit(s), %u miss(es)\n",
+		stats.iGlyphs, stats.iHits, stats.iMisses, layoutStats.iHits, layoutStats.iMisses);
+
+	return 0;
+}
@@ -0,0 +1,660 @@
+/*
+ * HttpStreamTest - runs the http stream of DVDPlayer against a server on
+ * the loopback interface.
+ *
+ *   HttpStreamTest [-v] [-bench [-size <MB>] [-seeks <n>] [-rate <KB/s>] [-delay <ms>]]
+ *
+ * The server makes up a file where every byte depends on its offset and
+ * answers range requests the way the test asks it to: keeping the
+ * connection, closing it after every response, closing it without saying
+ * so, dropping it in the middle of a body, or ignoring ranges. Every test
+ * checks the bytes it reads and the connections, requests and kinds of
+ * seek the stream counted. -v prints what the stream logs. The exit code
+ * is 1 when a test fails.
+ *
+ * -bench reads a file through once from start to end and once with random
+ * seeks instead, from a server that sends at most -rate KB/s and waits
+ * -delay ms before every response, like a NAS or a remote server. It prints
+ * the throughput, the stalls and the read-ahead the stream ended up with.
+ */
+
+#include "HttpRangeStream.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <string>
+
+enum ServerMode
+{
+	SERVE_KEEPALIVE,    // HTTP/1.1, ranges, the connection stays open
+	SERVE_CLOSE,        // Connection: close after every response
+	SERVE_IDLE_CLOSE,   // promises keep-alive, closes after every response anyway
+	SERVE_DROP_ONCE,    // drops the first connection in the middle of the body
+	SERVE_NO_RANGES     // 200 and the whole file for every request
+};
+
+#define DROP_AFTER (1024 * 1024)
+
+static bool g_bVerbose = false;
+
+static unsigned char ByteAt(int64_t iPos)
+{
+	return (unsigned char)(((uint64_t)iPos * 2654435761u) >> 24);
+}
+
+static int64_t GetTimeUs()
+{
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+class CTestServer
+{
+public:
+	CTestServer(ServerMode mode, int64_t iLength)
+	{
+		m_mode = mode;
+		m_iLength = iLength;
+		m_iPort = 0;
+		m_listen = -1;
+		m_iConnections = 0;
+		m_iRequests = 0;
+		m_bDropped = false;
+		m_iDelay = 0;
+		m_iRate = 0;
+		pthread_mutex_init(&m_lock, NULL);
+	}
+
+	~CTestServer()
+	{
+		Stop();
+		pthread_mutex_destroy(&m_lock);
+	}
+
+	// Both are set before Start(), 0 turns them off
+	void SetDelay(int iDelay) { m_iDelay = iDelay; }   // ms before every response
+	void SetRate(int iRate) { m_iRate = iRate; }       // bytes per second of each connection
+
+	bool Start()
+	{
+		m_listen = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+		if (m_listen < 0)
+			return false;
+
+		sockaddr_in sa;
+		memset(&sa, 0, sizeof(sa));
+		sa.sin_family = AF_INET;
+		sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		sa.sin_port = 0;
+
+		socklen_t iSize = sizeof(sa);
+		if (bind(m_listen, (sockaddr*)&sa, sizeof(sa)) != 0 || listen(m_listen, 8) != 0 ||
+		    getsockname(m_listen, (sockaddr*)&sa, &iSize) != 0)
+		{
+			close(m_listen);
+			m_listen = -1;
+			return false;
+		}
+		m_iPort = ntohs(sa.sin_port);
+
+		return pthread_create(&m_thread, NULL, AcceptThread, this) == 0;
+	}
+
+	void Stop()
+	{
+		if (m_listen < 0)
+			return;
+
+		shutdown(m_listen, SHUT_RDWR);
+		pthread_join(m_thread, NULL);
+		close(m_listen);
+		m_listen = -1;
+	}
+
+	std::string GetUrl() const
+	{
+		char strUrl[64];
+		snprintf(strUrl, sizeof(strUrl), "http://127.0.0.1:%i/test.bin", m_iPort);
+		return strUrl;
+	}
+
+	unsigned int GetConnections() { return Get(m_iConnections); }
+	unsigned int GetRequests() { return Get(m_iRequests); }
+
+private:
+	struct Connection
+	{
+		CTestServer* pServer;
+		int s;
+	};
+
+	static void* AcceptThread(void* pParam)
+	{
+		CTestServer* pServer = (CTestServer*)pParam;
+		for (;;)
+		{
+			int s = accept(pServer->m_listen, NULL, NULL);
+			if (s < 0)
+				break;
+
+			pServer->Add(pServer->m_iConnections);
+
+			// Each connection gets its own thread, the client may open the next before we notice the last closed
+			Connection* pConnection = new Connection;
+			pConnection->pServer = pServer;
+			pConnection->s = s;
+
+			pthread_t thread;
+			if (pthread_create(&thread, NULL, ConnectionThread, pConnection) == 0)
+				pthread_detach(thread);
+			else
+			{
+				close(s);
+				delete pConnection;
+			}
+		}
+		return NULL;
+	}
+
+	static void* ConnectionThread(void* pParam)
+	{
+		Connection* pConnection = (Connection*)pParam;
+		while (pConnection->pServer->Serve(pConnection->s))
+			;
+		close(pConnection->s);
+		delete pConnection;
+		return NULL;
+	}
+
+	// One request, false when the connection is done
+	bool Serve(int s)
+	{
+		std::string strRequest;
+		char c;
+		while (strRequest.size() < 8192)
+		{
+			if (recv(s, &c, 1, 0) != 1)
+				return false;
+			strRequest += c;
+			if (strRequest.size() >= 4 && strRequest.compare(strRequest.size() - 4, 4, "\r\n\r\n") == 0)
+				break;
+		}
+		Add(m_iRequests);
+
+		if (m_iDelay > 0)
+			usleep(m_iDelay * 1000);
+
+		long long iStart = 0, iEnd = m_iLength - 1;
+		bool bRange = false;
+		size_t iRange = strRequest.find("Range: bytes=");
+		if (iRange != std::string::npos && m_mode != SERVE_NO_RANGES)
+		{
+			bRange = true;
+			sscanf(strRequest.c_str() + iRange, "Range: bytes=%lld-%lld", &iStart, &iEnd);
+			if (iEnd >= m_iLength)
+				iEnd = m_iLength - 1;
+		}
+
+		char strHeader[512];
+		if (bRange && iStart >= m_iLength)
+		{
+			snprintf(strHeader, sizeof(strHeader), "HTTP/1.1 416 Requested Range Not Satisfiable\r\nContent-Length: 0\r\n\r\n");
+			return SendAll(s, strHeader, strlen(strHeader));
+		}
+
+		if (bRange)
+		{
+			snprintf(strHeader, sizeof(strHeader),
+			         "HTTP/1.1 206 Partial Content\r\n"
+			         "Content-Range: bytes %lld-%lld/%lld\r\n"
+			         "Content-Length: %lld\r\n"
+			         "%s"
+			         "\r\n", iStart, iEnd, (long long)m_iLength, iEnd - iStart + 1,
+			         m_mode == SERVE_CLOSE ? "Connection: close\r\n" : "");
+		}
+		else
+		{
+			snprintf(strHeader, sizeof(strHeader),
+			         "HTTP/1.1 200 OK\r\n"
+			         "Content-Length: %lld\r\n"
+			         "\r\n", (long long)m_iLength);
+		}
+
+		if (!SendAll(s, strHeader, strlen(strHeader)))
+			return false;
+
+		long long iBodyEnd = iEnd + 1;
+		if (m_mode == SERVE_DROP_ONCE && TakeDrop())
+			iBodyEnd = iStart + DROP_AFTER < iBodyEnd ? iStart + DROP_AFTER : iBodyEnd;
+
+		// Throttled bodies go out in pieces of 1/20 s, so the rate holds over short reads too
+		unsigned char buffer[16384];
+		int iChunk = sizeof(buffer);
+		if (m_iRate > 0 && m_iRate / 20 < iChunk)
+			iChunk = m_iRate / 20 > 1024 ? m_iRate / 20 : 1024;
+
+		int64_t iBodyStart = GetTimeUs();
+		for (long long iPos = iStart; iPos < iBodyEnd; )
+		{
+			int iSize = iBodyEnd - iPos < (long long)iChunk ? (int)(iBodyEnd - iPos) : iChunk;
+			for (int i = 0; i < iSize; i++)
+				buffer[i] = ByteAt(iPos + i);
+			if (!SendAll(s, buffer, iSize))
+				return false;
+			iPos += iSize;
+
+			if (m_iRate > 0)
+			{
+				int64_t iDue = iBodyStart + (iPos - iStart) * 1000000 / m_iRate;
+				int64_t iNow = GetTimeUs();
+				if (iDue > iNow)
+					usleep((useconds_t)(iDue - iNow));
+			}
+		}
+
+		if (iBodyEnd <= iEnd)
+			return false;
+
+		return m_mode == SERVE_KEEPALIVE || m_mode == SERVE_DROP_ONCE || m_mode == SERVE_NO_RANGES;
+	}
+
+	static bool SendAll(int s, const void* pData, size_t iSize)
+	{
+		const char* p = (const char*)pData;
+		while (iSize > 0)
+		{
+			ssize_t iSent = send(s, p, iSize, MSG_NOSIGNAL);
+			if (iSent <= 0)
+				return false;
+			p += iSent;
+			iSize -= iSent;
+		}
+		return true;
+	}
+
+	bool TakeDrop()
+	{
+		pthread_mutex_lock(&m_lock);
+		bool bDrop = !m_bDropped;
+		m_bDropped = true;
+		pthread_mutex_unlock(&m_lock);
+		return bDrop;
+	}
+
+	void Add(unsigned int& iCounter)
+	{
+		pthread_mutex_lock(&m_lock);
+		iCounter++;
+		pthread_mutex_unlock(&m_lock);
+	}
+
+	unsigned int Get(unsigned int& iCounter)
+	{
+		pthread_mutex_lock(&m_lock);
+		unsigned int iValue = iCounter;
+		pthread_mutex_unlock(&m_lock);
+		return iValue;
+	}
+
+	ServerMode m_mode;
+	int64_t m_iLength;
+	int m_iPort;
+	int m_listen;
+	pthread_t m_thread;
+	pthread_mutex_t m_lock;
+	unsigned int m_iConnections;
+	unsigned int m_iRequests;
+	bool m_bDropped;
+	int m_iDelay;
+	int m_iRate;
+};
+
+class CTestStream : public CHttpRangeStream
+{
+protected:
+	virtual void OnLog(HttpLogLevel, const char* strMessage)
+	{
+		if (g_bVerbose)
+			printf("    stream: %s\n", strMessage);
+	}
+};
+
+static int g_iFailed = 0;
+
+static bool Check(bool bCondition, const char* strTest, const char* strWhat)
+{
+	if (!bCondition)
+	{
+		printf("  FAILED: %s: %s\n", strTest, strWhat);
+		g_iFailed++;
+	}
+	return bCondition;
+}
+
+// Reads iSize bytes from iPos on, or up to the end when iSize < 0, and checks every one
+static bool ReadAndCheck(CHttpRangeStream& stream, int64_t iPos, int64_t iSize, const char* strTest)
+{
+	unsigned char buffer[32768];
+	int64_t iRead = 0;
+
+	while (iSize < 0 || iRead < iSize)
+	{
+		int iWanted = sizeof(buffer);
+		if (iSize >= 0 && iSize - iRead < iWanted)
+			iWanted = (int)(iSize - iRead);
+
+		int iRet = stream.Read(buffer, iWanted);
+		if (iRet == 0)
+			break;
+		if (!Check(iRet > 0, strTest, "read failed"))
+			return false;
+
+		for (int i = 0; i < iRet; i++)
+		{
+			if (buffer[i] != ByteAt(iPos + iRead + i))
+			{
+				char strWhat[128];
+				snprintf(strWhat, sizeof(strWhat), "wrong byte at %lld", (long long)(iPos + iRead + i));
+				return Check(false, strTest, strWhat);
+			}
+		}
+		iRead += iRet;
+	}
+
+	if (iSize >= 0)
+		return Check(iRead == iSize, strTest, "stream ended early");
+	return Check(stream.IsEOF() && iPos + iRead == stream.GetLength(), strTest, "didn't read to the end");
+}
+
+static void PrintStats(const char* strTest, CHttpRangeStream& stream, CTestServer& server)
+{
+	const HttpStreamStats& stats = stream.GetStats();
+	printf("  %-20s %u connect(s), %u request(s), seeks %u buffered / %u skipped / %u requested, server saw %u connection(s)\n",
+		strTest, stats.iConnects, stats.iRequests, stats.iBufferedSeeks, stats.iSkipSeeks, stats.iRequestSeeks, server.GetConnections());
+}
+
+// The file is fetched in HTTP_RANGE_CHUNK ranges, each one continuing where the last ended
+static void TestRangeResume()
+{
+	const char* strTest = "range resume";
+	int64_t iLength = 2 * HTTP_RANGE_CHUNK + 12345;
+	CTestServer server(SERVE_KEEPALIVE, iLength);
+	if (!Check(server.Start(), strTest, "server didn't start"))
+		return;
+
+	CTestStream stream;
+	if (!Check(stream.Open(server.GetUrl().c_str()), strTest, "open failed"))
+		return;
+
+	Check(stream.GetLength() == iLength && stream.CanSeek(), strTest, "wrong length or not seekable");
+	ReadAndCheck(stream, 0, -1, strTest);
+
+	const HttpStreamStats& stats = stream.GetStats();
+	Check(stats.iRequests == 3, strTest, "expected a request per range");
+	Check(stats.iConnects == 1, strTest, "keep-alive connection wasn't reused");
+	PrintStats(strTest, stream, server);
+}
+
+// A body cut off in the middle continues with a range from where it broke
+static void TestResumeAfterDrop()
+{
+	const char* strTest = "resume after drop";
+	int64_t iLength = 3 * 1024 * 1024;
+	CTestServer server(SERVE_DROP_ONCE, iLength);
+	if (!Check(server.Start(), strTest, "server didn't start"))
+		return;
+
+	CTestStream stream;
+	if (!Check(stream.Open(server.GetUrl().c_str()), strTest, "open failed"))
+		return;
+
+	ReadAndCheck(stream, 0, -1, strTest);
+
+	const HttpStreamStats& stats = stream.GetStats();
+	Check(stats.iConnects == 2, strTest, "expected one reconnect");
+	PrintStats(strTest, stream, server);
+}
+
+// Servers that close after every response, saying so or not
+static void TestReconnect(ServerMode mode, const char* strTest)
+{
+	int64_t iLength = 2 * HTTP_RANGE_CHUNK + 12345;
+	CTestServer server(mode, iLength);
+	if (!Check(server.Start(), strTest, "server didn't start"))
+		return;
+
+	CTestStream stream;
+	if (!Check(stream.Open(server.GetUrl().c_str()), strTest, "open failed"))
+		return;
+
+	ReadAndCheck(stream, 0, -1, strTest);
+
+	const HttpStreamStats& stats = stream.GetStats();
+	Check(stats.iConnects == 3, strTest, "expected a connection per range");
+	PrintStats(strTest, stream, server);
+}
+
+static void TestSeeks()
+{
+	const char* strTest = "seeks";
+	int64_t iLength = 2 * HTTP_RANGE_CHUNK;
+	CTestServer server(SERVE_KEEPALIVE, iLength);
+	if (!Check(server.Start(), strTest, "server didn't start"))
+		return;
+
+	CTestStream stream;
+	if (!Check(stream.Open(server.GetUrl().c_str()), strTest, "open failed"))
+		return;
+
+	const HttpStreamStats& stats = stream.GetStats();
+	ReadAndCheck(stream, 0, 200 * 1024, strTest);
+
+	// Back into what was read, served from the buffer
+	unsigned int iRequests = stats.iRequests;
+	Check(stream.Seek(-16 * 1024, SEEK_CUR) == 184 * 1024, strTest, "backward seek failed");
+	Check(stats.iBufferedSeeks == 1 && stats.iRequests == iRequests, strTest, "backward seek wasn't served from the buffer");
+	ReadAndCheck(stream, 184 * 1024, 64 * 1024, strTest);
+
+	// Far ahead, a new range request
+	int64_t iTarget = HTTP_RANGE_CHUNK + 4321;
+	Check(stream.Seek(iTarget, SEEK_SET) == iTarget, strTest, "far seek failed");
+	Check(stats.iRequestSeeks == 1 && stats.iRequests == iRequests + 1, strTest, "far seek didn't send one request");
+
+	// Nothing is buffered yet, a short seek ahead reads through the same response
+	iTarget += HTTP_SKIP_FORWARD / 2;
+	Check(stream.Seek(iTarget, SEEK_SET) == iTarget, strTest, "short forward seek failed");
+	Check(stats.iSkipSeeks == 1 && stats.iRequests == iRequests + 1, strTest, "short forward seek sent a request");
+	ReadAndCheck(stream, iTarget, 256 * 1024, strTest);
+
+	// And back to the start
+	Check(stream.Seek(0, SEEK_SET) == 0, strTest, "seek to start failed");
+	Check(stats.iRequestSeeks == 2 && stats.iRequests == iRequests + 2, strTest, "seek to start didn't send one request");
+	ReadAndCheck(stream, 0, 64 * 1024, strTest);
+
+	// The end reads nothing and needs no request, past it fails
+	Check(stream.Seek(0, SEEK_END) == iLength && stats.iRequests == iRequests + 2, strTest, "seek to end failed");
+	unsigned char c;
+	Check(stream.Read(&c, 1) == 0 && stream.IsEOF(), strTest, "read at the end didn't report the end");
+	Check(stream.Seek(iLength + 1, SEEK_SET) == -1, strTest, "seek past the end succeeded");
+
+	// Still reads after coming back from the end
+	Check(stream.Seek(iLength - 1000, SEEK_SET) == iLength - 1000, strTest, "seek back from the end failed");
+	ReadAndCheck(stream, iLength - 1000, -1, strTest);
+
+	PrintStats(strTest, stream, server);
+}
+
+static void TestNoRanges()
+{
+	const char* strTest = "no ranges";
+	int64_t iLength = 3 * 1024 * 1024;
+	CTestServer server(SERVE_NO_RANGES, iLength);
+	if (!Check(server.Start(), strTest, "server didn't start"))
+		return;
+
+	CTestStream stream;
+	if (!Check(stream.Open(server.GetUrl().c_str()), strTest, "open failed"))
+		return;
+
+	Check(!stream.CanSeek() && stream.GetLength() == iLength, strTest, "server without ranges taken as seekable");
+	ReadAndCheck(stream, 0, 128 * 1024, strTest);
+	Check(stream.Seek(-4096, SEEK_CUR) == 124 * 1024, strTest, "seek back in the buffer failed");
+	Check(stream.Seek(2 * 1024 * 1024, SEEK_SET) == -1, strTest, "seek outside the buffer succeeded");
+	ReadAndCheck(stream, 124 * 1024, -1, strTest);
+
+	PrintStats(strTest, stream, server);
+}
+
+struct BenchOptions
+{
+	int64_t iLength;
+	int iSeeks;
+	int iRate;     // bytes per second, 0 for as fast as the loopback goes
+	int iDelay;    // ms
+};
+
+static void PrintBench(const char* strWorkload, CHttpRangeStream& stream, int64_t iBytes, int64_t iTime)
+{
+	const HttpStreamStats& stats = stream.GetStats();
+	if (iTime < 1)
+		iTime = 1;
+
+	printf("  %-12s %8lld KB in %6lld ms, %7lld KB/s, %u stall(s) for %u ms, read-ahead %i KB, %u request(s)\n",
+		strWorkload, (long long)(iBytes / 1024), (long long)(iTime / 1000), (long long)(iBytes * 1000000 / 1024 / iTime),
+		stats.iStalls, stats.dwStallTime, stream.GetReadAhead() / 1024, stats.iRequests);
+}
+
+// Start to end, like playing a file
+static void BenchSequential(const BenchOptions& options)
+{
+	const char* strTest = "sequential";
+	CTestServer server(SERVE_KEEPALIVE, options.iLength);
+	server.SetRate(options.iRate);
+	server.SetDelay(options.iDelay);
+	if (!Check(server.Start(), strTest, "server didn't start"))
+		return;
+
+	CTestStream stream;
+	int64_t iStart = GetTimeUs();
+	if (!Check(stream.Open(server.GetUrl().c_str()), strTest, "open failed"))
+		return;
+
+	ReadAndCheck(stream, 0, -1, strTest);
+	PrintBench(strTest, stream, options.iLength, GetTimeUs() - iStart);
+}
+
+// Random positions with a short read at each, like a demuxer probing or the user skipping
+static void BenchSeeks(const BenchOptions& options)
+{
+	const char* strTest = "seeks";
+	const int64_t iReadSize = 64 * 1024;
+	CTestServer server(SERVE_KEEPALIVE, options.iLength);
+	server.SetRate(options.iRate);
+	server.SetDelay(options.iDelay);
+	if (!Check(server.Start(), strTest, "server didn't start"))
+		return;
+
+	CTestStream stream;
+	int64_t iStart = GetTimeUs();
+	if (!Check(stream.Open(server.GetUrl().c_str()), strTest, "open failed"))
+		return;
+
+	srand(1);
+	int64_t iBytes = 0;
+	for (int i = 0; i < options.iSeeks; i++)
+	{
+		int64_t iTarget = (int64_t)((double)rand() / RAND_MAX * (options.iLength - iReadSize));
+		if (!Check(stream.Seek(iTarget, SEEK_SET) == iTarget, strTest, "seek failed"))
+			return;
+		if (!ReadAndCheck(stream, iTarget, iReadSize, strTest))
+			return;
+		iBytes += iReadSize;
+	}
+
+	int64_t iTime = GetTimeUs() - iStart;
+	PrintBench(strTest, stream, iBytes, iTime);
+
+	const HttpStreamStats& stats = stream.GetStats();
+	printf("  %-12s %i seek(s), %.1f ms each, %u buffered / %u skipped / %u requested\n",
+		"", options.iSeeks, options.iSeeks ? iTime / 1000.0 / options.iSeeks : 0.0,
+		stats.iBufferedSeeks, stats.iSkipSeeks, stats.iRequestSeeks);
+}
+
+static void Usage()
+{
+	printf("Usage: HttpStreamTest [-v] [-bench [-size <MB>] [-seeks <n>] [-rate <KB/s>] [-delay <ms>]]\n");
+}
+
+int main(int argc, char* argv[])
+{
+	bool bBench = false;
+	BenchOptions options;
+	options.iLength = 64 * 1024 * 1024;
+	options.iSeeks = 200;
+	options.iRate = 0;
+	options.iDelay = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-v") == 0)
+			g_bVerbose = true;
+		else if (strcmp(argv[i], "-bench") == 0)
+			bBench = true;
+		else if (strcmp(argv[i], "-size") == 0 && i + 1 < argc)
+			options.iLength = (int64_t)atoi(argv[++i]) * 1024 * 1024;
+		else if (strcmp(argv[i], "-seeks") == 0 && i + 1 < argc)
+			options.iSeeks = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-rate") == 0 && i + 1 < argc)
+			options.iRate = atoi(argv[++i]) * 1024;
+		else if (strcmp(argv[i], "-delay") == 0 && i + 1 < argc)
+			options.iDelay = atoi(argv[++i]);
+		else
+		{
+			Usage();
+			return 1;
+		}
+	}
+
+	if (options.iLength < 1024 * 1024 || options.iSeeks < 0 || options.iRate < 0 || options.iDelay < 0)
+	{
+		Usage();
+		return 1;
+	}
+
+	if (bBench)
+	{
+		char strRate[32] = "no rate limit";
+		if (options.iRate)
+			snprintf(strRate, sizeof(strRate), "%i KB/s", options.iRate / 1024);
+		printf("%lld MB, %s, %i ms before every response\n", (long long)(options.iLength / (1024 * 1024)), strRate, options.iDelay);
+
+		BenchSequential(options);
+		BenchSeeks(options);
+		return g_iFailed ? 1 : 0;
+	}
+
+	TestRangeResume();
+	TestResumeAfterDrop();
+	TestReconnect(SERVE_CLOSE, "connection: close");
+	TestReconnect(SERVE_IDLE_CLOSE, "silent close");
+	TestSeeks();
+	TestNoRanges();
+
+	if (g_iFailed)
+	{
+		printf("%i check(s) failed\n", g_iFailed);
+		return 1;
+	}
+
+	printf("all tests passed\n");
+	return 0;
+}
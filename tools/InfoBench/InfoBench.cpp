@@ -0,0 +1,244 @@
+/*
+ * InfoBench - translates the info strings of a synthetic skin the way the
+ * GUI does when it loads one, to measure the interned lookup against a scan
+ * of every string translated before.
+ *
+ *   InfoBench [-windows <n>] [-controls <n>] [-distinct <n>] [-seed <n>]
+ *
+ * Every control gets a visibility condition and a Control.HasFocus() multi
+ * info. Conditions are drawn from a pool of distinct ones, a few of them
+ * much more often than the rest, in random case as skins write them.
+ * Both lookups have to give the same ids, the exit code is 1 otherwise.
+ */
+
+#include "InfoStringTable.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <string>
+#include <vector>
+
+#define MULTI_INFO_START  40000
+#define CONTROL_HAS_FOCUS 30000
+
+static const char* s_conditions[] =
+{
+	"Player.HasVideo", "Player.HasAudio", "Player.Paused", "Player.Playing", "Player.Caching",
+	"VideoPlayer.IsFullscreen", "System.HasNetwork", "Window.IsActive(%i)", "Control.IsVisible(%i)",
+	"Skin.HasSetting(option%i)", "Container.HasFiles", "ListItem.IsFolder"
+};
+
+// Old behaviour, every string translated so far compared without case
+class CLinearTable
+{
+public:
+	bool Find(const std::string& strInfo, int& id) const
+	{
+		for (unsigned int i = 0; i < m_entries.size(); i++)
+		{
+			if (strcasecmp(m_entries[i].first.c_str(), strInfo.c_str()) == 0)
+			{
+				id = m_entries[i].second;
+				return true;
+			}
+		}
+		return false;
+	}
+	void Add(const std::string& strInfo, int id) { m_entries.push_back(std::make_pair(strInfo, id)); }
+
+private:
+	std::vector<std::pair<std::string, int> > m_entries;
+};
+
+struct MultiInfo
+{
+	int info;
+	unsigned int data1;
+	int data2;
+};
+
+static std::string RandomCase(const std::string& str)
+{
+	std::string strResult(str);
+	for (unsigned int i = 0; i < strResult.size(); i++)
+	{
+		if (rand() % 4 == 0)
+			strResult[i] = (char)(isupper((unsigned char)strResult[i]) ? tolower((unsigned char)strResult[i]) : toupper((unsigned char)strResult[i]));
+	}
+	return strResult;
+}
+
+static std::string MakeCondition(int iIndex)
+{
+	int iTerms = 1 + iIndex % 3;
+	std::string strCondition;
+	for (int i = 0; i < iTerms; i++)
+	{
+		char szTerm[128];
+		const char* szFormat = s_conditions[(iIndex + i * 5) % (sizeof(s_conditions) / sizeof(s_conditions[0]))];
+		snprintf(szTerm, sizeof(szTerm), szFormat, iIndex * 7 + i);
+
+		if (i > 0)
+			strCondition += (iIndex + i) % 2 ? " + " : " | ";
+		if ((iIndex + i) % 4 == 0)
+			strCondition += "!";
+		strCondition += szTerm;
+	}
+	return strCondition;
+}
+
+// Skewed, most controls share a few conditions like Player.HasVideo
+static int PickCondition(int iDistinct)
+{
+	if (rand() % 2)
+		return rand() % (iDistinct < 16 ? iDistinct : 16);
+	return rand() % iDistinct;
+}
+
+static double Seconds(clock_t start, clock_t end)
+{
+	return (double)(end - start) / CLOCKS_PER_SEC;
+}
+
+static void Usage()
+{
+	printf("Usage: InfoBench [-windows <n>] [-controls <n>] [-distinct <n>] [-seed <n>]\n");
+}
+
+int main(int argc, char* argv[])
+{
+	int iWindows = 40;
+	int iControls = 250;
+	int iDistinct = 2000;
+	unsigned int iSeed = 1;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-windows") == 0 && i + 1 < argc)
+			iWindows = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-controls") == 0 && i + 1 < argc)
+			iControls = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-distinct") == 0 && i + 1 < argc)
+			iDistinct = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-seed") == 0 && i + 1 < argc)
+			iSeed = (unsigned int)atoi(argv[++i]);
+		else
+		{
+			Usage();
+			return 1;
+		}
+	}
+
+	if (iWindows < 1 || iControls < 1 || iDistinct < 1)
+	{
+		Usage();
+		return 1;
+	}
+
+	// The skin, as the strings and tuples its controls hand to the info manager
+	srand(iSeed);
+	std::vector<std::string> conditions;
+	std::vector<MultiInfo> multiInfos;
+	for (int iWindow = 0; iWindow < iWindows; iWindow++)
+	{
+		for (int iControl = 0; iControl < iControls; iControl++)
+		{
+			conditions.push_back(RandomCase(MakeCondition(PickCondition(iDistinct))));
+
+			MultiInfo info = { CONTROL_HAS_FOCUS, (unsigned int)(iControl % 100 + 1), 0 };
+			multiInfos.push_back(info);
+		}
+	}
+
+	printf("%i window(s) of %i control(s), %u condition(s) from %i distinct\n",
+		iWindows, iControls, (unsigned int)conditions.size(), iDistinct);
+
+	// Interned, as CGUIInfoManager::TranslateString() and AddMultiInfo() do it
+	std::vector<int> hashedIds;
+	hashedIds.reserve(conditions.size() + multiInfos.size());
+	CInfoStringTable strings;
+	CInfoTupleIndex tuples;
+	int iNextId = 1;
+	int iOffsets = 0;
+
+	clock_t start = clock();
+	for (unsigned int i = 0; i < conditions.size(); i++)
+	{
+		int id;
+		if (!strings.Find(conditions[i], id))
+		{
+			id = iNextId++;
+			strings.Add(conditions[i], id);
+		}
+		hashedIds.push_back(id);
+	}
+	for (unsigned int i = 0; i < multiInfos.size(); i++)
+	{
+		const MultiInfo& info = multiInfos[i];
+		int offset;
+		if (!tuples.Find(info.info, info.data1, info.data2, offset))
+		{
+			offset = iOffsets++;
+			tuples.Add(info.info, info.data1, info.data2, offset);
+		}
+		hashedIds.push_back(offset + MULTI_INFO_START);
+	}
+	clock_t end = clock();
+	double fHashed = Seconds(start, end);
+
+	// Scanned, as before
+	std::vector<int> linearIds;
+	linearIds.reserve(hashedIds.size());
+	CLinearTable linear;
+	std::vector<MultiInfo> linearInfos;
+	iNextId = 1;
+
+	start = clock();
+	for (unsigned int i = 0; i < conditions.size(); i++)
+	{
+		int id;
+		if (!linear.Find(conditions[i], id))
+		{
+			id = iNextId++;
+			linear.Add(conditions[i], id);
+		}
+		linearIds.push_back(id);
+	}
+	for (unsigned int i = 0; i < multiInfos.size(); i++)
+	{
+		const MultiInfo& info = multiInfos[i];
+		unsigned int offset = 0;
+		while (offset < linearInfos.size() &&
+		       !(linearInfos[offset].info == info.info && linearInfos[offset].data1 == info.data1 && linearInfos[offset].data2 == info.data2))
+			offset++;
+		if (offset == linearInfos.size())
+			linearInfos.push_back(info);
+		linearIds.push_back((int)offset + MULTI_INFO_START);
+	}
+	end = clock();
+	double fLinear = Seconds(start, end);
+
+	InfoTableStats stringStats, tupleStats;
+	strings.GetStats(stringStats);
+	tuples.GetStats(tupleStats);
+
+	printf("hashed: %.2f ms, %u of %u string(s) found, %u distinct, %u of %u tuple(s) found, %u distinct\n",
+		fHashed * 1000.0, stringStats.iHits, stringStats.iLookups, stringStats.iEntries,
+		tupleStats.iHits, tupleStats.iLookups, tupleStats.iEntries);
+	printf("linear: %.2f ms\n", fLinear * 1000.0);
+	if (fHashed > 0.0)
+		printf("speedup: %.1fx\n", fLinear / fHashed);
+
+	if (hashedIds != linearIds)
+	{
+		printf("FAILED: the lookups gave different ids\n");
+		return 1;
+	}
+
+	printf("ids match\n");
+	return 0;
+}
@@ -0,0 +1,189 @@
+/*
+ * ListBench - scrolls the layout of CGUIListContainer through lists of
+ * different sizes, to show that a scroll step binds and costs the same
+ * however many items the list has.
+ *
+ *   ListBench [-columns <n>] [-rows <n>] [-steps <n>] [<items> ...]
+ *
+ * Every step presses down, at the bottom it jumps back to the top like a
+ * page up would. After each step every item in range has to be bound to
+ * its view, and pressing down on the row above a short last row has to
+ * land on the last item. The exit code is 1 when either fails.
+ */
+
+#include "ListLayout.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <vector>
+
+// Same as LISTCONTAINER_PREFETCH_ROWS
+#define PREFETCH_ROWS 2
+
+struct ScrollResult
+{
+	unsigned int iViews;
+	unsigned int iSteps;
+	unsigned int iBinds;
+	unsigned int iMaxBinds;   // most in a single step
+	double fSeconds;
+};
+
+static bool CheckViews(const CListLayout& layout)
+{
+	int iFirst, iLast;
+	layout.GetShownItems(iFirst, iLast);
+	for (int i = iFirst; i <= iLast; i++)
+	{
+		if (layout.GetViewItem(layout.GetView(i)) != i)
+			return false;
+	}
+	return true;
+}
+
+static bool Scroll(int iColumns, int iRows, int iItems, unsigned int iSteps, ScrollResult& result)
+{
+	CListLayout layout;
+	layout.SetLayout(iColumns, iRows, PREFETCH_ROWS);
+	layout.SetItemCount(iItems);
+
+	std::vector<unsigned int> unbound, bound;
+	unbound.reserve(layout.GetViewCount());
+	bound.reserve(layout.GetViewCount());
+	layout.UpdateViews(unbound, bound);
+
+	memset(&result, 0, sizeof(result));
+	result.iViews = layout.GetViewCount();
+	result.iSteps = iSteps;
+
+	clock_t start = clock();
+	for (unsigned int i = 0; i < iSteps; i++)
+	{
+		if (!layout.MoveDown())
+			layout.MoveSelection(-iItems);
+
+		layout.UpdateViews(unbound, bound);
+		result.iBinds += bound.size();
+		if (bound.size() > result.iMaxBinds)
+			result.iMaxBinds = bound.size();
+	}
+	result.fSeconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	// Not checked in the timed loop, CheckAllSteps() does that
+	return CheckViews(layout);
+}
+
+static bool CheckAllSteps(int iColumns, int iRows, int iItems)
+{
+	CListLayout layout;
+	layout.SetLayout(iColumns, iRows, PREFETCH_ROWS);
+	layout.SetItemCount(iItems);
+
+	std::vector<unsigned int> unbound, bound;
+	layout.UpdateViews(unbound, bound);
+	if (!CheckViews(layout))
+		return false;
+
+	// Down to the bottom and back up
+	while (layout.MoveDown())
+	{
+		layout.UpdateViews(unbound, bound);
+		if (!CheckViews(layout))
+			return false;
+	}
+
+	while (layout.MoveUp())
+	{
+		layout.UpdateViews(unbound, bound);
+		if (!CheckViews(layout))
+			return false;
+	}
+	return true;
+}
+
+static bool CheckShortLastRow(int iColumns, int iRows)
+{
+	if (iColumns < 2)
+		return true;
+
+	// Two full rows and one item in the last, down from the end of the second row
+	CListLayout layout;
+	layout.SetLayout(iColumns, iRows, PREFETCH_ROWS);
+	layout.SetItemCount(2 * iColumns + 1);
+	layout.MoveSelection(2 * iColumns - 1);
+
+	return layout.MoveDown() && layout.GetSelected() == 2 * iColumns;
+}
+
+static void Usage()
+{
+	printf("Usage: ListBench [-columns <n>] [-rows <n>] [-steps <n>] [<items> ...]\n");
+}
+
+int main(int argc, char* argv[])
+{
+	int iColumns = 1;
+	int iRows = 10;
+	unsigned int iSteps = 1000000;
+	std::vector<int> sizes;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-columns") == 0 && i + 1 < argc)
+			iColumns = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-rows") == 0 && i + 1 < argc)
+			iRows = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-steps") == 0 && i + 1 < argc)
+			iSteps = (unsigned int)atoi(argv[++i]);
+		else if (argv[i][0] != '-' && atoi(argv[i]) > 0)
+			sizes.push_back(atoi(argv[i]));
+		else
+		{
+			Usage();
+			return 1;
+		}
+	}
+
+	if (iColumns < 1 || iRows < 1 || iSteps < 1)
+	{
+		Usage();
+		return 1;
+	}
+
+	if (sizes.empty())
+	{
+		sizes.push_back(50);
+		sizes.push_back(50000);
+	}
+
+	bool bOk = CheckShortLastRow(iColumns, iRows);
+	if (!bOk)
+		printf("FAILED: down from above a short last row didn't select its last item\n");
+
+	printf("%i column(s), %i row(s) on screen, %u step(s) down\n", iColumns, iRows, iSteps);
+	for (unsigned int i = 0; i < sizes.size(); i++)
+	{
+		// Every step of a whole pass is checked on lists that are cheap to walk
+		if (sizes[i] <= 100000 && !CheckAllSteps(iColumns, iRows, sizes[i]))
+		{
+			printf("FAILED: %i item(s), an item in range isn't bound to its view\n", sizes[i]);
+			bOk = false;
+		}
+
+		ScrollResult result;
+		if (!Scroll(iColumns, iRows, sizes[i], iSteps, result))
+		{
+			printf("FAILED: %i item(s), an item in range isn't bound to its view\n", sizes[i]);
+			bOk = false;
+		}
+
+		printf("%8i item(s): %u view(s), %.2f bind(s) per step, at most %u, %.1f ns per step\n",
+			sizes[i], result.iViews, (double)result.iBinds / result.iSteps, result.iMaxBinds,
+			result.fSeconds * 1e9 / result.iSteps);
+	}
+
+	return bOk ? 0 : 1;
+}
@@ -0,0 +1,223 @@
+/*
+ * ProbeBench - probes every file below a directory the way the background
+ * media probe does, with a Linux build of the same ffmpeg release.
+ *
+ *   ProbeBench [-v] [-probesize <KB>] [-analyze <ms>] <directory> ...
+ *
+ * For each file it prints how long opening and finding the stream info
+ * took, the streams found and whether the probesize or the analyze
+ * duration was reached, the files where the listing may show incomplete
+ * info. The defaults are the probe's own. -v lets ffmpeg log as well. The
+ * exit code is 1 when no file could be probed.
+ */
+
+#include "MediaProbeCore.h"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+struct BenchStats
+{
+	BenchStats()
+	{
+		iFiles = 0;
+		iUnknown = 0;
+		iNoStreams = 0;
+		iProbeSizeHits = 0;
+		iAnalyzeHits = 0;
+		fTotalTime = 0.0;
+		fMaxTime = 0.0;
+	}
+
+	unsigned int iFiles;
+	unsigned int iUnknown;       // no format detected
+	unsigned int iNoStreams;     // format detected, no stream info
+	unsigned int iProbeSizeHits;
+	unsigned int iAnalyzeHits;
+	double fTotalTime;
+	double fMaxTime;
+	std::string strSlowest;
+};
+
+static int g_iProbeSize = MEDIAPROBE_DEFAULT_PROBESIZE;
+static int g_iAnalyzeMs = MEDIAPROBE_DEFAULT_ANALYZE_MS;
+
+static double GetTimeMs()
+{
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+}
+
+static std::string DescribeStream(const MediaProbeStream& stream)
+{
+	char strText[128];
+	switch (stream.type)
+	{
+		case AVMEDIA_TYPE_VIDEO:
+			snprintf(strText, sizeof(strText), "video %s %ix%i %.3f fps", stream.strCodec.c_str(), stream.iWidth, stream.iHeight,
+				stream.iFpsScale ? (double)stream.iFpsRate / stream.iFpsScale : 0.0);
+			break;
+		case AVMEDIA_TYPE_AUDIO:
+			snprintf(strText, sizeof(strText), "audio %s %i ch %i Hz", stream.strCodec.c_str(), stream.iChannels, stream.iSampleRate);
+			break;
+		case AVMEDIA_TYPE_SUBTITLE:
+			snprintf(strText, sizeof(strText), "subtitle %s", stream.strCodec.c_str());
+			break;
+		default:
+			snprintf(strText, sizeof(strText), "data %s", stream.strCodec.c_str());
+			break;
+	}
+	return strText;
+}
+
+static void ProbeFile(const std::string& strPath, BenchStats& stats)
+{
+	stats.iFiles++;
+
+	double fStart = GetTimeMs();
+	AVFormatContext* pContext = NULL;
+	if (CMediaProbeCore::Open(&pContext, strPath.c_str(), NULL, g_iProbeSize, g_iAnalyzeMs) != 0)
+	{
+		stats.iUnknown++;
+		printf("%8.1f ms  %s  not recognised\n", GetTimeMs() - fStart, strPath.c_str());
+		return;
+	}
+
+	MediaProbeResult result;
+	bool bFound = CMediaProbeCore::FindStreams(pContext, result);
+	av_close_input_file(pContext);
+
+	double fTime = GetTimeMs() - fStart;
+	stats.fTotalTime += fTime;
+	if (fTime > stats.fMaxTime)
+	{
+		stats.fMaxTime = fTime;
+		stats.strSlowest = strPath;
+	}
+
+	if (!bFound)
+	{
+		stats.iNoStreams++;
+		printf("%8.1f ms  %s  [%s] no stream info\n", fTime, strPath.c_str(), result.strFormat.c_str());
+		return;
+	}
+
+	int iSeconds = result.iDuration / 1000;
+	printf("%8.1f ms  %s  [%s] %i:%02i:%02i\n", fTime, strPath.c_str(), result.strFormat.c_str(),
+		iSeconds / 3600, iSeconds / 60 % 60, iSeconds % 60);
+
+	for (unsigned int i = 0; i < result.streams.size(); i++)
+		printf("              %s\n", DescribeStream(result.streams[i]).c_str());
+
+	if (result.bProbeSizeHit)
+	{
+		stats.iProbeSizeHits++;
+		printf("              probesize reached, %i KB of packets\n", result.iPacketBytes / 1024);
+	}
+	if (result.bAnalyzeHit)
+	{
+		stats.iAnalyzeHits++;
+		printf("              analyze duration reached, %i ms of streams\n", result.iAnalyzed);
+	}
+}
+
+// Files in name order, then the directories below
+static void ProbeDirectory(const std::string& strDirectory, BenchStats& stats)
+{
+	DIR* pDir = opendir(strDirectory.c_str());
+	if (!pDir)
+	{
+		printf("can't open %s\n", strDirectory.c_str());
+		return;
+	}
+
+	std::vector<std::string> files;
+	std::vector<std::string> directories;
+	for (dirent* pEntry = readdir(pDir); pEntry; pEntry = readdir(pDir))
+	{
+		if (pEntry->d_name[0] == '.')
+			continue;
+
+		std::string strPath = strDirectory + "/" + pEntry->d_name;
+		struct stat info;
+		if (stat(strPath.c_str(), &info) != 0)
+			continue;
+
+		if (S_ISDIR(info.st_mode))
+			directories.push_back(strPath);
+		else if (S_ISREG(info.st_mode))
+			files.push_back(strPath);
+	}
+	closedir(pDir);
+
+	std::sort(files.begin(), files.end());
+	std::sort(directories.begin(), directories.end());
+
+	for (unsigned int i = 0; i < files.size(); i++)
+		ProbeFile(files[i], stats);
+	for (unsigned int i = 0; i < directories.size(); i++)
+		ProbeDirectory(directories[i], stats);
+}
+
+static void Usage()
+{
+	printf("Usage: ProbeBench [-v] [-probesize <KB>] [-analyze <ms>] <directory> ...\n");
+}
+
+int main(int argc, char* argv[])
+{
+	bool bVerbose = false;
+	std::vector<std::string> directories;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-v") == 0)
+			bVerbose = true;
+		else if (strcmp(argv[i], "-probesize") == 0 && i + 1 < argc)
+			g_iProbeSize = atoi(argv[++i]) * 1024;
+		else if (strcmp(argv[i], "-analyze") == 0 && i + 1 < argc)
+			g_iAnalyzeMs = atoi(argv[++i]);
+		else if (argv[i][0] != '-')
+			directories.push_back(argv[i]);
+		else
+		{
+			Usage();
+			return 1;
+		}
+	}
+
+	if (directories.empty() || g_iProbeSize < 1 || g_iAnalyzeMs < 1)
+	{
+		Usage();
+		return 1;
+	}
+
+	av_register_all();
+	if (!bVerbose)
+		av_log_set_level(AV_LOG_QUIET);
+
+	printf("probesize %i KB, analyze duration %i ms\n", g_iProbeSize / 1024, g_iAnalyzeMs);
+
+	BenchStats stats;
+	for (unsigned int i = 0; i < directories.size(); i++)
+		ProbeDirectory(directories[i], stats);
+
+	unsigned int iProbed = stats.iFiles - stats.iUnknown;
+	printf("%u file(s), %u not recognised, %u without stream info\n", stats.iFiles, stats.iUnknown, stats.iNoStreams);
+	if (iProbed)
+	{
+		printf("probe time avg %.1f ms, max %.1f ms for %s\n", stats.fTotalTime / iProbed, stats.fMaxTime, stats.strSlowest.c_str());
+		printf("%u reached the probesize, %u the analyze duration\n", stats.iProbeSizeHits, stats.iAnalyzeHits);
+	}
+
+	return iProbed > stats.iNoStreams ? 0 : 1;
+}
@@ -0,0 +1,180 @@
+#include "DXTCompressor.h"
+
+#include <string.h>
+
+static unsigned short To565(const int* pColor)
+{
+	int r = (pColor[0] * 31 + 127) / 255;
+	int g = (pColor[1] * 63 + 127) / 255;
+	int b = (pColor[2] * 31 + 127) / 255;
+	return (unsigned short)((r << 11) | (g << 5) | b);
+}
+
+static void From565(unsigned short wColor, int* pColor)
+{
+	int r = (wColor >> 11) & 31;
+	int g = (wColor >> 5) & 63;
+	int b = wColor & 31;
+	pColor[0] = (r << 3) | (r >> 2);
+	pColor[1] = (g << 2) | (g >> 4);
+	pColor[2] = (b << 3) | (b >> 2);
+}
+
+static void WriteWord(unsigned char* pOut, unsigned int iValue)
+{
+	pOut[0] = (unsigned char)(iValue & 0xFF);
+	pOut[1] = (unsigned char)((iValue >> 8) & 0xFF);
+}
+
+static void CompressColor(const unsigned char* pBlock, unsigned char* pOut)
+{
+	int colors[16][3];
+	float fMean[3] = { 0, 0, 0 };
+
+	for (int i = 0; i < 16; i++)
+	{
+		for (int c = 0; c < 3; c++)
+		{
+			colors[i][c] = pBlock[i * 4 + 1 + c];
+			fMean[c] += colors[i][c] / 16.0f;
+		}
+	}
+
+	// Principal axis of the colors, the endpoints are the texels furthest along it
+	float fCov[6] = { 0, 0, 0, 0, 0, 0 };
+	for (int i = 0; i < 16; i++)
+	{
+		float r = colors[i][0] - fMean[0];
+		float g = colors[i][1] - fMean[1];
+		float b = colors[i][2] - fMean[2];
+		fCov[0] += r * r; fCov[1] += r * g; fCov[2] += r * b;
+		fCov[3] += g * g; fCov[4] += g * b; fCov[5] += b * b;
+	}
+
+	float fAxis[3] = { 1, 1, 1 };
+	for (int iIteration = 0; iIteration < 4; iIteration++)
+	{
+		float x = fCov[0] * fAxis[0] + fCov[1] * fAxis[1] + fCov[2] * fAxis[2];
+		float y = fCov[1] * fAxis[0] + fCov[3] * fAxis[1] + fCov[4] * fAxis[2];
+		float z = fCov[2] * fAxis[0] + fCov[4] * fAxis[1] + fCov[5] * fAxis[2];
+
+		float fMax = x > 0 ? x : -x;
+		if ((y > 0 ? y : -y) > fMax) fMax = y > 0 ? y : -y;
+		if ((z > 0 ? z : -z) > fMax) fMax = z > 0 ? z : -z;
+		if (fMax == 0)
+			break;
+
+		fAxis[0] = x / fMax; fAxis[1] = y / fMax; fAxis[2] = z / fMax;
+	}
+
+	int iMin = 0, iMax = 0;
+	float fMinDot = 0, fMaxDot = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		float fDot = colors[i][0] * fAxis[0] + colors[i][1] * fAxis[1] + colors[i][2] * fAxis[2];
+		if (i == 0 || fDot < fMinDot) { fMinDot = fDot; iMin = i; }
+		if (i == 0 || fDot > fMaxDot) { fMaxDot = fDot; iMax = i; }
+	}
+
+	unsigned short wColor0 = To565(colors[iMax]);
+	unsigned short wColor1 = To565(colors[iMin]);
+
+	// color0 > color1 selects the four color mode
+	if (wColor0 < wColor1)
+	{
+		unsigned short wTemp = wColor0;
+		wColor0 = wColor1;
+		wColor1 = wTemp;
+	}
+
+	unsigned int iIndices = 0;
+	if (wColor0 != wColor1)
+	{
+		int palette[4][3];
+		From565(wColor0, palette[0]);
+		From565(wColor1, palette[1]);
+		for (int c = 0; c < 3; c++)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+
+		for (int i = 0; i < 16; i++)
+		{
+			int iBest = 0, iBestError = 0x7FFFFFFF;
+			for (int p = 0; p < 4; p++)
+			{
+				int iError = 0;
+				for (int c = 0; c < 3; c++)
+					iError += (colors[i][c] - palette[p][c]) * (colors[i][c] - palette[p][c]);
+				if (iError < iBestError)
+				{
+					iBestError = iError;
+					iBest = p;
+				}
+			}
+			iIndices |= iBest << (i * 2);
+		}
+	}
+
+	WriteWord(pOut, wColor0);
+	WriteWord(pOut + 2, wColor1);
+	WriteWord(pOut + 4, iIndices & 0xFFFF);
+	WriteWord(pOut + 6, iIndices >> 16);
+}
+
+static void CompressAlpha(const unsigned char* pBlock, unsigned char* pOut)
+{
+	int iMin = 255, iMax = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		int a = pBlock[i * 4];
+		if (a < iMin) iMin = a;
+		if (a > iMax) iMax = a;
+	}
+
+	// alpha0 > alpha1 selects eight interpolated values
+	pOut[0] = (unsigned char)iMax;
+	pOut[1] = (unsigned char)iMin;
+	memset(pOut + 2, 0, 6);
+
+	if (iMax == iMin)
+		return;
+
+	int palette[8];
+	palette[0] = iMax;
+	palette[1] = iMin;
+	for (int p = 1; p < 7; p++)
+		palette[p + 1] = ((7 - p) * iMax + p * iMin) / 7;
+
+	unsigned long long iIndices = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		int a = pBlock[i * 4];
+		int iBest = 0, iBestError = 256;
+		for (int p = 0; p < 8; p++)
+		{
+			int iError = a > palette[p] ? a - palette[p] : palette[p] - a;
+			if (iError < iBestError)
+			{
+				iBestError = iError;
+				iBest = p;
+			}
+		}
+		iIndices |= (unsigned long long)iBest << (i * 3);
+	}
+
+	for (int i = 0; i < 6; i++)
+		pOut[2 + i] = (unsigned char)((iIndices >> (i * 8)) & 0xFF);
+}
+
+void CompressBlockDXT1(const unsigned char* pBlock, unsigned char* pOut)
+{
+	CompressColor(pBlock, pOut);
+}
+
+void CompressBlockDXT5(const unsigned char* pBlock, unsigned char* pOut)
+{
+	CompressAlpha(pBlock, pOut);
+	CompressColor(pBlock, pOut + 8);
+}
@@ -0,0 +1,9 @@
+#ifndef TEXTUREPACKER_DXTCOMPRESSOR_H
+#define TEXTUREPACKER_DXTCOMPRESSOR_H
+
+// Compresses one 4x4 block of A,R,G,B bytes, rows top to bottom.
+// The output uses the little endian layout of the DXT specification.
+void CompressBlockDXT1(const unsigned char* pBlock, unsigned char* pOut);  // 8 bytes, alpha ignored
+void CompressBlockDXT5(const unsigned char* pBlock, unsigned char* pOut);  // 16 bytes
+
+#endif //TEXTUREPACKER_DXTCOMPRESSOR_H
@@ -0,0 +1,562 @@
+/*
+ * TexturePacker - packs the images of a skin's media folder into a texture
+ * bundle (Textures.xbt) the GUI can load without decoding anything.
+ *
+ *   TexturePacker [-dxt] [-notile] [-noatlas] <media folder> <output file>
+ *
+ *   -dxt      compress textures with sides divisible by 4, DXT1 when opaque, DXT5 otherwise
+ *   -notile   store all textures linear instead of in the GPU's tiled layout
+ *   -noatlas  store small images as textures of their own instead of in shared pages
+ *
+ * The bundle layout is described in xbmc360/guilib/TextureBundle.h, both
+ * have to be changed together. Everything is written big endian.
+ */
+
+#include "DXTCompressor.h"
+
+#include <png.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#define TEXTUREBUNDLE_MAGIC     0x58425458 // 'XBTX'
+#define TEXTUREBUNDLE_VERSION   2
+#define TEXTUREBUNDLE_NAMESIZE  64
+#define TEXTUREBUNDLE_ALIGN     4096
+
+#define TEXTUREBUNDLE_FMT_ARGB  0
+#define TEXTUREBUNDLE_FMT_DXT1  1
+#define TEXTUREBUNDLE_FMT_DXT5  2
+
+#define TEXTUREBUNDLE_FLAG_TILED 0x00000001
+#define TEXTUREBUNDLE_FLAG_ATLAS 0x00000002
+
+#define TEXTUREBUNDLE_HEADERSIZE 16
+#define TEXTUREBUNDLE_ENTRYSIZE  (TEXTUREBUNDLE_NAMESIZE + 9 * 4)
+
+// Smaller textures may be packed into the mip tail by the GPU, they stay linear
+#define TILE_MIN_SIZE 32
+
+// Images up to this size on both sides go into shared atlas pages
+#define ATLAS_MAX_SIZE    128
+#define ATLAS_PAGE_WIDTH  1024
+#define ATLAS_PAGE_HEIGHT 1024
+// Border repeated around every image, so filtering never picks up a neighbour.
+// Cells, image plus border, start on 4 texel boundaries so DXT blocks never mix images.
+#define ATLAS_PADDING     2
+#define ATLAS_PAGE_NAME   "atlas\\page%u"
+
+struct Texture
+{
+	std::string strName;      // bundle name, lower case with '\'
+	std::string strFile;
+	unsigned int iFormat;
+	unsigned int iFlags;
+	unsigned int iWidth;
+	unsigned int iHeight;
+	unsigned int iOffset;
+	unsigned int iFileSize;
+	std::vector<unsigned char> data;
+
+	// Atlas images only
+	std::string strPage;
+	unsigned int iPage;
+	unsigned int iX;
+	unsigned int iY;
+	std::vector<unsigned char> pixels; // until placed in the page
+};
+
+static bool g_bDXT = false;
+static bool g_bTile = true;
+static bool g_bAtlas = true;
+
+static unsigned int Align(unsigned int iValue, unsigned int iAlign)
+{
+	return (iValue + iAlign - 1) / iAlign * iAlign;
+}
+
+// Offset in blocks of block x,y in a tiled 2D surface, as XGAddress2DTiledOffset() does
+static unsigned int TiledOffset(unsigned int x, unsigned int y, unsigned int iWidth, unsigned int iBytesPerBlock)
+{
+	unsigned int iAlignedWidth = (iWidth + 31) & ~31;
+	unsigned int iLogBpp = (iBytesPerBlock >> 2) + ((iBytesPerBlock >> 1) >> (iBytesPerBlock >> 2));
+	unsigned int iMacro = ((x >> 5) + (y >> 5) * (iAlignedWidth >> 5)) << (iLogBpp + 7);
+	unsigned int iMicro = ((x & 7) + ((y & 6) << 2)) << iLogBpp;
+	unsigned int iOffset = iMacro + ((iMicro & ~15) << 1) + (iMicro & 15) + ((y & 8) << (3 + iLogBpp)) + ((y & 1) << 4);
+
+	return (((iOffset & ~511) << 3) + ((iOffset & 448) << 2) + (iOffset & 63) +
+		((y & 16) << 7) + (((((y & 8) >> 2) + (x >> 3)) & 3) << 6)) >> iLogBpp;
+}
+
+static void WriteDWORD(FILE* fd, unsigned int iValue)
+{
+	unsigned char buffer[4] = { (unsigned char)(iValue >> 24), (unsigned char)(iValue >> 16), (unsigned char)(iValue >> 8), (unsigned char)iValue };
+	fwrite(buffer, 4, 1, fd);
+}
+
+static bool LoadPNG(const std::string& strFile, std::vector<unsigned char>& pixels, unsigned int& iWidth, unsigned int& iHeight)
+{
+	png_image image;
+	memset(&image, 0, sizeof(image));
+	image.version = PNG_IMAGE_VERSION;
+
+	if (!png_image_begin_read_from_file(&image, strFile.c_str()))
+		return false;
+
+	// A,R,G,B bytes are what a big endian A8R8G8B8 texel looks like in memory
+	image.format = PNG_FORMAT_ARGB;
+	pixels.resize(PNG_IMAGE_SIZE(image));
+
+	if (!png_image_finish_read(&image, NULL, &pixels[0], 0, NULL))
+	{
+		png_image_free(&image);
+		return false;
+	}
+
+	iWidth = image.width;
+	iHeight = image.height;
+	return true;
+}
+
+static bool Convert(Texture& texture, const std::vector<unsigned char>& pixels)
+{
+	unsigned int iWidth = texture.iWidth;
+	unsigned int iHeight = texture.iHeight;
+
+	texture.iFormat = TEXTUREBUNDLE_FMT_ARGB;
+	if (g_bDXT && (iWidth % 4) == 0 && (iHeight % 4) == 0)
+	{
+		bool bOpaque = true;
+		for (size_t i = 0; i < pixels.size() && bOpaque; i += 4)
+			bOpaque = pixels[i] == 255;
+
+		texture.iFormat = bOpaque ? TEXTUREBUNDLE_FMT_DXT1 : TEXTUREBUNDLE_FMT_DXT5;
+	}
+
+	// Blocks are single texels for ARGB and 4x4 texels for DXT
+	unsigned int iBlockSize = texture.iFormat == TEXTUREBUNDLE_FMT_ARGB ? 1 : 4;
+	unsigned int iBytesPerBlock = texture.iFormat == TEXTUREBUNDLE_FMT_DXT1 ? 8 : 16;
+	if (texture.iFormat == TEXTUREBUNDLE_FMT_ARGB)
+		iBytesPerBlock = 4;
+
+	unsigned int iBlocksWide = (iWidth + iBlockSize - 1) / iBlockSize;
+	unsigned int iBlocksHigh = (iHeight + iBlockSize - 1) / iBlockSize;
+
+	std::vector<unsigned char> blocks(iBlocksWide * iBlocksHigh * iBytesPerBlock);
+	if (texture.iFormat == TEXTUREBUNDLE_FMT_ARGB)
+	{
+		blocks = pixels;
+	}
+	else
+	{
+		for (unsigned int by = 0; by < iBlocksHigh; by++)
+		{
+			for (unsigned int bx = 0; bx < iBlocksWide; bx++)
+			{
+				unsigned char block[16 * 4];
+				for (unsigned int y = 0; y < 4; y++)
+					memcpy(block + y * 16, &pixels[((by * 4 + y) * iWidth + bx * 4) * 4], 16);
+
+				unsigned char* pOut = &blocks[(by * iBlocksWide + bx) * iBytesPerBlock];
+				if (texture.iFormat == TEXTUREBUNDLE_FMT_DXT1)
+					CompressBlockDXT1(block, pOut);
+				else
+					CompressBlockDXT5(block, pOut);
+
+				// The GPU reads DXT blocks as big endian 16 bit words
+				for (unsigned int i = 0; i < iBytesPerBlock; i += 2)
+					std::swap(pOut[i], pOut[i + 1]);
+			}
+		}
+	}
+
+	texture.iFlags = 0;
+	if (!g_bTile || iWidth < TILE_MIN_SIZE || iHeight < TILE_MIN_SIZE)
+	{
+		texture.data.swap(blocks);
+		return true;
+	}
+
+	// Tiled surfaces are padded to 32x32 blocks
+	unsigned int iAlignedWide = Align(iBlocksWide, 32);
+	unsigned int iAlignedHigh = Align(iBlocksHigh, 32);
+
+	texture.data.assign(iAlignedWide * iAlignedHigh * iBytesPerBlock, 0);
+	for (unsigned int by = 0; by < iBlocksHigh; by++)
+	{
+		for (unsigned int bx = 0; bx < iBlocksWide; bx++)
+		{
+			unsigned int iOffset = TiledOffset(bx, by, iBlocksWide, iBytesPerBlock) * iBytesPerBlock;
+			memcpy(&texture.data[iOffset], &blocks[(by * iBlocksWide + bx) * iBytesPerBlock], iBytesPerBlock);
+		}
+	}
+	texture.iFlags |= TEXTUREBUNDLE_FLAG_TILED;
+
+	return true;
+}
+
+static bool SortByHeight(const Texture& left, const Texture& right)
+{
+	if (left.iHeight != right.iHeight)
+		return left.iHeight > right.iHeight;
+	return left.strName < right.strName;
+}
+
+// Copies an image into a page, repeating its edge texels into the padding
+static void Blit(const Texture& image, std::vector<unsigned char>& page, unsigned int iPageWidth)
+{
+	int iPadding = ATLAS_PADDING;
+	for (int y = -iPadding; y < (int)image.iHeight + iPadding; y++)
+	{
+		int iSourceY = std::min(std::max(y, 0), (int)image.iHeight - 1);
+		for (int x = -iPadding; x < (int)image.iWidth + iPadding; x++)
+		{
+			int iSourceX = std::min(std::max(x, 0), (int)image.iWidth - 1);
+			memcpy(&page[((image.iY + y) * iPageWidth + image.iX + x) * 4],
+				&image.pixels[(iSourceY * image.iWidth + iSourceX) * 4], 4);
+		}
+	}
+}
+
+// Packs the images into as few pages as possible, shelf by shelf from the tallest image
+static void BuildAtlas(std::vector<Texture>& images, std::vector<Texture>& textures)
+{
+	std::sort(images.begin(), images.end(), SortByHeight);
+
+	unsigned int iPages = 0;
+	size_t iFirst = 0;
+	while (iFirst < images.size())
+	{
+		unsigned int x = 0, y = 0, iShelfHeight = 0, iPageHeight = 0;
+
+		size_t iLast = iFirst;
+		for (; iLast < images.size(); iLast++)
+		{
+			Texture& image = images[iLast];
+			unsigned int iCellWidth = Align(image.iWidth + 2 * ATLAS_PADDING, 4);
+			unsigned int iCellHeight = Align(image.iHeight + 2 * ATLAS_PADDING, 4);
+
+			if (x + iCellWidth > ATLAS_PAGE_WIDTH)
+			{
+				x = 0;
+				y += iShelfHeight;
+				iShelfHeight = 0;
+			}
+
+			if (y + iCellHeight > ATLAS_PAGE_HEIGHT)
+				break;
+
+			image.iX = x + ATLAS_PADDING;
+			image.iY = y + ATLAS_PADDING;
+			x += iCellWidth;
+			iShelfHeight = std::max(iShelfHeight, iCellHeight);
+			iPageHeight = y + iShelfHeight;
+		}
+
+		// A page with a single image saves nothing
+		if (iLast - iFirst == 1)
+		{
+			Texture& image = images[iFirst];
+			Convert(image, image.pixels);
+			image.pixels.clear();
+			textures.push_back(image);
+			iFirst = iLast;
+			continue;
+		}
+
+		char szName[TEXTUREBUNDLE_NAMESIZE];
+		snprintf(szName, sizeof(szName), ATLAS_PAGE_NAME, iPages++);
+
+		// Only as high as needed, at least high enough to be tiled
+		Texture page;
+		page.strName = szName;
+		page.iFileSize = 0;
+		page.iPage = page.iX = page.iY = 0;
+		page.iWidth = ATLAS_PAGE_WIDTH;
+		page.iHeight = std::max(Align(iPageHeight, 4), (unsigned int)TILE_MIN_SIZE);
+
+		std::vector<unsigned char> pixels(page.iWidth * page.iHeight * 4, 0);
+		for (size_t i = iFirst; i < iLast; i++)
+			Blit(images[i], pixels, page.iWidth);
+
+		Convert(page, pixels);
+
+		for (size_t i = iFirst; i < iLast; i++)
+		{
+			Texture& image = images[i];
+			image.strPage = page.strName;
+			image.iFormat = page.iFormat;
+			image.iFlags = TEXTUREBUNDLE_FLAG_ATLAS;
+			image.pixels.clear();
+			textures.push_back(image);
+		}
+
+		textures.push_back(page);
+		iFirst = iLast;
+	}
+}
+
+static bool HasExtension(const std::string& strFile, const char* strExtension)
+{
+	size_t iLength = strlen(strExtension);
+	if (strFile.size() < iLength)
+		return false;
+
+	for (size_t i = 0; i < iLength; i++)
+	{
+		if (tolower(strFile[strFile.size() - iLength + i]) != strExtension[i])
+			return false;
+	}
+	return true;
+}
+
+static void CollectFiles(const std::string& strFolder, const std::string& strPrefix, std::vector<Texture>& textures)
+{
+	DIR* dir = opendir(strFolder.c_str());
+	if (!dir)
+		return;
+
+	struct dirent* pEntry;
+	while ((pEntry = readdir(dir)) != NULL)
+	{
+		std::string strEntry = pEntry->d_name;
+		if (strEntry == "." || strEntry == "..")
+			continue;
+
+		std::string strFile = strFolder + "/" + strEntry;
+
+		struct stat info;
+		if (stat(strFile.c_str(), &info) != 0)
+			continue;
+
+		if (S_ISDIR(info.st_mode))
+		{
+			CollectFiles(strFile, strPrefix + strEntry + "\\", textures);
+			continue;
+		}
+
+		if (!HasExtension(strEntry, ".png"))
+		{
+			if (!HasExtension(strEntry, ".xbt"))
+				printf("  skipping %s, only PNG files are packed\n", strFile.c_str());
+			continue;
+		}
+
+		Texture texture;
+		texture.iPage = texture.iX = texture.iY = 0;
+		texture.strName = strPrefix + strEntry;
+		std::transform(texture.strName.begin(), texture.strName.end(), texture.strName.begin(), ::tolower);
+		texture.strFile = strFile;
+		texture.iFileSize = (unsigned int)info.st_size;
+
+		if (texture.strName.size() >= TEXTUREBUNDLE_NAMESIZE)
+		{
+			printf("  skipping %s, the name is too long\n", strFile.c_str());
+			continue;
+		}
+
+		textures.push_back(texture);
+	}
+
+	closedir(dir);
+}
+
+static bool SortByName(const Texture& left, const Texture& right)
+{
+	return left.strName < right.strName;
+}
+
+static bool WriteBundle(const std::string& strOutput, std::vector<Texture>& textures)
+{
+	unsigned int iOffset = Align(TEXTUREBUNDLE_HEADERSIZE + textures.size() * TEXTUREBUNDLE_ENTRYSIZE, TEXTUREBUNDLE_ALIGN);
+	unsigned int iDataOffset = iOffset;
+
+	for (size_t i = 0; i < textures.size(); i++)
+	{
+		// Atlas images have no data of their own
+		if (textures[i].data.empty())
+		{
+			textures[i].iOffset = 0;
+			continue;
+		}
+
+		textures[i].iOffset = iOffset;
+		iOffset = Align(iOffset + textures[i].data.size(), TEXTUREBUNDLE_ALIGN);
+	}
+
+	FILE* fd = fopen(strOutput.c_str(), "wb");
+	if (!fd)
+	{
+		fprintf(stderr, "Unable to create %s\n", strOutput.c_str());
+		return false;
+	}
+
+	WriteDWORD(fd, TEXTUREBUNDLE_MAGIC);
+	WriteDWORD(fd, TEXTUREBUNDLE_VERSION);
+	WriteDWORD(fd, (unsigned int)textures.size());
+	WriteDWORD(fd, iDataOffset);
+
+	for (size_t i = 0; i < textures.size(); i++)
+	{
+		const Texture& texture = textures[i];
+
+		char szName[TEXTUREBUNDLE_NAMESIZE];
+		memset(szName, 0, sizeof(szName));
+		strncpy(szName, texture.strName.c_str(), TEXTUREBUNDLE_NAMESIZE - 1);
+		fwrite(szName, sizeof(szName), 1, fd);
+
+		WriteDWORD(fd, texture.iFormat);
+		WriteDWORD(fd, texture.iFlags);
+		WriteDWORD(fd, texture.iWidth);
+		WriteDWORD(fd, texture.iHeight);
+		WriteDWORD(fd, texture.iOffset);
+		WriteDWORD(fd, (unsigned int)texture.data.size());
+		WriteDWORD(fd, texture.iPage);
+		WriteDWORD(fd, texture.iX);
+		WriteDWORD(fd, texture.iY);
+	}
+
+	static const unsigned char padding[TEXTUREBUNDLE_ALIGN] = { 0 };
+	for (size_t i = 0; i < textures.size(); i++)
+	{
+		const Texture& texture = textures[i];
+		if (texture.data.empty())
+			continue;
+
+		long lPosition = ftell(fd);
+		fwrite(padding, texture.iOffset - lPosition, 1, fd);
+		fwrite(&texture.data[0], texture.data.size(), 1, fd);
+	}
+
+	// Pad the last texture too, so every read can be a whole number of pages
+	long lPosition = ftell(fd);
+	if (lPosition != (long)iOffset)
+		fwrite(padding, iOffset - lPosition, 1, fd);
+
+	bool bResult = ferror(fd) == 0;
+	fclose(fd);
+
+	if (!bResult)
+		fprintf(stderr, "Failed writing %s\n", strOutput.c_str());
+
+	return bResult;
+}
+
+static void Usage()
+{
+	printf("Usage: TexturePacker [-dxt] [-notile] [-noatlas] <media folder> <output file>\n");
+}
+
+int main(int argc, char* argv[])
+{
+	std::string strInput, strOutput;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-dxt") == 0)
+			g_bDXT = true;
+		else if (strcmp(argv[i], "-notile") == 0)
+			g_bTile = false;
+		else if (strcmp(argv[i], "-noatlas") == 0)
+			g_bAtlas = false;
+		else if (strInput.empty())
+			strInput = argv[i];
+		else if (strOutput.empty())
+			strOutput = argv[i];
+		else
+		{
+			Usage();
+			return 1;
+		}
+	}
+
+	if (strInput.empty() || strOutput.empty())
+	{
+		Usage();
+		return 1;
+	}
+
+	std::vector<Texture> textures;
+	CollectFiles(strInput, "", textures);
+	std::sort(textures.begin(), textures.end(), SortByName);
+
+	unsigned int iFileSize = 0;
+
+	std::vector<Texture> packed, small;
+	for (size_t i = 0; i < textures.size(); i++)
+	{
+		Texture& texture = textures[i];
+
+		std::vector<unsigned char> pixels;
+		if (!LoadPNG(texture.strFile, pixels, texture.iWidth, texture.iHeight))
+		{
+			printf("  skipping %s, unable to decode it\n", texture.strFile.c_str());
+			continue;
+		}
+
+		iFileSize += texture.iFileSize;
+
+		if (g_bAtlas && texture.iWidth <= ATLAS_MAX_SIZE && texture.iHeight <= ATLAS_MAX_SIZE)
+		{
+			texture.pixels.swap(pixels);
+			small.push_back(texture);
+			continue;
+		}
+
+		Convert(texture, pixels);
+		packed.push_back(texture);
+	}
+
+	BuildAtlas(small, packed);
+
+	std::sort(packed.begin(), packed.end(), SortByName);
+
+	// Pages are referred to by their position in the index
+	for (size_t i = 0; i < packed.size(); i++)
+	{
+		if (packed[i].strPage.empty())
+			continue;
+
+		for (size_t j = 0; j < packed.size(); j++)
+		{
+			if (packed[j].strName == packed[i].strPage)
+				packed[i].iPage = j;
+		}
+	}
+
+	static const char* strFormats[] = { "argb", "dxt1", "dxt5" };
+	unsigned int iBundleSize = 0;
+
+	for (size_t i = 0; i < packed.size(); i++)
+	{
+		const Texture& texture = packed[i];
+
+		if (texture.iFlags & TEXTUREBUNDLE_FLAG_ATLAS)
+		{
+			printf("  %-40s %4ux%-4u in %s at %u,%u\n", texture.strName.c_str(), texture.iWidth, texture.iHeight,
+				texture.strPage.c_str(), texture.iX, texture.iY);
+			continue;
+		}
+
+		printf("  %-40s %4ux%-4u %s%s %7u bytes\n", texture.strName.c_str(), texture.iWidth, texture.iHeight,
+			strFormats[texture.iFormat], texture.iFlags & TEXTUREBUNDLE_FLAG_TILED ? " tiled" : "      ", (unsigned int)texture.data.size());
+
+		iBundleSize += texture.data.size();
+	}
+
+	if (!WriteBundle(strOutput, packed))
+		return 1;
+
+	printf("Packed %u texture(s) from %u KB of files into %u KB of texture data\n",
+		(unsigned int)packed.size(), iFileSize / 1024, iBundleSize / 1024);
+
+	return 0;
+}
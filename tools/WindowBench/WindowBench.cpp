@@ -0,0 +1,259 @@
+/*
+ * WindowBench - times the control lookups of CGUIWindow against the scans
+ * of m_vecControls they replaced, on windows with many controls.
+ *
+ *   WindowBench [-lookups <n>] [<controls> ...]
+ *
+ * For each window size it times finding a control by id, finding the
+ * controls a message goes to, and asking for the focused control, once
+ * with the last control focused and once with nothing focused. Every answer
+ * is checked against the scan, and so is focus that moved without the
+ * window being told. The exit code is 1 when an answer is wrong.
+ */
+
+#include "ControlLookup.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <vector>
+
+// Just what CControlLookup asks of CGUIControl
+class CBenchControl
+{
+public:
+	CBenchControl(int id) { m_id = id; m_bHasFocus = false; }
+
+	int GetID() const { return m_id; }
+	bool HasFocus() const { return m_bHasFocus; }
+
+	void SetFocus(bool bOnOff)
+	{
+		if (bOnOff && !m_bHasFocus)
+			m_focusChanges++;
+		m_bHasFocus = bOnOff;
+	}
+
+	static unsigned int GetFocusChanges() { return m_focusChanges; }
+
+private:
+	int m_id;
+	bool m_bHasFocus;
+
+	static unsigned int m_focusChanges;
+};
+
+unsigned int CBenchControl::m_focusChanges = 0;
+
+typedef CControlLookup<CBenchControl> LOOKUPCONTROLS;
+
+struct BenchWindow
+{
+	std::vector<CBenchControl*> controls;
+	LOOKUPCONTROLS lookup;
+};
+
+static bool g_bOk = true;
+
+static void Check(bool bCondition, int iControls, const char* strWhat)
+{
+	if (!bCondition)
+	{
+		printf("FAILED: %i control(s), %s\n", iControls, strWhat);
+		g_bOk = false;
+	}
+}
+
+// What CGUIWindow did before
+static CBenchControl* ScanControl(const BenchWindow& window, int id)
+{
+	for (unsigned int i = 0; i < window.controls.size(); i++)
+	{
+		if (window.controls[i]->GetID() == id)
+			return window.controls[i];
+	}
+	return NULL;
+}
+
+static int ScanMatches(const BenchWindow& window, int id)
+{
+	int iMatches = 0;
+	for (unsigned int i = 0; i < window.controls.size(); i++)
+	{
+		if (window.controls[i]->GetID() == id)
+			iMatches++;
+	}
+	return iMatches;
+}
+
+static CBenchControl* ScanFocused(const BenchWindow& window)
+{
+	for (unsigned int i = 0; i < window.controls.size(); i++)
+	{
+		if (window.controls[i]->HasFocus())
+			return window.controls[i];
+	}
+	return NULL;
+}
+
+static int LookupMatches(BenchWindow& window, int id)
+{
+	int iMatches = 0;
+	std::pair<LOOKUPCONTROLS::iterator, LOOKUPCONTROLS::iterator> range = window.lookup.Find(id);
+	for (LOOKUPCONTROLS::iterator i = range.first; i != range.second; ++i)
+		iMatches++;
+	return iMatches;
+}
+
+static double Elapsed(clock_t start, unsigned int iLookups)
+{
+	return (double)(clock() - start) * 1e9 / CLOCKS_PER_SEC / iLookups;
+}
+
+static void Bench(int iControls, unsigned int iLookups)
+{
+	// Ids like a skin has them, some shared by a label and its button
+	BenchWindow window;
+	for (int i = 0; i < iControls; i++)
+	{
+		CBenchControl* control = new CBenchControl(i % 7 == 6 ? i - 1 : i);
+		window.controls.push_back(control);
+		window.lookup.Add(control);
+	}
+
+	// Ids of every control and some no control has, in a random order
+	std::vector<int> ids(4096);
+	srand(iControls);
+	for (unsigned int i = 0; i < ids.size(); i++)
+		ids[i] = rand() % (iControls + iControls / 8);
+
+	for (unsigned int i = 0; i < ids.size(); i++)
+	{
+		Check(window.lookup.Get(ids[i]) == ScanControl(window, ids[i]), iControls, "wrong control for an id");
+		Check(LookupMatches(window, ids[i]) == ScanMatches(window, ids[i]), iControls, "wrong controls for a message");
+	}
+
+	volatile int iSink = 0;
+	clock_t start;
+
+	start = clock();
+	for (unsigned int i = 0; i < iLookups; i++)
+		iSink += ScanControl(window, ids[i & 4095]) != NULL;
+	double fScanControl = Elapsed(start, iLookups);
+
+	start = clock();
+	for (unsigned int i = 0; i < iLookups; i++)
+		iSink += window.lookup.Get(ids[i & 4095]) != NULL;
+	double fLookupControl = Elapsed(start, iLookups);
+
+	start = clock();
+	for (unsigned int i = 0; i < iLookups; i++)
+		iSink += ScanMatches(window, ids[i & 4095]);
+	double fScanMessage = Elapsed(start, iLookups);
+
+	start = clock();
+	for (unsigned int i = 0; i < iLookups; i++)
+		iSink += LookupMatches(window, ids[i & 4095]);
+	double fLookupMessage = Elapsed(start, iLookups);
+
+	// Focus on the last control is the worst case of the scan
+	CBenchControl* last = window.controls.back();
+	last->SetFocus(true);
+	window.lookup.SetFocused(last);
+
+	start = clock();
+	for (unsigned int i = 0; i < iLookups; i++)
+		iSink += ScanFocused(window) != NULL;
+	double fScanFocus = Elapsed(start, iLookups);
+
+	start = clock();
+	for (unsigned int i = 0; i < iLookups; i++)
+		iSink += window.lookup.GetFocused(window.controls) != NULL;
+	double fLookupFocus = Elapsed(start, iLookups);
+
+	Check(window.lookup.GetFocused(window.controls) == last, iControls, "lost the focused control");
+
+	// Nothing focused, what a window shows while a dialog has the focus
+	last->SetFocus(false);
+	Check(window.lookup.GetFocused(window.controls) == NULL, iControls, "a control without focus returned");
+
+	start = clock();
+	for (unsigned int i = 0; i < iLookups; i++)
+		iSink += ScanFocused(window) != NULL;
+	double fScanNoFocus = Elapsed(start, iLookups);
+
+	start = clock();
+	for (unsigned int i = 0; i < iLookups; i++)
+		iSink += window.lookup.GetFocused(window.controls) != NULL;
+	double fLookupNoFocus = Elapsed(start, iLookups);
+
+	// Focus taken without the window being told has to be found
+	CBenchControl* middle = window.controls[iControls / 2];
+	middle->SetFocus(true);
+	Check(window.lookup.GetFocused(window.controls) == middle, iControls, "missed focus taken behind the window's back");
+
+	// And moved on the same way
+	middle->SetFocus(false);
+	window.controls[0]->SetFocus(true);
+	Check(window.lookup.GetFocused(window.controls) == window.controls[0], iControls, "missed focus moving behind the window's back");
+
+	// A removed control is never returned, even with focus
+	CBenchControl* first = window.controls[0];
+	window.controls.erase(window.controls.begin());
+	window.lookup.Remove(first);
+	Check(window.lookup.GetFocused(window.controls) == NULL, iControls, "returned a removed control");
+	delete first;
+
+	printf("%6i control(s), ns per lookup, scan / lookup:\n", iControls);
+	printf("    control by id    %9.1f / %6.1f\n", fScanControl, fLookupControl);
+	printf("    message targets  %9.1f / %6.1f\n", fScanMessage, fLookupMessage);
+	printf("    focused control  %9.1f / %6.1f\n", fScanFocus, fLookupFocus);
+	printf("    nothing focused  %9.1f / %6.1f\n", fScanNoFocus, fLookupNoFocus);
+
+	for (unsigned int i = 0; i < window.controls.size(); i++)
+		delete window.controls[i];
+}
+
+static void Usage()
+{
+	printf("Usage: WindowBench [-lookups <n>] [<controls> ...]\n");
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned int iLookups = 200000;
+	std::vector<int> sizes;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-lookups") == 0 && i + 1 < argc)
+			iLookups = (unsigned int)atoi(argv[++i]);
+		else if (argv[i][0] != '-' && atoi(argv[i]) > 0)
+			sizes.push_back(atoi(argv[i]));
+		else
+		{
+			Usage();
+			return 1;
+		}
+	}
+
+	if (iLookups < 1)
+	{
+		Usage();
+		return 1;
+	}
+
+	if (sizes.empty())
+	{
+		sizes.push_back(100);
+		sizes.push_back(2000);
+		sizes.push_back(10000);
+	}
+
+	for (unsigned int i = 0; i < sizes.size(); i++)
+		Bench(sizes[i], iLookups);
+
+	return g_bOk ? 0 : 1;
+}
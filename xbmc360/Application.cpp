@@ -7,8 +7,20 @@
 #include "guilib\GUIWindowManager.h"
 #include "cores\VideoRenderers\RenderManager.h"
 #include "guilib\GUIFontManager.h"
+#include "guilib\ShaderManager.h"
+#include "guilib\SpriteBatch.h"
+#include "guilib\DirtyRegions.h"
+#include "guilib\GUISkinCache.h"
+#include "guilib\GUIWindowRetention.h"
+#include "guilib\GUIWindowLoader.h"
+#include "guilib\SkinInfo.h"
+#include "FramePacer.h"
 #include "guilib\GUIInfoManager.h"
 #include "cores\DVDPlayer\DVDPlayer.h"
+#include "cores\DVDPlayer\DVDMediaProbe.h"
+#include "cores\DVDPlayer\DVDDemuxers\DVDFormatCache.h"
+#include "cores\DVDPlayer\DVDCodecs\DVDCodecUtils.h"
+#include "VideoThumbLoader.h"
 #include "guilib\LocalizeStrings.h"
 #include "Settings.h"
 #include "filesystem\File.h"
@@ -153,6 +165,25 @@ bool CApplication::Initialize()
 {
 	g_windowManager.Add(new CGUIWindowHome); // window id = 0
 
+	g_TextureManager.SetBudget(g_guiSettings.GetInt("TextureCache.Budget") * 1024 * 1024);
+	g_TextureManager.StartLoader();
+
+	// Drawing only the changed part relies on the back buffer still holding the last frame
+	int iDirtyRegions = g_guiSettings.GetInt("GUI.DirtyRegions");
+	if (iDirtyRegions == DIRTYREGIONS_PARTIAL && m_d3dpp.SwapEffect == D3DSWAPEFFECT_DISCARD)
+	{
+		CLog::Log(LOGWARNING, "GUI.DirtyRegions: the back buffer is discarded on present, skipping unchanged frames instead of redrawing changed parts");
+		iDirtyRegions = DIRTYREGIONS_SKIP;
+	}
+	g_dirtyRegions.SetMode(iDirtyRegions);
+	g_dirtyRegions.SetShowRegions(g_guiSettings.GetInt("GUI.ShowDirtyRegions") != 0);
+
+	g_windowRetention.SetBudget(g_guiSettings.GetInt("GUI.WindowRetentionBudget") * 1024 * 1024);
+	g_windowRetention.SetRetainTextures(g_guiSettings.GetInt("GUI.RetainWindowTextures") != 0);
+
+	g_windowManager.SetPreload(g_guiSettings.GetInt("GUI.WindowPreload"));
+	g_windowLoader.Start();
+
 	CLog::Log(LOGNOTICE, "load default skin:[%s]", g_guiSettings.GetString("LookAndFeel.Skin").c_str());
 	LoadSkin(g_guiSettings.GetString("LookAndFeel.Skin"));
 
@@ -170,10 +201,19 @@ bool CApplication::Initialize()
 
 	g_windowManager.Initialize();
 
+	// Before the probe workers and the thumb loader, they open codecs concurrently with the player
+	CDVDCodecUtils::InitFFmpeg();
+
+	// Background media info for the file listings
+	g_mediaProbe.Start(g_guiSettings.GetInt("MediaProbe.Workers"), g_guiSettings.GetInt("MediaProbe.ProbeSize") * 1024);
+	g_videoThumbLoader.Start();
+
 	m_slowTimer.StartZero();
 
 	g_windowManager.ActivateWindow(WINDOW_HOME);
 
+	g_shaderManager.LogStats("startup");
+
 	if (m_splash)
 		m_splash->Stop();
 
@@ -222,6 +262,7 @@ void CApplication::LoadSkin(const CStdString& strSkin)
 	UnloadSkin();	
 
 	g_graphicsContext.SetMediaDir(strSkinPath);
+	g_SkinInfo.Load(strSkinPath);
 
 	CLog::Log(LOGINFO, "Load fonts for skin...");
 
@@ -263,6 +304,7 @@ void CApplication::UnloadSkin()
 	g_TextureManager.Cleanup();
 	g_fontManager.Clear();
 	g_audioManager.Cleanup();
+	g_SkinInfo.Unload();
 }
 
 void CApplication::Process()
@@ -279,7 +321,12 @@ void CApplication::Process()
 	// Process messages, even if a movie is playing
 	g_applicationMessenger.ProcessMessages();
 
-	// Process input actions
+	// Process input actions, anything held keeps the GUI at full rate
+	if (m_DefaultGamepad.wButtons ||
+	    m_DefaultGamepad.bLeftTrigger > XINPUT_GAMEPAD_TRIGGER_THRESHOLD || m_DefaultGamepad.bRightTrigger > XINPUT_GAMEPAD_TRIGGER_THRESHOLD ||
+	    m_DefaultGamepad.sThumbLX || m_DefaultGamepad.sThumbLY || m_DefaultGamepad.sThumbRX || m_DefaultGamepad.sThumbRY)
+		g_framePacer.OnInput();
+
 	ProcessGamepad();
 
 	// Do any processing that isn't needed on each run
@@ -471,6 +518,9 @@ bool CApplication::OnMessage(CGUIMessage& message)
 				m_pPlayer = NULL;
 			}
 
+			g_mediaProbe.Pause(false);
+			g_videoThumbLoader.Pause(false);
+
 			if (!IsPlayingVideo() && g_windowManager.GetActiveWindow() == WINDOW_FULLSCREEN_VIDEO)
 			{
 				g_windowManager.PreviousWindow();
@@ -498,6 +548,13 @@ void CApplication::Render()
 	if(!m_pd3dDevice)
 		return;
 
+	// While idle most passes only read input
+	if (!g_framePacer.BeginFrame(IsPlayingVideo()))
+		return;
+
+	// Skin conditions are evaluated once per frame from here on
+	g_infoManager.BeginFrame();
+
 	// Don't do anything that would require graphiccontext to be locked before here in fullscreen.
 	// that stuff should go into renderfullscreen instead as that is called from the rendering thread
 
@@ -506,11 +563,15 @@ void CApplication::Render()
 	{
 		if (g_graphicsContext.IsFullScreenVideo())
 		{
+			// The back buffer holds video now, not the last GUI frame
+			g_dirtyRegions.MarkAllDirty();
+
 			if (m_pPlayer)
 			{
 				if (m_pPlayer->IsPaused())
 				{
 					g_graphicsContext.Lock();
+					g_TextureManager.ProcessUploads(TEXTURE_UPLOAD_TIMESLICE);
 					m_pd3dDevice->BeginScene();  
 					g_graphicsContext.Unlock();
 					g_windowManager.Render();
@@ -519,13 +580,21 @@ void CApplication::Render()
 					g_graphicsContext.Lock();
 					RenderFullScreen();
 //					m_pd3dDevice->BlockUntilVerticalBlank(); //TODO
+					// Always a full redraw here, but the regions the controls marked have to go
+					g_dirtyRegions.EndFrame();
+					g_spriteBatch.EndFrame();
+					g_TextureManager.EndFrame();
 					m_pd3dDevice->EndScene();
+					g_framePacer.BeginWait();
 					m_pd3dDevice->Present( NULL, NULL, NULL, NULL );
+					g_framePacer.EndWait();
 					g_graphicsContext.Unlock();
+					g_framePacer.EndFrame(true);
 					return;
 				}
 			}
-			Sleep(10);
+			// The player's render thread draws, we only keep reading input
+			g_framePacer.Wait(FRAMEPACER_POLL_TIME);
 			return;
 		}
 	}
@@ -541,6 +610,8 @@ void CApplication::Render()
 	}
 
 	g_graphicsContext.Lock();
+	// Create the textures read in the background since the last frame
+	g_TextureManager.ProcessUploads(TEXTURE_UPLOAD_TIMESLICE);
 	m_pd3dDevice->BeginScene();  
 	g_graphicsContext.Unlock();
 
@@ -556,11 +627,22 @@ void CApplication::Render()
 	g_windowManager.RenderDialogs();
 
 	g_graphicsContext.Lock();
+	bool bChanged = g_dirtyRegions.EndFrame();
+	g_spriteBatch.EndFrame();
+	g_TextureManager.EndFrame();
 	m_pd3dDevice->EndScene();
 
-	// Present the backbuffer contents to the display
-	m_pd3dDevice->Present( NULL, NULL, NULL, NULL );
+	// Present the backbuffer contents to the display, when nothing changed
+	// the last frame stays on screen and we only wait for the next one
+	g_framePacer.BeginWait();
+	if (bChanged)
+		m_pd3dDevice->Present( NULL, NULL, NULL, NULL );
+	else
+		m_pd3dDevice->BlockUntilVerticalBlank();
+	g_framePacer.EndWait();
 	g_graphicsContext.Unlock();
+
+	g_framePacer.EndFrame(bChanged);
 }
 
 bool CApplication::NeedRenderFullScreen()
@@ -659,6 +741,10 @@ bool CApplication::PlayFile(const string strFile)
 	// Tell system we are starting a file
 	m_bPlaybackStarting = true;
 
+	// Keep the disk for the player
+	g_mediaProbe.Pause(true);
+	g_videoThumbLoader.Pause(true);
+
 	if (m_pPlayer)
 	{
 		// We should restart the player
@@ -906,6 +992,12 @@ void CApplication::Stop()
 	m_bStop = true;
 	CLog::Log(LOGNOTICE, "Stop all");
 
+	CLog::Log(LOGNOTICE, "Stopping media probe");
+	g_mediaProbe.Stop();
+	g_videoThumbLoader.Stop();
+	g_TextureManager.StopLoader();
+	g_windowLoader.Stop();
+
 	if (m_pPlayer)
 	{
 		CLog::Log(LOGNOTICE, "Stopping DVDPlayer");
@@ -914,9 +1006,22 @@ void CApplication::Stop()
 		m_pPlayer = NULL;
 	}
 
+	g_formatCache.Save();
+
 	CLog::Log(LOGNOTICE, "Unload skin");
 	UnloadSkin();
 
+	g_framePacer.Reset();
+	g_dirtyRegions.Reset();
+	g_skinCache.Reset();
+	g_windowRetention.Reset();
+	g_windowLoader.Reset();
+	g_infoManager.ResetStats();
+	g_windowManager.ResetThreadMessageStats();
+	g_applicationMessenger.ResetStats();
+	g_spriteBatch.Release();
+	g_shaderManager.Cleanup();
+
 	// Windows
 	g_windowManager.Delete(WINDOW_HOME);
 	g_windowManager.Delete(WINDOW_FULLSCREEN_VIDEO);
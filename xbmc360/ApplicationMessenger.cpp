@@ -21,11 +21,18 @@
 #include "ApplicationMessenger.h"
 #include "Application.h"
 #include "xbox\XBKernalExports.h"
+#include "utils\Log.h"
 
 using namespace std;
 
 CApplicationMessenger g_applicationMessenger;
 
+CApplicationMessenger::CApplicationMessenger()
+	: m_messages(APPMESSAGES_SIZE, ThreadMessage())
+{
+	m_iOverflowed = 0;
+}
+
 CApplicationMessenger::~CApplicationMessenger()
 {
 	Cleanup();
@@ -33,40 +40,45 @@ CApplicationMessenger::~CApplicationMessenger()
 
 void CApplicationMessenger::Cleanup()
 {
-	CSingleLock lock (m_critSection);
-
-	while (m_vecMessages.size() > 0)
+	ThreadMessage msg;
+	while (m_messages.Pop(msg))
 	{
-		ThreadMessage* pMsg = m_vecMessages.front();
-
-		if (pMsg->hWaitEvent)
-			SetEvent(pMsg->hWaitEvent);
+		if (msg.hWaitEvent)
+			SetEvent(msg.hWaitEvent);
+	}
 
-		delete pMsg;
-			m_vecMessages.pop();
+	CSingleLock lock(m_critSection);
+	for (unsigned int i = 0; i < m_overflow.size(); i++)
+	{
+		if (m_overflow[i].hWaitEvent)
+			SetEvent(m_overflow[i].hWaitEvent);
 	}
+	m_overflow.clear();
 }
 
 void CApplicationMessenger::SendMessage(ThreadMessage& message, bool wait)
 {
-	ThreadMessage* msg = new ThreadMessage();
-	msg->dwMessage = message.dwMessage;
-	msg->dwParam1 = message.dwParam1;
-	msg->dwParam2 = message.dwParam2;
-	msg->hWaitEvent = message.hWaitEvent;
-	msg->lpVoid = message.lpVoid;
-	msg->strParam = message.strParam;
-
-	CSingleLock lock (m_critSection);
-
 /*	if (msg->dwMessage == TMSG_DIALOG_DOMODAL ||
       msg->dwMessage == TMSG_WRITE_SCRIPT_OUTPUT)
 	{
 		m_vecWindowMessages.push_back(msg);
 	}
-	else*/ m_vecMessages.push(msg);
+	else*/
+	if (!m_messages.Push(message))
+	{
+		if (!IsControlMessage(message.dwMessage))
+		{
+			// Nobody would ever set the event of a dropped message
+			CLog::Log(LOGERROR, "CApplicationMessenger: %u messages waiting, dropping message %u", m_messages.GetDepth(), message.dwMessage);
+			return;
+		}
 
-	lock.Leave();
+		// Waiting for room could hang when the application thread sends it
+		CLog::Log(LOGWARNING, "CApplicationMessenger: %u messages waiting, queueing message %u beside them", m_messages.GetDepth(), message.dwMessage);
+		CSingleLock lock(m_critSection);
+		m_overflow.push_back(message);
+		m_iOverflowed++;
+	}
 
 	if (message.hWaitEvent)
 	{
@@ -76,26 +88,27 @@ void CApplicationMessenger::SendMessage(ThreadMessage& message, bool wait)
 
 void CApplicationMessenger::ProcessMessages()
 {
-	// Process threadmessages
-	CSingleLock lock (m_critSection);
-
-	while (m_vecMessages.size() > 0)
+	// Process threadmessages, each is taken off the ring before it's processed,
+	// so a message that makes this thread process messages again isn't seen twice
+	ThreadMessage msg;
+	while (m_messages.Pop(msg))
 	{
-		ThreadMessage* pMsg = m_vecMessages.front();
-		// First remove the message from the queue, else the message could be processed more then once
-		m_vecMessages.pop();
-
-		// Leave here as the message might make another
-		// thread call processmessages or sendmessage
-		lock.Leave();
-
-		ProcessMessage(pMsg);
-		if (pMsg->hWaitEvent)
-			SetEvent(pMsg->hWaitEvent);
-		delete pMsg;
+		ProcessMessage(&msg);
+		if (msg.hWaitEvent)
+			SetEvent(msg.hWaitEvent);
+	}
 
-		// Reenter here again, to not ruin message vector
-		lock.Enter();
+	// Control messages that didn't fit go last, they were sent after the ring filled up
+	std::vector<ThreadMessage> overflow;
+	{
+		CSingleLock lock(m_critSection);
+		overflow.swap(m_overflow);
+	}
+	for (unsigned int i = 0; i < overflow.size(); i++)
+	{
+		ProcessMessage(&overflow[i]);
+		if (overflow[i].hWaitEvent)
+			SetEvent(overflow[i].hWaitEvent);
 	}
 }
 
@@ -125,6 +138,40 @@ void CApplicationMessenger::ProcessMessage(ThreadMessage *pMsg)
 	}
 }
 
+// Messages that end the application
+bool CApplicationMessenger::IsControlMessage(DWORD dwMessage)
+{
+	switch (dwMessage)
+	{
+		case TMSG_SHUTDOWN:
+		case TMSG_POWERDOWN:
+		case TMSG_REBOOT:
+			return true;
+	}
+	return false;
+}
+
+void CApplicationMessenger::GetStats(MessageRingStats& stats) const
+{
+	m_messages.GetStats(stats);
+}
+
+void CApplicationMessenger::ResetStats()
+{
+	MessageRingStats stats;
+	GetStats(stats);
+	if (stats.iPushed || stats.iDropped)
+	{
+		CLog::Log(LOGNOTICE, "CApplicationMessenger: %u message(s), %u dropped, at most %u waiting, processed after avg %.2f ms, max %.2f ms",
+			stats.iPushed, stats.iDropped - m_iOverflowed, stats.iMaxDepth, stats.fLatency, stats.fMaxLatency);
+	}
+	if (m_iOverflowed)
+		CLog::Log(LOGNOTICE, "CApplicationMessenger: %u control message(s) found the ring full", m_iOverflowed);
+
+	m_messages.ResetStats();
+	m_iOverflowed = 0;
+}
+
 void CApplicationMessenger::Shutdown()
 {
 	ThreadMessage tMsg = {TMSG_SHUTDOWN};
@@ -23,13 +23,16 @@
 #include "utils\StdString.h"
 #include "utils\Stdafx.h"
 #include "utils\SingleLock.h"
-#include <queue>
+#include "utils\MessageRing.h"
 
 // Defines here
 #define TMSG_SHUTDOWN             300
 #define TMSG_POWERDOWN            301
 #define TMSG_REBOOT               306
 
+// Messages other threads may have waiting for the application thread
+#define APPMESSAGES_SIZE          32
+
 typedef struct
 {
 	DWORD dwMessage;
@@ -45,6 +48,7 @@ ThreadMessage;
 class CApplicationMessenger
 {
 public:
+	CApplicationMessenger();
 	~CApplicationMessenger();
 
 	void Cleanup();
@@ -55,11 +59,21 @@ public:
 	void Shutdown();
 	void Reboot();
 
+	void GetStats(MessageRingStats& stats) const;
+
+	// Logs and clears the stats
+	void ResetStats();
+
 private:
 	void ProcessMessage(ThreadMessage *pMsg);
+	static bool IsControlMessage(DWORD dwMessage);
+
+	CMessageRing<ThreadMessage> m_messages;
 
+	// Control messages that found the ring full, they must never be dropped
+	std::vector<ThreadMessage> m_overflow;
+	unsigned int m_iOverflowed;   // counted as dropped by the ring as well
 	CCriticalSection m_critSection;
-	std::queue<ThreadMessage*> m_vecMessages;
 };
 
 extern CApplicationMessenger g_applicationMessenger;
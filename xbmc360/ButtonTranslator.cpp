@@ -123,6 +123,8 @@ bool CButtonTranslator::TranslateActionString(const char *szAction, int &iAction
 	else if (strAction.Equals("right")) iAction = ACTION_MOVE_RIGHT;
 	else if (strAction.Equals("up")) iAction = ACTION_MOVE_UP;
 	else if (strAction.Equals("down")) iAction = ACTION_MOVE_DOWN;
+	else if (strAction.Equals("pageup")) iAction = ACTION_PAGE_UP;
+	else if (strAction.Equals("pagedown")) iAction = ACTION_PAGE_DOWN;
 	else if (strAction.Equals("select")) iAction = ACTION_SELECT_ITEM;
 	else if (strAction.Equals("previousmenu")) iAction = ACTION_PREVIOUS_MENU;
 
@@ -40,6 +40,11 @@ CFileItem* CFileItemList::Get(int iItem)
 	return m_items[iItem];
 }
 
+void CFileItemList::Reserve(int iItems)
+{
+	m_items.reserve(iItems);
+}
+
 void CFileItemList::Add(CFileItem* pItem)
 {
 	m_items.push_back(pItem);
@@ -52,16 +57,10 @@ int CFileItemList::Size() const
 
 void CFileItemList::Clear()
 {
-	if (m_items.size())
-	{
-		IVECFILEITEMS i;
-		i = m_items.begin();
-		while (i != m_items.end())
-		{
-			CFileItem* pItem = *i;
-			delete pItem;
-			i = m_items.erase(i);
-		}
-		m_map.clear();
-	}
+	// Erasing one by one from the front would move the rest every time
+	for (IVECFILEITEMS i = m_items.begin(); i != m_items.end(); ++i)
+		delete *i;
+
+	m_items.clear();
+	m_map.clear();
 }
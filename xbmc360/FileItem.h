@@ -13,6 +13,7 @@ public:
 	~CFileItem();
 
 	void SetPath(CStdString strPath) { m_strPath = strPath; };
+	const CStdString& GetPath() const { return m_strPath; };
 
 private:
 	CStdString m_strPath;
@@ -53,6 +54,7 @@ public:
 
 	void Clear();
 	CFileItem* Get(int iItem);
+	void Reserve(int iItems);
 	void Add(CFileItem* pItem);
 	int Size() const;
 
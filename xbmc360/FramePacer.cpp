@@ -0,0 +1,173 @@
+#include "FramePacer.h"
+#include "guilib\SpriteBatch.h"
+#include "guilib\DirtyRegions.h"
+#include "utils\Log.h"
+
+CFramePacer g_framePacer;
+
+static __int64 Now()
+{
+	LARGE_INTEGER now;
+	QueryPerformanceCounter(&now);
+	return now.QuadPart;
+}
+
+CFramePacer::CFramePacer(void)
+{
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	m_iFrequency = frequency.QuadPart;
+
+	m_state = PACING_ACTIVE;
+	memset(m_totals, 0, sizeof(m_totals));
+
+	m_iLastAccount = Now();
+	m_iWaited = 0;
+	m_iWaitStart = 0;
+
+	// Start at full rate, the first windows are still fading in
+	m_iLastActive = m_iLastAccount;
+	m_iLastFrame = 0;
+	m_iChangedInRow = 0;
+}
+
+CFramePacer::~CFramePacer(void)
+{
+}
+
+void CFramePacer::OnInput()
+{
+	m_iLastActive = Now();
+}
+
+bool CFramePacer::BeginFrame(bool bVideo)
+{
+	__int64 iNow = Now();
+	Account(iNow);
+
+	PacingState state;
+	if (bVideo)
+		state = PACING_VIDEO;
+	else if (iNow - m_iLastActive < ToTicks(FRAMEPACER_ACTIVE_HOLD))
+		state = PACING_ACTIVE;
+	else
+		state = PACING_IDLE;
+
+	if (state != m_state)
+	{
+		CLog::Log(LOGDEBUG, "CFramePacer: %s -> %s", GetStateName(m_state), GetStateName(state));
+		m_state = state;
+	}
+
+	if (m_state == PACING_IDLE && iNow - m_iLastFrame < ToTicks(FRAMEPACER_IDLE_INTERVAL))
+	{
+		Wait(FRAMEPACER_POLL_TIME);
+		return false;
+	}
+
+	m_iLastFrame = iNow;
+	return true;
+}
+
+void CFramePacer::EndFrame(bool bChanged)
+{
+	StateTotals& totals = m_totals[m_state];
+	totals.iFrames++;
+	totals.iDrawCalls += g_spriteBatch.GetDrawCalls();
+	totals.iQuads += g_spriteBatch.GetQuads();
+	totals.fRedrawArea += g_dirtyRegions.GetRedrawArea();
+	if (bChanged)
+		totals.iPresents++;
+
+	// Changing in consecutive frames is an animation, a label ticking over once isn't
+	m_iChangedInRow = bChanged ? m_iChangedInRow + 1 : 0;
+	if (m_iChangedInRow >= 2)
+		m_iLastActive = Now();
+}
+
+void CFramePacer::BeginWait()
+{
+	m_iWaitStart = Now();
+}
+
+void CFramePacer::EndWait()
+{
+	m_iWaited += Now() - m_iWaitStart;
+}
+
+void CFramePacer::Wait(DWORD dwMilliseconds)
+{
+	BeginWait();
+	Sleep(dwMilliseconds);
+	EndWait();
+}
+
+const char* CFramePacer::GetStateName(PacingState state)
+{
+	switch (state)
+	{
+		case PACING_ACTIVE:
+			return "active";
+		case PACING_IDLE:
+			return "idle";
+		case PACING_VIDEO:
+			return "video";
+	}
+	return "unknown";
+}
+
+void CFramePacer::GetStats(PacingState state, FramePacerStats& stats) const
+{
+	const StateTotals& totals = m_totals[state];
+
+	memset(&stats, 0, sizeof(stats));
+	if (totals.iTime <= 0)
+		return;
+
+	float fSeconds = (float)((double)totals.iTime / m_iFrequency);
+	stats.fSeconds = fSeconds;
+	stats.fCpuUsage = (float)(100.0 * totals.iBusy / totals.iTime);
+	stats.fFramesPerSecond = totals.iFrames / fSeconds;
+	stats.fPresentsPerSecond = totals.iPresents / fSeconds;
+	stats.fDrawCallsPerSecond = (float)(totals.iDrawCalls / fSeconds);
+	stats.fQuadsPerSecond = (float)(totals.iQuads / fSeconds);
+	stats.fRedrawArea = totals.iFrames ? (float)(totals.fRedrawArea / totals.iFrames) : 0.0f;
+}
+
+void CFramePacer::Reset()
+{
+	Account(Now());
+
+	for (int i = 0; i < PACING_STATES; i++)
+	{
+		FramePacerStats stats;
+		GetStats((PacingState)i, stats);
+		if (stats.fSeconds <= 0.0f)
+			continue;
+
+		CLog::Log(LOGNOTICE, "CFramePacer: %s for %.0fs, cpu %.0f%%, %.1f frames/s of which %.1f presented, %.0f draw calls/s, %.0f quads/s, avg %.1f%% of the screen redrawn",
+			GetStateName((PacingState)i), stats.fSeconds, stats.fCpuUsage, stats.fFramesPerSecond, stats.fPresentsPerSecond,
+			stats.fDrawCallsPerSecond, stats.fQuadsPerSecond, stats.fRedrawArea);
+	}
+
+	memset(m_totals, 0, sizeof(m_totals));
+}
+
+// Everything since the last call happened in the current state
+void CFramePacer::Account(__int64 iNow)
+{
+	__int64 iTime = iNow - m_iLastAccount;
+	__int64 iBusy = iTime - m_iWaited;
+
+	StateTotals& totals = m_totals[m_state];
+	totals.iTime += iTime;
+	totals.iBusy += iBusy > 0 ? iBusy : 0;
+
+	m_iLastAccount = iNow;
+	m_iWaited = 0;
+}
+
+__int64 CFramePacer::ToTicks(DWORD dwMilliseconds) const
+{
+	return m_iFrequency * dwMilliseconds / 1000;
+}
@@ -0,0 +1,111 @@
+#ifndef H_CFRAMEPACER
+#define H_CFRAMEPACER
+
+#include "utils\Stdafx.h"
+
+// How the GUI is being drawn
+enum PacingState
+{
+	PACING_ACTIVE = 0, // every vertical blank
+	PACING_IDLE,       // nothing moves and nobody's there, a few times a second
+	PACING_VIDEO,      // video is playing, the player sets the pace
+	PACING_STATES
+};
+
+// Input and continuous changes keep the GUI at full rate for this long, in ms
+#define FRAMEPACER_ACTIVE_HOLD 2000
+
+// Time between GUI frames while idle, in ms
+#define FRAMEPACER_IDLE_INTERVAL 100
+
+// Time slept between input checks when not drawing, in ms
+#define FRAMEPACER_POLL_TIME 10
+
+struct FramePacerStats
+{
+	float fSeconds;            // spent in the state
+	float fCpuUsage;           // percent of that time the main loop was working rather than waiting
+	float fFramesPerSecond;    // GUI frames built
+	float fPresentsPerSecond;  // of those, frames that changed and were drawn
+	float fDrawCallsPerSecond;
+	float fQuadsPerSecond;
+	float fRedrawArea;         // average percent of the screen redrawn per frame
+};
+
+/*!
+ \brief Decides how often the main loop builds a GUI frame.
+
+ While there's input, video or something on screen changing every frame
+ the GUI runs at full rate. Once that stopped for FRAMEPACER_ACTIVE_HOLD
+ the GUI is only looked at every FRAMEPACER_IDLE_INTERVAL, enough for a
+ clock to tick, and the loop sleeps in between. Input is still read every
+ FRAMEPACER_POLL_TIME and switches back to full rate at once.
+
+ Time, CPU and GPU work are accounted to the state they were spent in.
+ */
+class CFramePacer
+{
+public:
+	CFramePacer(void);
+	virtual ~CFramePacer(void);
+
+	// A button is held or a stick is pushed
+	void OnInput();
+
+	/*!
+	 \brief Called by the main loop before it builds a GUI frame.
+	 \param bVideo video is playing, in a window or fullscreen
+	 \return false when no frame is due, the pacer slept for FRAMEPACER_POLL_TIME instead
+	 */
+	bool BeginFrame(bool bVideo);
+
+	// bChanged: the frame was presented, it looked different than the last one
+	void EndFrame(bool bChanged);
+
+	// Time between these is spent waiting for the GPU or the vertical blank, not working
+	void BeginWait();
+	void EndWait();
+
+	// Sleeps without building a frame, counted as waiting
+	void Wait(DWORD dwMilliseconds);
+
+	PacingState GetState() const { return m_state; }
+	static const char* GetStateName(PacingState state);
+
+	void GetStats(PacingState state, FramePacerStats& stats) const;
+
+	// Logs and clears the stats
+	void Reset();
+
+private:
+	struct StateTotals
+	{
+		__int64 iTime;
+		__int64 iBusy;
+		unsigned int iFrames;
+		unsigned int iPresents;
+		unsigned __int64 iDrawCalls;
+		unsigned __int64 iQuads;
+		double fRedrawArea;
+	};
+
+	void Account(__int64 iNow);
+	__int64 ToTicks(DWORD dwMilliseconds) const;
+
+	PacingState m_state;
+	StateTotals m_totals[PACING_STATES];
+
+	__int64 m_iFrequency;
+	__int64 m_iLastAccount;
+	__int64 m_iWaited;         // since the last Account()
+	__int64 m_iWaitStart;
+
+	__int64 m_iLastInput;
+	__int64 m_iLastActive;     // input or continuous change
+	__int64 m_iLastFrame;
+	unsigned int m_iChangedInRow;
+};
+
+extern CFramePacer g_framePacer;
+
+#endif //H_CFRAMEPACER
@@ -75,6 +75,16 @@ CGUISettings::CGUISettings()
 	AddCategory(7, "ScreenSaver", 360);
 	AddString(1, "ScreenSaver.Mode", 356, "Dim", SPIN_CONTROL_TEXT);
 	AddInt(2, "ScreenSaver.Time", 355, 3, 1, 1, 60, SPIN_CONTROL_INT_PLUS); //TODO
+
+	// Hidden settings (negative order), only changeable through settings.xml
+	AddInt(-1, "MediaProbe.Workers", 0, 1, 1, 1, 4, SPIN_CONTROL_INT_PLUS);
+	AddInt(-1, "MediaProbe.ProbeSize", 0, 512, 32, 32, 4096, SPIN_CONTROL_INT_PLUS); // KB per file
+	AddInt(-1, "TextureCache.Budget", 0, 64, 0, 8, 512, SPIN_CONTROL_INT_PLUS); // MB of unused textures kept
+	AddInt(-1, "GUI.DirtyRegions", 0, 1, 0, 1, 2, SPIN_CONTROL_INT_PLUS); // 0 redraw all, 1 skip unchanged frames, 2 redraw changed part (needs a kept back buffer)
+	AddInt(-1, "GUI.ShowDirtyRegions", 0, 0, 0, 1, 1, SPIN_CONTROL_INT_PLUS); // outline what is redrawn
+	AddInt(-1, "GUI.WindowRetentionBudget", 0, 8, 0, 1, 64, SPIN_CONTROL_INT_PLUS); // MB closed windows may keep loaded
+	AddInt(-1, "GUI.RetainWindowTextures", 0, 0, 0, 1, 1, SPIN_CONTROL_INT_PLUS); // closed windows keep their textures too
+	AddInt(-1, "GUI.WindowPreload", 0, 2, 0, 1, 2, SPIN_CONTROL_INT_PLUS); // 0 off, 1 read windows in the background, 2 also the ones the focused button opens
 }
 
 CGUISettings::~CGUISettings()
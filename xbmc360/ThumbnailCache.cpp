@@ -0,0 +1,127 @@
+#include "ThumbnailCache.h"
+#include "filesystem\File.h"
+#include "utils\Log.h"
+#include "utils\Fnv.h"
+
+CStdString CThumbnailCache::GetVideoThumb(const CStdString& strPath)
+{
+	CStdString strThumb;
+	strThumb.Format("%s%08x%s", THUMB_VIDEO_PATH, Hash(strPath), THUMB_FILE_EXT);
+	return strThumb;
+}
+
+bool CThumbnailCache::HasVideoThumb(const CStdString& strPath)
+{
+	return XFILE::CFile::Exists(GetVideoThumb(strPath));
+}
+
+bool CThumbnailCache::IsThumbFile(const CStdString& strPath)
+{
+	return strPath.Right(strlen(THUMB_FILE_EXT)).CompareNoCase(THUMB_FILE_EXT) == 0;
+}
+
+bool CThumbnailCache::Write(const CStdString& strThumb, const BYTE* pData, int iWidth, int iHeight, int iPitch)
+{
+	if (!pData || iWidth <= 0 || iHeight <= 0 || iPitch < iWidth * 4)
+		return false;
+
+	if (!CreateFolder(strThumb))
+	{
+		CLog::Log(LOGERROR, "CThumbnailCache: unable to create folder for %s", strThumb.c_str());
+		return false;
+	}
+
+	// Write to a temp file first so a half written thumb is never picked up
+	CStdString strTemp = strThumb + ".tmp";
+	FILE* fd = fopen(strTemp.c_str(), "wb");
+	if (!fd)
+	{
+		CLog::Log(LOGERROR, "CThumbnailCache: unable to write %s", strTemp.c_str());
+		return false;
+	}
+
+	ThumbFileHeader header;
+	header.dwMagic = THUMB_FILE_MAGIC;
+	header.dwVersion = THUMB_FILE_VERSION;
+	header.dwWidth = iWidth;
+	header.dwHeight = iHeight;
+	header.dwPitch = iWidth * 4; // stored without row padding
+
+	bool bResult = fwrite(&header, sizeof(header), 1, fd) == 1;
+	for (int y = 0; bResult && y < iHeight; y++)
+		bResult = fwrite(pData + y * iPitch, header.dwPitch, 1, fd) == 1;
+
+	fclose(fd);
+
+	if (bResult)
+	{
+		DeleteFile(strThumb.c_str());
+		bResult = MoveFile(strTemp.c_str(), strThumb.c_str()) != FALSE;
+	}
+
+	if (!bResult)
+	{
+		CLog::Log(LOGERROR, "CThumbnailCache: failed writing %s", strThumb.c_str());
+		DeleteFile(strTemp.c_str());
+	}
+
+	return bResult;
+}
+
+bool CThumbnailCache::Read(const CStdString& strThumb, BYTE** pData, int& iWidth, int& iHeight, int& iPitch)
+{
+	*pData = NULL;
+
+	FILE* fd = fopen(strThumb.c_str(), "rb");
+	if (!fd)
+		return false;
+
+	ThumbFileHeader header;
+	if (fread(&header, sizeof(header), 1, fd) != 1 ||
+	    header.dwMagic != THUMB_FILE_MAGIC || header.dwVersion != THUMB_FILE_VERSION ||
+	    header.dwWidth == 0 || header.dwWidth > THUMB_MAX_WIDTH ||
+	    header.dwHeight == 0 || header.dwHeight > THUMB_MAX_HEIGHT ||
+	    header.dwPitch < header.dwWidth * 4)
+	{
+		CLog::Log(LOGWARNING, "CThumbnailCache: %s is not a valid thumb", strThumb.c_str());
+		fclose(fd);
+		return false;
+	}
+
+	DWORD dwSize = header.dwPitch * header.dwHeight;
+	BYTE* pBuffer = new BYTE[dwSize];
+	if (fread(pBuffer, dwSize, 1, fd) != 1)
+	{
+		CLog::Log(LOGWARNING, "CThumbnailCache: %s is truncated", strThumb.c_str());
+		delete[] pBuffer;
+		fclose(fd);
+		return false;
+	}
+	fclose(fd);
+
+	*pData = pBuffer;
+	iWidth = header.dwWidth;
+	iHeight = header.dwHeight;
+	iPitch = header.dwPitch;
+
+	return true;
+}
+
+DWORD CThumbnailCache::Hash(const CStdString& strPath)
+{
+	// Paths on the 360 are case insensitive
+	return CFnv::HashLower(strPath.c_str(), strPath.size());
+}
+
+bool CThumbnailCache::CreateFolder(const CStdString& strPath)
+{
+	// Create every folder along the path, existing ones are fine
+	for (int iPos = strPath.Find('\\', 3); iPos > 0; iPos = strPath.Find('\\', iPos + 1))
+	{
+		CStdString strFolder = strPath.Left(iPos);
+		if (!CreateDirectory(strFolder.c_str(), NULL) && GetLastError() != ERROR_ALREADY_EXISTS)
+			return false;
+	}
+
+	return true;
+}
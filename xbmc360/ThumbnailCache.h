@@ -0,0 +1,48 @@
+#ifndef H_CTHUMBNAILCACHE
+#define H_CTHUMBNAILCACHE
+
+#include "utils\Stdafx.h"
+#include "utils\StdString.h"
+
+// Thumbnails are stored ready for upload as D3DFMT_LIN_A8R8G8B8 textures,
+// the size fits list and thumb views without scaling on the GPU
+#define THUMB_MAX_WIDTH    256
+#define THUMB_MAX_HEIGHT   256
+
+#define THUMB_FILE_MAGIC   0x58544842 // 'XTHB'
+#define THUMB_FILE_VERSION 1
+#define THUMB_FILE_EXT     ".thb"
+
+#define THUMB_VIDEO_PATH   "D:\\thumbnails\\video\\"
+
+// Header of a cached thumbnail, followed by iHeight rows of iPitch bytes
+struct ThumbFileHeader
+{
+	DWORD dwMagic;
+	DWORD dwVersion;
+	DWORD dwWidth;
+	DWORD dwHeight;
+	DWORD dwPitch;
+};
+
+class CThumbnailCache
+{
+public:
+	// Cache file that holds the thumbnail of a video file
+	static CStdString GetVideoThumb(const CStdString& strPath);
+	static bool HasVideoThumb(const CStdString& strPath);
+
+	static bool IsThumbFile(const CStdString& strPath);
+
+	// pData holds 32 bit ARGB pixels in native byte order
+	static bool Write(const CStdString& strThumb, const BYTE* pData, int iWidth, int iHeight, int iPitch);
+
+	// Reads a thumb file, pData is allocated with new[] and must be freed by the caller
+	static bool Read(const CStdString& strThumb, BYTE** pData, int& iWidth, int& iHeight, int& iPitch);
+
+private:
+	static DWORD Hash(const CStdString& strPath);
+	static bool CreateFolder(const CStdString& strPath);
+};
+
+#endif //H_CTHUMBNAILCACHE
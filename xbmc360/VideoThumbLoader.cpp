@@ -0,0 +1,167 @@
+#include "VideoThumbLoader.h"
+#include "ThumbnailCache.h"
+#include "cores\DVDPlayer\DVDFileInfo.h"
+#include "filesystem\File.h"
+#include "guilib\GUIWindowManager.h"
+#include "guilib\GUIUserMessage.h"
+#include "utils\SingleLock.h"
+#include "utils\Log.h"
+
+#include <algorithm>
+
+CVideoThumbLoader g_videoThumbLoader;
+
+CVideoThumbLoader::CVideoThumbLoader()
+{
+	m_bPaused = false;
+	m_iCreated = 0;
+	m_iFailed = 0;
+}
+
+CVideoThumbLoader::~CVideoThumbLoader()
+{
+	Stop();
+}
+
+void CVideoThumbLoader::Start()
+{
+	if (m_ThreadHandle != NULL)
+		return;
+
+	Create();
+}
+
+void CVideoThumbLoader::Stop()
+{
+	CancelAll();
+	StopThread();
+}
+
+void CVideoThumbLoader::Pause(bool bPause)
+{
+	CSingleLock lock(m_critSection);
+	if (m_bPaused == bPause)
+		return;
+
+	m_bPaused = bPause;
+	if (!m_bPaused)
+		m_jobEvent.Set();
+}
+
+CStdString CVideoThumbLoader::Request(const CStdString& strPath, ThumbPriority priority)
+{
+	CStdString strThumb = CThumbnailCache::GetVideoThumb(strPath);
+	if (XFILE::CFile::Exists(strThumb))
+		return strThumb;
+
+	CSingleLock lock(m_critSection);
+
+	// Move the item to the front of the requested queue, newest requests first
+	RemoveFromQueue(m_visible, strPath);
+	RemoveFromQueue(m_background, strPath);
+
+	if (priority == THUMB_PRIORITY_VISIBLE)
+		m_visible.push_front(strPath);
+	else
+		m_background.push_back(strPath);
+
+	m_jobEvent.Set();
+
+	return "";
+}
+
+void CVideoThumbLoader::Cancel(const CStdString& strPath)
+{
+	CSingleLock lock(m_critSection);
+	RemoveFromQueue(m_visible, strPath);
+	RemoveFromQueue(m_background, strPath);
+}
+
+void CVideoThumbLoader::CancelAll()
+{
+	CSingleLock lock(m_critSection);
+	m_visible.clear();
+	m_background.clear();
+}
+
+void CVideoThumbLoader::OnStartup()
+{
+	SetPriority(THREAD_PRIORITY_LOWEST);
+	SetName("CVideoThumbLoader");
+}
+
+void CVideoThumbLoader::Process()
+{
+	while (!m_bStop)
+	{
+		CStdString strPath;
+		if (!GetNextJob(strPath))
+		{
+			m_jobEvent.WaitMSec(500);
+			continue;
+		}
+
+		// Made meanwhile by an earlier request for the same item
+		CStdString strThumb = CThumbnailCache::GetVideoThumb(strPath);
+		if (XFILE::CFile::Exists(strThumb))
+		{
+			OnThumbLoaded(strPath, strThumb);
+			continue;
+		}
+
+		if (CDVDFileInfo::ExtractThumb(strPath, strThumb))
+		{
+			m_iCreated++;
+			OnThumbLoaded(strPath, strThumb);
+		}
+		else
+			m_iFailed++;
+	}
+}
+
+void CVideoThumbLoader::OnThumbLoaded(const CStdString& strPath, const CStdString& strThumb)
+{
+	CGUIMessage msg(GUI_MSG_THUMB_LOADED, 0, 0);
+	msg.SetStringParam(strPath);
+	msg.SetLabel(strThumb);
+	g_windowManager.SendThreadMessage(msg);
+}
+
+void CVideoThumbLoader::OnExit()
+{
+	CLog::Log(LOGNOTICE, "CVideoThumbLoader: created %u thumb(s), %u failed", m_iCreated, m_iFailed);
+}
+
+bool CVideoThumbLoader::GetNextJob(CStdString& strPath)
+{
+	CSingleLock lock(m_critSection);
+
+	if (m_bPaused)
+		return false;
+
+	if (!m_visible.empty())
+	{
+		strPath = m_visible.front();
+		m_visible.pop_front();
+		return true;
+	}
+
+	if (!m_background.empty())
+	{
+		strPath = m_background.front();
+		m_background.pop_front();
+		return true;
+	}
+
+	return false;
+}
+
+bool CVideoThumbLoader::RemoveFromQueue(std::deque<CStdString>& queue, const CStdString& strPath)
+{
+	std::deque<CStdString>::iterator it = std::find(queue.begin(), queue.end(), strPath);
+	if (it == queue.end())
+		return false;
+
+	queue.erase(it);
+	return true;
+}
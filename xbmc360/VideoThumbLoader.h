@@ -0,0 +1,59 @@
+#ifndef H_CVIDEOTHUMBLOADER
+#define H_CVIDEOTHUMBLOADER
+
+#include "utils\Thread.h"
+#include "utils\CriticalSection.h"
+#include "utils\StdString.h"
+
+#include <deque>
+
+enum ThumbPriority
+{
+	THUMB_PRIORITY_BACKGROUND = 0, // items that may be scrolled to later
+	THUMB_PRIORITY_VISIBLE         // items currently on screen
+};
+
+/*!
+ \brief Background queue that extracts video thumbs into the thumbnail cache.
+ Visible items are always handled before background ones. Every thumb it
+ makes is announced with a GUI_MSG_THUMB_LOADED thread message.
+ */
+class CVideoThumbLoader : public CThread
+{
+public:
+	CVideoThumbLoader();
+	virtual ~CVideoThumbLoader();
+
+	void Start();
+	void Stop();
+	void Pause(bool bPause);
+
+	// Returns the cached thumb if it already exists, otherwise queues it and returns an empty string
+	CStdString Request(const CStdString& strPath, ThumbPriority priority);
+	void Cancel(const CStdString& strPath);
+	void CancelAll();
+
+protected:
+	virtual void OnStartup();
+	virtual void Process();
+	virtual void OnExit();
+
+private:
+	bool GetNextJob(CStdString& strPath);
+	void OnThumbLoaded(const CStdString& strPath, const CStdString& strThumb);
+	bool RemoveFromQueue(std::deque<CStdString>& queue, const CStdString& strPath);
+
+	std::deque<CStdString> m_visible;
+	std::deque<CStdString> m_background;
+
+	CCriticalSection m_critSection;
+	CEvent m_jobEvent;
+	bool m_bPaused;
+
+	unsigned int m_iCreated;
+	unsigned int m_iFailed;
+};
+
+extern CVideoThumbLoader g_videoThumbLoader;
+
+#endif //H_CVIDEOTHUMBLOADER
@@ -1,4 +1,40 @@
 #include "DVDCodecUtils.h"
+#include "..\DVDDemuxers\DVDDemuxFFmpeg.h"
+#include "..\..\..\utils\CriticalSection.h"
+#include "..\..\..\utils\Log.h"
+
+// The player, the media probe workers and the thumb loader all open codecs
+// (av_find_stream_info does too), ffmpeg refuses concurrent opens without this
+static int FFmpegLockManager(void** mutex, enum AVLockOp op)
+{
+	CCriticalSection* pSection = (CCriticalSection*)*mutex;
+
+	switch (op)
+	{
+		case AV_LOCK_CREATE:
+			*mutex = new CCriticalSection;
+			return 0;
+		case AV_LOCK_OBTAIN:
+			EnterCriticalSection(*pSection);
+			return 0;
+		case AV_LOCK_RELEASE:
+			LeaveCriticalSection(*pSection);
+			return 0;
+		case AV_LOCK_DESTROY:
+			delete pSection;
+			*mutex = NULL;
+			return 0;
+	}
+	return 1;
+}
+
+void CDVDCodecUtils::InitFFmpeg()
+{
+	av_register_all();
+
+	if (av_lockmgr_register(FFmpegLockManager) != 0)
+		CLog::Log(LOGERROR, "CDVDCodecUtils: can't register the ffmpeg lock manager");
+}
 
 void CDVDCodecUtils::FreePicture(DVDVideoPicture* pPicture)
 {
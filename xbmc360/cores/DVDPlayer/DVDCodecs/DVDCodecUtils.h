@@ -8,6 +8,9 @@
 class CDVDCodecUtils
 {
 public:
+	// Registers ffmpeg and its lock manager, before any thread opens a codec
+	static void InitFFmpeg();
+
 	//static DVDVideoPicture* AllocatePicture(int iWidth, int iHeight);
 	static void FreePicture(DVDVideoPicture* pPicture);
 	//static bool CopyPicture(DVDVideoPicture* pDst, DVDVideoPicture* pSrc);
@@ -136,6 +136,11 @@ public:
 	* Seek, time in msec calculated from stream start
 	*/
 	virtual bool Seek(int iTime) = 0;
+	/*
+	* Enable or disable reading of a stream, packets of disabled streams are
+	* dropped by the demuxer before they are copied
+	*/
+	virtual void EnableStream(int iStreamId, bool bEnable) {};
 
 };
 
@@ -1,6 +1,7 @@
 #include "DVDDemuxFFmpeg.h"
 #include "..\DVDClock.h"
 #include "DVDDemuxUtils.h"
+#include "DVDFormatCache.h"
 
 #include "..\DVDUtils\DVDTimeUtils.h"
 #include "..\..\..\utils\thread.h"
@@ -11,6 +12,24 @@
 // threashold for start values in AV_TIME_BASE units
 #define PTS_START_THREASHOLD 100000
 
+// buffer size for custom I/O through the input stream
+#define FFMPEG_FILE_BUFFER_SIZE 32768
+
+static int dvd_file_read(void *h, uint8_t* buf, int size)
+{
+	CDVDInputStream* pInputStream = (CDVDInputStream*)h;
+	return pInputStream->Read(buf, size);
+}
+
+static int64_t dvd_file_seek(void *h, int64_t pos, int whence)
+{
+	CDVDInputStream* pInputStream = (CDVDInputStream*)h;
+	if (whence == AVSEEK_SIZE)
+		return pInputStream->GetLength();
+
+	return pInputStream->Seek(pos, whence & ~AVSEEK_FORCE);
+}
+
 // class CDemuxStreamVideoFFmpeg
 void CDemuxStreamVideoFFmpeg::GetStreamInfo(std::string& strInfo)
 {
@@ -32,9 +51,13 @@ void CDemuxStreamAudioFFmpeg::GetStreamInfo(std::string& strInfo)
 CDVDDemuxFFmpeg::CDVDDemuxFFmpeg()
 {
 	m_pFormatContext = NULL;
+	m_ioContext = NULL;
 	InitializeCriticalSection(&m_critSection);
 	for (int i = 0; i < MAX_STREAMS; i++) m_streams[i] = NULL;
 	m_iCurrentPts = 0LL;
+	m_iDeliveredBytes = 0LL;
+	m_iDiscardedBytes = 0LL;
+	m_iDiscardedPackets = 0;
 }
 
 CDVDDemuxFFmpeg::~CDVDDemuxFFmpeg()
@@ -55,9 +78,11 @@ void CDVDDemuxFFmpeg::Unlock()
 
 bool CDVDDemuxFFmpeg::Open(CDVDInputStream* pInput)
 {
-	AVInputFormat* iformat = NULL;
 	const char* strFile;
 	m_iCurrentPts = 0LL;
+	m_iDeliveredBytes = 0LL;
+	m_iDiscardedBytes = 0LL;
+	m_iDiscardedPackets = 0;
 
 	if (!pInput) return false;
 
@@ -66,18 +91,50 @@ bool CDVDDemuxFFmpeg::Open(CDVDInputStream* pInput)
 
 	strFile = pInput->GetFileName();
 
-	if(av_open_input_file(&m_pFormatContext, strFile, NULL, 0, NULL)!=0)
+	// Skip probing all demuxers if we opened this file before
+	__int64 iSize = pInput->NeedsCustomIO() ? pInput->GetLength() : -1;
+	DVDFormatHint hint;
+	bool bHint = g_formatCache.Lookup(strFile, iSize, hint);
+
+	DWORD dwStart = GetTickCount();
+	bool bOpened = OpenFormat(pInput, bHint ? hint.pFormat : NULL);
+
+	if (bOpened && bHint && !g_formatCache.Verify(strFile, hint, m_pFormatContext))
 	{
-		CLog::Log(LOGNOTICE, "Can't open file for reading");
-		return false;
+		// Another demuxer took the file, the streams it found can't be trusted
+		Dispose();
+		bOpened = false;
+	}
+	else if (!bOpened && bHint)
+	{
+		// The file changed in a way we couldn't see
+		g_formatCache.Remove(strFile);
 	}
 
-	// Retrieve stream information
-	if(av_find_stream_info(m_pFormatContext)<0)
+	if (!bOpened && bHint)
 	{
-		CLog::Log(LOGNOTICE, "Can't fetch info from file");
+		// Probe it again
+		if (pInput->NeedsCustomIO())
+			pInput->Seek(0, SEEK_SET);
+
+		bHint = false;
+		dwStart = GetTickCount();
+		bOpened = OpenFormat(pInput, NULL);
+	}
+
+	if (!bOpened)
 		return false;
+
+	if (bHint)
+	{
+		g_formatCache.ReportHit(hint.dwProbeTime, GetTickCount() - dwStart);
+
+		// Hints from the media probe only have the format, add the streams we found
+		if (hint.iStreams < 0)
+			g_formatCache.Store(strFile, iSize, m_pFormatContext, hint.dwProbeTime, true);
 	}
+	else
+		g_formatCache.Store(strFile, iSize, m_pFormatContext, GetTickCount() - dwStart, true);
 
 	// add the ffmpeg streams to our own stream array
 	for (int i = 0; i < (int)m_pFormatContext->nb_streams; i++)
@@ -88,9 +145,79 @@ bool CDVDDemuxFFmpeg::Open(CDVDInputStream* pInput)
 	return true;
 }
 
+bool CDVDDemuxFFmpeg::OpenFormat(CDVDInputStream* pInput, AVInputFormat* iformat)
+{
+	const char* strFile = pInput->GetFileName();
+
+	if (pInput->NeedsCustomIO())
+	{
+		// ffmpeg reads through our input stream, it has its own buffering and seeking
+		unsigned char* buffer = (unsigned char*)av_malloc(FFMPEG_FILE_BUFFER_SIZE);
+		m_ioContext = avio_alloc_context(buffer, FFMPEG_FILE_BUFFER_SIZE, 0, pInput, dvd_file_read, NULL, dvd_file_seek);
+		if (!m_ioContext)
+		{
+			av_free(buffer);
+			CLog::Log(LOGERROR, "Can't allocate io context");
+			return false;
+		}
+
+		if (pInput->GetLength() < 0)
+			m_ioContext->seekable = 0;
+
+		if (!iformat && av_probe_input_buffer(m_ioContext, &iformat, strFile, NULL, 0, 0) < 0)
+		{
+			CLog::Log(LOGNOTICE, "Can't detect format of %s", strFile);
+			Dispose();
+			return false;
+		}
+
+		if (av_open_input_stream(&m_pFormatContext, m_ioContext, strFile, iformat, NULL) < 0)
+		{
+			CLog::Log(LOGNOTICE, "Can't open stream for reading");
+			m_pFormatContext = NULL;
+			Dispose();
+			return false;
+		}
+	}
+	else if(av_open_input_file(&m_pFormatContext, strFile, iformat, 0, NULL)!=0)
+	{
+		CLog::Log(LOGNOTICE, "Can't open file for reading");
+		m_pFormatContext = NULL;
+		return false;
+	}
+
+	// Retrieve stream information
+	if(av_find_stream_info(m_pFormatContext)<0 || m_pFormatContext->nb_streams == 0)
+	{
+		CLog::Log(LOGNOTICE, "Can't fetch info from file");
+		Dispose();
+		return false;
+	}
+
+	return true;
+}
+
 void CDVDDemuxFFmpeg::Dispose()
 {
-	if (m_pFormatContext) av_close_input_file/*avformat_close_input*/(m_pFormatContext);
+	if (m_pFormatContext)
+	{
+		// Nothing to tell for files that were only probed
+		if (m_iDeliveredBytes || m_iDiscardedPackets)
+			CLog::Log(LOGNOTICE, "CDVDDemuxFFmpeg: delivered %I64d bytes, discarded %I64d bytes in %u packets of disabled streams",
+				m_iDeliveredBytes, m_iDiscardedBytes, m_iDiscardedPackets);
+
+		if (m_ioContext)
+			av_close_input_stream(m_pFormatContext);
+		else
+			av_close_input_file/*avformat_close_input*/(m_pFormatContext);
+	}
+
+	if (m_ioContext)
+	{
+		av_free(m_ioContext->buffer);
+		av_free(m_ioContext);
+	}
+	m_ioContext = NULL;
 
 	for (int i = 0; i < MAX_STREAMS; i++)
 	{
@@ -136,7 +263,19 @@ CDVDDemux::DemuxPacket* CDVDDemuxFFmpeg::Read()
 
 	if (m_pFormatContext)
 	{
-		if (av_read_frame(m_pFormatContext, &pkt) < 0)
+		int iRet;
+
+		// Not every ffmpeg demuxer honours AVDISCARD_ALL, drop what slips through before we copy it
+		while ((iRet = av_read_frame(m_pFormatContext, &pkt)) >= 0 &&
+		       pkt.stream_index >= 0 && pkt.stream_index < (int)m_pFormatContext->nb_streams &&
+		       m_pFormatContext->streams[pkt.stream_index]->discard == AVDISCARD_ALL)
+		{
+			m_iDiscardedBytes += pkt.size;
+			m_iDiscardedPackets++;
+			av_free_packet(&pkt);
+		}
+
+		if (iRet < 0)
 		{
 			// error reading from stream
 			// XXX, just reset eof for now, and let the dvd player decide what todo
@@ -162,6 +301,7 @@ CDVDDemux::DemuxPacket* CDVDDemuxFFmpeg::Read()
 				{
 					// copy contents into our own packet
 					pPacket->iSize = pkt.size;
+					m_iDeliveredBytes += pkt.size;
           
 					// maybe we can avoid a memcpy here by detecting where pkt.destruct is pointing too?
 					/*fast_*/memcpy(pPacket->pData, pkt.data, pPacket->iSize);
@@ -281,6 +421,16 @@ bool CDVDDemuxFFmpeg::Seek(int iTime)
 	return (ret >= 0);
 }
 
+void CDVDDemuxFFmpeg::EnableStream(int iStreamId, bool bEnable)
+{
+	if (!m_pFormatContext || iStreamId < 0 || iStreamId >= (int)m_pFormatContext->nb_streams)
+		return;
+
+	Lock();
+	m_pFormatContext->streams[iStreamId]->discard = bEnable ? AVDISCARD_DEFAULT : AVDISCARD_ALL;
+	Unlock();
+}
+
 void CDVDDemuxFFmpeg::AddStream(int iId)
 {
 	AVStream* pStream = m_pFormatContext->streams[iId];
@@ -63,6 +63,7 @@ public:
 	bool Seek(int iTime);
 
 	AVFormatContext* m_pFormatContext;
+	AVIOContext* m_ioContext; // only used for input streams that can't be opened by name
 
 	CRITICAL_SECTION m_critSection;
 	CDemuxStream* m_streams[20]; // maximum number of streams that ffmpeg can handle
@@ -71,13 +72,24 @@ public:
 	virtual CDemuxStream* GetStream(int iStreamId);
 	virtual int GetNrOfStreams();
 
+	virtual void EnableStream(int iStreamId, bool bEnable);
+
+	__int64 GetDeliveredBytes() { return m_iDeliveredBytes; }
+	__int64 GetDiscardedBytes() { return m_iDiscardedBytes; }
+
 private:
+	bool OpenFormat(CDVDInputStream* pInput, AVInputFormat* iformat);
 	void AddStream(int iId);
 
 	void Lock();
 	void Unlock();
 
 	unsigned __int64 m_iCurrentPts; // used for stream length estimation
+
+	// Bytes of packets handed out and of packets dropped for disabled streams
+	__int64 m_iDeliveredBytes;
+	__int64 m_iDiscardedBytes;
+	unsigned int m_iDiscardedPackets;
 };
 
 #endif //H_CDVDDEMUXFFMPEG
\ No newline at end of file
@@ -8,5 +8,6 @@ CDVDDemux* CDVDFactoryDemuxer::CreateDemuxer(CDVDInputStream* pInputStream)
 	if(pDemuxer->Open(pInputStream))
 		return pDemuxer;
 
+	delete pDemuxer;
 	return NULL;
 }
\ No newline at end of file
@@ -0,0 +1,229 @@
+#include "DVDFormatCache.h"
+#include "DVDDemuxFFmpeg.h"
+#include "..\..\..\utils\SingleLock.h"
+#include "..\..\..\utils\Log.h"
+#include "..\..\..\utils\Fnv.h"
+
+#include <stdio.h>
+
+CDVDFormatCache g_formatCache;
+
+CDVDFormatCache::CDVDFormatCache()
+{
+	m_bLoaded = false;
+	m_bChanged = false;
+	m_iHits = 0;
+	m_iMisses = 0;
+	m_iWrongHints = 0;
+	m_dwTimeSaved = 0;
+}
+
+CDVDFormatCache::~CDVDFormatCache()
+{
+}
+
+bool CDVDFormatCache::Lookup(const CStdString& strFile, __int64 iSize, DVDFormatHint& hint)
+{
+	unsigned __int64 iModified = 0;
+	if (iSize < 0 && !GetIdentity(strFile, iSize, iModified))
+		return false;
+
+	CSingleLock lock(m_critSection);
+
+	if (!m_bLoaded)
+		Load();
+
+	CStdString strKey = strFile;
+	strKey.ToLower();
+
+	MAPENTRIES::iterator it = m_entries.find(strKey);
+	if (it == m_entries.end() || it->second.iSize != iSize || it->second.iModified != iModified)
+	{
+		m_iMisses++;
+		return false;
+	}
+
+	AVInputFormat* pFormat = av_find_input_format(it->second.strFormat.c_str());
+	if (!pFormat)
+	{
+		// Format isn't compiled in anymore
+		m_entries.erase(it);
+		m_bChanged = true;
+		m_iMisses++;
+		return false;
+	}
+
+	hint.pFormat = pFormat;
+	hint.iStreams = it->second.iStreams;
+	hint.dwCodecs = it->second.dwCodecs;
+	hint.dwProbeTime = it->second.dwProbeTime;
+	return true;
+}
+
+void CDVDFormatCache::Store(const CStdString& strFile, __int64 iSize, AVFormatContext* pContext, DWORD dwProbeTime, bool bStreams)
+{
+	if (!pContext || !pContext->iformat || !pContext->iformat->name)
+		return;
+
+	unsigned __int64 iModified = 0;
+	if (iSize < 0 && !GetIdentity(strFile, iSize, iModified))
+		return;
+
+	CSingleLock lock(m_critSection);
+
+	if (!m_bLoaded)
+		Load();
+
+	// Simply start over when full, the cache refills as files are opened again
+	if (m_entries.size() >= FORMATCACHE_MAX_ENTRIES)
+		m_entries.clear();
+
+	CStdString strKey = strFile;
+	strKey.ToLower();
+
+	CacheEntry& entry = m_entries[strKey];
+	entry.iSize = iSize;
+	entry.iModified = iModified;
+	entry.strFormat = pContext->iformat->name;
+	entry.iStreams = bStreams ? (int)pContext->nb_streams : -1;
+	entry.dwCodecs = bStreams ? GetCodecs(pContext) : 0;
+	entry.dwProbeTime = dwProbeTime;
+
+	m_bChanged = true;
+}
+
+void CDVDFormatCache::Remove(const CStdString& strFile)
+{
+	CSingleLock lock(m_critSection);
+
+	CStdString strKey = strFile;
+	strKey.ToLower();
+
+	MAPENTRIES::iterator it = m_entries.find(strKey);
+	if (it != m_entries.end())
+	{
+		CLog::Log(LOGWARNING, "CDVDFormatCache: format hint %s was wrong for %s", it->second.strFormat.c_str(), strFile.c_str());
+		m_entries.erase(it);
+		m_bChanged = true;
+		m_iWrongHints++;
+	}
+}
+
+bool CDVDFormatCache::Verify(const CStdString& strFile, const DVDFormatHint& hint, AVFormatContext* pContext)
+{
+	// Only the format is known, the demuxer stores the rest after this open
+	if (hint.iStreams < 0)
+		return true;
+
+	if ((int)pContext->nb_streams == hint.iStreams && GetCodecs(pContext) == hint.dwCodecs)
+		return true;
+
+	CLog::Log(LOGDEBUG, "CDVDFormatCache: %s opened with %u stream(s) (codecs %08lx) instead of %i (codecs %08lx)",
+		strFile.c_str(), pContext->nb_streams, GetCodecs(pContext), hint.iStreams, hint.dwCodecs);
+	Remove(strFile);
+	return false;
+}
+
+void CDVDFormatCache::ReportHit(DWORD dwProbeTime, DWORD dwOpenTime)
+{
+	CSingleLock lock(m_critSection);
+
+	m_iHits++;
+	if (dwProbeTime > dwOpenTime)
+		m_dwTimeSaved += dwProbeTime - dwOpenTime;
+
+	CLog::Log(LOGDEBUG, "CDVDFormatCache: opened in %u ms instead of %u ms, %u ms saved over %u hit(s)",
+		dwOpenTime, dwProbeTime, m_dwTimeSaved, m_iHits);
+}
+
+bool CDVDFormatCache::Load()
+{
+	CSingleLock lock(m_critSection);
+
+	m_bLoaded = true;
+	m_entries.clear();
+
+	FILE* fd = fopen(FORMATCACHE_FILE, "r");
+	if (!fd)
+		return false;
+
+	// One entry per line: size modified probetime streams codecs format path
+	char line[1024];
+	while (fgets(line, sizeof(line), fd))
+	{
+		CacheEntry entry;
+		char format[64];
+		int iPathStart = 0;
+
+		if (sscanf(line, "%I64d %I64u %lu %i %lx %63s %n", &entry.iSize, &entry.iModified, &entry.dwProbeTime,
+		           &entry.iStreams, &entry.dwCodecs, format, &iPathStart) < 6 || iPathStart == 0)
+			continue;
+
+		CStdString strPath = line + iPathStart;
+		strPath.TrimRight("\r\n");
+		if (strPath.IsEmpty())
+			continue;
+
+		entry.strFormat = format;
+		m_entries[strPath] = entry;
+	}
+	fclose(fd);
+
+	CLog::Log(LOGDEBUG, "CDVDFormatCache: loaded %u entries", (unsigned int)m_entries.size());
+	return true;
+}
+
+bool CDVDFormatCache::Save()
+{
+	CSingleLock lock(m_critSection);
+
+	if (m_iHits || m_iMisses)
+	{
+		CLog::Log(LOGNOTICE, "CDVDFormatCache: %u hit(s), %u miss(es), %u wrong hint(s), %u ms of probing saved",
+			m_iHits, m_iMisses, m_iWrongHints, m_dwTimeSaved);
+	}
+
+	if (!m_bChanged)
+		return true;
+
+	FILE* fd = fopen(FORMATCACHE_FILE, "w");
+	if (!fd)
+	{
+		CLog::Log(LOGERROR, "CDVDFormatCache: unable to write %s", FORMATCACHE_FILE);
+		return false;
+	}
+
+	for (MAPENTRIES::iterator it = m_entries.begin(); it != m_entries.end(); it++)
+	{
+		fprintf(fd, "%I64d %I64u %lu %i %08lx %s %s\n", it->second.iSize, it->second.iModified, it->second.dwProbeTime,
+			it->second.iStreams, it->second.dwCodecs, it->second.strFormat.c_str(), it->first.c_str());
+	}
+	fclose(fd);
+
+	m_bChanged = false;
+	return true;
+}
+
+bool CDVDFormatCache::GetIdentity(const CStdString& strFile, __int64& iSize, unsigned __int64& iModified)
+{
+	WIN32_FILE_ATTRIBUTE_DATA data;
+	if (!GetFileAttributesEx(strFile.c_str(), GetFileExInfoStandard, &data))
+		return false;
+
+	iSize = ((__int64)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+	iModified = ((unsigned __int64)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+	return true;
+}
+
+DWORD CDVDFormatCache::GetCodecs(AVFormatContext* pContext)
+{
+	// The type and codec of every stream, in order
+	unsigned int iHash = FNV_OFFSET_BASIS;
+	for (unsigned int i = 0; i < pContext->nb_streams; i++)
+	{
+		AVCodecContext* pCodec = pContext->streams[i]->codec;
+		iHash = CFnv::HashValue((unsigned int)pCodec->codec_type, iHash);
+		iHash = CFnv::HashValue((unsigned int)pCodec->codec_id, iHash);
+	}
+	return iHash;
+}
@@ -0,0 +1,92 @@
+#ifndef H_CDVDFORMATCACHE
+#define H_CDVDFORMATCACHE
+
+#include "..\..\..\utils\CriticalSection.h"
+#include "..\..\..\utils\StdString.h"
+
+#include <map>
+
+#define FORMATCACHE_FILE        "D:\\formatcache.dat"
+#define FORMATCACHE_MAX_ENTRIES 2000
+
+struct AVInputFormat;
+struct AVFormatContext;
+
+struct DVDFormatHint
+{
+	AVInputFormat* pFormat;
+	int iStreams;        // streams av_find_stream_info() found, -1 if not known yet
+	DWORD dwCodecs;      // hash of their types and codecs
+	DWORD dwProbeTime;   // time the open took without the hint, in ms
+};
+
+/*!
+ \brief Remembers which ffmpeg input format a file was detected as, so that
+ reopening it can skip probing all demuxers.
+
+ Files are identified by path, size and modification time. Next to the
+ format the streams the demuxer found are kept, an open with the hint has
+ to find the same ones. A hint that turns out wrong must be reported with
+ Remove() or Verify(), the caller then probes as usual.
+ */
+class CDVDFormatCache
+{
+public:
+	CDVDFormatCache();
+	~CDVDFormatCache();
+
+	/*!
+	 \brief Look up the input format of a file
+	 \param iSize size of the input, -1 to take it from the file system
+	 \return false if the file isn't known
+	 */
+	bool Lookup(const CStdString& strFile, __int64 iSize, DVDFormatHint& hint);
+
+	/*!
+	 \brief Remember what a file was detected as
+	 \param pContext the file after av_find_stream_info()
+	 \param dwProbeTime time the open took without a hint, in ms
+	 \param bStreams whether the streams are all the demuxer finds, false when the probe was cut short
+	 */
+	void Store(const CStdString& strFile, __int64 iSize, AVFormatContext* pContext, DWORD dwProbeTime, bool bStreams);
+	void Remove(const CStdString& strFile);
+
+	// False and the hint is removed when pContext, opened with it, didn't find the streams it did before
+	bool Verify(const CStdString& strFile, const DVDFormatHint& hint, AVFormatContext* pContext);
+
+	// Account an open that used the hint, dwOpenTime is the time it took
+	void ReportHit(DWORD dwProbeTime, DWORD dwOpenTime);
+
+	bool Load();
+	bool Save();
+
+private:
+	struct CacheEntry
+	{
+		__int64 iSize;
+		unsigned __int64 iModified;
+		CStdString strFormat;
+		int iStreams;
+		DWORD dwCodecs;
+		DWORD dwProbeTime;
+	};
+
+	bool GetIdentity(const CStdString& strFile, __int64& iSize, unsigned __int64& iModified);
+	static DWORD GetCodecs(AVFormatContext* pContext);
+
+	typedef std::map<CStdString, CacheEntry> MAPENTRIES;
+	MAPENTRIES m_entries;
+
+	CCriticalSection m_critSection;
+	bool m_bLoaded;
+	bool m_bChanged;
+
+	unsigned int m_iHits;
+	unsigned int m_iMisses;
+	unsigned int m_iWrongHints;
+	DWORD m_dwTimeSaved;
+};
+
+extern CDVDFormatCache g_formatCache;
+
+#endif //H_CDVDFORMATCACHE
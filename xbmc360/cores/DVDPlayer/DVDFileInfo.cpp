@@ -0,0 +1,145 @@
+#include "DVDFileInfo.h"
+#include "DVDDemuxers\DVDDemuxFFmpeg.h"
+#include "..\..\ThumbnailCache.h"
+#include "..\..\utils\Log.h"
+
+// Give up if no keyframe shows up within this many video packets
+#define THUMB_MAX_PACKETS 250
+
+// Seek to a third of the file, opening credits and black frames are mostly before that
+#define THUMB_SEEK_DIVISOR 3
+
+bool CDVDFileInfo::ExtractThumb(const CStdString& strPath, const CStdString& strTarget)
+{
+	AVFormatContext* pFormatContext = NULL;
+	AVCodecContext* pCodecContext = NULL;
+	AVFrame* pFrame = NULL;
+	int iVideoStream = -1;
+	bool bResult = false;
+
+	DWORD dwStart = GetTickCount();
+
+	av_register_all();
+
+	if (av_open_input_file(&pFormatContext, strPath.c_str(), NULL, 0, NULL) != 0)
+	{
+		CLog::Log(LOGDEBUG, "%s - can't open %s", __FUNCTION__, strPath.c_str());
+		return false;
+	}
+
+	if (av_find_stream_info(pFormatContext) < 0)
+	{
+		CLog::Log(LOGDEBUG, "%s - can't fetch info from %s", __FUNCTION__, strPath.c_str());
+		av_close_input_file(pFormatContext);
+		return false;
+	}
+
+	// Only the first video stream is read, everything else is dropped by the demuxer
+	for (int i = 0; i < (int)pFormatContext->nb_streams; i++)
+	{
+		if (iVideoStream < 0 && pFormatContext->streams[i]->codec->codec_type == AVMEDIA_TYPE_VIDEO)
+			iVideoStream = i;
+		else
+			pFormatContext->streams[i]->discard = AVDISCARD_ALL;
+	}
+
+	if (iVideoStream < 0)
+	{
+		CLog::Log(LOGDEBUG, "%s - no video stream in %s", __FUNCTION__, strPath.c_str());
+		av_close_input_file(pFormatContext);
+		return false;
+	}
+
+	pCodecContext = pFormatContext->streams[iVideoStream]->codec;
+
+	AVCodec* pCodec = avcodec_find_decoder(pCodecContext->codec_id);
+	if (!pCodec || avcodec_open(pCodecContext, pCodec) < 0)
+	{
+		CLog::Log(LOGDEBUG, "%s - unable to open codec for %s", __FUNCTION__, strPath.c_str());
+		av_close_input_file(pFormatContext);
+		return false;
+	}
+
+	// We want exactly one picture, so don't waste time on anything but keyframes
+	pCodecContext->skip_frame = AVDISCARD_NONKEY;
+
+	if (pFormatContext->duration != AV_NOPTS_VALUE && pFormatContext->duration > 0)
+	{
+		__int64 iSeekPts = pFormatContext->duration / THUMB_SEEK_DIVISOR;
+		if (pFormatContext->start_time != AV_NOPTS_VALUE)
+			iSeekPts += pFormatContext->start_time;
+
+		// If seeking fails we simply use the first keyframe of the file
+		if (av_seek_frame(pFormatContext, -1, iSeekPts, AVSEEK_FLAG_BACKWARD) >= 0)
+			avcodec_flush_buffers(pCodecContext);
+	}
+
+	pFrame = avcodec_alloc_frame();
+
+	AVPacket pkt;
+	int iGotPicture = 0;
+	int iPackets = 0;
+
+	while (!iGotPicture && iPackets < THUMB_MAX_PACKETS && av_read_frame(pFormatContext, &pkt) >= 0)
+	{
+		if (pkt.stream_index == iVideoStream)
+		{
+			iPackets++;
+			try
+			{
+				avcodec_decode_video2(pCodecContext, pFrame, &iGotPicture, &pkt);
+			}
+			catch (...)
+			{
+				CLog::Log(LOGERROR, "%s - exception decoding %s", __FUNCTION__, strPath.c_str());
+				iGotPicture = 0;
+			}
+		}
+		av_free_packet(&pkt);
+	}
+
+	if (iGotPicture && pCodecContext->width > 0 && pCodecContext->height > 0)
+	{
+		// Fit into the thumb size, keeping the aspect ratio
+		int iWidth = THUMB_MAX_WIDTH;
+		int iHeight = (pCodecContext->height * THUMB_MAX_WIDTH) / pCodecContext->width;
+		if (iHeight > THUMB_MAX_HEIGHT)
+		{
+			iHeight = THUMB_MAX_HEIGHT;
+			iWidth = (pCodecContext->width * THUMB_MAX_HEIGHT) / pCodecContext->height;
+		}
+		if (iWidth < 1) iWidth = 1;
+		if (iHeight < 1) iHeight = 1;
+
+		struct SwsContext* pSwsContext = sws_getContext(
+			pCodecContext->width, pCodecContext->height, pCodecContext->pix_fmt,
+			iWidth, iHeight, PIX_FMT_RGB32,
+			SWS_FAST_BILINEAR, NULL, NULL, NULL);
+
+		if (pSwsContext)
+		{
+			int iPitch = iWidth * 4;
+			BYTE* pBuffer = new BYTE[iPitch * iHeight];
+
+			uint8_t* dst[4] = { pBuffer, NULL, NULL, NULL };
+			int dstStride[4] = { iPitch, 0, 0, 0 };
+
+			sws_scale(pSwsContext, pFrame->data, pFrame->linesize, 0, pCodecContext->height, dst, dstStride);
+			sws_freeContext(pSwsContext);
+
+			bResult = CThumbnailCache::Write(strTarget, pBuffer, iWidth, iHeight, iPitch);
+			delete[] pBuffer;
+		}
+	}
+
+	if (pFrame) av_free(pFrame);
+	avcodec_close(pCodecContext);
+	av_close_input_file(pFormatContext);
+
+	if (bResult)
+		CLog::Log(LOGDEBUG, "%s - thumb for %s created in %u ms", __FUNCTION__, strPath.c_str(), GetTickCount() - dwStart);
+	else
+		CLog::Log(LOGDEBUG, "%s - no picture decoded from %s (%i packets)", __FUNCTION__, strPath.c_str(), iPackets);
+
+	return bResult;
+}
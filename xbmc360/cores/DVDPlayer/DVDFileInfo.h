@@ -0,0 +1,18 @@
+#ifndef H_CDVDFILEINFO
+#define H_CDVDFILEINFO
+
+#include "..\..\utils\StdString.h"
+
+class CDVDFileInfo
+{
+public:
+	/*!
+	 \brief Decode a single keyframe of a video and store it as a thumb
+	 \param strPath video file to extract the frame from
+	 \param strTarget thumb file to write, see CThumbnailCache
+	 \return true if the thumb was written
+	 */
+	static bool ExtractThumb(const CStdString& strPath, const CStdString& strTarget);
+};
+
+#endif //H_CDVDFILEINFO
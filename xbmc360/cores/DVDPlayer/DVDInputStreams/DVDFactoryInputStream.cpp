@@ -1,10 +1,12 @@
 #include "DVDFactoryInputStream.h"
 #include "DVDInputStream.h"
 #include "DVDInputStreamFile.h"
+#include "DVDInputStreamHttp.h"
 
 CDVDInputStream* CDVDFactoryInputStream::CreateInputStream(IDVDPlayer* pPlayer, const char* strFile)
 {
-	// TODO: Only have file atm..
+	if (strnicmp(strFile, "http://", 7) == 0)
+		return (new CDVDInputStreamHttp());
 
 	return (new CDVDInputStreamFile());
 }
@@ -1,10 +1,13 @@
 #ifndef H_CDVDINPUTSTREAM
 #define H_CDVDINPUTSTREAM
 
+#include "..\..\..\utils\stdafx.h"
+
 enum DVDStreamType
 {
 	DVDSTREAM_TYPE_NONE   = -1,
-	DVDSTREAM_TYPE_FILE   = 1
+	DVDSTREAM_TYPE_FILE   = 1,
+	DVDSTREAM_TYPE_HTTP   = 2
 	// TODO: More Stream types
 };
 
@@ -17,6 +20,15 @@ public:
 	virtual bool Open(const char* strFile);
 	virtual void Close();
 
+	// Byte access for streams ffmpeg can't open by name, files return -1 here
+	virtual int Read(BYTE* buf, int buf_size) { return -1; }
+	virtual __int64 Seek(__int64 offset, int whence) { return -1; }
+	virtual __int64 GetLength() { return -1; }
+	virtual bool IsEOF() { return false; }
+
+	// True if the demuxer has to read through Read/Seek instead of the file name
+	virtual bool NeedsCustomIO() { return false; }
+
 	const char* GetFileName();
 	bool IsStreamType(DVDStreamType type) { return m_streamType == type; }
 
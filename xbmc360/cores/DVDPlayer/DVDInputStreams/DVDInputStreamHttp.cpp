@@ -0,0 +1,126 @@
+#include "DVDInputStreamHttp.h"
+#include "..\..\..\utils\Log.h"
+#include "..\..\..\utils\SingleLock.h"
+
+CCriticalSection CDVDInputStreamHttp::m_critNetwork;
+bool CDVDInputStreamHttp::m_bNetworkStarted = false;
+
+CDVDInputStreamHttp::CDVDInputStreamHttp() : CDVDInputStream()
+{
+	m_streamType = DVDSTREAM_TYPE_HTTP;
+	m_bOpen = false;
+}
+
+CDVDInputStreamHttp::~CDVDInputStreamHttp()
+{
+	Close();
+}
+
+bool CDVDInputStreamHttp::InitNetwork()
+{
+	CSingleLock lock(m_critNetwork);
+	if (m_bNetworkStarted)
+		return true;
+
+	XNetStartupParams xnsp;
+	memset(&xnsp, 0, sizeof(xnsp));
+	xnsp.cfgSizeOfStruct = sizeof(XNetStartupParams);
+	xnsp.cfgFlags = XNET_STARTUP_BYPASS_SECURITY;
+	if (XNetStartup(&xnsp) != 0)
+	{
+		CLog::Log(LOGERROR, "CDVDInputStreamHttp: XNetStartup failed");
+		return false;
+	}
+
+	WSADATA wsaData;
+	if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+	{
+		CLog::Log(LOGERROR, "CDVDInputStreamHttp: WSAStartup failed");
+		return false;
+	}
+
+	m_bNetworkStarted = true;
+	return true;
+}
+
+bool CDVDInputStreamHttp::Open(const char* strFile)
+{
+	if (!CDVDInputStream::Open(strFile)) return false;
+
+	if (!InitNetwork())
+		return false;
+
+	m_bOpen = m_stream.Open(strFile);
+	return m_bOpen;
+}
+
+void CDVDInputStreamHttp::Close()
+{
+	if (m_bOpen)
+		LogStats();
+	m_bOpen = false;
+
+	m_stream.Close();
+
+	CDVDInputStream::Close();
+}
+
+int CDVDInputStreamHttp::Read(BYTE* buf, int buf_size)
+{
+	return m_stream.Read(buf, buf_size);
+}
+
+__int64 CDVDInputStreamHttp::Seek(__int64 offset, int whence)
+{
+	return m_stream.Seek(offset, whence);
+}
+
+__int64 CDVDInputStreamHttp::GetLength()
+{
+	return m_stream.GetLength();
+}
+
+bool CDVDInputStreamHttp::IsEOF()
+{
+	return m_stream.IsEOF();
+}
+
+void CDVDInputStreamHttp::LogStats()
+{
+	const HttpStreamStats& stats = m_stream.GetStats();
+	CLog::Log(LOGNOTICE, "CDVDInputStreamHttp: %u connect(s), %u request(s), seeks %u buffered / %u skipped / %u requested",
+		stats.iConnects, stats.iRequests, stats.iBufferedSeeks, stats.iSkipSeeks, stats.iRequestSeeks);
+	CLog::Log(LOGNOTICE, "CDVDInputStreamHttp: %I64d bytes received, %I64d read, %u stall(s) waiting %u ms, %i KB/s, read-ahead %i KB",
+		stats.iBytesReceived, stats.iBytesRead, stats.iStalls, stats.dwStallTime, m_stream.GetThroughput(), m_stream.GetReadAhead() / 1024);
+}
+
+bool CDVDInputStreamHttp::CXNetRangeStream::Resolve(const std::string& strHost, unsigned long& address)
+{
+	if (CHttpRangeStream::Resolve(strHost, address))
+		return true;
+
+	XNDNS* pDns = NULL;
+	WSAEVENT hEvent = WSACreateEvent();
+
+	if (XNetDnsLookup(strHost.c_str(), hEvent, &pDns) == 0)
+	{
+		WaitForSingleObject(hEvent, HTTP_TIMEOUT);
+		if (pDns->iStatus == 0 && pDns->cina > 0)
+			address = pDns->aina[0].s_addr;
+		XNetDnsRelease(pDns);
+	}
+	WSACloseEvent(hEvent);
+
+	return address != INADDR_NONE;
+}
+
+void CDVDInputStreamHttp::CXNetRangeStream::OnLog(HttpLogLevel level, const char* strMessage)
+{
+	int iLevel = LOGNOTICE;
+	if (level == HTTPLOG_WARNING)
+		iLevel = LOGWARNING;
+	else if (level == HTTPLOG_ERROR)
+		iLevel = LOGERROR;
+
+	CLog::Log(iLevel, "CDVDInputStreamHttp: %s", strMessage);
+}
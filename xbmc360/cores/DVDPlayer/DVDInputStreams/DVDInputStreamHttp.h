@@ -0,0 +1,48 @@
+#ifndef H_CDVDINPUTSTREAMHTTP
+#define H_CDVDINPUTSTREAMHTTP
+
+#include "DVDInputStream.h"
+#include "HttpRangeStream.h"
+#include "..\..\..\utils\CriticalSection.h"
+
+class CDVDInputStreamHttp : public CDVDInputStream
+{
+public:
+	CDVDInputStreamHttp();
+	virtual ~CDVDInputStreamHttp();
+
+	virtual bool Open(const char* strFile);
+	virtual void Close();
+
+	virtual int Read(BYTE* buf, int buf_size);
+	virtual __int64 Seek(__int64 offset, int whence);
+	virtual __int64 GetLength();
+	virtual bool IsEOF();
+	virtual bool NeedsCustomIO() { return true; }
+
+	const HttpStreamStats& GetStats() const { return m_stream.GetStats(); }
+
+	// Throughput of the connection in KB/s, measured while receiving
+	int GetThroughput() const { return m_stream.GetThroughput(); }
+
+private:
+	// Host names go through XNet, messages to the log
+	class CXNetRangeStream : public CHttpRangeStream
+	{
+	protected:
+		virtual bool Resolve(const std::string& strHost, unsigned long& address);
+		virtual void OnLog(HttpLogLevel level, const char* strMessage);
+	};
+
+	static bool InitNetwork();
+	void LogStats();
+
+	// Streams may be opened from several threads, the network is started once
+	static CCriticalSection m_critNetwork;
+	static bool m_bNetworkStarted;
+
+	CXNetRangeStream m_stream;
+	bool m_bOpen;
+};
+
+#endif //H_CDVDINPUTSTREAMHTTP
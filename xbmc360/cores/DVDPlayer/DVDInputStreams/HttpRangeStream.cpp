@@ -0,0 +1,682 @@
+#include "HttpRangeStream.h"
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _XBOX
+#define HTTP_SEND_FLAGS 0
+#define snprintf        _snprintf
+#define vsnprintf       _vsnprintf
+
+static void SetTimeouts(SOCKET s)
+{
+	DWORD dwTimeout = HTTP_TIMEOUT;
+	setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, (const char*)&dwTimeout, sizeof(dwTimeout));
+	setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, (const char*)&dwTimeout, sizeof(dwTimeout));
+}
+
+static unsigned int GetTicks()
+{
+	return GetTickCount();
+}
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define INVALID_SOCKET  (-1)
+#define SD_BOTH         SHUT_RDWR
+#define closesocket     close
+#define HTTP_SEND_FLAGS MSG_NOSIGNAL  // a closed connection is an error, not a signal
+
+static void SetTimeouts(SOCKET s)
+{
+	timeval tv = { HTTP_TIMEOUT / 1000, (HTTP_TIMEOUT % 1000) * 1000 };
+	setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+	setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+}
+
+static unsigned int GetTicks()
+{
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (unsigned int)(now.tv_sec * 1000 + now.tv_nsec / 1000000);
+}
+#endif
+
+#define HTTP_BUFFER_SIZE (HTTP_READAHEAD_MAX + HTTP_KEEP_BEHIND)
+#define HTTP_MAX_HEADER  8192
+
+static bool StartsWithNoCase(const std::string& str, const char* strPrefix)
+{
+	size_t iLength = strlen(strPrefix);
+	if (str.size() < iLength)
+		return false;
+
+	for (size_t i = 0; i < iLength; i++)
+	{
+		if (tolower((unsigned char)str[i]) != tolower((unsigned char)strPrefix[i]))
+			return false;
+	}
+	return true;
+}
+
+static bool EqualsNoCase(const std::string& str, const char* strOther)
+{
+	return str.size() == strlen(strOther) && StartsWithNoCase(str, strOther);
+}
+
+static std::string Trim(const std::string& str)
+{
+	size_t iStart = str.find_first_not_of(" \t");
+	if (iStart == std::string::npos)
+		return "";
+	size_t iEnd = str.find_last_not_of(" \t");
+	return str.substr(iStart, iEnd - iStart + 1);
+}
+
+CHttpRangeStream::CHttpRangeStream()
+{
+	m_iPort = 80;
+	m_socket = INVALID_SOCKET;
+	m_bKeepAlive = false;
+	m_bCanSeek = false;
+	m_iLength = -1;
+	m_iRequestPos = 0;
+	m_iBodyLeft = 0;
+	m_pBuffer = NULL;
+	m_iBufferEnd = 0;
+	m_iBufferPos = 0;
+	m_iPos = 0;
+	m_iReadAhead = HTTP_READAHEAD_MIN;
+	m_iFillsSinceStall = 0;
+	m_bEOF = false;
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+CHttpRangeStream::~CHttpRangeStream()
+{
+	Close();
+}
+
+bool CHttpRangeStream::Open(const char* strUrl)
+{
+	Close();
+
+	if (!ParseUrl(strUrl))
+	{
+		Log(HTTPLOG_ERROR, "invalid url %s", strUrl);
+		return false;
+	}
+
+	memset(&m_stats, 0, sizeof(m_stats));
+	m_iLength = -1;
+	m_bCanSeek = false;
+	m_bEOF = false;
+	m_iReadAhead = HTTP_READAHEAD_MIN;
+	m_iFillsSinceStall = 0;
+
+	m_pBuffer = new unsigned char[HTTP_BUFFER_SIZE];
+	ResetBuffer(0);
+
+	// The first request also tells us the length and whether ranges work
+	if (!SendRequest(0))
+	{
+		Log(HTTPLOG_ERROR, "unable to open %s", strUrl);
+		Close();
+		return false;
+	}
+
+	Log(HTTPLOG_NOTICE, "opened %s, length %lld, %s", strUrl, (long long)m_iLength, m_bCanSeek ? "seekable" : "not seekable");
+	return true;
+}
+
+void CHttpRangeStream::Close()
+{
+	Disconnect();
+
+	delete[] m_pBuffer;
+	m_pBuffer = NULL;
+}
+
+int CHttpRangeStream::Read(unsigned char* buf, int buf_size)
+{
+	if (!m_pBuffer) return -1;
+
+	if (m_iPos >= m_iBufferPos + m_iBufferEnd)
+	{
+		if (m_iLength >= 0 && m_iPos >= m_iLength)
+		{
+			m_bEOF = true;
+			return 0;
+		}
+
+		// The demuxer has to wait for the network
+		unsigned int dwStart = GetTicks();
+		bool bFilled = Fill(1);
+		m_stats.iStalls++;
+		m_stats.dwStallTime += GetTicks() - dwStart;
+
+		// Not enough read-ahead for this connection, grow it
+		if (m_iReadAhead < HTTP_READAHEAD_MAX)
+			m_iReadAhead *= 2;
+		m_iFillsSinceStall = 0;
+
+		if (!bFilled)
+		{
+			if (m_iLength < 0 || m_iPos >= m_iLength)
+			{
+				m_bEOF = true;
+				return 0;
+			}
+			return -1;
+		}
+	}
+
+	int iOffset = (int)(m_iPos - m_iBufferPos);
+	int iCopy = m_iBufferEnd - iOffset;
+	if (iCopy > buf_size) iCopy = buf_size;
+
+	memcpy(buf, m_pBuffer + iOffset, iCopy);
+	m_iPos += iCopy;
+	m_stats.iBytesRead += iCopy;
+
+	// Top up the read-ahead with whatever has arrived, without waiting
+	if (m_iBufferEnd - (int)(m_iPos - m_iBufferPos) < m_iReadAhead / 2)
+	{
+		Fill(0);
+
+		// A long run without stalls means we hold more than needed
+		if (++m_iFillsSinceStall > 64 && m_iReadAhead > HTTP_READAHEAD_MIN)
+		{
+			m_iReadAhead /= 2;
+			m_iFillsSinceStall = 0;
+		}
+	}
+
+	return iCopy;
+}
+
+int64_t CHttpRangeStream::Seek(int64_t offset, int whence)
+{
+	int64_t iTarget;
+
+	switch (whence)
+	{
+		case SEEK_SET: iTarget = offset; break;
+		case SEEK_CUR: iTarget = m_iPos + offset; break;
+		case SEEK_END:
+		{
+			if (m_iLength < 0) return -1;
+			iTarget = m_iLength + offset;
+			break;
+		}
+		default:
+			return -1;
+	}
+
+	if (!m_pBuffer || iTarget < 0 || (m_iLength >= 0 && iTarget > m_iLength))
+		return -1;
+
+	m_bEOF = false;
+
+	// Already buffered, no network needed
+	if (iTarget >= m_iBufferPos && iTarget <= m_iBufferPos + m_iBufferEnd)
+	{
+		m_iPos = iTarget;
+		m_stats.iBufferedSeeks++;
+		return m_iPos;
+	}
+
+	if (!m_bCanSeek)
+		return -1;
+
+	// Just ahead of the buffer, reading through is cheaper than a new request
+	if (iTarget > m_iRequestPos && iTarget - m_iRequestPos <= HTTP_SKIP_FORWARD && m_socket != INVALID_SOCKET)
+	{
+		unsigned char scratch[4096];
+		while (m_iRequestPos < iTarget)
+		{
+			if (m_iBodyLeft == 0 && !ContinueBody())
+				break;
+
+			int iSize = (int)(iTarget - m_iRequestPos < (int64_t)sizeof(scratch) ? iTarget - m_iRequestPos : sizeof(scratch));
+			if (Receive(scratch, iSize, true) <= 0)
+				break;
+		}
+
+		if (m_iRequestPos == iTarget)
+		{
+			ResetBuffer(iTarget);
+			m_stats.iSkipSeeks++;
+			return m_iPos;
+		}
+	}
+
+	// New range request, reuse the connection if the rest of the response is small
+	if (m_socket != INVALID_SOCKET && !(m_bKeepAlive && Drain()))
+		Disconnect();
+
+	ResetBuffer(iTarget);
+
+	// Nothing to ask for at the end, the server would refuse the range
+	if (iTarget == m_iLength)
+		return m_iPos;
+
+	m_stats.iRequestSeeks++;
+
+	if (!SendRequest(iTarget))
+		return -1;
+
+	return m_iPos;
+}
+
+int CHttpRangeStream::GetThroughput() const
+{
+	if (m_stats.dwReceiveTime == 0)
+		return 0;
+
+	return (int)((m_stats.iBytesReceived * 1000 / 1024) / m_stats.dwReceiveTime);
+}
+
+bool CHttpRangeStream::Resolve(const std::string& strHost, unsigned long& address)
+{
+	address = inet_addr(strHost.c_str());
+	return address != INADDR_NONE;
+}
+
+void CHttpRangeStream::Log(HttpLogLevel level, const char* strFormat, ...)
+{
+	char strMessage[512];
+
+	va_list va;
+	va_start(va, strFormat);
+	vsnprintf(strMessage, sizeof(strMessage), strFormat, va);
+	va_end(va);
+	strMessage[sizeof(strMessage) - 1] = '\0';
+
+	OnLog(level, strMessage);
+}
+
+bool CHttpRangeStream::ParseUrl(const char* strUrl)
+{
+	std::string strUrlCopy = strUrl;
+	if (!StartsWithNoCase(strUrlCopy, "http://"))
+		return false;
+
+	std::string strHostPort;
+	size_t iSlash = strUrlCopy.find('/', 7);
+	if (iSlash == std::string::npos)
+	{
+		strHostPort = strUrlCopy.substr(7);
+		m_strPath = "/";
+	}
+	else
+	{
+		strHostPort = strUrlCopy.substr(7, iSlash - 7);
+		m_strPath = strUrlCopy.substr(iSlash);
+	}
+
+	m_iPort = 80;
+	size_t iColon = strHostPort.find(':');
+	if (iColon != std::string::npos)
+	{
+		m_iPort = atoi(strHostPort.substr(iColon + 1).c_str());
+		strHostPort = strHostPort.substr(0, iColon);
+	}
+
+	m_strHost = strHostPort;
+	return !m_strHost.empty() && m_iPort > 0;
+}
+
+bool CHttpRangeStream::Connect()
+{
+	Disconnect();
+
+	unsigned long address;
+	if (!Resolve(m_strHost, address))
+	{
+		Log(HTTPLOG_ERROR, "unable to resolve %s", m_strHost.c_str());
+		return false;
+	}
+
+	m_socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (m_socket == INVALID_SOCKET)
+	{
+		Log(HTTPLOG_ERROR, "unable to create socket");
+		return false;
+	}
+
+	SetTimeouts(m_socket);
+
+	sockaddr_in sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sin_family = AF_INET;
+	sa.sin_port = htons((unsigned short)m_iPort);
+	sa.sin_addr.s_addr = address;
+
+	if (connect(m_socket, (const sockaddr*)&sa, sizeof(sa)) != 0)
+	{
+		Log(HTTPLOG_ERROR, "unable to connect to %s:%i", m_strHost.c_str(), m_iPort);
+		Disconnect();
+		return false;
+	}
+
+	// Assume keep-alive until the server says otherwise
+	m_bKeepAlive = true;
+	m_iBodyLeft = 0;
+	m_stats.iConnects++;
+
+	return true;
+}
+
+void CHttpRangeStream::Disconnect()
+{
+	if (m_socket != INVALID_SOCKET)
+	{
+		shutdown(m_socket, SD_BOTH);
+		closesocket(m_socket);
+	}
+	m_socket = INVALID_SOCKET;
+	m_iBodyLeft = 0;
+}
+
+bool CHttpRangeStream::SendRequest(int64_t iStart)
+{
+	// Always ask for a range, the answer tells us if the server can seek
+	int64_t iEnd = iStart + HTTP_RANGE_CHUNK - 1;
+	if (m_iLength > 0 && iEnd >= m_iLength)
+		iEnd = m_iLength - 1;
+
+	char strRequest[1024];
+	int iLength = snprintf(strRequest, sizeof(strRequest),
+	                       "GET %s HTTP/1.1\r\n"
+	                       "Host: %s\r\n"
+	                       "User-Agent: XBMC360\r\n"
+	                       "Connection: keep-alive\r\n"
+	                       "Range: bytes=%lld-%lld\r\n"
+	                       "\r\n", m_strPath.c_str(), m_strHost.c_str(), (long long)iStart, (long long)iEnd);
+	if (iLength <= 0 || iLength >= (int)sizeof(strRequest))
+	{
+		Log(HTTPLOG_ERROR, "url too long");
+		return false;
+	}
+
+	// A kept alive connection may have been closed by the server in the meantime, retry once on a new one
+	for (int iTry = 0; iTry < 2; iTry++)
+	{
+		if (m_socket == INVALID_SOCKET && !Connect())
+			return false;
+
+		m_iRequestPos = iStart;
+
+		int iSent = 0;
+		while (iSent < iLength)
+		{
+			int iRet = send(m_socket, strRequest + iSent, iLength - iSent, HTTP_SEND_FLAGS);
+			if (iRet <= 0) break;
+			iSent += iRet;
+		}
+
+		if (iSent == iLength)
+		{
+			m_stats.iRequests++;
+			if (ReadResponseHeader())
+				return true;
+
+			// The server answered, but not with what we need
+			if (m_socket != INVALID_SOCKET)
+				break;
+		}
+
+		Disconnect();
+	}
+
+	return false;
+}
+
+bool CHttpRangeStream::ReadResponseHeader()
+{
+	std::string strHeader;
+	char c;
+
+	while (strHeader.size() < HTTP_MAX_HEADER)
+	{
+		if (recv(m_socket, &c, 1, 0) != 1)
+		{
+			Disconnect();
+			return false;
+		}
+
+		strHeader += c;
+		if (strHeader.size() >= 4 && strHeader.compare(strHeader.size() - 4, 4, "\r\n\r\n") == 0)
+			break;
+	}
+
+	int iStatus = 0;
+	long long iContentLength = -1;
+	long long iRangeStart = -1, iRangeEnd = -1, iRangeTotal = -1;
+	bool bChunked = false;
+
+	size_t iStart = 0;
+	for (size_t iEnd = strHeader.find("\r\n"); iEnd != std::string::npos && iEnd > iStart; iStart = iEnd + 2, iEnd = strHeader.find("\r\n", iStart))
+	{
+		std::string strLine = strHeader.substr(iStart, iEnd - iStart);
+
+		if (iStart == 0)
+		{
+			// Status line, HTTP/1.0 servers close the connection by default
+			if (!StartsWithNoCase(strLine, "HTTP/"))
+				break;
+
+			m_bKeepAlive = strLine.compare(5, 3, "1.1") == 0;
+			size_t iSpace = strLine.find(' ');
+			if (iSpace != std::string::npos)
+				iStatus = atoi(strLine.c_str() + iSpace + 1);
+			continue;
+		}
+
+		size_t iColon = strLine.find(':');
+		if (iColon == std::string::npos || iColon == 0)
+			continue;
+
+		std::string strName = strLine.substr(0, iColon);
+		std::string strValue = Trim(strLine.substr(iColon + 1));
+
+		if (EqualsNoCase(strName, "Content-Length"))
+			sscanf(strValue.c_str(), "%lld", &iContentLength);
+		else if (EqualsNoCase(strName, "Content-Range"))
+			sscanf(strValue.c_str(), "bytes %lld-%lld/%lld", &iRangeStart, &iRangeEnd, &iRangeTotal);
+		else if (EqualsNoCase(strName, "Connection"))
+			m_bKeepAlive = !EqualsNoCase(strValue, "close");
+		else if (EqualsNoCase(strName, "Transfer-Encoding"))
+			bChunked = EqualsNoCase(strValue, "chunked");
+	}
+
+	if (bChunked)
+	{
+		Log(HTTPLOG_ERROR, "chunked transfer encoding is not supported");
+		Disconnect();
+		return false;
+	}
+
+	if (iStatus == 206)
+	{
+		if (iRangeStart != m_iRequestPos)
+		{
+			Log(HTTPLOG_ERROR, "server returned range at %lld, requested %lld", iRangeStart, (long long)m_iRequestPos);
+			Disconnect();
+			return false;
+		}
+
+		m_bCanSeek = true;
+		if (iRangeTotal > 0)
+			m_iLength = iRangeTotal;
+		m_iBodyLeft = iContentLength >= 0 ? iContentLength : iRangeEnd - iRangeStart + 1;
+	}
+	else if (iStatus == 200)
+	{
+		// Ranges are ignored, we only get the whole file from the start
+		if (m_iRequestPos != 0)
+		{
+			Log(HTTPLOG_ERROR, "server can't seek to %lld", (long long)m_iRequestPos);
+			Disconnect();
+			return false;
+		}
+
+		m_bCanSeek = false;
+		m_iLength = iContentLength;
+		m_iBodyLeft = iContentLength;
+	}
+	else if (iStatus == 416)
+	{
+		// Asked for data past the end
+		m_iLength = m_iRequestPos;
+		m_iBodyLeft = 0;
+		m_bEOF = true;
+		return false;
+	}
+	else
+	{
+		Log(HTTPLOG_ERROR, "server returned status %i", iStatus);
+		Disconnect();
+		return false;
+	}
+
+	// Without a length the end of the body is only known by the connection closing
+	if (m_iBodyLeft < 0)
+		m_bKeepAlive = false;
+
+	return true;
+}
+
+bool CHttpRangeStream::ContinueBody()
+{
+	if (m_iLength >= 0 && m_iRequestPos >= m_iLength)
+		return false;
+
+	if (!m_bKeepAlive)
+		Disconnect();
+
+	return SendRequest(m_iRequestPos);
+}
+
+int CHttpRangeStream::Receive(unsigned char* buf, int size, bool bWait)
+{
+	if (m_socket == INVALID_SOCKET)
+		return -1;
+
+	if (m_iBodyLeft >= 0 && size > m_iBodyLeft)
+		size = (int)m_iBodyLeft;
+
+	if (size <= 0)
+		return 0;
+
+	if (!bWait)
+	{
+		fd_set readSet;
+		FD_ZERO(&readSet);
+		FD_SET(m_socket, &readSet);
+		timeval tv = { 0, 0 };
+		if (select((int)m_socket + 1, &readSet, NULL, NULL, &tv) <= 0)
+			return 0;
+	}
+
+	unsigned int dwStart = GetTicks();
+	int iRet = recv(m_socket, (char*)buf, size, 0);
+	m_stats.dwReceiveTime += GetTicks() - dwStart;
+
+	if (iRet <= 0)
+	{
+		// A closed connection is the end of the file when the length is unknown
+		if (iRet == 0 && m_iBodyLeft < 0)
+			m_iLength = m_iRequestPos;
+		else
+			Log(HTTPLOG_WARNING, "connection lost at %lld", (long long)m_iRequestPos);
+
+		Disconnect();
+		return -1;
+	}
+
+	m_stats.iBytesReceived += iRet;
+	m_iRequestPos += iRet;
+	if (m_iBodyLeft > 0)
+		m_iBodyLeft -= iRet;
+
+	return iRet;
+}
+
+bool CHttpRangeStream::Fill(int iMinBytes)
+{
+	int iConsumed = (int)(m_iPos - m_iBufferPos);
+
+	// Make room, keeping a bit of consumed data for backward seeks
+	if (m_iBufferEnd + m_iReadAhead > HTTP_BUFFER_SIZE && iConsumed > HTTP_KEEP_BEHIND)
+	{
+		int iDrop = iConsumed - HTTP_KEEP_BEHIND;
+		memmove(m_pBuffer, m_pBuffer + iDrop, m_iBufferEnd - iDrop);
+		m_iBufferEnd -= iDrop;
+		m_iBufferPos += iDrop;
+		iConsumed -= iDrop;
+	}
+
+	int iWanted = m_iReadAhead - (m_iBufferEnd - iConsumed);
+	if (iWanted > HTTP_BUFFER_SIZE - m_iBufferEnd)
+		iWanted = HTTP_BUFFER_SIZE - m_iBufferEnd;
+
+	int iGot = 0;
+	bool bResumed = false;
+	while (iGot < iWanted)
+	{
+		if (m_iBodyLeft == 0)
+		{
+			// Don't start a new request just to top up
+			if (iGot >= iMinBytes || !ContinueBody())
+				break;
+		}
+
+		int iRet = Receive(m_pBuffer + m_iBufferEnd, iWanted - iGot, iGot < iMinBytes);
+		if (iRet < 0 && iGot < iMinBytes && m_bCanSeek && !bResumed)
+		{
+			// Connection lost in the middle of a body, go on from where it broke once
+			bResumed = true;
+			continue;
+		}
+		if (iRet <= 0)
+			break;
+
+		m_iBufferEnd += iRet;
+		iGot += iRet;
+	}
+
+	return iGot >= iMinBytes;
+}
+
+bool CHttpRangeStream::Drain()
+{
+	if (m_iBodyLeft < 0 || m_iBodyLeft > HTTP_DRAIN_MAX)
+		return false;
+
+	unsigned char scratch[4096];
+	while (m_iBodyLeft > 0)
+	{
+		if (Receive(scratch, sizeof(scratch), true) <= 0)
+			return false;
+	}
+
+	return m_socket != INVALID_SOCKET;
+}
+
+void CHttpRangeStream::ResetBuffer(int64_t iPos)
+{
+	m_iBufferPos = iPos;
+	m_iBufferEnd = 0;
+	m_iPos = iPos;
+	m_iRequestPos = iPos;
+}
@@ -0,0 +1,121 @@
+#ifndef H_CHTTPRANGESTREAM
+#define H_CHTTPRANGESTREAM
+
+// Kept free of XBMC headers, tools/HttpStreamTest builds it on Linux
+
+#ifdef _XBOX
+#include <xtl.h>
+#else
+typedef int SOCKET;
+#endif
+
+#include <stdint.h>
+#include <string>
+
+#define HTTP_READAHEAD_MIN    (64 * 1024)       // read-ahead after open
+#define HTTP_READAHEAD_MAX    (1024 * 1024)     // read-ahead is doubled on every stall up to this
+#define HTTP_KEEP_BEHIND      (64 * 1024)       // consumed data kept for small backward seeks
+#define HTTP_SKIP_FORWARD     (256 * 1024)      // forward seeks up to this read through instead of a new request
+#define HTTP_DRAIN_MAX        (64 * 1024)       // rest of a response we read away to reuse the connection
+#define HTTP_RANGE_CHUNK      (8 * 1024 * 1024) // size of each range request
+#define HTTP_TIMEOUT          10000             // connect and receive timeout in ms
+
+enum HttpLogLevel
+{
+	HTTPLOG_NOTICE,
+	HTTPLOG_WARNING,
+	HTTPLOG_ERROR
+};
+
+struct HttpStreamStats
+{
+	unsigned int iConnects;      // tcp connections opened
+	unsigned int iRequests;      // http requests sent, more than iConnects means keep-alive worked
+	unsigned int iBufferedSeeks; // seeks served from the read-ahead buffer
+	unsigned int iSkipSeeks;     // seeks served by reading through
+	unsigned int iRequestSeeks;  // seeks that needed a new range request
+	unsigned int iStalls;        // reads that found the buffer empty and had to wait
+	unsigned int dwStallTime;    // total time waited in those reads, in ms
+	unsigned int dwReceiveTime;  // total time spent receiving, in ms
+	int64_t iBytesReceived;
+	int64_t iBytesRead;          // bytes handed to the demuxer
+};
+
+/*!
+ \brief Reads a file over HTTP with range requests, for CDVDInputStreamHttp.
+
+ Data is read ahead into a buffer that keeps HTTP_KEEP_BEHIND of consumed
+ data. Seeks inside the buffer need no network, short forward seeks read
+ through and anything else sends a new range request. The file is asked
+ for in HTTP_RANGE_CHUNK ranges on one kept alive connection, a connection
+ the server closed is opened again.
+
+ Resolving host names and logging are left to the platform.
+ */
+class CHttpRangeStream
+{
+public:
+	CHttpRangeStream();
+	virtual ~CHttpRangeStream();
+
+	// http://host[:port]/path
+	bool Open(const char* strUrl);
+	void Close();
+
+	int Read(unsigned char* buf, int buf_size);
+	int64_t Seek(int64_t offset, int whence);
+	int64_t GetLength() const { return m_iLength; }
+	bool IsEOF() const { return m_bEOF; }
+	bool CanSeek() const { return m_bCanSeek; }
+
+	const HttpStreamStats& GetStats() const { return m_stats; }
+	int GetReadAhead() const { return m_iReadAhead; }
+
+	// Throughput of the connection in KB/s, measured while receiving
+	int GetThroughput() const;
+
+protected:
+	// The default only takes dotted addresses, address is in network order
+	virtual bool Resolve(const std::string& strHost, unsigned long& address);
+	virtual void OnLog(HttpLogLevel, const char*) {}
+
+private:
+	void Log(HttpLogLevel level, const char* strFormat, ...);
+
+	bool ParseUrl(const char* strUrl);
+	bool Connect();
+	void Disconnect();
+	bool SendRequest(int64_t iStart);
+	bool ReadResponseHeader();
+	bool ContinueBody();
+	int Receive(unsigned char* buf, int size, bool bWait);
+	bool Fill(int iMinBytes);
+	bool Drain();
+	void ResetBuffer(int64_t iPos);
+
+	std::string m_strHost;
+	std::string m_strPath;
+	int m_iPort;
+
+	SOCKET m_socket;
+	bool m_bKeepAlive;     // server keeps the connection open after a response
+	bool m_bCanSeek;       // server answers range requests
+
+	int64_t m_iLength;       // total size, -1 if unknown
+	int64_t m_iRequestPos;   // file offset of the next byte from the socket
+	int64_t m_iBodyLeft;     // bytes of the current response not yet received, -1 if unknown
+
+	// Read-ahead buffer, holds file data [m_iBufferPos, m_iBufferPos + m_iBufferEnd)
+	unsigned char* m_pBuffer;
+	int m_iBufferEnd;
+	int64_t m_iBufferPos;
+	int64_t m_iPos;          // position of the consumer
+	int m_iReadAhead;        // current read-ahead target
+	int m_iFillsSinceStall;
+
+	bool m_bEOF;
+
+	HttpStreamStats m_stats;
+};
+
+#endif //H_CHTTPRANGESTREAM
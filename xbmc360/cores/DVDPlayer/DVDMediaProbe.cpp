@@ -0,0 +1,453 @@
+#include "DVDMediaProbe.h"
+#include "DVDDemuxers\DVDDemuxFFmpeg.h"
+#include "DVDDemuxers\DVDFormatCache.h"
+#include "..\..\utils\SingleLock.h"
+#include "..\..\utils\Log.h"
+
+#include <algorithm>
+
+CDVDMediaProbe g_mediaProbe;
+
+// How long an idle worker waits before checking for new work or a stop request
+#define MEDIAPROBE_IDLE_WAIT 500
+
+// Installed while the workers run. ffmpeg calls it from every thread that reads, so it has to be cheap
+static int InterruptProbe(void)
+{
+	return g_mediaProbe.IsInterrupted() ? 1 : 0;
+}
+
+// class CDVDMediaProbeWorker
+CDVDMediaProbeWorker::CDVDMediaProbeWorker(CDVDMediaProbe* pOwner, int iIndex)
+{
+	m_pOwner = pOwner;
+	m_iIndex = iIndex;
+}
+
+CDVDMediaProbeWorker::~CDVDMediaProbeWorker()
+{
+}
+
+void CDVDMediaProbeWorker::OnStartup()
+{
+	// Probing must never compete with rendering or playback
+	SetPriority(THREAD_PRIORITY_LOWEST);
+	SetName("CDVDMediaProbeWorker");
+}
+
+void CDVDMediaProbeWorker::Process()
+{
+	m_pOwner->m_dwWorkerThreads[m_iIndex] = GetCurrentThreadId();
+
+	while (!m_bStop)
+	{
+		CStdString strPath;
+		if (!m_pOwner->GetNextJob(strPath))
+		{
+			m_pOwner->m_jobEvent.WaitMSec(MEDIAPROBE_IDLE_WAIT);
+			continue;
+		}
+
+		DVDMediaInfo info;
+		CDVDMediaProbe::ProbeFile(strPath, info, m_pOwner->m_iProbeSize);
+		m_pOwner->JobDone(strPath, info, !info.bValid && m_pOwner->IsInterrupted());
+	}
+
+	m_pOwner->m_dwWorkerThreads[m_iIndex] = 0;
+}
+
+// class CDVDMediaProbe
+CDVDMediaProbe::CDVDMediaProbe()
+{
+	m_iProbeSize = MEDIAPROBE_DEFAULT_PROBESIZE;
+	m_bPaused = false;
+	m_bStopped = true;
+	m_lInterrupt = 1;
+	m_iProbed = 0;
+	m_iFailed = 0;
+	m_iCancelled = 0;
+	m_iInterrupted = 0;
+	m_iEvicted = 0;
+	m_iTotalProbeTime = 0;
+
+	for (int i = 0; i < MEDIAPROBE_MAX_WORKERS; i++)
+		m_dwWorkerThreads[i] = 0;
+}
+
+CDVDMediaProbe::~CDVDMediaProbe()
+{
+	Stop();
+}
+
+void CDVDMediaProbe::Start(int iWorkers, int iProbeSize)
+{
+	Stop();
+
+	if (iWorkers < 1) iWorkers = 1;
+	if (iWorkers > MEDIAPROBE_MAX_WORKERS) iWorkers = MEDIAPROBE_MAX_WORKERS;
+
+	// ffmpeg needs a few KB to detect the container at all
+	m_iProbeSize = iProbeSize < 32 * 1024 ? 32 * 1024 : iProbeSize;
+
+	{
+		CSingleLock lock(m_critSection);
+		m_bStopped = false;
+		UpdateInterrupt();
+	}
+
+	// Register codecs before any worker touches ffmpeg
+	av_register_all();
+	avio_set_interrupt_cb(InterruptProbe);
+
+	for (int i = 0; i < iWorkers; i++)
+	{
+		CDVDMediaProbeWorker* pWorker = new CDVDMediaProbeWorker(this, i);
+		pWorker->Create();
+		m_workers.push_back(pWorker);
+	}
+
+	CLog::Log(LOGNOTICE, "CDVDMediaProbe: started %i worker(s), probe budget %i bytes per file", iWorkers, m_iProbeSize);
+}
+
+void CDVDMediaProbe::Stop()
+{
+	{
+		CSingleLock lock(m_critSection);
+		if (m_bStopped && m_workers.empty())
+			return;
+
+		m_bStopped = true;
+		UpdateInterrupt();
+		m_queue.clear();
+	}
+
+	for (unsigned int i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i]->StopThread();
+		delete m_workers[i];
+	}
+	m_workers.clear();
+
+	avio_set_interrupt_cb(NULL);
+
+	CSingleLock lock(m_critSection);
+	m_active.clear();
+	m_cancelled.clear();
+
+	LogStats();
+}
+
+void CDVDMediaProbe::Pause(bool bPause)
+{
+	CSingleLock lock(m_critSection);
+	if (m_bPaused == bPause)
+		return;
+
+	// Setting it also interrupts the probes that are running
+	m_bPaused = bPause;
+	UpdateInterrupt();
+	if (!m_bPaused)
+		m_jobEvent.Set();
+}
+
+// Called with m_critSection held
+void CDVDMediaProbe::UpdateInterrupt()
+{
+	InterlockedExchange(&m_lInterrupt, m_bPaused || m_bStopped ? 1 : 0);
+}
+
+bool CDVDMediaProbe::IsInterrupted() const
+{
+	if (!m_lInterrupt)
+		return false;
+
+	// The player reads through ffmpeg as well, only our own workers give up
+	DWORD dwThread = GetCurrentThreadId();
+	for (int i = 0; i < MEDIAPROBE_MAX_WORKERS; i++)
+	{
+		if (m_dwWorkerThreads[i] == dwThread)
+			return true;
+	}
+	return false;
+}
+
+bool CDVDMediaProbe::Probe(const CStdString& strPath)
+{
+	CSingleLock lock(m_critSection);
+
+	if (m_bStopped || m_results.find(strPath) != m_results.end())
+		return false;
+
+	// A file that was cancelled while in flight is wanted again after all
+	std::vector<CStdString>::iterator it = std::find(m_cancelled.begin(), m_cancelled.end(), strPath);
+	if (it != m_cancelled.end())
+	{
+		m_cancelled.erase(it);
+		return true;
+	}
+
+	if (std::find(m_active.begin(), m_active.end(), strPath) != m_active.end())
+		return true;
+
+	// The latest request is the item the user is looking at, so it goes first
+	std::deque<CStdString>::iterator itQueue = std::find(m_queue.begin(), m_queue.end(), strPath);
+	if (itQueue != m_queue.end())
+		m_queue.erase(itQueue);
+
+	m_queue.push_front(strPath);
+	m_jobEvent.Set();
+
+	return true;
+}
+
+void CDVDMediaProbe::Cancel(const CStdString& strPath)
+{
+	CSingleLock lock(m_critSection);
+
+	std::deque<CStdString>::iterator it = std::find(m_queue.begin(), m_queue.end(), strPath);
+	if (it != m_queue.end())
+	{
+		m_queue.erase(it);
+		m_iCancelled++;
+		return;
+	}
+
+	// ffmpeg can't be interrupted per context, drop the result once it is done
+	if (std::find(m_active.begin(), m_active.end(), strPath) != m_active.end() &&
+	    std::find(m_cancelled.begin(), m_cancelled.end(), strPath) == m_cancelled.end())
+	{
+		m_cancelled.push_back(strPath);
+		m_iCancelled++;
+	}
+}
+
+void CDVDMediaProbe::CancelAll()
+{
+	CSingleLock lock(m_critSection);
+
+	m_iCancelled += m_queue.size();
+	m_queue.clear();
+
+	for (unsigned int i = 0; i < m_active.size(); i++)
+	{
+		if (std::find(m_cancelled.begin(), m_cancelled.end(), m_active[i]) == m_cancelled.end())
+		{
+			m_cancelled.push_back(m_active[i]);
+			m_iCancelled++;
+		}
+	}
+}
+
+bool CDVDMediaProbe::GetInfo(const CStdString& strPath, DVDMediaInfo& info)
+{
+	CSingleLock lock(m_critSection);
+
+	std::map<CStdString, DVDMediaInfo>::iterator it = m_results.find(strPath);
+	if (it == m_results.end())
+		return false;
+
+	info = it->second;
+	return true;
+}
+
+bool CDVDMediaProbe::HasInfo(const CStdString& strPath)
+{
+	CSingleLock lock(m_critSection);
+	return m_results.find(strPath) != m_results.end();
+}
+
+void CDVDMediaProbe::ClearResults()
+{
+	CSingleLock lock(m_critSection);
+	m_results.clear();
+	m_resultOrder.clear();
+}
+
+bool CDVDMediaProbe::GetNextJob(CStdString& strPath)
+{
+	CSingleLock lock(m_critSection);
+
+	if (m_bStopped || m_bPaused || m_queue.empty())
+		return false;
+
+	strPath = m_queue.front();
+	m_queue.pop_front();
+	m_active.push_back(strPath);
+
+	// Wake another worker if there is more to do
+	if (!m_queue.empty())
+		m_jobEvent.Set();
+
+	return true;
+}
+
+void CDVDMediaProbe::JobDone(const CStdString& strPath, const DVDMediaInfo& info, bool bInterrupted)
+{
+	CSingleLock lock(m_critSection);
+
+	std::vector<CStdString>::iterator it = std::find(m_active.begin(), m_active.end(), strPath);
+	if (it != m_active.end())
+		m_active.erase(it);
+
+	if (bInterrupted)
+	{
+		m_iInterrupted++;
+
+		// Still wanted, it is probed again first thing after the pause
+		it = std::find(m_cancelled.begin(), m_cancelled.end(), strPath);
+		if (it != m_cancelled.end())
+			m_cancelled.erase(it);
+		else if (!m_bStopped)
+			m_queue.push_front(strPath);
+		return;
+	}
+
+	m_iTotalProbeTime += info.iProbeTime;
+	if (info.bValid) m_iProbed++;
+	else m_iFailed++;
+
+	it = std::find(m_cancelled.begin(), m_cancelled.end(), strPath);
+	if (it != m_cancelled.end())
+	{
+		m_cancelled.erase(it);
+		return;
+	}
+
+	// Failed probes are stored too, so broken files are not retried on every scroll
+	StoreResult(strPath, info);
+}
+
+void CDVDMediaProbe::StoreResult(const CStdString& strPath, const DVDMediaInfo& info)
+{
+	std::map<CStdString, DVDMediaInfo>::iterator it = m_results.find(strPath);
+	if (it != m_results.end())
+	{
+		it->second = info;
+		return;
+	}
+
+	m_results.insert(std::make_pair(strPath, info));
+	m_resultOrder.push_back(strPath);
+
+	// Browsing a big collection shouldn't keep every file's info around
+	while (m_resultOrder.size() > MEDIAPROBE_MAX_RESULTS)
+	{
+		m_results.erase(m_resultOrder.front());
+		m_resultOrder.pop_front();
+		m_iEvicted++;
+	}
+}
+
+void CDVDMediaProbe::LogStats()
+{
+	unsigned int iTotal = m_iProbed + m_iFailed;
+
+	CLog::Log(LOGNOTICE, "CDVDMediaProbe: probed %u file(s) (%u failed, %u cancelled, %u interrupted), avg %u ms per file, %u result(s) stored, %u dropped",
+		iTotal, m_iFailed, m_iCancelled, m_iInterrupted, iTotal ? (unsigned int)(m_iTotalProbeTime / iTotal) : 0, (unsigned int)m_results.size(), m_iEvicted);
+}
+
+bool CDVDMediaProbe::ProbeFile(const CStdString& strPath, DVDMediaInfo& info, int iProbeSize)
+{
+	AVFormatContext* pFormatContext = NULL;
+	DWORD dwStart = GetTickCount();
+
+	info = DVDMediaInfo();
+
+	DVDFormatHint hint;
+	bool bHint = g_formatCache.Lookup(strPath, -1, hint);
+
+	if (bHint && CMediaProbeCore::Open(&pFormatContext, strPath.c_str(), hint.pFormat, iProbeSize) != 0)
+	{
+		// Stale hint, fall back to probing
+		g_formatCache.Remove(strPath);
+		bHint = false;
+		pFormatContext = NULL;
+	}
+
+	if (!bHint)
+	{
+		if (CMediaProbeCore::Open(&pFormatContext, strPath.c_str(), NULL, iProbeSize) != 0)
+		{
+			CLog::Log(LOGDEBUG, "CDVDMediaProbe: can't open %s", strPath.c_str());
+			info.iProbeTime = GetTickCount() - dwStart;
+			return false;
+		}
+	}
+
+	// Playback of this file can skip format probing now
+	// The probe reads less than the demuxer, so it only stores the format and leaves the streams to playback
+	if (bHint)
+		g_formatCache.ReportHit(hint.dwProbeTime, GetTickCount() - dwStart);
+	else
+		g_formatCache.Store(strPath, -1, pFormatContext, GetTickCount() - dwStart, false);
+
+	MediaProbeResult result;
+	bool bFound = CMediaProbeCore::FindStreams(pFormatContext, result);
+	av_close_input_file(pFormatContext);
+	info.iProbeTime = GetTickCount() - dwStart;
+
+	if (!bFound)
+	{
+		CLog::Log(LOGDEBUG, "CDVDMediaProbe: can't fetch info from %s", strPath.c_str());
+		return false;
+	}
+
+	info.strContainer = result.strFormat;
+	info.iDuration = result.iDuration;
+
+	for (unsigned int i = 0; i < result.streams.size(); i++)
+	{
+		const MediaProbeStream& stream = result.streams[i];
+
+		switch (stream.type)
+		{
+			case AVMEDIA_TYPE_VIDEO:
+			{
+				// First video stream is the one the player will pick
+				if (info.strVideoCodec.IsEmpty())
+				{
+					info.strVideoCodec = stream.strCodec;
+					info.iWidth = stream.iWidth;
+					info.iHeight = stream.iHeight;
+					info.iFpsRate = stream.iFpsRate;
+					info.iFpsScale = stream.iFpsScale;
+				}
+				break;
+			}
+			case AVMEDIA_TYPE_AUDIO:
+			{
+				if (info.strAudioCodec.IsEmpty())
+				{
+					info.strAudioCodec = stream.strCodec;
+					info.iChannels = stream.iChannels;
+					info.iSampleRate = stream.iSampleRate;
+				}
+				info.iAudioStreams++;
+				break;
+			}
+			case AVMEDIA_TYPE_SUBTITLE:
+			{
+				info.iSubtitleStreams++;
+				break;
+			}
+			default:
+				break;
+		}
+	}
+
+	info.bValid = true;
+
+	// Info that took the whole budget may be incomplete, the probesize setting is the knob
+	if (result.bProbeSizeHit || result.bAnalyzeHit)
+	{
+		const char* strLimit = !result.bAnalyzeHit ? "probesize" : !result.bProbeSizeHit ? "analyze duration" : "probesize and analyze duration";
+		CLog::Log(LOGDEBUG, "CDVDMediaProbe: %s reached the %s limit, %i bytes for %i ms of streams",
+			strPath.c_str(), strLimit, result.iPacketBytes, result.iAnalyzed);
+	}
+
+	CLog::Log(LOGDEBUG, "CDVDMediaProbe: %s [%s] video:%s %ix%i audio:%s %iHz %ich, %i ms, probed in %u ms",
+		strPath.c_str(), info.strContainer.c_str(), info.strVideoCodec.c_str(), info.iWidth, info.iHeight,
+		info.strAudioCodec.c_str(), info.iSampleRate, info.iChannels, info.iDuration, info.iProbeTime);
+
+	return true;
+}
@@ -0,0 +1,155 @@
+#ifndef H_CDVDMEDIAPROBE
+#define H_CDVDMEDIAPROBE
+
+#include "..\..\utils\Thread.h"
+#include "..\..\utils\CriticalSection.h"
+#include "..\..\utils\StdString.h"
+#include "MediaProbeCore.h"
+
+#include <deque>
+#include <map>
+#include <vector>
+
+// Default limits for the background probe, used when no setting overrides them
+#define MEDIAPROBE_DEFAULT_WORKERS      1
+#define MEDIAPROBE_MAX_WORKERS          4
+#define MEDIAPROBE_MAX_RESULTS          4096         // results kept, the oldest is dropped first
+
+// Metadata extracted for one file
+struct DVDMediaInfo
+{
+	DVDMediaInfo()
+	{
+		bValid = false;
+		iDuration = 0;
+		iWidth = 0;
+		iHeight = 0;
+		iFpsRate = 0;
+		iFpsScale = 0;
+		iChannels = 0;
+		iSampleRate = 0;
+		iAudioStreams = 0;
+		iSubtitleStreams = 0;
+		iProbeTime = 0;
+	}
+
+	bool bValid;                 // false if the file could not be probed
+	CStdString strContainer;     // ffmpeg input format name
+	CStdString strVideoCodec;
+	CStdString strAudioCodec;
+	int iDuration;               // in ms
+	int iWidth;
+	int iHeight;
+	int iFpsRate;
+	int iFpsScale;
+	int iChannels;
+	int iSampleRate;
+	int iAudioStreams;
+	int iSubtitleStreams;
+	DWORD iProbeTime;            // time the probe took in ms
+};
+
+class CDVDMediaProbe;
+
+class CDVDMediaProbeWorker : public CThread
+{
+public:
+	CDVDMediaProbeWorker(CDVDMediaProbe* pOwner, int iIndex);
+	virtual ~CDVDMediaProbeWorker();
+
+protected:
+	virtual void OnStartup();
+	virtual void Process();
+
+	CDVDMediaProbe* m_pOwner;
+	int m_iIndex;
+};
+
+/*!
+ \brief Extracts codec, resolution and duration of media files on low priority
+ worker threads so that listings can show it before playback.
+
+ Requests are queued with Probe(), the most recently requested file is handled
+ first. Items that scroll off screen should be withdrawn with Cancel() or
+ CancelAll(), results are kept per file and fetched with GetInfo().
+
+ Pause() also interrupts the probes that are running, they are queued again
+ and start over once the workers are resumed.
+ */
+class CDVDMediaProbe
+{
+	friend class CDVDMediaProbeWorker;
+
+public:
+	CDVDMediaProbe();
+	~CDVDMediaProbe();
+
+	/*!
+	 \brief Start the worker threads
+	 \param iWorkers number of files probed concurrently
+	 \param iProbeSize maximum number of bytes read from a single file
+	 */
+	void Start(int iWorkers = MEDIAPROBE_DEFAULT_WORKERS, int iProbeSize = MEDIAPROBE_DEFAULT_PROBESIZE);
+	void Stop();
+
+	// Workers sleep while paused, used to keep the disk free during playback
+	void Pause(bool bPause);
+
+	// True on a worker thread whose probe should be abandoned, ffmpeg asks through its interrupt callback
+	bool IsInterrupted() const;
+
+	// Queue a file, returns false if a result is already known
+	bool Probe(const CStdString& strPath);
+	void Cancel(const CStdString& strPath);
+	void CancelAll();
+
+	bool GetInfo(const CStdString& strPath, DVDMediaInfo& info);
+	bool HasInfo(const CStdString& strPath);
+	void ClearResults();
+
+	/*!
+	 \brief Probe a file on the calling thread
+	 \param iProbeSize maximum number of bytes read from the file
+	 */
+	static bool ProbeFile(const CStdString& strPath, DVDMediaInfo& info, int iProbeSize = MEDIAPROBE_DEFAULT_PROBESIZE);
+
+private:
+	bool GetNextJob(CStdString& strPath);
+	void JobDone(const CStdString& strPath, const DVDMediaInfo& info, bool bInterrupted);
+	void StoreResult(const CStdString& strPath, const DVDMediaInfo& info);
+	void LogStats();
+	void UpdateInterrupt();
+
+	std::vector<CDVDMediaProbeWorker*> m_workers;
+	std::deque<CStdString> m_queue;
+	std::map<CStdString, DVDMediaInfo> m_results;
+	std::deque<CStdString> m_resultOrder;  // oldest result first
+	std::vector<CStdString> m_active;    // files currently being probed
+	std::vector<CStdString> m_cancelled; // active files whose result should be dropped
+
+	CCriticalSection m_critSection;
+	CEvent m_jobEvent;
+
+	// Thread ids of the running workers, fixed so the interrupt callback can read them unlocked
+	volatile DWORD m_dwWorkerThreads[MEDIAPROBE_MAX_WORKERS];
+
+	int m_iProbeSize;
+	bool m_bPaused;      // both under m_critSection
+	bool m_bStopped;
+
+	// Non zero while paused or stopped, what the interrupt callback reads unlocked.
+	// Written with InterlockedExchange, no other data is published through it.
+	volatile LONG m_lInterrupt;
+
+	// Statistics
+	unsigned int m_iProbed;
+	unsigned int m_iFailed;
+	unsigned int m_iCancelled;
+	unsigned int m_iInterrupted;
+	unsigned int m_iEvicted;
+	DWORD m_iTotalProbeTime;
+};
+
+extern CDVDMediaProbe g_mediaProbe;
+
+#endif //H_CDVDMEDIAPROBE
@@ -201,8 +201,9 @@ void CDVDPlayer::Process()
   
 	try
 	{
+		// The factory opens the demuxer already, opening again would probe the input twice
 		m_pDemuxer = CDVDFactoryDemuxer::CreateDemuxer(m_pInputStream);
-		if (!m_pDemuxer || !m_pDemuxer->Open(m_pInputStream))
+		if (!m_pDemuxer)
 		{
 			throw;
 		}
@@ -228,6 +229,8 @@ void CDVDPlayer::Process()
 	if (audio_index >= 0) OpenAudioStream(audio_index);
 	if (video_index >= 0) OpenVideoStream(video_index);
 
+	UpdateStreamSelection();
+
 	// We are done initializing now, set the readyevent
 	SetEvent(m_hReadyEvent);
 
@@ -844,6 +847,8 @@ bool CDVDPlayer::OpenAudioStream(int iStream)
 
 	m_dvdPlayerAudio.SetPriority(THREAD_PRIORITY_HIGHEST);
 
+	UpdateStreamSelection();
+
 	/* set aspect ratio as requested by navigator for dvd's */ //FIXME MARTY
 //	if( m_pInputStream && m_pInputStream->IsStreamType(DVDSTREAM_TYPE_DVD) )
 //		m_dvdPlayerVideo.m_messageQueue.Put(new CDVDMsgVideoSetAspect(static_cast<CDVDInputStreamNavigator*>(m_pInputStream)->GetVideoAspectRatio()));
@@ -908,6 +913,8 @@ bool CDVDPlayer::OpenVideoStream(int iStream)
 
 	m_dvdPlayerVideo.SetPriority(THREAD_PRIORITY_ABOVE_NORMAL);
 
+	UpdateStreamSelection();
+
 	return true;
 }
 
@@ -925,6 +932,8 @@ bool CDVDPlayer::CloseAudioStream(bool bWaitForBuffers)
 		m_CurrentAudio.id = -1;
 	}
 	UnlockStreams();
+
+	UpdateStreamSelection();
   
 	return true;
 }
@@ -939,9 +948,35 @@ bool CDVDPlayer::CloseVideoStream(bool bWaitForBuffers) // bWaitForBuffers curre
 
 	m_CurrentVideo.id = -1;
 
+	UpdateStreamSelection();
+
 	return true;
 }
 
+void CDVDPlayer::UpdateStreamSelection()
+{
+	if (!m_pDemuxer) return;
+
+	for (int i = 0; i < m_pDemuxer->GetNrOfStreams(); i++)
+	{
+		CDemuxStream* pStream = m_pDemuxer->GetStream(i);
+		if (!pStream) continue;
+
+		bool bEnable;
+
+		// While no stream of a type is playing we keep reading all of them,
+		// so the first usable one can still be opened from Process()
+		if (pStream->type == STREAM_AUDIO)
+			bEnable = m_CurrentAudio.id < 0 ? !pStream->disabled : i == m_CurrentAudio.id;
+		else if (pStream->type == STREAM_VIDEO)
+			bEnable = m_CurrentVideo.id < 0 ? !pStream->disabled : i == m_CurrentVideo.id;
+		else
+			bEnable = false; // subtitles and data aren't played yet
+
+		m_pDemuxer->EnableStream(i, bEnable);
+	}
+}
+
 // Return the time in milliseconds
 __int64 CDVDPlayer::GetTime()
 {
@@ -88,6 +88,9 @@ private:
 
 	int GetPlaySpeed()				{ return m_playSpeed; }
 
+	// Tell the demuxer which streams are read, everything else is discarded
+	void UpdateStreamSelection();
+
 	void HandleMessages();
 	void SyncronizePlayers(DWORD sources);
 	void CheckContinuity(CDVDDemux::DemuxPacket* pPacket, unsigned int source);
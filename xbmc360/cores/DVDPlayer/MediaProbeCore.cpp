@@ -0,0 +1,101 @@
+#include "MediaProbeCore.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _XBOX
+#define snprintf _snprintf
+#endif
+
+// The context is allocated up front so that format detection keeps to the budget as well
+int CMediaProbeCore::Open(AVFormatContext** ppContext, const char* strPath, AVInputFormat* pFormat, int iProbeSize, int iAnalyzeMs)
+{
+	AVFormatParameters params;
+	memset(&params, 0, sizeof(params));
+	params.prealloced_context = 1;
+
+	*ppContext = avformat_alloc_context();
+	if (!*ppContext)
+		return -1;
+
+	(*ppContext)->probesize = iProbeSize;
+	(*ppContext)->max_analyze_duration = (int64_t)iAnalyzeMs * (AV_TIME_BASE / 1000);
+
+	// Frees the context on failure
+	return av_open_input_file(ppContext, strPath, pFormat, 0, &params);
+}
+
+bool CMediaProbeCore::FindStreams(AVFormatContext* pContext, MediaProbeResult& result)
+{
+	result = MediaProbeResult();
+
+	if (pContext->iformat && pContext->iformat->name)
+		result.strFormat = pContext->iformat->name;
+
+	if (av_find_stream_info(pContext) < 0)
+		return false;
+
+	if (pContext->duration != AV_NOPTS_VALUE && pContext->duration > 0)
+		result.iDuration = (int)(pContext->duration / (AV_TIME_BASE / 1000));
+
+	for (unsigned int i = 0; i < pContext->nb_streams; i++)
+	{
+		AVStream* pStream = pContext->streams[i];
+		AVCodecContext* pCodec = pStream->codec;
+
+		MediaProbeStream stream;
+		stream.type = pCodec->codec_type;
+		stream.strCodec = GetCodecName(pCodec);
+		stream.iWidth = pCodec->width;
+		stream.iHeight = pCodec->height;
+		stream.iFpsRate = pStream->avg_frame_rate.num;
+		stream.iFpsScale = pStream->avg_frame_rate.den;
+		stream.iChannels = pCodec->channels;
+		stream.iSampleRate = pCodec->sample_rate;
+		result.streams.push_back(stream);
+	}
+
+	// Every packet read for the info stays buffered for the demuxer, their
+	// size is what counted against the probesize and their time span
+	// against the analyze duration
+	std::vector<int64_t> first(pContext->nb_streams, AV_NOPTS_VALUE);
+	std::vector<int64_t> last(pContext->nb_streams, AV_NOPTS_VALUE);
+	for (AVPacketList* pList = pContext->packet_buffer; pList; pList = pList->next)
+	{
+		const AVPacket& packet = pList->pkt;
+		result.iPacketBytes += packet.size;
+
+		if (packet.stream_index < 0 || packet.stream_index >= (int)pContext->nb_streams || packet.dts == AV_NOPTS_VALUE)
+			continue;
+		if (first[packet.stream_index] == AV_NOPTS_VALUE)
+			first[packet.stream_index] = packet.dts;
+		last[packet.stream_index] = packet.dts;
+	}
+
+	for (unsigned int i = 0; i < pContext->nb_streams; i++)
+	{
+		AVStream* pStream = pContext->streams[i];
+		if (first[i] == AV_NOPTS_VALUE || pStream->time_base.den <= 0)
+			continue;
+
+		AVRational ms = { 1, 1000 };
+		int iAnalyzed = (int)av_rescale_q(last[i] - first[i], pStream->time_base, ms);
+		if (iAnalyzed > result.iAnalyzed)
+			result.iAnalyzed = iAnalyzed;
+	}
+
+	result.bProbeSizeHit = (unsigned int)result.iPacketBytes >= pContext->probesize;
+	result.bAnalyzeHit = (int64_t)result.iAnalyzed * (AV_TIME_BASE / 1000) >= pContext->max_analyze_duration;
+	return true;
+}
+
+std::string CMediaProbeCore::GetCodecName(AVCodecContext* pContext)
+{
+	AVCodec* pCodec = avcodec_find_decoder(pContext->codec_id);
+	if (pCodec && pCodec->name)
+		return pCodec->name;
+
+	char strName[16];
+	snprintf(strName, sizeof(strName), "0x%x", pContext->codec_id);
+	return strName;
+}
@@ -0,0 +1,80 @@
+#ifndef H_CMEDIAPROBECORE
+#define H_CMEDIAPROBECORE
+
+// Kept free of XBMC headers, tools/ProbeBench builds it on Linux
+
+extern "C"
+{
+	#ifndef __STDC_CONSTANT_MACROS
+	#define __STDC_CONSTANT_MACROS
+	#endif
+#include <libavformat/avformat.h>
+}
+
+#include <string>
+#include <vector>
+
+#define MEDIAPROBE_DEFAULT_PROBESIZE    (512 * 1024) // bytes read per file at most
+#define MEDIAPROBE_DEFAULT_ANALYZE_MS   2000         // stream time analyzed per file at most
+
+struct MediaProbeStream
+{
+	AVMediaType type;
+	std::string strCodec;
+	int iWidth;
+	int iHeight;
+	int iFpsRate;
+	int iFpsScale;
+	int iChannels;
+	int iSampleRate;
+};
+
+struct MediaProbeResult
+{
+	MediaProbeResult()
+	{
+		iDuration = 0;
+		iPacketBytes = 0;
+		iAnalyzed = 0;
+		bProbeSizeHit = false;
+		bAnalyzeHit = false;
+	}
+
+	std::string strFormat;      // ffmpeg input format name
+	int iDuration;              // in ms, 0 if unknown
+	std::vector<MediaProbeStream> streams;
+	int iPacketBytes;           // read to find the stream info
+	int iAnalyzed;              // ms of stream time those packets cover, longest stream
+	bool bProbeSizeHit;         // read up to the probesize
+	bool bAnalyzeHit;           // analyzed up to the analyze duration
+};
+
+/*!
+ \brief The part of probing a file that only talks to ffmpeg, shared by
+ CDVDMediaProbe and tools/ProbeBench.
+
+ Open() keeps format detection to the budget as well, FindStreams() reads
+ until the info of every stream is known or the budget is spent and says
+ which limit it reached. ffmpeg doesn't report that, it's worked out from
+ the packets it keeps buffered for the demuxer, so a file whose info was
+ complete right at a limit counts as reaching it.
+ */
+class CMediaProbeCore
+{
+public:
+	/*!
+	 \brief Open a file with probesize and analyze duration applied
+	 \param pFormat skips format detection when not NULL
+	 \return 0 or an ffmpeg error, the context is freed on failure
+	 */
+	static int Open(AVFormatContext** ppContext, const char* strPath, AVInputFormat* pFormat,
+	                int iProbeSize = MEDIAPROBE_DEFAULT_PROBESIZE, int iAnalyzeMs = MEDIAPROBE_DEFAULT_ANALYZE_MS);
+
+	// False if ffmpeg found no stream info, result holds what was found otherwise
+	static bool FindStreams(AVFormatContext* pContext, MediaProbeResult& result);
+
+	// Name of the decoder, the codec id when it isn't compiled in
+	static std::string GetCodecName(AVCodecContext* pContext);
+};
+
+#endif //H_CMEDIAPROBECORE
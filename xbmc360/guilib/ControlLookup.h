@@ -0,0 +1,118 @@
+#ifndef GUILIB_CONTROLLOOKUP_H
+#define GUILIB_CONTROLLOOKUP_H
+
+// Kept free of Xbox headers, tools/WindowBench builds it on Linux
+
+#include <stddef.h>
+
+#include <map>
+#include <vector>
+
+/*!
+ \brief The controls of a window by id, and which of them has focus.
+
+ T is CGUIControl, or anything with GetID(), HasFocus() and a static
+ GetFocusChanges() that counts controls taking focus.
+
+ The focused control is remembered and returned as long as it still has
+ focus. "Nothing has focus" is remembered too and holds until a control
+ takes focus anywhere. Only after a control lost focus on its own are the
+ controls scanned again.
+ */
+template<class T>
+class CControlLookup
+{
+public:
+	typedef std::multimap<int, T*> CONTROLS;
+	typedef typename CONTROLS::iterator iterator;
+	typedef typename CONTROLS::const_iterator const_iterator;
+
+	CControlLookup()
+	{
+		m_focused = NULL;
+		m_bNoFocus = false;
+		m_focusChanges = 0;
+	}
+
+	void Add(T* control)
+	{
+		m_controls.insert(typename CONTROLS::value_type(control->GetID(), control));
+
+		// It may come with focus
+		m_bNoFocus = false;
+	}
+
+	void Remove(T* control)
+	{
+		std::pair<iterator, iterator> range = m_controls.equal_range(control->GetID());
+		for (iterator it = range.first; it != range.second; ++it)
+		{
+			if (it->second == control)
+			{
+				m_controls.erase(it);
+				break;
+			}
+		}
+
+		if (m_focused == control)
+			m_focused = NULL;
+	}
+
+	void Clear()
+	{
+		m_controls.clear();
+		m_focused = NULL;
+		m_bNoFocus = false;
+	}
+
+	// First control added with the id, NULL if there's none
+	T* Get(int id) const
+	{
+		const_iterator it = m_controls.find(id);
+		if (it != m_controls.end()) return it->second;
+		return NULL;
+	}
+
+	// All controls with the id, in the order they were added
+	std::pair<iterator, iterator> Find(int id) { return m_controls.equal_range(id); }
+
+	// control took focus through GUI_MSG_SETFOCUS
+	void SetFocused(T* control)
+	{
+		m_focused = control;
+		m_bNoFocus = false;
+	}
+
+	// controls are the window's in their order, they're only scanned when the cache can't answer
+	T* GetFocused(const std::vector<T*>& controls) const
+	{
+		if (m_focused && m_focused->HasFocus())
+			return m_focused;
+
+		if (m_bNoFocus && m_focusChanges == T::GetFocusChanges())
+			return NULL;
+
+		m_focused = NULL;
+		for (unsigned int i = 0; i < controls.size(); ++i)
+		{
+			if (controls[i]->HasFocus())
+			{
+				m_focused = controls[i];
+				break;
+			}
+		}
+
+		m_bNoFocus = m_focused == NULL;
+		m_focusChanges = T::GetFocusChanges();
+		return m_focused;
+	}
+
+private:
+	CONTROLS m_controls;
+
+	mutable T* m_focused;
+	mutable bool m_bNoFocus;
+	mutable unsigned int m_focusChanges;  // T::GetFocusChanges() when m_bNoFocus was found
+};
+
+#endif //GUILIB_CONTROLLOOKUP_H
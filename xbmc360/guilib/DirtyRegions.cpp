@@ -0,0 +1,216 @@
+#include "DirtyRegions.h"
+#include "GraphicContext.h"
+#include "SpriteBatch.h"
+#include "..\utils\Log.h"
+#include "..\utils\SingleLock.h"
+
+CGUIDirtyRegions g_dirtyRegions;
+
+// Width of the overlay outlines, in pixels
+#define OVERLAY_OUTLINE 2
+
+static void AddToUnion(FRECT& dest, bool& bEmpty, const FRECT& rect)
+{
+	if (bEmpty)
+	{
+		dest = rect;
+		bEmpty = false;
+		return;
+	}
+
+	if (rect.left < dest.left) dest.left = rect.left;
+	if (rect.top < dest.top) dest.top = rect.top;
+	if (rect.right > dest.right) dest.right = rect.right;
+	if (rect.bottom > dest.bottom) dest.bottom = rect.bottom;
+}
+
+CGUIDirtyRegions::CGUIDirtyRegions(void)
+{
+	m_iMode = DIRTYREGIONS_PARTIAL;
+	m_bShowRegions = false;
+
+	// Nothing of ours is in the back buffer yet
+	m_bAllDirty = true;
+
+	m_fLastArea = 0.0f;
+	m_iFrames = 0;
+	m_iSkipped = 0;
+	m_iFull = 0;
+	m_fTotalArea = 0.0;
+}
+
+CGUIDirtyRegions::~CGUIDirtyRegions(void)
+{
+}
+
+void CGUIDirtyRegions::SetMode(int iMode)
+{
+	CSingleLock lock(g_graphicsContext);
+
+	m_iMode = iMode;
+	m_bAllDirty = true;
+}
+
+void CGUIDirtyRegions::SetShowRegions(bool bShow)
+{
+	CSingleLock lock(g_graphicsContext);
+
+	m_bShowRegions = bShow;
+	m_bAllDirty = true;
+}
+
+void CGUIDirtyRegions::MarkDirty(const FRECT& rect)
+{
+	if (rect.right <= rect.left || rect.bottom <= rect.top)
+		return;
+
+	CSingleLock lock(g_graphicsContext);
+
+	m_regions.push_back(rect);
+}
+
+void CGUIDirtyRegions::MarkAllDirty()
+{
+	CSingleLock lock(g_graphicsContext);
+
+	m_bAllDirty = true;
+}
+
+bool CGUIDirtyRegions::EndFrame()
+{
+	CSingleLock lock(g_graphicsContext);
+
+	FRECT screen;
+	screen.left = 0.0f;
+	screen.top = 0.0f;
+	screen.right = (float)g_graphicsContext.GetWidth();
+	screen.bottom = (float)g_graphicsContext.GetHeight();
+
+	FRECT redraw;
+	bool bEmpty = true;
+
+	// Outlines drawn by the overlay have to be painted over again, expired ones a last time
+	DWORD dwNow = GetTickCount();
+	for (unsigned int i = 0; i < m_overlay.size(); )
+	{
+		AddToUnion(redraw, bEmpty, m_overlay[i].rect);
+		if (dwNow - m_overlay[i].dwTime >= DIRTYREGIONS_OVERLAY_TIME)
+			m_overlay.erase(m_overlay.begin() + i);
+		else
+			i++;
+	}
+
+	for (unsigned int i = 0; i < m_regions.size(); i++)
+		AddToUnion(redraw, bEmpty, m_regions[i]);
+
+	if (!bEmpty)
+	{
+		if (redraw.left < screen.left) redraw.left = screen.left;
+		if (redraw.top < screen.top) redraw.top = screen.top;
+		if (redraw.right > screen.right) redraw.right = screen.right;
+		if (redraw.bottom > screen.bottom) redraw.bottom = screen.bottom;
+		bEmpty = redraw.right <= redraw.left || redraw.bottom <= redraw.top;
+	}
+
+	// Quads that were flushed early are drawn already, unclipped
+	bool bFull = m_iMode == DIRTYREGIONS_FULL || m_bAllDirty || g_spriteBatch.WasFlushed();
+
+	if (bEmpty && !bFull)
+	{
+		g_spriteBatch.Discard();
+		m_regions.clear();
+		m_fLastArea = 0.0f;
+		m_iSkipped++;
+		return false;
+	}
+
+	if (m_bShowRegions)
+	{
+		for (unsigned int i = 0; i < m_regions.size(); i++)
+		{
+			OverlayRegion region;
+			region.rect = m_regions[i];
+			region.dwTime = dwNow;
+			m_overlay.push_back(region);
+		}
+	}
+
+	if (bFull || m_iMode != DIRTYREGIONS_PARTIAL)
+		redraw = screen;
+	else
+		g_spriteBatch.SetClip(&redraw);
+
+	if (m_bShowRegions)
+		RenderOverlay(redraw);
+
+	if (bFull)
+		m_iFull++;
+	m_iFrames++;
+
+	float fScreenArea = (screen.right - screen.left) * (screen.bottom - screen.top);
+	m_fLastArea = fScreenArea > 0.0f ? 100.0f * (redraw.right - redraw.left) * (redraw.bottom - redraw.top) / fScreenArea : 0.0f;
+	m_fTotalArea += m_fLastArea;
+
+	m_regions.clear();
+	m_bAllDirty = false;
+	return true;
+}
+
+void CGUIDirtyRegions::RenderOverlay(const FRECT& redraw)
+{
+	DWORD dwNow = GetTickCount();
+	for (unsigned int i = 0; i < m_overlay.size(); i++)
+	{
+		const FRECT& rect = m_overlay[i].rect;
+		if (rect.right <= redraw.left || redraw.right <= rect.left || rect.bottom <= redraw.top || redraw.bottom <= rect.top)
+			continue;
+
+		// Fades out, so a region that changes every frame stands out
+		DWORD dwAge = dwNow - m_overlay[i].dwTime;
+		DWORD dwAlpha = 0xC0 * (DIRTYREGIONS_OVERLAY_TIME - dwAge) / DIRTYREGIONS_OVERLAY_TIME;
+		DWORD dwColor = (dwAlpha << 24) | 0x00FF2020;
+
+		float fWidth = rect.right - rect.left;
+		float fHeight = rect.bottom - rect.top;
+		g_spriteBatch.AddRect(rect.left, rect.top, fWidth, OVERLAY_OUTLINE, dwColor);
+		g_spriteBatch.AddRect(rect.left, rect.bottom - OVERLAY_OUTLINE, fWidth, OVERLAY_OUTLINE, dwColor);
+		g_spriteBatch.AddRect(rect.left, rect.top, OVERLAY_OUTLINE, fHeight, dwColor);
+		g_spriteBatch.AddRect(rect.right - OVERLAY_OUTLINE, rect.top, OVERLAY_OUTLINE, fHeight, dwColor);
+	}
+}
+
+void CGUIDirtyRegions::GetStats(DirtyRegionStats& stats) const
+{
+	CSingleLock lock(g_graphicsContext);
+
+	unsigned int iTotal = m_iFrames + m_iSkipped;
+
+	stats.iFrames = m_iFrames;
+	stats.iSkipped = m_iSkipped;
+	stats.iFull = m_iFull;
+	stats.fLastArea = m_fLastArea;
+	stats.fAverageArea = iTotal ? (float)(m_fTotalArea / iTotal) : 0.0f;
+}
+
+void CGUIDirtyRegions::Reset()
+{
+	CSingleLock lock(g_graphicsContext);
+
+	DirtyRegionStats stats;
+	GetStats(stats);
+	if (stats.iFrames || stats.iSkipped)
+	{
+		CLog::Log(LOGNOTICE, "CGUIDirtyRegions: %u frame(s) presented, %u of them redrawn completely, %u skipped, avg %.1f%% of the screen redrawn per frame",
+			stats.iFrames, stats.iFull, stats.iSkipped, stats.fAverageArea);
+	}
+
+	m_regions.clear();
+	m_overlay.clear();
+	m_bAllDirty = true;
+
+	m_fLastArea = 0.0f;
+	m_iFrames = 0;
+	m_iSkipped = 0;
+	m_iFull = 0;
+	m_fTotalArea = 0.0;
+}
@@ -0,0 +1,90 @@
+#ifndef GUILIB_DIRTYREGIONS_H
+#define GUILIB_DIRTYREGIONS_H
+
+#include "..\utils\Stdafx.h"
+#include "GUITexture.h"
+
+#include <vector>
+
+// What a frame where only part of the GUI changed redraws, "GUI.DirtyRegions" in settings.xml
+#define DIRTYREGIONS_FULL     0 // everything, every frame
+#define DIRTYREGIONS_SKIP     1 // everything, frames where nothing changed aren't drawn at all
+#define DIRTYREGIONS_PARTIAL  2 // only the changed part, needs a swap effect that keeps the back buffer
+
+// How long the debug overlay keeps showing a redrawn rectangle, in ms
+#define DIRTYREGIONS_OVERLAY_TIME 500
+
+struct DirtyRegionStats
+{
+	unsigned int iFrames;       // presented
+	unsigned int iSkipped;      // nothing changed, not drawn
+	unsigned int iFull;         // redrawn completely
+	float fLastArea;            // percent of the screen redrawn in the last frame
+	float fAverageArea;         // per frame, skipped ones count as 0
+};
+
+/*!
+ \brief Collects the parts of the screen that changed this frame and
+ decides what of it has to be drawn.
+
+ Controls report the rectangles they drew differently than in the last
+ frame. Their union is all that has to be redrawn, the sprite batch is
+ clipped to it. When nothing changed the frame isn't drawn or presented
+ and the last one stays on screen.
+ */
+class CGUIDirtyRegions
+{
+public:
+	CGUIDirtyRegions(void);
+	virtual ~CGUIDirtyRegions(void);
+
+	void SetMode(int iMode);
+	int GetMode() const { return m_iMode; }
+
+	// Outlines redrawn rectangles on screen
+	void SetShowRegions(bool bShow);
+
+	void MarkDirty(const FRECT& rect);
+
+	// The next frame is redrawn completely, e.g. after video or a new window
+	void MarkAllDirty();
+
+	/*!
+	 \brief Called once the GUI queued its quads for the frame, before the sprite batch's EndFrame().
+	 \return false when nothing changed, the frame mustn't be presented
+	 */
+	bool EndFrame();
+
+	float GetRedrawArea() const { return m_fLastArea; }
+
+	void GetStats(DirtyRegionStats& stats) const;
+
+	// Logs and clears the stats
+	void Reset();
+
+private:
+	struct OverlayRegion
+	{
+		FRECT rect;
+		DWORD dwTime;
+	};
+
+	void RenderOverlay(const FRECT& redraw);
+
+	int m_iMode;
+	bool m_bShowRegions;
+
+	bool m_bAllDirty;
+	std::vector<FRECT> m_regions;   // this frame
+	std::vector<OverlayRegion> m_overlay;
+
+	float m_fLastArea;
+	unsigned int m_iFrames;
+	unsigned int m_iSkipped;
+	unsigned int m_iFull;
+	double m_fTotalArea;
+};
+
+extern CGUIDirtyRegions g_dirtyRegions;
+
+#endif //GUILIB_DIRTYREGIONS_H
@@ -155,6 +155,7 @@ void CGUIButtonControl::OnClick()
 void CGUIButtonControl::SetLabel(const string &label)
 {	
 	m_label.SetText(label);
+	MarkDirty();
 }
 
 const CStdString CGUIButtonControl::GetLabel()
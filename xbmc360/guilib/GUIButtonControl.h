@@ -36,12 +36,14 @@ public:
 
 	virtual ~CGUIButtonControl(void);
 	virtual void DynamicResourceAlloc(bool bOnOff);
+	virtual unsigned int GetTextureMemory() const { return m_imgFocus.GetMemoryUsage() + m_imgNoFocus.GetMemoryUsage(); };
 	virtual void Update();
 	virtual void Render();
 	virtual bool OnAction(const CAction &action) ;
 	const CStdString GetLabel();
 	void SetLabel(const string & aLabel);
 	void SetClickActions(const vector<CStdString>& clickActions) { m_clickActions = clickActions; };
+	const vector<CStdString>& GetClickActions() const { return m_clickActions; };
 
 protected:
 	virtual void RenderText();
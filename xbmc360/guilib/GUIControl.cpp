@@ -21,9 +21,13 @@
 #include "GUIControl.h"
 #include "GUIWindowManager.h"
 #include "GUIInfoManager.h"
+#include "SpriteBatch.h"
+#include "DirtyRegions.h"
 
 using namespace std;
 
+unsigned int CGUIControl::m_focusChanges = 0;
+
 CGUIControl::CGUIControl()
 {
 	m_hasRendered = false;
@@ -43,6 +47,10 @@ CGUIControl::CGUIControl()
 	m_dwControlUp = 0;
 	m_dwControlDown = 0;
 
+	m_bDirty = true;
+	m_bDrawn = false;
+	m_dwDrawnHash = 0;
+
 	ControlType = GUICONTROL_UNKNOWN;
 }
 
@@ -67,6 +75,10 @@ CGUIControl::CGUIControl(int parentID, int controlID, float posX, float posY, fl
 	m_dwControlRight = 0;
 	m_dwControlUp = 0;
 	m_dwControlDown = 0;
+
+	m_bDirty = true;
+	m_bDrawn = false;
+	m_dwDrawnHash = 0;
 }
 
 CGUIControl::~CGUIControl(void)
@@ -90,6 +102,17 @@ bool CGUIControl::HasFocus(void) const
 
 void CGUIControl::SetFocus(bool bOnOff)
 {
+	if (m_bHasFocus != bOnOff)
+	{
+		MarkDirty();
+
+		// Control.HasFocus() conditions evaluated this frame are out of date
+		g_infoManager.ResetCache();
+
+		if (bOnOff)
+			m_focusChanges++;
+	}
+
 	m_bHasFocus = bOnOff;
 }
 
@@ -112,6 +135,7 @@ void CGUIControl::DynamicResourceAlloc(bool bOnOff)
 
 void CGUIControl::AllocResources()
 {
+	MarkDirty();
 	m_hasRendered = false;
 	m_bInvalidated = true;
 	m_bAllocated = true;
@@ -126,6 +150,7 @@ void CGUIControl::FreeResources()
 //		m_animations[i].ResetAnimation();
 		m_bAllocated=false;
 	}
+	MarkDirty();
 	m_hasRendered = false;
 }
 
@@ -133,6 +158,7 @@ void CGUIControl::FreeResources()
 // 1. animate and set the animation transform
 // 2. if visible, paint
 // 3. reset the animation transform
+// 4. report where we look different than last frame
 void CGUIControl::DoRender()
 {
 /*	Animate(currentTime);
@@ -141,11 +167,36 @@ void CGUIControl::DoRender()
 
 	m_visible = g_infoManager.GetBool(m_visibleCondition);
 
+	g_spriteBatch.ResetRegion();
+
 	if (IsVisible())
 		Render();
 /*	if (m_hasCamera)
 		g_graphicsContext.RestoreCameraPosition();
 	g_graphicsContext.RemoveTransform();*/
+
+	// Position, focus, texture, fade or label changes all end up as different quads
+	DWORD dwHash = 0;
+	FRECT rect;
+	bool bDrawn = g_spriteBatch.GetRegion(dwHash, rect);
+	if (m_bDirty || bDrawn != m_bDrawn || (bDrawn && dwHash != m_dwDrawnHash))
+	{
+		if (m_bDrawn)
+			g_dirtyRegions.MarkDirty(m_drawnRect);
+		if (bDrawn)
+			g_dirtyRegions.MarkDirty(rect);
+		if (m_bDirty)
+		{
+			FRECT area = { m_posX, m_posY, m_posX + m_width, m_posY + m_height };
+			g_dirtyRegions.MarkDirty(area);
+		}
+	}
+
+	m_bDirty = false;
+	m_bDrawn = bDrawn;
+	m_dwDrawnHash = dwHash;
+	if (bDrawn)
+		m_drawnRect = rect;
 }
 
 void CGUIControl::Render()
@@ -250,11 +301,13 @@ bool CGUIControl::OnMessage(CGUIMessage& message)
 			case GUI_MSG_VISIBLE:
 				m_visible = m_visibleCondition ? g_infoManager.GetBool(m_visibleCondition) : true;
 				m_forceHidden = false;
+				MarkDirty();
 				return true;
 				break;
 
 			case GUI_MSG_HIDDEN:
 				m_forceHidden = true;
+				MarkDirty();
 				return true;
 				break;
 		}
@@ -271,6 +324,8 @@ bool CGUIControl::IsVisible() const
 void CGUIControl::SetVisible(bool bVisible)
 {
 	// just force to hidden if necessary
+	if (m_forceHidden == bVisible)
+		MarkDirty();
 	m_forceHidden = !bVisible;
 }
 
@@ -283,6 +338,7 @@ void CGUIControl::SetPosition(float posX, float posY)
 {
 	 if ((m_posX != posX) || (m_posY != posY))
 	{
+		MarkDirty();
 		m_posX = posX;
 		m_posY = posY;
 		Update();
@@ -78,8 +78,17 @@ public:
 	virtual void FreeResources();
 	virtual void Update() {};
 
+	// Video memory held by the control's textures
+	virtual unsigned int GetTextureMemory() const { return 0; };
+
 	void SetFocus(bool bOnOff);
 
+	// Counts controls taking focus, a window's "nothing has focus" holds while this doesn't change
+	static unsigned int GetFocusChanges() { return m_focusChanges; };
+
+	// The control's area is redrawn next frame, for changes the quads it draws don't show
+	void MarkDirty() { m_bDirty = true; };
+
 	int GetXPosition() const;
 	int GetYPosition() const;
 	int GetWidth() const;
@@ -148,6 +157,12 @@ protected:
 	bool m_bHasFocus;
 	bool m_bInvalidated;
 
+	// what the control drew last frame, see DoRender()
+	bool m_bDirty;
+	bool m_bDrawn;
+	DWORD m_dwDrawnHash;
+	FRECT m_drawnRect;
+
 	GUICONTROLTYPES ControlType;
 
 	// visibility condition/state
@@ -162,6 +177,8 @@ protected:
 	bool m_enabled;
 
 	int m_parentID;
+
+	static unsigned int m_focusChanges;
 };
 
 #endif //H_CGUICONTROL
\ No newline at end of file
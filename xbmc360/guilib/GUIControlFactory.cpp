@@ -29,6 +29,7 @@
 #include "GUIInfoManager.h"
 #include "GUISpinControl.h"
 #include "GUISpinControlEx.h"
+#include "GUIListContainer.h"
 
 typedef struct
 {
@@ -80,143 +81,34 @@ CGUIControlFactory::~CGUIControlFactory(void)
 {}
 
 CGUIControl* CGUIControlFactory::Create(int parentID, const FRECT &rect, TiXmlElement* pControlNode, bool insideContainer)
+{
+	ControlDesc desc;
+	Parse(pControlNode, desc);
+	return Create(parentID, desc, insideContainer);
+}
+
+bool CGUIControlFactory::Parse(TiXmlElement* pControlNode, ControlDesc& desc)
 {
 	// resolve any <include> tag's in this control
-//	g_SkinInfo.ResolveIncludes(pControlNode);
+	g_SkinInfo.ResolveIncludes(pControlNode);
 
 	// get the control type
 	CStdString strType = GetType(pControlNode);
-	CGUIControl::GUICONTROLTYPES type = TranslateControlType(strType);
+	desc.iType = TranslateControlType(strType);
 
 	// resolve again with strType set so that <default> tags are added
-//	g_SkinInfo.ResolveIncludes(pControlNode, strType);
-
-	float posX = 0, posY = 0;
-	float width = 0, height = 0;
-	float minWidth = 0;
-
-	DWORD dwID, left = 0, right = 0, up = 0, down = 0;
-
-	int pageControl = 0;
-//	CGUIInfoColor colorDiffuse(0xFFFFFFFF);
-	int defaultControl = 0;
-	bool  defaultAlways = false;
-	CStdString strTmp;
-	int singleInfo = 0;
-	CStdString strLabel;
-	int iUrlSet=0;
-//	int iToggleSelect;
-
-	float spinWidth = 16;
-	float spinHeight = 16;
-	float spinPosX = 0, spinPosY = 0;
-	float checkWidth = 0, checkHeight = 0;
-	CStdString strSubType;
-	int iType = SPIN_CONTROL_TYPE_TEXT;
-	int iMin = 0;
-	int iMax = 100;
-	int iInterval = 1;
-	float fMin = 0.0f;
-	float fMax = 1.0f;
-	float fInterval = 0.1f;
-	bool bReverse = true;
-	bool bReveal = false;
-//	CTextureInfo textureBackground, textureLeft, textureRight, textureMid, textureOverlay;
-//	CTextureInfo textureNib, textureNibFocus, textureBar, textureBarFocus;
-//	CTextureInfo textureLeftFocus, textureRightFocus;
-	CTextureInfo textureUp, textureDown;
-	CTextureInfo textureUpFocus, textureDownFocus;
-	CTextureInfo texture, borderTexture;
-	CGUIInfoLabel textureFile;
-//	CTextureInfo textureCheckMark, textureCheckMarkNF;
-	CTextureInfo textureFocus, textureNoFocus;
-//	CTextureInfo textureAltFocus, textureAltNoFocus;
-//	CTextureInfo textureRadioOn, textureRadioOff;
-//	CTextureInfo imageNoFocus, imageFocus;
-//	CGUIInfoLabel texturePath;
-	FRECT borderSize = { 0, 0, 0, 0};
-
-	float sliderWidth = 150, sliderHeight = 16;
-//	CPoint offset;
-
-	bool bHasPath = false;
-	vector<CStdString> clickActions;
-//	CGUIAction altclickActions;
-//	CGUIAction focusActions;
-//	CGUIAction unfocusActions;
-//	CGUIAction textChangeActions;
-	CStdString strTitle = "";
-	CStdString strRSSTags = "";
-
-	DWORD dwBuddyControlID = 0;
-	int iNumSlots = 7;
-	float buttonGap = 5;
-	int iDefaultSlot = 2;
-	int iMovementRange = 0;
-	bool bHorizontal = false;
-	int iAlpha = 0;
-	bool bWrapAround = true;
-	bool bSmoothScrolling = true;
-//	CAspectRatio aspect;
-#ifdef PRE_SKIN_VERSION_9_10_COMPATIBILITY
-	if (insideContainer)  // default for inside containers is keep
-		aspect.ratio = CAspectRatio::AR_KEEP;
-#endif
-
-	int iVisibleCondition = 0;
-//	CGUIInfoBool allowHiddenFocus(false);
-	int enableCondition = 0;
-
-//	vector<CAnimation> animations;
-
-	bool bScrollLabel = false;
-	bool bPulse = true;
-	unsigned int timePerImage = 0;
-	unsigned int fadeTime = 0;
-	unsigned int timeToPauseAtEnd = 0;
-	bool randomized = false;
-	bool loop = true;
-	bool wrapMultiLine = false;
-//	ORIENTATION orientation = VERTICAL;
-	bool showOnePage = true;
-	bool scrollOut = true;
-	int preloadItems = 0;
-
-	CLabelInfo labelInfo;
-//	CLabelInfo spinInfo;
-
-//	CGUIInfoColor textColor3;
-//	CGUIInfoColor headlineColor;
-
-	float radioWidth = 0;
-	float radioHeight = 0;
-	float radioPosX = 0;
-	float radioPosY = 0;
-
-	CStdString altLabel;
-	CStdString strLabel2;
-
-	int focusPosition = 0;
-	int scrollTime = 200;
-	bool useControlCoords = false;
-	bool renderFocusedLast = false;
-
-//	CRect hitRect;
-//	CPoint camera;
-	bool hasCamera = false;
-	bool resetOnLabelChange = true;
-	bool bPassword = false;
+	g_SkinInfo.ResolveIncludes(pControlNode, strType);
 
 	/////////////////////////////////////////////////////////////////////////////
 	// Read control properties from XML
 	//
 
-	XMLUtils::GetDWORD(pControlNode, "id", dwID);
+	XMLUtils::GetDWORD(pControlNode, "id", desc.dwID);
 	// TODO: Perhaps we should check here whether id is valid for focusable controls
 	// such as buttons etc.  For labels/fadelabels/images it does not matter
 
-	GetFloat(pControlNode, "posx", posX);
-	GetFloat(pControlNode, "posy", posY);
+	GetFloat(pControlNode, "posx", desc.posX);
+	GetFloat(pControlNode, "posy", desc.posY);
 	
   // Convert these from relative coords
 /*  CStdString pos;
@@ -227,8 +119,8 @@ CGUIControl* CGUIControlFactory::Create(int parentID, const FRECT &rect, TiXmlEl
   if (pos.Right(1) == "r")
     posY = (rect.bottom - rect.top) - posY;*/
 
-	GetDimension(pControlNode, "width", width, minWidth);
-	GetFloat(pControlNode, "height", height);
+	GetDimension(pControlNode, "width", desc.width, desc.minWidth);
+	GetFloat(pControlNode, "height", desc.height);
 /*  GetFloat(pControlNode, "offsetx", offset.x);
   GetFloat(pControlNode, "offsety", offset.y);
 
@@ -246,21 +138,21 @@ CGUIControl* CGUIControlFactory::Create(int parentID, const FRECT &rect, TiXmlEl
   hitRect.SetRect(posX, posY, posX + width, posY + height);
   GetHitRect(pControlNode, hitRect);*/
 
-	if (!XMLUtils::GetDWORD(pControlNode, "onup" , up ))
+	if (!XMLUtils::GetDWORD(pControlNode, "onup" , desc.up ))
 	{
-		up = dwID - 1;
+		desc.up = desc.dwID - 1;
 	}
-	if (!XMLUtils::GetDWORD(pControlNode, "ondown" , down))
+	if (!XMLUtils::GetDWORD(pControlNode, "ondown" , desc.down))
 	{
-		down = dwID + 1;
+		desc.down = desc.dwID + 1;
 	}
-	if (!XMLUtils::GetDWORD(pControlNode, "onleft" , left ))
+	if (!XMLUtils::GetDWORD(pControlNode, "onleft" , desc.left ))
 	{
-		left = dwID;
+		desc.left = desc.dwID;
 	}
-	if (!XMLUtils::GetDWORD(pControlNode, "onright", right))
+	if (!XMLUtils::GetDWORD(pControlNode, "onright", desc.right))
 	{
-		right = dwID;
+		desc.right = desc.dwID;
 	}
 
  /*
@@ -276,35 +168,33 @@ CGUIControl* CGUIControlFactory::Create(int parentID, const FRECT &rect, TiXmlEl
 
   GetInfoColor(pControlNode, "colordiffuse", colorDiffuse, parentID);*/
 
-  GetConditionalVisibility(pControlNode, iVisibleCondition/*, allowHiddenFocus*/);
+  GetConditionalVisibility(pControlNode, desc.strVisible/*, allowHiddenFocus*/);
 /*  GetCondition(pControlNode, "enable", enableCondition);
 
   // note: animrect here uses .right and .bottom as width and height respectively (nonstandard)
   FRECT animRect = { posX, posY, width, height };
   GetAnimations(pControlNode, animRect, animations);*/
 
-  XMLUtils::GetHex(pControlNode, "textcolor", labelInfo.dwTextColor);
+  XMLUtils::GetHex(pControlNode, "textcolor", desc.dwTextColor);
 
 /*  GetInfoColor(pControlNode, "focusedcolor", labelInfo.focusedColor, parentID);
   GetInfoColor(pControlNode, "disabledcolor", labelInfo.disabledColor, parentID);
   GetInfoColor(pControlNode, "shadowcolor", labelInfo.shadowColor, parentID);
   GetInfoColor(pControlNode, "selectedcolor", labelInfo.selectedColor, parentID);*/
-  GetFloat(pControlNode, "textoffsetx", labelInfo.offsetX);
-  GetFloat(pControlNode, "textoffsety", labelInfo.offsetY);
+  GetFloat(pControlNode, "textoffsetx", desc.textOffsetX);
+  GetFloat(pControlNode, "textoffsety", desc.textOffsetY);
 /*  int angle = 0;  // use the negative angle to compensate for our vertically flipped cartesian plane
   if (XMLUtils::GetInt(pControlNode, "angle", angle)) labelInfo.angle = (float)-angle;*/
-	CStdString strFont;
-	if (XMLUtils::GetString(pControlNode, "font", strFont))
-		labelInfo.font = g_fontManager.GetFont(strFont);
+	XMLUtils::GetString(pControlNode, "font", desc.strFont);
 
-	GetAlignment(pControlNode, "align", labelInfo.dwAlign);
+	GetAlignment(pControlNode, "align", desc.dwAlign);
 /*  uint32_t alignY = 0;
   if (GetAlignmentY(pControlNode, "aligny", alignY))
     labelInfo.align |= alignY;
   if (GetFloat(pControlNode, "textwidth", labelInfo.width))
     labelInfo.align |= XBFONT_TRUNCATED;*/
 
-	GetMultipleString(pControlNode, "onclick", clickActions);/*
+	GetMultipleString(pControlNode, "onclick", desc.clickActions);/*
   GetActions(pControlNode, "ontextchange", textChangeActions);
   GetActions(pControlNode, "onfocus", focusActions);
   GetActions(pControlNode, "onunfocus", unfocusActions);
@@ -315,8 +205,8 @@ CGUIControl* CGUIControlFactory::Create(int parentID, const FRECT &rect, TiXmlEl
   if (XMLUtils::GetString(pControlNode, "info", infoString))
     singleInfo = g_infoManager.TranslateString(infoString);
 
-*/	GetTexture(pControlNode, "texturefocus", textureFocus);
-	GetTexture(pControlNode, "texturenofocus", textureNoFocus);
+*/	GetTexture(pControlNode, "texturefocus", desc.textureFocus);
+	GetTexture(pControlNode, "texturenofocus", desc.textureNoFocus);
 /*  GetTexture(pControlNode, "alttexturefocus", textureAltFocus);
   GetTexture(pControlNode, "alttexturenofocus", textureAltNoFocus);
   CStdString strToggleSelect;
@@ -326,10 +216,10 @@ CGUIControl* CGUIControlFactory::Create(int parentID, const FRECT &rect, TiXmlEl
 
   XMLUtils::GetBoolean(pControlNode, "haspath", bHasPath);
   */
-	GetTexture(pControlNode, "textureup", textureUp);
-	GetTexture(pControlNode, "texturedown", textureDown);
-	GetTexture(pControlNode, "textureupfocus", textureUpFocus);
-	GetTexture(pControlNode, "texturedownfocus", textureDownFocus);
+	GetTexture(pControlNode, "textureup", desc.textureUp);
+	GetTexture(pControlNode, "texturedown", desc.textureDown);
+	GetTexture(pControlNode, "textureupfocus", desc.textureUpFocus);
+	GetTexture(pControlNode, "texturedownfocus", desc.textureDownFocus);
 
   /*
   GetTexture(pControlNode, "textureleft", textureLeft);
@@ -342,8 +232,11 @@ CGUIControl* CGUIControlFactory::Create(int parentID, const FRECT &rect, TiXmlEl
     spinInfo.font = g_fontManager.GetFont(strFont);
   if (!spinInfo.font) spinInfo.font = labelInfo.font;*/
 
-  GetFloat(pControlNode, "spinwidth", spinWidth);
-  GetFloat(pControlNode, "spinheight", spinHeight);
+  GetFloat(pControlNode, "spinwidth", desc.spinWidth);
+  GetFloat(pControlNode, "spinheight", desc.spinHeight);
+  GetFloat(pControlNode, "itemwidth", desc.itemWidth);
+  GetFloat(pControlNode, "itemheight", desc.itemHeight);
+  GetFloat(pControlNode, "thumbwidth", desc.thumbWidth);
  /* GetFloat(pControlNode, "spinposx", spinPosX);
   GetFloat(pControlNode, "spinposy", spinPosY);
 
@@ -369,18 +262,19 @@ CGUIControl* CGUIControlFactory::Create(int parentID, const FRECT &rect, TiXmlEl
   GetInfoColor(pControlNode, "headlinecolor", headlineColor, parentID);
   GetInfoColor(pControlNode, "titlecolor", textColor3, parentID);
 */
+	CStdString strSubType;
 	if (XMLUtils::GetString(pControlNode, "subtype", strSubType))
 	{
 		strSubType.ToLower();
 
 		if ( strSubType == "int")
-			iType = SPIN_CONTROL_TYPE_INT;
+			desc.iSubType = SPIN_CONTROL_TYPE_INT;
 //		else if ( strSubType == "page")
-//			iType = SPIN_CONTROL_TYPE_PAGE;
+//			desc.iSubType = SPIN_CONTROL_TYPE_PAGE;
 		else if ( strSubType == "float")
-			iType = SPIN_CONTROL_TYPE_FLOAT;
+			desc.iSubType = SPIN_CONTROL_TYPE_FLOAT;
 		else
-			iType = SPIN_CONTROL_TYPE_TEXT;
+			desc.iSubType = SPIN_CONTROL_TYPE_TEXT;
   }
 
 /*  if (!GetIntRange(pControlNode, "range", iMin, iMax, iInterval))
@@ -388,7 +282,7 @@ CGUIControl* CGUIControlFactory::Create(int parentID, const FRECT &rect, TiXmlEl
     GetFloatRange(pControlNode, "range", fMin, fMax, fInterval);
   }
   */
-	 XMLUtils::GetBoolean(pControlNode, "reverse", bReverse);
+	 XMLUtils::GetBoolean(pControlNode, "reverse", desc.bReverse);
  /* XMLUtils::GetBoolean(pControlNode, "reveal", bReveal);
 
   GetTexture(pControlNode, "texturebg", textureBackground);
@@ -398,7 +292,9 @@ CGUIControl* CGUIControlFactory::Create(int parentID, const FRECT &rect, TiXmlEl
   GetTexture(pControlNode, "overlaytexture", textureOverlay);*/
 
 	// the <texture> tag can be overridden by the <info> tag
-	GetInfoTexture(pControlNode, "texture", texture, textureFile, parentID);
+	GetInfoTexture(pControlNode, "texture", desc.texture, desc.textureFile);
+	if (strType == "largeimage")
+		desc.texture.useLarge = true;
 
  /* GetTexture(pControlNode, "bordertexture", borderTexture);
 
@@ -406,10 +302,9 @@ CGUIControl* CGUIControlFactory::Create(int parentID, const FRECT &rect, TiXmlEl
   GetTexture(pControlNode, "imagefolderfocus", imageFocus);
 */
 	// fade label can have a whole bunch, but most just have one
-	vector<CGUIInfoLabel> infoLabels;
-	GetInfoLabels(pControlNode, "label", infoLabels, parentID);
+	GetInfoLabels(pControlNode, "label", desc.infoLabels);
 
-	GetString(pControlNode, "label", strLabel);
+	GetString(pControlNode, "label", desc.strLabel);
 /*  GetString(pControlNode, "altlabel", altLabel);
   GetString(pControlNode, "label2", strLabel2);
 
@@ -450,8 +345,8 @@ CGUIControl* CGUIControlFactory::Create(int parentID, const FRECT &rect, TiXmlEl
   GetFloat(pControlNode, "radioheight", radioHeight);
   GetFloat(pControlNode, "radioposx", radioPosX);
   GetFloat(pControlNode, "radioposy", radioPosY);*/
-  CStdString borderStr;
-/*  if (XMLUtils::GetString(pControlNode, "bordersize", borderStr))
+/*  CStdString borderStr;
+  if (XMLUtils::GetString(pControlNode, "bordersize", borderStr))
     GetRectFromString(borderStr, borderSize);
 
   XMLUtils::GetBoolean(pControlNode, "showonepage", showOnePage);
@@ -522,6 +417,139 @@ CGUIControl* CGUIControlFactory::Create(int parentID, const FRECT &rect, TiXmlEl
   GetString(pControlNode, "scrollsuffix", labelInfo.scrollSuffix);
   spinInfo.scrollSuffix = labelInfo.scrollSuffix;
 */
+	return true;
+}
+
+CGUIControl* CGUIControlFactory::Create(int parentID, const ControlDesc& desc, bool insideContainer)
+{
+	CGUIControl::GUICONTROLTYPES type = (CGUIControl::GUICONTROLTYPES)desc.iType;
+
+	float posX = desc.posX, posY = desc.posY;
+	float width = desc.width, height = desc.height;
+	float minWidth = desc.minWidth;
+
+	DWORD dwID = desc.dwID, left = desc.left, right = desc.right, up = desc.up, down = desc.down;
+
+	int pageControl = 0;
+//	CGUIInfoColor colorDiffuse(0xFFFFFFFF);
+	int defaultControl = 0;
+	bool  defaultAlways = false;
+	CStdString strTmp;
+	int singleInfo = 0;
+	CStdString strLabel = desc.strLabel;
+	int iUrlSet=0;
+//	int iToggleSelect;
+
+	float spinWidth = desc.spinWidth;
+	float spinHeight = desc.spinHeight;
+	float spinPosX = 0, spinPosY = 0;
+	float checkWidth = 0, checkHeight = 0;
+	int iType = desc.iSubType;
+	int iMin = 0;
+	int iMax = 100;
+	int iInterval = 1;
+	float fMin = 0.0f;
+	float fMax = 1.0f;
+	float fInterval = 0.1f;
+	bool bReverse = desc.bReverse;
+	bool bReveal = false;
+//	CTextureInfo textureBackground, textureLeft, textureRight, textureMid, textureOverlay;
+//	CTextureInfo textureNib, textureNibFocus, textureBar, textureBarFocus;
+//	CTextureInfo textureLeftFocus, textureRightFocus;
+	CTextureInfo textureUp = desc.textureUp, textureDown = desc.textureDown;
+	CTextureInfo textureUpFocus = desc.textureUpFocus, textureDownFocus = desc.textureDownFocus;
+	CTextureInfo texture = desc.texture, borderTexture;
+	CGUIInfoLabel textureFile(desc.textureFile.strLabel, desc.textureFile.strFallback, parentID);
+//	CTextureInfo textureCheckMark, textureCheckMarkNF;
+	CTextureInfo textureFocus = desc.textureFocus, textureNoFocus = desc.textureNoFocus;
+//	CTextureInfo textureAltFocus, textureAltNoFocus;
+//	CTextureInfo textureRadioOn, textureRadioOff;
+//	CTextureInfo imageNoFocus, imageFocus;
+//	CGUIInfoLabel texturePath;
+	FRECT borderSize = { 0, 0, 0, 0};
+	CStdString borderStr;
+
+	float sliderWidth = 150, sliderHeight = 16;
+//	CPoint offset;
+
+	bool bHasPath = false;
+	vector<CStdString> clickActions = desc.clickActions;
+//	CGUIAction altclickActions;
+//	CGUIAction focusActions;
+//	CGUIAction unfocusActions;
+//	CGUIAction textChangeActions;
+	CStdString strTitle = "";
+	CStdString strRSSTags = "";
+
+	DWORD dwBuddyControlID = 0;
+	int iNumSlots = 7;
+	float buttonGap = 5;
+	int iDefaultSlot = 2;
+	int iMovementRange = 0;
+	bool bHorizontal = false;
+	int iAlpha = 0;
+	bool bWrapAround = true;
+	bool bSmoothScrolling = true;
+//	CAspectRatio aspect;
+#ifdef PRE_SKIN_VERSION_9_10_COMPATIBILITY
+	if (insideContainer)  // default for inside containers is keep
+		aspect.ratio = CAspectRatio::AR_KEEP;
+#endif
+
+	int iVisibleCondition = desc.strVisible.IsEmpty() ? 0 : g_infoManager.TranslateString(desc.strVisible);
+//	CGUIInfoBool allowHiddenFocus(false);
+	int enableCondition = 0;
+
+//	vector<CAnimation> animations;
+
+	bool bScrollLabel = false;
+	bool bPulse = true;
+	unsigned int timePerImage = 0;
+	unsigned int fadeTime = 0;
+	unsigned int timeToPauseAtEnd = 0;
+	bool randomized = false;
+	bool loop = true;
+	bool wrapMultiLine = false;
+//	ORIENTATION orientation = VERTICAL;
+	bool showOnePage = true;
+	bool scrollOut = true;
+	int preloadItems = 0;
+
+	CLabelInfo labelInfo;
+	labelInfo.dwTextColor = desc.dwTextColor;
+	labelInfo.offsetX = desc.textOffsetX;
+	labelInfo.offsetY = desc.textOffsetY;
+	labelInfo.dwAlign = desc.dwAlign;
+	if (!desc.strFont.IsEmpty())
+		labelInfo.font = g_fontManager.GetFont(desc.strFont);
+//	CLabelInfo spinInfo;
+
+//	CGUIInfoColor textColor3;
+//	CGUIInfoColor headlineColor;
+
+	float radioWidth = 0;
+	float radioHeight = 0;
+	float radioPosX = 0;
+	float radioPosY = 0;
+
+	CStdString altLabel;
+	CStdString strLabel2;
+
+	int focusPosition = 0;
+	int scrollTime = 200;
+	bool useControlCoords = false;
+	bool renderFocusedLast = false;
+
+//	CRect hitRect;
+//	CPoint camera;
+	bool hasCamera = false;
+	bool resetOnLabelChange = true;
+	bool bPassword = false;
+
+	vector<CGUIInfoLabel> infoLabels;
+	for (unsigned int i = 0; i < desc.infoLabels.size(); i++)
+		infoLabels.push_back(CGUIInfoLabel(desc.infoLabels[i].strLabel, desc.infoLabels[i].strFallback, parentID));
+
 	/////////////////////////////////////////////////////////////////////////////
 	// Instantiate a new control using the properties gathered above
 	//
@@ -729,9 +757,6 @@ CGUIControl* CGUIControlFactory::Create(int parentID, const FRECT &rect, TiXmlEl
   }
 */	else if (type == CGUIControl::GUICONTROL_IMAGE)
 	{
-		if (strType == "largeimage")
-			texture.useLarge = true;
-
 		// use a bordered texture if we have <bordersize> or <bordertexture> specified.
 		if (borderTexture.filename.IsEmpty() && borderStr.IsEmpty())
 			control = new CGUIImage(
@@ -748,6 +773,17 @@ CGUIControl* CGUIControlFactory::Create(int parentID, const FRECT &rect, TiXmlEl
 //		((CGUIImage *)control)->SetAspectRatio(aspect);
 //		((CGUIImage *)control)->SetCrossFade(fadeTime);
 	}
+	else if (type == CGUIControl::GUICONTAINER_LIST || type == CGUIControl::GUICONTAINER_PANEL)
+	{
+		float itemWidth = (type == CGUIControl::GUICONTAINER_LIST) ? width : desc.itemWidth;
+
+		control = new CGUIListContainer(
+			parentID, dwID, posX, posY, width, height,
+			itemWidth, desc.itemHeight, desc.thumbWidth,
+			textureFocus, textureNoFocus, labelInfo);
+
+		control->SetNavigation(up, down, left, right);
+	}
 /*  else if (type == CGUIControl::GUICONTROL_MULTI_IMAGE)
   {
     control = new CGUIMultiImage(
@@ -886,11 +922,11 @@ bool CGUIControlFactory::GetDimension(const TiXmlNode *pRootNode, const char* st
 	return g_SkinInfo.ResolveConstant(pNode->FirstChild()->Value(), value);
 }
 
-bool CGUIControlFactory::GetInfoTexture(const TiXmlNode* pRootNode, const char* strTag, CTextureInfo &image, CGUIInfoLabel &info, int parentID)
+bool CGUIControlFactory::GetInfoTexture(const TiXmlNode* pRootNode, const char* strTag, CTextureInfo &image, InfoLabelDesc &info)
 {
 	GetTexture(pRootNode, strTag, image);
 	image.filename = "";
-	GetInfoLabel(pRootNode, strTag, info, parentID);
+	GetInfoLabel(pRootNode, strTag, info);
 	return true;
 }
 
@@ -928,7 +964,7 @@ bool CGUIControlFactory::GetAlignment(const TiXmlNode* pRootNode, const char* st
 	return true;
 }
 
-bool CGUIControlFactory::GetInfoLabelFromElement(const TiXmlElement *element, CGUIInfoLabel &infoLabel, int parentID)
+bool CGUIControlFactory::GetInfoLabelFromElement(const TiXmlElement *element, InfoLabelDesc &infoLabel)
 {
 	if (!element || !element->FirstChild())
 		return false;
@@ -946,19 +982,20 @@ bool CGUIControlFactory::GetInfoLabelFromElement(const TiXmlElement *element, CG
 		fallback = g_localizeStrings.Get(atoi(fallback));
 	else
 		g_charsetConverter.unknownToUTF8(fallback);*/
-	infoLabel.SetLabel(label, fallback, parentID);
+	infoLabel.strLabel = label;
+	infoLabel.strFallback = fallback;
 	return true;
 }
 
-void CGUIControlFactory::GetInfoLabel(const TiXmlNode *pControlNode, const CStdString &labelTag, CGUIInfoLabel &infoLabel, int parentID)
+void CGUIControlFactory::GetInfoLabel(const TiXmlNode *pControlNode, const CStdString &labelTag, InfoLabelDesc &infoLabel)
 {
-	vector<CGUIInfoLabel> labels;
-	GetInfoLabels(pControlNode, labelTag, labels, parentID);
+	vector<InfoLabelDesc> labels;
+	GetInfoLabels(pControlNode, labelTag, labels);
 	if (labels.size())
 		infoLabel = labels[0];
 }
 
-void CGUIControlFactory::GetInfoLabels(const TiXmlNode *pControlNode, const CStdString &labelTag, vector<CGUIInfoLabel> &infoLabels, int parentID)
+void CGUIControlFactory::GetInfoLabels(const TiXmlNode *pControlNode, const CStdString &labelTag, vector<InfoLabelDesc> &infoLabels)
 {
 	// we can have the following infolabels:
 	// 1.  <number>1234</number> -> direct number
@@ -968,16 +1005,16 @@ void CGUIControlFactory::GetInfoLabels(const TiXmlNode *pControlNode, const CStd
 	int labelNumber = 0;
 	if (XMLUtils::GetInt(pControlNode, "number", labelNumber))
 	{
-		CStdString label;
-		label.Format("%i", labelNumber);
-		infoLabels.push_back(CGUIInfoLabel(label));
+		InfoLabelDesc label;
+		label.strLabel.Format("%i", labelNumber);
+		infoLabels.push_back(label);
 		return; // done
 	}
 	const TiXmlElement *labelNode = pControlNode->FirstChildElement(labelTag);
 	while (labelNode)
 	{
-		CGUIInfoLabel label;
-		if (GetInfoLabelFromElement(labelNode, label, parentID))
+		InfoLabelDesc label;
+		if (GetInfoLabelFromElement(labelNode, label))
 			infoLabels.push_back(label);
 		labelNode = labelNode->NextSiblingElement(labelTag);
 	}
@@ -987,15 +1024,16 @@ void CGUIControlFactory::GetInfoLabels(const TiXmlNode *pControlNode, const CStd
 		// <info> nodes override <label>'s (backward compatibility)
 		CStdString fallback;
 		if (infoLabels.size())
-			fallback = infoLabels[0].GetLabel(0);
+			fallback = CGUIInfoLabel(infoLabels[0].strLabel, infoLabels[0].strFallback).GetLabel(0);
 		infoLabels.clear();
     while (infoNode)
     {
 		if (infoNode->FirstChild())
 		{
-			CStdString info;
-			info.Format("$INFO[%s]", infoNode->FirstChild()->Value());
-			infoLabels.push_back(CGUIInfoLabel(info, fallback, parentID));
+			InfoLabelDesc info;
+			info.strLabel.Format("$INFO[%s]", infoNode->FirstChild()->Value());
+			info.strFallback = fallback;
+			infoLabels.push_back(info);
 		}
 		infoNode = infoNode->NextSibling("info");
     }
@@ -1012,6 +1050,16 @@ CGUIControl::GUICONTROLTYPES CGUIControlFactory::TranslateControlType(const CStd
 }
 
 bool CGUIControlFactory::GetConditionalVisibility(const TiXmlNode* control, int &condition)
+{
+	CStdString conditionString;
+	if (!GetConditionalVisibility(control, conditionString))
+		return false;
+
+	condition = g_infoManager.TranslateString(conditionString);
+	return (condition != 0);
+}
+
+bool CGUIControlFactory::GetConditionalVisibility(const TiXmlNode* control, CStdString &condition)
 {
 	const TiXmlElement* node = control->FirstChildElement("visible");
 	if (!node) return false;
@@ -1027,17 +1075,16 @@ bool CGUIControlFactory::GetConditionalVisibility(const TiXmlNode* control, int
 	if (!conditions.size())
 		return false;
 	if (conditions.size() == 1)
-		condition = g_infoManager.TranslateString(conditions[0]);
+		condition = conditions[0];
 	else
 	{
 		// multiple conditions should be anded together
-		CStdString conditionString = "[";
+		condition = "[";
 		for (unsigned int i = 0; i < conditions.size() - 1; i++)
-			conditionString += conditions[i] + "] + [";
-		conditionString += conditions[conditions.size() - 1] + "]";
-		condition = g_infoManager.TranslateString(conditionString);
+			condition += conditions[i] + "] + [";
+		condition += conditions[conditions.size() - 1] + "]";
 	}
-	return (condition != 0);
+	return !condition.IsEmpty();
 }
 
 
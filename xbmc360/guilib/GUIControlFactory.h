@@ -25,17 +25,86 @@
 #include "tinyxml\tinyxml.h"
 #include "GUITexture.h"
 #include "GUIInfoTypes.h"
+#include "GUISpinControl.h"
 
 #include <vector>
 
 using namespace std;
 
+// An info label as written in the skin, parsed into a CGUIInfoLabel when the control is created
+struct InfoLabelDesc
+{
+	CStdString strLabel;
+	CStdString strFallback;
+};
+
+/*!
+ \brief Everything a control is created from, read from its <control> element.
+
+ Constants are resolved and colours parsed already. Fonts, conditions and
+ info labels are kept by name, the handles they resolve to only live as
+ long as the skin and the info manager, they are looked up on Create().
+ */
+struct ControlDesc
+{
+	ControlDesc()
+	{
+		iType = CGUIControl::GUICONTROL_UNKNOWN;
+		dwID = 0;
+		posX = posY = 0;
+		width = height = minWidth = 0;
+		up = down = left = right = 0;
+		dwTextColor = D3DCOLOR_ARGB(255, 255, 255, 255);
+		textOffsetX = textOffsetY = 0;
+		dwAlign = 0;
+		iSubType = SPIN_CONTROL_TYPE_TEXT;
+		bReverse = true;
+		spinWidth = spinHeight = 16;
+		itemWidth = itemHeight = thumbWidth = 0;
+	}
+
+	int iType;                // CGUIControl::GUICONTROLTYPES
+	DWORD dwID;
+	float posX, posY;
+	float width, height, minWidth;
+	DWORD up, down, left, right;
+	CStdString strVisible;    // visibility condition
+
+	DWORD dwTextColor;
+	float textOffsetX, textOffsetY;
+	DWORD dwAlign;
+	CStdString strFont;
+
+	vector<CStdString> clickActions;
+
+	CTextureInfo textureFocus, textureNoFocus;
+	CTextureInfo textureUp, textureDown;
+	CTextureInfo textureUpFocus, textureDownFocus;
+	CTextureInfo texture;
+	InfoLabelDesc textureFile;
+
+	vector<InfoLabelDesc> infoLabels;
+	CStdString strLabel;
+
+	int iSubType;             // SPIN_CONTROL_TYPE_xxx
+	bool bReverse;
+	float spinWidth, spinHeight;
+
+	float itemWidth, itemHeight;  // lists and panels, a list's items are as wide as the list
+	float thumbWidth;
+};
+
 class CGUIControlFactory
 {
 public:
 	CGUIControlFactory(void);
 	virtual ~CGUIControlFactory(void);
 	CGUIControl* Create(int parentID, const FRECT &rect, TiXmlElement* pControlNode, bool insideContainer = false);
+	CGUIControl* Create(int parentID, const ControlDesc& desc, bool insideContainer = false);
+
+	// Reads a <control> element, Create() builds the control from it without looking at the XML again
+	static bool Parse(TiXmlElement* pControlNode, ControlDesc& desc);
+
 	static bool GetFloat(const TiXmlNode* pRootNode, const char* strTag, float& value);
 
    /*
@@ -46,7 +115,7 @@ public:
    \return true if we found and read the tag.
    */
 	static bool GetDimension(const TiXmlNode* pRootNode, const char* strTag, float &value, float &min);
-	static bool GetInfoTexture(const TiXmlNode* pRootNode, const char* strTag, CTextureInfo &image, CGUIInfoLabel &info, int parentID);
+	static bool GetInfoTexture(const TiXmlNode* pRootNode, const char* strTag, CTextureInfo &image, InfoLabelDesc &info);
 	static bool GetTexture(const TiXmlNode* pRootNode, const char* strTag, CTextureInfo &image);
 	static bool GetAlignment(const TiXmlNode* pRootNode, const char* strTag, DWORD& alignment);
 
@@ -60,9 +129,9 @@ public:
 	\param infoLabel returned infoLabel
 	\return true if a valid info label was read, false otherwise
 	*/
-	static bool GetInfoLabelFromElement(const TiXmlElement *element, CGUIInfoLabel &infoLabel, int parentID);
-	static void GetInfoLabel(const TiXmlNode *pControlNode, const CStdString &labelTag, CGUIInfoLabel &infoLabel, int parentID);
-	static void GetInfoLabels(const TiXmlNode *pControlNode, const CStdString &labelTag, std::vector<CGUIInfoLabel> &infoLabels, int parentID);
+	static bool GetInfoLabelFromElement(const TiXmlElement *element, InfoLabelDesc &infoLabel);
+	static void GetInfoLabel(const TiXmlNode *pControlNode, const CStdString &labelTag, InfoLabelDesc &infoLabel);
+	static void GetInfoLabels(const TiXmlNode *pControlNode, const CStdString &labelTag, std::vector<InfoLabelDesc> &infoLabels);
 
 	/*! \brief translate from control name to control type
 	\param type name of the control
@@ -71,11 +140,12 @@ public:
 	static CGUIControl::GUICONTROLTYPES TranslateControlType(const CStdString &type);
 
 	static bool GetConditionalVisibility(const TiXmlNode* control, int &condition);
+	static bool GetConditionalVisibility(const TiXmlNode* control, CStdString &condition);
 
 private:
 	static CStdString GetType(const TiXmlElement *pControlNode);
-	bool GetString(const TiXmlNode* pRootNode, const char* strTag, CStdString& strString);
-	bool GetMultipleString(const TiXmlNode* pRootNode, const char* strTag, vector<CStdString>& vecStringValue);
+	static bool GetString(const TiXmlNode* pRootNode, const char* strTag, CStdString& strString);
+	static bool GetMultipleString(const TiXmlNode* pRootNode, const char* strTag, vector<CStdString>& vecStringValue);
 };
 
 #endif //H_CGUICONTROLFACTORY
\ No newline at end of file
@@ -1,55 +1,11 @@
 #include "GUID3DTexture.h"
 #include "GraphicContext.h"
-#include "GraphicContext.h"
+#include "SpriteBatch.h"
+#include "TextureManager.h"
 #include "..\utils\Log.h"
 
-namespace D3DTextureShaders
-{
-//-------------------------------------------------------------------------------------
-// Vertex shader
-// We use the register semantic here to directly define the input register
-// matWVP.  Conversely, we could let the HLSL compiler decide and check the
-// constant table.
-//-------------------------------------------------------------------------------------
-const char* g_strVertexShaderProgram =
-    " float4x4 matWVP : register(c0);              "
-    "                                              "
-    " struct VS_IN                                 "
-    " {                                            "
-    "     float4 ObjPos   : POSITION;              "  // Object space position 
-    "     float2 TexCoord : TEXCOORD;              "
-    " };                                           "
-    "                                              "
-    " struct VS_OUT                                "
-    " {                                            "
-    "     float4 ProjPos  : POSITION;              "  // Projected space position 
-    "     float2 TexCoord : TEXCOORD;              "
-    " };                                           "
-    "                                              "
-    " VS_OUT main( VS_IN In )                      "
-    " {                                            "
-    "     VS_OUT Out;                              "
-    "     Out.ProjPos = mul( matWVP, In.ObjPos );  "  // Transform vertex into
-    "     Out.TexCoord = In.TexCoord;              "
-    "     return Out;                              "
-    " }                                            ";
-
-//-------------------------------------------------------------------------------------
-// Pixel shader
-//-------------------------------------------------------------------------------------
-const char* g_strPixelShaderProgram =
-    " struct PS_IN                                 "
-    " {                                            "
-    "     float2 TexCoord : TEXCOORD;              "
-    " };                                           "  // the vertex shader
-    "                                              "
-    " sampler detail;                              "
-    "                                              "
-    " float4 main( PS_IN In ) : COLOR              "
-    " {                                            "
-    "     return tex2D( detail, In.TexCoord );     "  // Output color
-    " }                                            ";
-}
+// Textures that arrive from a background load fade in over this time, in ms
+#define TEXTURE_FADE_TIME 150
 
 CGUID3DTexture::CGUID3DTexture(float posX, float posY, float width, float height, const CTextureInfo& texture)
 {
@@ -63,12 +19,14 @@ CGUID3DTexture::CGUID3DTexture(float posX, float posY, float width, float height
 
 	m_bVisible = true;
 
-	m_pd3dDevice = NULL;
 	m_pTexture = NULL;
-	m_pVB = NULL;
-	m_pVertexShader = NULL;
-	m_pVertexDecl = NULL;
-	m_pPixelShader = NULL;
+	m_uv.left = m_uv.top = 0.0f;
+	m_uv.right = m_uv.bottom = 1.0f;
+	m_bReferenced = false;
+	m_bLoading = false;
+	m_bPrioritized = false;
+	m_bWaited = false;
+	m_dwFadeStart = 0;
 }
 
 CGUID3DTexture::~CGUID3DTexture()
@@ -77,14 +35,23 @@ CGUID3DTexture::~CGUID3DTexture()
 
 void CGUID3DTexture::SetFileName(const CStdString &strFilename)
 {
+	if (m_strFilename == strFilename)
+		return;
+
+	// Swap the texture reference if we already hold one
+	bool bAllocated = m_initialized;
+	if (bAllocated)
+		FreeResources();
+
 	m_strFilename = strFilename;
+
+	if (bAllocated)
+		AllocResources();
 }
 
 bool CGUID3DTexture::AllocResources()
 {
-	m_pd3dDevice = g_graphicsContext.Get3DDevice();
-
-	if(!m_pd3dDevice)
+	if(!g_graphicsContext.Get3DDevice())
 		return false;
 
 	if(m_initialized)
@@ -93,97 +60,17 @@ bool CGUID3DTexture::AllocResources()
 	if ( !g_graphicsContext.IsFullScreenVideo() )
 		g_graphicsContext.Lock();
 
-	// Compile vertex shader.
-	ID3DXBuffer* pVertexShaderCode;
-	ID3DXBuffer* pVertexErrorMsg;
-   
-	D3DXCompileShader( D3DTextureShaders::g_strVertexShaderProgram,
-                                    ( UINT )strlen( D3DTextureShaders::g_strVertexShaderProgram ),
-                                    NULL,
-                                    NULL,
-                                    "main",
-                                    "vs_2_0",
-                                    0,
-                                    &pVertexShaderCode,
-                                    &pVertexErrorMsg,
-                                    NULL );
-
-    // Create vertex shader.
-    m_pd3dDevice->CreateVertexShader( ( DWORD* )pVertexShaderCode->GetBufferPointer(),
-                                      &m_pVertexShader );
-
-    // Compile pixel shader.
-	ID3DXBuffer* pPixelShaderCode;
-    ID3DXBuffer* pPixelErrorMsg;
-
-	D3DXCompileShader( D3DTextureShaders::g_strPixelShaderProgram,
-                            ( UINT )strlen( D3DTextureShaders::g_strPixelShaderProgram ),
-                            NULL,
-                            NULL,
-                            "main",
-                            "ps_2_0",
-                            0,
-                            &pPixelShaderCode,
-                            &pPixelErrorMsg,
-                            NULL );
-
-    // Create pixel shader.
-    m_pd3dDevice->CreatePixelShader( ( DWORD* )pPixelShaderCode->GetBufferPointer(),
-                                     &m_pPixelShader );
-
-    // Define the vertex elements and
-    // Create a vertex declaration from the element descriptions.
-    static const D3DVERTEXELEMENT9 VertexElements[3] =
-    {
-        { 0,  0, D3DDECLTYPE_FLOAT3, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_POSITION, 0 },
-        { 0, 12, D3DDECLTYPE_FLOAT2, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_TEXCOORD, 0 },
-        D3DDECL_END()
-    };
-    m_pd3dDevice->CreateVertexDeclaration( VertexElements, &m_pVertexDecl );
-
-    // Create the vertex buffer. Here we are allocating enough memory
-    // (from the default pool) to hold all our 3 custom vertices. 
-    m_pd3dDevice->CreateVertexBuffer( 4 * sizeof( COLORVERTEX ),
-                                                  D3DUSAGE_WRITEONLY,
-                                                  NULL,
-                                                  D3DPOOL_MANAGED,
-                                                  &m_pVB,
-                                                  NULL );
-	if(pVertexShaderCode)
-		pVertexShaderCode->Release();
-
-	if(pVertexErrorMsg)
-		pVertexErrorMsg->Release();
-
-	if(pPixelShaderCode)
-		pPixelShaderCode->Release();
-
-	if(pPixelErrorMsg)
-		pPixelErrorMsg->Release();
-
-	COLORVERTEX Vertices[] =
-    {
-        {(FLOAT)m_posX, (FLOAT)m_posY,  0.0f, 0, 0 ,},
-        {(FLOAT)m_posX+m_width, (FLOAT)m_posY, 0.0f,  1, 0 ,},
-        {(FLOAT)m_posX, (FLOAT)m_height+(FLOAT)m_posY, 0.0f,  0, 1 ,},
-	    {(FLOAT)m_posX+(FLOAT)m_width, (FLOAT)m_posY+(FLOAT)m_height, 0.0f,  1, 1 ,},
-    };
-
-    COLORVERTEX* pVertices;
-    m_pVB->Lock( 0, 0, ( void** )&pVertices, 0 );
-    memcpy( pVertices, Vertices, 4 * sizeof( COLORVERTEX ) );
-    m_pVB->Unlock();
-
-    // Initialize the world and view matrix
-    D3DXMatrixIdentity( &m_matWorld );
-    D3DXMatrixIdentity( &m_matView );
-
-    // Initialize the projection matrix
-	D3DXMatrixOrthoOffCenterLH(&m_matProj, 0, (float)g_graphicsContext.GetWidth(), (float)g_graphicsContext.GetHeight(), 0, 0.0f, 1.0f ); 
-	
-	g_TextureManager.Load(m_strFilename, NULL);
-
-	m_pTexture = g_TextureManager.GetTexture(m_strFilename);
+	// Vertices, shaders and states are owned by the sprite batch,
+	// all we need is the texture. Until it's read nothing is drawn.
+	m_bReferenced = g_TextureManager.LoadAsync(m_strFilename, m_bVisible ? TEXTURE_PRIORITY_VISIBLE : TEXTURE_PRIORITY_PRELOAD);
+	if (m_bReferenced)
+	{
+		m_pTexture = g_TextureManager.GetTexture(m_strFilename, &m_uv);
+		m_bLoading = !m_pTexture;
+		m_bPrioritized = m_bVisible;
+		m_bWaited = false;
+		m_dwFadeStart = 0;
+	}
 
 	m_initialized = true;
 
@@ -193,6 +80,14 @@ bool CGUID3DTexture::AllocResources()
 	return true;
 }
 
+unsigned int CGUID3DTexture::GetMemoryUsage() const
+{
+	if (!m_bReferenced)
+		return 0;
+
+	return g_TextureManager.GetMemoryUsage(m_strFilename);
+}
+
 bool CGUID3DTexture::FreeResources()
 {
 	if(!m_initialized)
@@ -200,40 +95,13 @@ bool CGUID3DTexture::FreeResources()
 
 	m_initialized = false;
 
-//	if ( !g_graphicsContext.IsFullScreenVideo() )
-		g_graphicsContext.Lock();
-
-	if(m_pVB)
+	if (m_bReferenced)
 	{
-		m_pd3dDevice->SetStreamSource( NULL, NULL, NULL, NULL );
-		m_pVB->Release();
-		m_pVB = NULL;
+		g_TextureManager.ReleaseTexture(m_strFilename);
+		m_bReferenced = false;
 	}
-
-	if(m_pVertexShader)
-	{
-		m_pd3dDevice->SetVertexShader( NULL );
-		m_pVertexShader->Release();
-		m_pVertexShader = NULL;
-	}
-
-	if(m_pVertexDecl)
-	{
-		m_pd3dDevice->SetVertexDeclaration( NULL );
-		m_pVertexDecl->Release();
-		m_pVertexDecl = NULL;
-	}
-
-	if(m_pPixelShader)
-	{
-		m_pd3dDevice->SetPixelShader( NULL );
-		m_pPixelShader->Release();
-		m_pPixelShader = NULL;
-	}
-
-//	if ( !g_graphicsContext.IsFullScreenVideo() )	
-		g_graphicsContext.Unlock();
-
+	m_pTexture = NULL;
+	m_bLoading = false;
 
 	return true;
 }
@@ -247,89 +115,52 @@ void CGUID3DTexture::Update(float fPosX, float fPosY)
 {
 	m_posY = fPosY;
 	m_posX = fPosX;
-
-	if( !m_pd3dDevice || !m_pVB )
-		return;
-
-	COLORVERTEX Vertices[] =
-    {
-        {(FLOAT)m_posX, (FLOAT)m_posY,  0.0f, 0, 0 ,},
-        {(FLOAT)m_posX+m_width, (FLOAT)m_posY, 0.0f,  1, 0 ,},
-        {(FLOAT)m_posX, (FLOAT)m_height+(FLOAT)m_posY, 0.0f,  0, 1 ,},
-	    {(FLOAT)m_posX+(FLOAT)m_width, (FLOAT)m_posY+(FLOAT)m_height, 0.0f,  1, 1 ,},
-    };
-
-    COLORVERTEX* pVertices;
-    m_pVB->Lock( 0, 0, ( void** )&pVertices, 0 );
-    memcpy( pVertices, Vertices, 4 * sizeof( COLORVERTEX ) );
-    m_pVB->Unlock();
-
-    // Initialize the world and view matrix
-    D3DXMatrixIdentity( &m_matWorld );
-    D3DXMatrixIdentity( &m_matView );
-
-    // Initialize the projection matrix
-	D3DXMatrixOrthoOffCenterLH(&m_matProj, 0, (float)g_graphicsContext.GetWidth(), (float)g_graphicsContext.GetHeight(), 0, 0.0f, 1.0f ); 
 }
 
 void CGUID3DTexture::Render()
 {
-	if( !m_pd3dDevice || !m_pVertexShader || !m_pVB )
-	{
-		CLog::Log(LOGERROR, "Direct3D rendering objects missing!");
+	if( !m_initialized )
 		return;
-	}
-
-	if ( !g_graphicsContext.IsFullScreenVideo() )
-		g_graphicsContext.Lock();
-
-#if 1 //FIXME
-
-	COLORVERTEX Vertices[] =
-    {
-        {(FLOAT)m_posX, (FLOAT)m_posY,  0.0f, 0, 0 ,},
-        {(FLOAT)m_posX+m_width, (FLOAT)m_posY, 0.0f,  1, 0 ,},
-        {(FLOAT)m_posX, (FLOAT)m_height+(FLOAT)m_posY, 0.0f,  0, 1 ,},
-	    {(FLOAT)m_posX+(FLOAT)m_width, (FLOAT)m_posY+(FLOAT)m_height, 0.0f,  1, 1 ,},
-    };
-
-    COLORVERTEX* pVertices;
-    m_pVB->Lock( 0, 0, ( void** )&pVertices, 0 );
-    memcpy( pVertices, Vertices, 4 * sizeof( COLORVERTEX ) );
-    m_pVB->Unlock();
 
-    // Initialize the world and view matrix
-    D3DXMatrixIdentity( &m_matWorld );
-    D3DXMatrixIdentity( &m_matView );
-
-    // Initialize the projection matrix
-	D3DXMatrixOrthoOffCenterLH(&m_matProj, 0, (float)g_graphicsContext.GetWidth(), (float)g_graphicsContext.GetHeight(), 0, 0.0f, 1.0f ); 
-
-#endif
-
-    // Build the world-view-projection matrix and pass it into the vertex shader
-    D3DXMATRIX matWVP = m_matWorld * m_matView * m_matProj;
-    m_pd3dDevice->SetVertexShaderConstantF( 0, ( FLOAT* )&matWVP, 4 );
-
-    m_pd3dDevice->SetSamplerState( 0, D3DSAMP_MAGFILTER, D3DTEXF_ANISOTROPIC );
-    m_pd3dDevice->SetSamplerState( 0, D3DSAMP_MINFILTER, D3DTEXF_ANISOTROPIC );
-    m_pd3dDevice->SetSamplerState( 0, D3DSAMP_MIPFILTER, D3DTEXF_LINEAR );
-
-	// We are passing the vertices down a "stream", so first we need
-    // to specify the source of that stream, which is our vertex buffer. 
-    // Then we need to let D3D know what vertex and pixel shaders to use. 
-    m_pd3dDevice->SetVertexDeclaration( m_pVertexDecl );
-	m_pd3dDevice->SetStreamSource( 0, m_pVB, 0, sizeof( COLORVERTEX ) );
-    m_pd3dDevice->SetVertexShader( m_pVertexShader );
-    m_pd3dDevice->SetPixelShader( m_pPixelShader );
+	if (m_bLoading)
+	{
+		m_pTexture = g_TextureManager.GetTexture(m_strFilename, &m_uv);
+		if (m_pTexture)
+		{
+			m_bLoading = false;
+
+			// A preloaded texture that was ready before it was shown just appears
+			if (m_bWaited)
+				m_dwFadeStart = GetTickCount();
+		}
+		else
+		{
+			m_bWaited = true;
+
+			if (!g_TextureManager.IsLoading(m_strFilename))
+				m_bLoading = false; // failed, keep the reference until we're freed
+			else if (!m_bPrioritized)
+			{
+				// We're on screen now, read it before the preloads
+				g_TextureManager.Prioritize(m_strFilename);
+				m_bPrioritized = true;
+			}
+			return;
+		}
+	}
 
-	m_pd3dDevice->SetTexture( 0, m_pTexture );
-    // Draw the vertices in the vertex buffer
-	m_pd3dDevice->DrawPrimitive( D3DPT_TRIANGLESTRIP, 0, 2 );
-	m_pd3dDevice->SetTexture( 0,  NULL );
+	if (!m_pTexture)
+		return;
 
-	m_pd3dDevice->SetStreamSource( NULL, NULL, NULL, NULL );
+	DWORD dwColor = 0xFFFFFFFF;
+	if (m_dwFadeStart)
+	{
+		DWORD dwElapsed = GetTickCount() - m_dwFadeStart;
+		if (dwElapsed >= TEXTURE_FADE_TIME)
+			m_dwFadeStart = 0;
+		else
+			dwColor = ((dwElapsed * 255 / TEXTURE_FADE_TIME) << 24) | 0x00FFFFFF;
+	}
 
-	if ( !g_graphicsContext.IsFullScreenVideo() )
-		g_graphicsContext.Unlock();
-}
\ No newline at end of file
+	g_spriteBatch.AddQuad(m_pTexture, m_uv, m_posX, m_posY, m_width, m_height, dwColor);
+}
@@ -15,6 +15,9 @@ public:
 
 	bool AllocResources();
 	bool FreeResources();
+
+	// Video memory of the texture while we hold it, 0 otherwise
+	unsigned int GetMemoryUsage() const;
 	void SetVisible(bool bOnOff);
 	void Update(float fPosX, float fPosY);
 	void Render();
@@ -23,23 +26,13 @@ private:
 	CStdString m_strFilename;
 	bool m_initialized;
 
-	LPDIRECT3DDEVICE9 m_pd3dDevice;
-
-	struct COLORVERTEX
-	{
-		float   Position[3];
-		float   TexCoord[2];
-	};
-
-	IDirect3DVertexBuffer9*			m_pVB;           // Buffer to hold vertices
-	IDirect3DVertexDeclaration9*	m_pVertexDecl;   // Vertex format decl
-	IDirect3DVertexShader9*			m_pVertexShader; // Vertex Shader
-	IDirect3DPixelShader9*			m_pPixelShader;  // Pixel Shader
-	LPDIRECT3DTEXTURE9				m_pTexture;
-
-	D3DXMATRIX						m_matWorld;
-	D3DXMATRIX						m_matProj;
-	D3DXMATRIX						m_matView;
+	LPDIRECT3DTEXTURE9 m_pTexture;
+	FRECT m_uv;           // part of m_pTexture we draw, less than all of it for atlas images
+	bool m_bReferenced;   // we hold a texture manager reference
+	bool m_bLoading;      // waiting for a background load
+	bool m_bPrioritized;  // the background load was raised to visible
+	bool m_bWaited;       // we were rendered without the texture, so fade it in
+	DWORD m_dwFadeStart;  // tick count the texture arrived, 0 when not fading
 };
 
 #endif //GUILIB_GUID3DTEXTURE_H
\ No newline at end of file
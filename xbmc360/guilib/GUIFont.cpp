@@ -1,14 +1,26 @@
 #include "GUIFont.h"
+#include "GUIFontManager.h"
 #include "GraphicContext.h"
+#include "..\utils\Log.h"
 #include "..\utils\StringUtils.h"
 
+// Skins and labels still use the XUI style flags
+static DWORD GetGlyphStyle(DWORD dwFlags)
+{
+	DWORD dwStyle = GLYPH_STYLE_NORMAL;
+	if (dwFlags & XUI_FONT_STYLE_BOLD)
+		dwStyle |= GLYPH_STYLE_BOLD;
+	if (dwFlags & XUI_FONT_STYLE_ITALIC)
+		dwStyle |= GLYPH_STYLE_ITALIC;
+	return dwStyle;
+}
+
 CGUIFont::CGUIFont(void)
 {
-	m_wstrFontName = L"";
-	m_wstrFontFile = L"";
-	m_dwStyle = 0;
+	m_strFontName = "";
+	m_iFace = -1;
+	m_dwStyle = GLYPH_STYLE_NORMAL;
 	m_fSize = 0;
-	m_Font = NULL;
 }
 
 CGUIFont::~CGUIFont(void)
@@ -17,114 +29,47 @@ CGUIFont::~CGUIFont(void)
 
 const CStdString CGUIFont::GetFontName()
 {
-	// Convert back to a normal string from wide
-	string strFontName( m_wstrFontName.begin(), m_wstrFontName.end() );
-	
-	return strFontName;
+	return m_strFontName;
 }
 
 bool CGUIFont::Load(const CStdString& strFontName,const CStdString& strFilename, int iSize, DWORD dwStyles)
 {
-	CStdString strFontPath = g_graphicsContext.GetMediaDir();
-
-#if 1 // Nasty workaround for XUI to work..
-	strFontPath.Replace("D:\\", "file://game:/");
-#endif
+	CStdString strFontPath = g_graphicsContext.GetMediaDir() + "fonts\\" + strFilename;
 
-	strFontPath += "fonts/" + strFilename;
-
-	// Convert to wide for our wide members
-	CStringUtils::StringtoWString(strFontName, m_wstrFontName);
-	CStringUtils::StringtoWString(strFontPath, m_wstrFontFile);
+	// Fonts using the same file share its outlines
+	m_iFace = g_fontManager.LoadFace(strFontPath);
+	if (m_iFace < 0)
+	{
+		CLog::Log(LOGERROR, "CGUIFont: unable to load %s for font %s", strFontPath.c_str(), strFontName.c_str());
+		return false;
+	}
 
-	m_dwStyle = dwStyles;
+	m_strFontName = strFontName;
+	m_dwStyle = GetGlyphStyle(dwStyles);
 	m_fSize = (float)iSize;
 
-	TypefaceDescriptor typeface = {0};
-	typeface.szTypeface = m_wstrFontName.c_str();
-	typeface.szLocator = m_wstrFontFile.c_str();
-	typeface.szReserved1 = NULL;
-	XuiRegisterTypeface( &typeface, TRUE );
-
-	XuiCreateFont( m_wstrFontName.c_str(), m_fSize, dwStyles, 0, &m_Font );
-
-	return true;
-}
-
-bool CGUIFont::Reload(DWORD dwStyles)
-{
-	TypefaceDescriptor typeface = {0};
-	typeface.szTypeface = m_wstrFontName.c_str();
-	typeface.szLocator = m_wstrFontFile.c_str();
-	typeface.szReserved1 = NULL;
-	XuiRegisterTypeface( &typeface, TRUE );
-
-	XuiCreateFont( m_wstrFontName.c_str(), m_fSize, dwStyles, 0, &m_Font );
-
 	return true;
 }
 
-bool CGUIFont::DrawText( float fPosX, float fPosY, DWORD dwColor, const CStdString strText, DWORD dwFlags/* = XUI_FONT_STYLE_NORMAL*//*, FLOAT fMaxPixelWidth*/ )
+bool CGUIFont::DrawText( float fPosX, float fPosY, DWORD dwColor, const CStdString& strText, DWORD dwFlags/* = XUI_FONT_STYLE_NORMAL*/, float fMaxWidth/* = 0*/, int iOverflow/* = GLYPH_OVERFLOW_NONE*/ )
 {
-	if ( !g_graphicsContext.IsFullScreenVideo() )
-		g_graphicsContext.Lock();
-
 	// Convert our text string to wide
 	wstring wstrText;
 	CStringUtils::StringtoWString(strText, wstrText);
 
-	XuiRenderBegin( g_graphicsContext.GetXUIDevice(), D3DCOLOR_ARGB(255,0,0,0) );
-
-	// If our font syle changed we need to recreate our font..
-	// Why does XUI make this a pain to do ugh..
-	if(m_dwStyle != dwFlags)
-	{
-		Release();
-		Reload(dwFlags);
-		m_dwStyle = dwFlags;
-	}
-
-	// Measure the text
-	XUIRect clipRect( 0, 0, g_graphicsContext.GetWidth() - fPosX, g_graphicsContext.GetHeight() - fPosY );
-	XuiMeasureText( m_Font, wstrText.c_str(), -1, dwFlags, 0, &clipRect );
-
-	if(dwFlags & XUI_FONT_STYLE_RIGHT_ALIGN) //HACK: Using XUI to do this should be easy, but it's a pain in the butt...
-	{
-		clipRect.right = g_graphicsContext.GetWidth() - fPosX + clipRect.GetWidth();
-		fPosX = fPosX - clipRect.GetWidth();
-	}
-
-	// Set the text position in the device context
-	D3DXMATRIX matXForm;
-	D3DXMatrixIdentity( &matXForm );
-	matXForm._41 = fPosX;
-	matXForm._42 = fPosY;
-	XuiRenderSetTransform( g_graphicsContext.GetXUIDevice(), &matXForm );
-
-	// Select the font and color into the device context
-    XuiSelectFont( g_graphicsContext.GetXUIDevice(), m_Font );
-    XuiSetColorFactor( g_graphicsContext.GetXUIDevice(), ( DWORD )dwColor );
-
-    // Set the view
-    D3DXMATRIX matView;
-    D3DXMatrixIdentity( &matView );
-    XuiRenderSetViewTransform( g_graphicsContext.GetXUIDevice(), &matView );
-
-	// Draw the text
-	XuiDrawText( g_graphicsContext.GetXUIDevice(), wstrText.c_str(), dwFlags, 0, &clipRect );
-	
-	XuiRenderEnd( g_graphicsContext.GetXUIDevice() );
-	XuiRenderPresent( g_graphicsContext.GetXUIDevice(), NULL, NULL, NULL );
+	return DrawText(fPosX, fPosY, dwColor, wstrText, dwFlags, fMaxWidth, iOverflow);
+}
 
-	if ( !g_graphicsContext.IsFullScreenVideo() )
-		g_graphicsContext.Unlock();
+bool CGUIFont::DrawText( float fPosX, float fPosY, DWORD dwColor, const std::wstring& strText, DWORD dwFlags/* = XUI_FONT_STYLE_NORMAL*/, float fMaxWidth/* = 0*/, int iOverflow/* = GLYPH_OVERFLOW_NONE*/, CTextLayoutCache::Ref* pRef/* = NULL*/ )
+{
+	// Labels add their alignment and maybe a style on top of the font's own
+	int iAlign = (dwFlags & XUI_FONT_STYLE_RIGHT_ALIGN) ? GLYPH_ALIGN_RIGHT : GLYPH_ALIGN_LEFT;
 
-	return true;
+	return g_fontManager.DrawText(m_iFace, m_fSize, m_dwStyle | GetGlyphStyle(dwFlags), iAlign, fMaxWidth, iOverflow, fPosX, fPosY, dwColor, strText, pRef);
 }
 
 void CGUIFont::Release()
 {
-	// Release the font
-	XuiReleaseFont( m_Font );
-	m_Font = NULL;
+	// The face belongs to the font manager
+	m_iFace = -1;
 }
\ No newline at end of file
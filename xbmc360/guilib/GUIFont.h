@@ -3,6 +3,8 @@
 
 #include "..\utils\StdString.h"
 #include "..\utils\Stdafx.h"
+#include "GlyphCache.h"
+#include "TextLayoutCache.h"
 #include <xui.h>
 
 class CGUIFont
@@ -13,16 +15,19 @@ public:
 
 	const CStdString GetFontName();
 	bool Load(const CStdString& strFontName,const CStdString& strFilename, int iSize, DWORD dwStyles);
-	bool Reload(DWORD dwStyles);
-	bool DrawText( float fPosX, float fPosY, DWORD dwColor, const CStdString strText, DWORD dwFlags = XUI_FONT_STYLE_NORMAL/*, FLOAT fMaxPixelWidth*/ );
+	// Lines wider than fMaxWidth are handled as iOverflow (GLYPH_OVERFLOW_xxx) says
+	bool DrawText( float fPosX, float fPosY, DWORD dwColor, const CStdString& strText, DWORD dwFlags = XUI_FONT_STYLE_NORMAL, float fMaxWidth = 0, int iOverflow = GLYPH_OVERFLOW_NONE );
+
+	// Text that was converted before, labels keep it wide between frames. With
+	// pRef the layout is reused until the caller resets it for new text.
+	bool DrawText( float fPosX, float fPosY, DWORD dwColor, const std::wstring& strText, DWORD dwFlags = XUI_FONT_STYLE_NORMAL, float fMaxWidth = 0, int iOverflow = GLYPH_OVERFLOW_NONE, CTextLayoutCache::Ref* pRef = NULL );
 	void Release();
 
 private:
-	std::wstring m_wstrFontName;
-	std::wstring m_wstrFontFile;
+	CStdString m_strFontName;
+	int m_iFace;        // in the font manager's glyph cache
 	float m_fSize;
-	DWORD m_dwStyle;
-	HXUIFONT m_Font;
+	DWORD m_dwStyle;    // GLYPH_STYLE_xxx
 };
 
 #endif //CGUILIB_GUIFONT_H
\ No newline at end of file
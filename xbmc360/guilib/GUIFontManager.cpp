@@ -1,11 +1,19 @@
 #include "GUIFontManager.h"
+#include "GraphicContext.h"
+#include "SpriteBatch.h"
 #include "..\utils\Log.h"
+#include "..\utils\SingleLock.h"
 #include "tinyxml\tinyxml.h"
 
+#include <math.h>
+
 GUIFontManager g_fontManager;
 
 GUIFontManager::GUIFontManager(void)
+	: m_glyphs(GLYPH_PAGE_WIDTH, GLYPH_PAGE_HEIGHT)
+	, m_layouts(m_glyphs)
 {
+	m_pGlyphTexture = NULL;
 }
 
 GUIFontManager::~GUIFontManager(void)
@@ -52,7 +60,9 @@ void GUIFontManager::LoadFonts(const CStdString& strFilename)
 					if (iSize <= 0) iSize = 20;
 				}
 
-				pNode = pNode->FirstChild("style");
+				// Styles are synthesized now, so fonts can share a regular face
+				dwStyle = XUI_FONT_STYLE_NORMAL;
+				pNode = pChild->FirstChild("style");
 				if(pNode)
 				{
 					string style = pNode->FirstChild()->Value();
@@ -109,4 +119,116 @@ void GUIFontManager::Clear()
 		delete pFont;
 	}
 	m_vecFonts.erase(m_vecFonts.begin(),m_vecFonts.end());
+
+	CSingleLock lock(g_graphicsContext);
+
+	GlyphCacheStats stats;
+	m_glyphs.GetStats(stats);
+	CLog::Log(LOGDEBUG, "GUIFontManager: %u text(s) laid out, %u glyph hit(s), %u glyph(s) rendered, page emptied %u time(s)",
+		stats.iLayouts, stats.iHits, stats.iMisses, stats.iResets);
+
+	// Hits are labels drawn without laying them out again
+	TextLayoutStats layoutStats;
+	m_layouts.GetStats(layoutStats);
+	unsigned int iLookups = layoutStats.iHits + layoutStats.iMisses + layoutStats.iStale;
+	CLog::Log(LOGDEBUG, "GUIFontManager: %u layout(s) cached, %u hit(s), %u miss(es), %u stale, %u eviction(s), %u%% hit rate",
+		layoutStats.iEntries, layoutStats.iHits, layoutStats.iMisses, layoutStats.iStale, layoutStats.iEvictions,
+		iLookups ? layoutStats.iHits * 100 / iLookups : 0);
+
+	m_layouts.Clear();
+	m_glyphs.Reset();
+
+	if (m_pGlyphTexture)
+	{
+		// Quads queued this frame may still point at the texture
+		g_spriteBatch.Flush();
+		m_pGlyphTexture->Release();
+		m_pGlyphTexture = NULL;
+	}
+}
+
+int GUIFontManager::LoadFace(const CStdString& strPath)
+{
+	CSingleLock lock(g_graphicsContext);
+	return m_glyphs.LoadFace(strPath);
+}
+
+bool GUIFontManager::DrawText(int iFace, float fSize, DWORD dwStyle, int iAlign, float fMaxWidth, int iOverflow,
+                              float fPosX, float fPosY, DWORD dwColor, const std::wstring& strText, CTextLayoutCache::Ref* pRef)
+{
+	CSingleLock lock(g_graphicsContext);
+
+	if (!m_pGlyphTexture)
+	{
+		if (g_graphicsContext.Get3DDevice()->CreateTexture(GLYPH_PAGE_WIDTH, GLYPH_PAGE_HEIGHT, 1, 0, D3DFMT_LIN_A8R8G8B8,
+		                                                   D3DPOOL_MANAGED, &m_pGlyphTexture, NULL) != D3D_OK)
+		{
+			CLog::Log(LOGERROR, "GUIFontManager: unable to create the glyph texture");
+			m_pGlyphTexture = NULL;
+			return false;
+		}
+	}
+
+	// Text drawn with a ref is the same as last time until its owner resets it
+	const TextLayout* pLayout = pRef ? m_layouts.Get(*pRef) : NULL;
+	if (!pLayout)
+		pLayout = m_layouts.Get(iFace, fSize, dwStyle, iAlign, fMaxWidth, iOverflow, strText, pRef);
+	if (!pLayout)
+	{
+		// The page is full. Draw the text queued so far while its glyphs are
+		// still there, and let the GPU finish before they're overwritten.
+		g_spriteBatch.Flush();
+		g_graphicsContext.Get3DDevice()->BlockUntilIdle();
+
+		m_glyphs.Clear();
+		pLayout = m_layouts.Get(iFace, fSize, dwStyle, iAlign, fMaxWidth, iOverflow, strText, pRef);
+		if (!pLayout)
+		{
+			CLog::Log(LOGWARNING, "GUIFontManager: text needs more glyphs than fit in the page");
+			return false;
+		}
+	}
+
+	if (!UploadGlyphs())
+		return false;
+
+	// Layouts are made at 0,0, whole pixel offsets keep glyphs texel for pixel
+	float fOffsetX = floorf(fPosX + 0.5f);
+	float fOffsetY = floorf(fPosY + 0.5f);
+
+	for (unsigned int i = 0; i < pLayout->quads.size(); i++)
+	{
+		const GlyphQuad& quad = pLayout->quads[i];
+		FRECT uv = { quad.u1, quad.v1, quad.u2, quad.v2 };
+		g_spriteBatch.AddQuad(m_pGlyphTexture, uv, fOffsetX + quad.fPosX, fOffsetY + quad.fPosY, quad.fWidth, quad.fHeight, dwColor, true);
+	}
+
+	return true;
+}
+
+bool GUIFontManager::UploadGlyphs()
+{
+	int iTop, iBottom;
+	if (!m_glyphs.GetDirtyRows(iTop, iBottom))
+		return true;
+
+	// Only rows with new glyphs, the quads drawn earlier use other parts of the page
+	RECT rect = { 0, iTop, m_glyphs.GetWidth(), iBottom };
+	D3DLOCKED_RECT lr;
+	if (m_pGlyphTexture->LockRect(0, &lr, &rect, 0) != D3D_OK)
+		return false;
+
+	// White texels with the coverage as alpha, the quad's colour tints them
+	for (int y = iTop; y < iBottom; y++)
+	{
+		const unsigned char* pSource = m_glyphs.GetPixels() + y * m_glyphs.GetWidth();
+		DWORD* pDest = (DWORD*)((BYTE*)lr.pBits + (y - iTop) * lr.Pitch);
+		for (int x = 0; x < m_glyphs.GetWidth(); x++)
+			pDest[x] = ((DWORD)pSource[x] << 24) | 0x00FFFFFF;
+	}
+
+	m_pGlyphTexture->UnlockRect(0);
+	m_glyphs.ClearDirty();
+
+	return true;
 }
\ No newline at end of file
@@ -4,6 +4,12 @@
 #include <string>
 #include <vector>
 #include "GUIFont.h"
+#include "GlyphCache.h"
+#include "TextLayoutCache.h"
+
+// Glyphs of every font share one texture, so the text of a frame can be drawn together
+#define GLYPH_PAGE_WIDTH  512
+#define GLYPH_PAGE_HEIGHT 512
 
 using namespace std;
 
@@ -17,8 +23,22 @@ public:
 	CGUIFont* Load(const string& strFontName, const string& strFilename, int iSize, DWORD dwStyles);
 	CGUIFont* GetFont(const string& strFontName);
 	void Clear();
+
+	// Returns the face id in the glyph cache, -1 if the file can't be used
+	int LoadFace(const CStdString& strPath);
+
+	// Queues the text's glyphs in the sprite batch, fMaxWidth and iOverflow as in CGlyphCache::Layout()
+	bool DrawText(int iFace, float fSize, DWORD dwStyle, int iAlign, float fMaxWidth, int iOverflow,
+	              float fPosX, float fPosY, DWORD dwColor, const std::wstring& strText, CTextLayoutCache::Ref* pRef = NULL);
+
 private:
+	bool UploadGlyphs();
+
 	vector<CGUIFont*> m_vecFonts;
+
+	CGlyphCache m_glyphs;
+	CTextLayoutCache m_layouts;
+	LPDIRECT3DTEXTURE9 m_pGlyphTexture;
 };
 
 extern GUIFontManager g_fontManager;
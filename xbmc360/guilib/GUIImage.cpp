@@ -29,6 +29,7 @@ void CGUIImage::FreeResources()
 void CGUIImage::SetInfo(const CGUIInfoLabel &info)
 {
 	m_info = info;
+	MarkDirty();
 	// a constant image never needs updating
 	if (m_info.IsConstant())
 		m_texture.SetFileName(m_info.GetLabel(0));
@@ -13,6 +13,7 @@ public:
 
 	virtual void AllocResources();
 	virtual void FreeResources();
+	virtual unsigned int GetTextureMemory() const { return m_texture.GetMemoryUsage(); };
 	virtual void SetInfo(const CGUIInfoLabel &info);
 	virtual void Update();
 	virtual void Render();
@@ -23,19 +23,267 @@
 #include "SkinInfo.h"
 //#include "GUIInfoManager.h"
 //#include "interfaces/info/SkinVariable.h"
+#include "..\utils\SingleLock.h"
+#include "..\utils\Log.h"
+
+#include <algorithm>
 
 using namespace std;
 
 CGUIIncludes::CGUIIncludes()
 {
+	m_iExpanded = 0;
+	m_iTemplates = 0;
+
+	m_constantNodes.insert("posx");
+	m_constantNodes.insert("posy");
+	m_constantNodes.insert("width");
+	m_constantNodes.insert("height");
+	m_constantNodes.insert("offsetx");
+	m_constantNodes.insert("offsety");
+	m_constantNodes.insert("textoffsetx");
+	m_constantNodes.insert("textoffsety");
+	m_constantNodes.insert("textwidth");
+	m_constantNodes.insert("spinposx");
+	m_constantNodes.insert("spinposy");
+	m_constantNodes.insert("spinwidth");
+	m_constantNodes.insert("spinheight");
+	m_constantNodes.insert("radioposx");
+	m_constantNodes.insert("radioposy");
+	m_constantNodes.insert("radiowidth");
+	m_constantNodes.insert("radioheight");
+	m_constantNodes.insert("markwidth");
+	m_constantNodes.insert("markheight");
+	m_constantNodes.insert("sliderwidth");
+	m_constantNodes.insert("sliderheight");
+	m_constantNodes.insert("itemgap");
+	m_constantNodes.insert("bordersize");
+	m_constantNodes.insert("timeperimage");
+	m_constantNodes.insert("fadetime");
+	m_constantNodes.insert("pauseatend");
 }
 
 CGUIIncludes::~CGUIIncludes()
 {
 }
 
+void CGUIIncludes::ClearIncludes()
+{
+	CSingleLock lock(m_critSection);
+
+	if (m_iExpanded)
+		CLog::Log(LOGNOTICE, "CGUIIncludes: expanded %u include(s) from %u template(s)", m_iExpanded, m_iTemplates);
+
+	m_includes.clear();
+	m_defaults.clear();
+	m_skinvariables.clear();
+	m_constants.clear();
+	m_resolvedIncludes.clear();
+	m_resolvedDefaults.clear();
+	m_files.clear();
+
+	m_iExpanded = 0;
+	m_iTemplates = 0;
+}
+
+bool CGUIIncludes::LoadIncludes(const CStdString &includeFile)
+{
+	CSingleLock lock(m_critSection);
+
+	// check to see if we already have this loaded
+	if (find(m_files.begin(), m_files.end(), includeFile) != m_files.end())
+		return true;
+
+	// Remembered even if it doesn't exist, so windows notice when it's added
+	m_files.push_back(includeFile);
+
+	TiXmlDocument doc;
+	if (!doc.LoadFile(includeFile))
+	{
+		CLog::Log(LOGINFO, "Error loading includes file (%s): %s (row=%i, col=%i)", includeFile.c_str(), doc.ErrorDesc(), doc.ErrorRow(), doc.ErrorCol());
+		return false;
+	}
+
+	CStdString strDir = includeFile.Left(includeFile.ReverseFind('\\') + 1);
+	return LoadIncludesFromXML(doc.RootElement(), strDir);
+}
+
+bool CGUIIncludes::LoadIncludesFromXML(const TiXmlElement *root, const CStdString &strDir)
+{
+	if (!root || strcmpi(root->Value(), "includes"))
+	{
+		CLog::Log(LOGERROR, "Skin includes must start with <includes>");
+		return false;
+	}
+
+	const TiXmlElement* node = root->FirstChildElement("include");
+	while (node)
+	{
+		if (node->Attribute("name") && node->FirstChild())
+		{
+			CStdString tagName = node->Attribute("name");
+			m_includes.erase(tagName);
+			m_includes.insert(make_pair(tagName, *node));
+		}
+		else if (node->Attribute("file"))
+			LoadIncludes(strDir + node->Attribute("file"));
+		node = node->NextSiblingElement("include");
+	}
+
+	// now defaults
+	node = root->FirstChildElement("default");
+	while (node)
+	{
+		if (node->Attribute("type") && node->FirstChild())
+		{
+			CStdString tagName = node->Attribute("type");
+			m_defaults.erase(tagName);
+			m_defaults.insert(make_pair(tagName, *node));
+		}
+		node = node->NextSiblingElement("default");
+	}
+
+	// and finally constants
+	node = root->FirstChildElement("constant");
+	while (node)
+	{
+		if (node->Attribute("name") && node->FirstChild())
+			m_constants[node->Attribute("name")] = (float)atof(node->FirstChild()->Value());
+		node = node->NextSiblingElement("constant");
+	}
+
+	node = root->FirstChildElement("variable");
+	while (node)
+	{
+		if (node->Attribute("name") && node->FirstChild())
+		{
+			CStdString tagName = node->Attribute("name");
+			m_skinvariables.erase(tagName);
+			m_skinvariables.insert(make_pair(tagName, *node));
+		}
+		node = node->NextSiblingElement("variable");
+	}
+
+	CLog::Log(LOGINFO, "Loaded %u include(s), %u default(s) and %u constant(s) from %s",
+		m_includes.size(), m_defaults.size(), m_constants.size(), strDir.c_str());
+	return true;
+}
+
+void CGUIIncludes::ResolveIncludes(TiXmlElement *node, const CStdString &type)
+{
+	// we have a node, find any <include file="fileName">tagName</include> tags and replace
+	// recursively with their real includes
+	if (!node) return;
+
+	CSingleLock lock(m_critSection);
+	set<CStdString> resolving;
+
+	// First add the defaults if this is for a control
+	if (!type.IsEmpty())
+	{
+		const TiXmlElement *defaults = GetTemplate(m_defaults, m_resolvedDefaults, type, resolving);
+		if (defaults)
+		{
+			const TiXmlElement *element = defaults->FirstChildElement();
+			while (element)
+			{
+				// we insert at the end of block, only the tags this control doesn't set itself
+				if (!node->FirstChild(element->Value()))
+					node->InsertEndChild(*element);
+				element = element->NextSiblingElement();
+			}
+		}
+	}
+
+	ResolveIncludesForNode(node, resolving);
+}
+
+void CGUIIncludes::ResolveIncludesForNode(TiXmlElement *node, set<CStdString> &resolving)
+{
+	// Constants are replaced by their value, so the tree reads like plain numbers
+	if (node->FirstChild() && node->FirstChild()->Type() == TiXmlNode::TINYXML_TEXT && m_constantNodes.count(node->Value()))
+	{
+		map<CStdString, float>::const_iterator it = m_constants.find(node->FirstChild()->Value());
+		if (it != m_constants.end())
+		{
+			CStdString strValue;
+			strValue.Format("%g", it->second);
+			node->FirstChild()->SetValue(strValue.c_str());
+		}
+	}
+
+	// Resolve the children first, the templates copied in below already are
+	TiXmlElement *child = node->FirstChildElement();
+	while (child)
+	{
+		if (strcmp(child->Value(), "include"))
+			ResolveIncludesForNode(child, resolving);
+		child = child->NextSiblingElement();
+	}
+
+	TiXmlElement *include = node->FirstChildElement("include");
+	while (include)
+	{
+		// file="fileName" loads another includes file before this include is looked up
+		if (include->Attribute("file"))
+			LoadIncludes(g_SkinInfo.GetSkinPath(include->Attribute("file")));
+
+		if (include->FirstChild())
+		{
+			CStdString tagName = include->FirstChild()->Value();
+			const TiXmlElement *tag = GetTemplate(m_includes, m_resolvedIncludes, tagName, resolving);
+			if (tag)
+			{
+				// we've found our include - place its children before the <include> tag
+				const TiXmlElement *element = tag->FirstChildElement();
+				while (element)
+				{
+					node->InsertBeforeChild(include, *element);
+					element = element->NextSiblingElement();
+				}
+				m_iExpanded++;
+			}
+			else
+				CLog::Log(LOGWARNING, "Skin has invalid include: %s", tagName.c_str());
+		}
+
+		TiXmlElement *found = include;
+		include = include->NextSiblingElement("include");
+		node->RemoveChild(found);
+	}
+}
+
+// Returns the include or default called name with everything below it resolved
+const TiXmlElement *CGUIIncludes::GetTemplate(map<CStdString, TiXmlElement> &source, map<CStdString, TiXmlElement> &resolved,
+	const CStdString &name, set<CStdString> &resolving)
+{
+	map<CStdString, TiXmlElement>::const_iterator it = resolved.find(name);
+	if (it != resolved.end())
+		return &it->second;
+
+	it = source.find(name);
+	if (it == source.end())
+		return NULL;
+
+	if (resolving.count(name))
+	{
+		CLog::Log(LOGERROR, "Skin include %s includes itself", name.c_str());
+		return NULL;
+	}
+
+	resolving.insert(name);
+	TiXmlElement element(it->second);
+	ResolveIncludesForNode(&element, resolving);
+	resolving.erase(name);
+
+	m_iTemplates++;
+	return &resolved.insert(make_pair(name, element)).first->second;
+}
+
 bool CGUIIncludes::ResolveConstant(const CStdString &constant, float &value) const
 {
+	CSingleLock lock(m_critSection);
+
 	map<CStdString, float>::const_iterator it = m_constants.find(constant);
 	if (it == m_constants.end())
 		value = (float)atof(constant.c_str());
@@ -43,3 +291,20 @@ bool CGUIIncludes::ResolveConstant(const CStdString &constant, float &value) con
 		value = it->second;
 	return true;
 }
+
+const TiXmlElement *CGUIIncludes::GetSkinVariable(const CStdString &name) const
+{
+	CSingleLock lock(m_critSection);
+
+	map<CStdString, TiXmlElement>::const_iterator it = m_skinvariables.find(name);
+	if (it == m_skinvariables.end())
+		return NULL;
+	return &it->second;
+}
+
+void CGUIIncludes::GetFiles(vector<CStdString> &files) const
+{
+	CSingleLock lock(m_critSection);
+
+	files.insert(files.end(), m_files.begin(), m_files.end());
+}
@@ -23,22 +23,59 @@
 
 #include <map>
 #include <set>
+#include <vector>
 
+#include "tinyxml\tinyxml.h"
+#include "..\utils\CriticalSection.h"
 #include "..\utils\StdString.h"
 
-// forward definitions
-class TiXmlElement;
+/*!
+ \brief Resolves <include>, <default> and <constant> in skin files.
 
+ Includes.xml (and any file it includes) is read once per skin load. An
+ include is expanded the first time it's used, with the includes nested in
+ it and its constants resolved, and that expanded template is kept. Windows
+ then only copy templates in, no include is resolved twice.
+ */
 class CGUIIncludes
 {
 public:
 	CGUIIncludes();
 	~CGUIIncludes();
 
+	void ClearIncludes();
+	bool LoadIncludes(const CStdString &includeFile);
+
+	// Replaces the <include> tags below node, and adds the <default> tags of type that node lacks
+	void ResolveIncludes(TiXmlElement *node, const CStdString &type = "");
 	bool ResolveConstant(const CStdString &constant, float &value) const;
+	const TiXmlElement *GetSkinVariable(const CStdString &name) const;
+
+	// Include files read so far, also those that didn't exist
+	void GetFiles(std::vector<CStdString> &files) const;
 
 private:
+	bool LoadIncludesFromXML(const TiXmlElement *root, const CStdString &strDir);
+	void ResolveIncludesForNode(TiXmlElement *node, std::set<CStdString> &resolving);
+	const TiXmlElement *GetTemplate(std::map<CStdString, TiXmlElement> &source, std::map<CStdString, TiXmlElement> &resolved,
+		const CStdString &name, std::set<CStdString> &resolving);
+
+	std::map<CStdString, TiXmlElement> m_includes;
+	std::map<CStdString, TiXmlElement> m_defaults;
+	std::map<CStdString, TiXmlElement> m_skinvariables;
 	std::map<CStdString, float> m_constants;
+	std::set<std::string> m_constantNodes;
+
+	// Includes and defaults with everything below them resolved, built on first use
+	std::map<CStdString, TiXmlElement> m_resolvedIncludes;
+	std::map<CStdString, TiXmlElement> m_resolvedDefaults;
+
+	std::vector<CStdString> m_files;
+
+	unsigned int m_iExpanded;
+	unsigned int m_iTemplates;
+
+	CCriticalSection m_critSection;
 };
 
-#endif //H_CGUIINCLUDES
\ No newline at end of file
+#endif //H_CGUIINCLUDES
@@ -3,6 +3,10 @@
 #include "..\utils\Log.h"
 #include "..\Application.h"
 #include "LocalizeStrings.h"
+#include "SpriteBatch.h"
+#include "DirtyRegions.h"
+#include "TextureManager.h"
+#include "..\FramePacer.h"
 #include "..\xbox\XBKernalExports.h"
 #include "..\utils\StringUtils.h"
 
@@ -39,6 +43,23 @@ int GUIInfo::GetData2() const
 
 CGUIInfoManager::CGUIInfoManager(void)
 {
+	m_iCacheGeneration = 1;
+	m_iFrameNumber = 1;
+
+	m_iLookups = 0;
+	m_iCacheHits = 0;
+	m_iLastLookups = 0;
+	m_iLastCacheHits = 0;
+	m_iFrames = 0;
+	m_iTotalLookups = 0;
+	m_iTotalCacheHits = 0;
+
+	m_iLabelLookups = 0;
+	m_iLabelFormats = 0;
+	m_iLastLabelLookups = 0;
+	m_iLastLabelFormats = 0;
+	m_iTotalLabelLookups = 0;
+	m_iTotalLabelFormats = 0;
 }
 
 CGUIInfoManager::~CGUIInfoManager(void)
@@ -55,23 +76,27 @@ int CGUIInfoManager::TranslateString(const CStdString &condition)
 	CStdString strCondition;//(CGUIInfoLabel::ReplaceLocalize(condition));
 	strCondition = condition;//CGUIInfoLabel::ReplaceAddonStrings(strCondition);
 
+	// Check if this was translated before, the same string always gets the same id
+	int id = 0;
+	if (m_infoStrings.Find(strCondition, id))
+		return id;
+
 	if (strCondition.find_first_of("|") != strCondition.npos ||
 		strCondition.find_first_of("+") != strCondition.npos ||
 		strCondition.find_first_of("[") != strCondition.npos ||
 		strCondition.find_first_of("]") != strCondition.npos)
 	{
 		// Have a boolean expression
-		// Check if this was added before
-		vector<CCombinedValue>::iterator it;
-		for(it = m_CombinedValues.begin(); it != m_CombinedValues.end(); it++)
-		{
-			if(strCondition.CompareNoCase(it->m_info) == 0)
-				return it->m_id;
-		}
-		return TranslateBooleanExpression(strCondition);
+		id = TranslateBooleanExpression(strCondition);
+	}
+	else
+	{
+		//Just single command.
+		id = TranslateSingleString(strCondition);
 	}
-	//Just single command.
-	return TranslateSingleString(strCondition);
+
+	m_infoStrings.Add(strCondition, id);
+	return id;
 }
 
 /// \brief Translates a string as given by the skin into an int that we use for more
@@ -109,6 +134,30 @@ int CGUIInfoManager::TranslateSingleString(const CStdString &strCondition)
 			ret = SYSTEM_TIME;
 		else if (strTest.Equals("system.fps")) 
 			ret = SYSTEM_FPS;
+		else if (strTest.Equals("system.drawcalls"))
+			ret = SYSTEM_DRAW_CALLS;
+		else if (strTest.Equals("system.vertices"))
+			ret = SYSTEM_VERTICES;
+		else if (strTest.Equals("system.redrawarea"))
+			ret = SYSTEM_REDRAW_AREA;
+		else if (strTest.Equals("system.framepacing"))
+			ret = SYSTEM_FRAME_PACING;
+		else if (strTest.Equals("system.conditionevaluations"))
+			ret = SYSTEM_CONDITION_EVALUATIONS;
+		else if (strTest.Equals("system.conditioncachehits"))
+			ret = SYSTEM_CONDITION_CACHE_HITS;
+		else if (strTest.Equals("system.labelformats"))
+			ret = SYSTEM_LABEL_FORMATS;
+		else if (strTest.Equals("system.texturememory"))
+			ret = SYSTEM_TEXTURE_MEMORY;
+		else if (strTest.Equals("system.textureunusedmemory"))
+			ret = SYSTEM_TEXTURE_UNUSED_MEMORY;
+		else if (strTest.Equals("system.texturehits"))
+			ret = SYSTEM_TEXTURE_HITS;
+		else if (strTest.Equals("system.textureloads"))
+			ret = SYSTEM_TEXTURE_LOADS;
+		else if (strTest.Equals("system.textureevictions"))
+			ret = SYSTEM_TEXTURE_EVICTIONS;
 		else if (strTest.Equals("system.cputemperature"))
 			ret = SYSTEM_CPU_TEMPERATURE;
 		else if (strTest.Equals("system.gputemperature"))
@@ -160,10 +209,12 @@ int CGUIInfoManager::GetOperator(const char ch)
 		return 0;
 }
 
-bool CGUIInfoManager::EvaluateBooleanExpression(const CCombinedValue &expression, bool &result, int contextWindow)
+// Turns the postfix expression into code that stops evaluating once the
+// result is known, "a + b" becomes: LOAD a, JUMP_IF_FALSE 1, LOAD b
+bool CGUIInfoManager::CompileBooleanExpression(CCombinedValue &expression)
 {
-	// stack to save our bool state as we go
-	stack<bool> save;
+	// stack of the code of each subexpression as we go
+	stack< vector<ConditionOp> > save;
 
 	for (list<int>::const_iterator it = expression.m_postfix.begin(); it != expression.m_postfix.end(); ++it)
 	{
@@ -172,34 +223,59 @@ bool CGUIInfoManager::EvaluateBooleanExpression(const CCombinedValue &expression
 		{
 			// NOT the top item on the stack
 			if (save.size() < 1) return false;
-			bool expr = save.top();
-			save.pop();
-			save.push(!expr);
+			save.top().push_back(ConditionOp(CONDITION_NOT));
 		}
-		else if (expr == -OPERATOR_AND)
+		else if (expr == -OPERATOR_AND || expr == -OPERATOR_OR)
 		{
-			// AND the top two items on the stack
+			// AND or OR the top two items on the stack, the right one is skipped
+			// when the left one already decides
 			if (save.size() < 2) return false;
-			bool right = save.top(); save.pop();
-			bool left = save.top(); save.pop();
-			save.push(left && right);
+			vector<ConditionOp> right = save.top(); save.pop();
+			vector<ConditionOp> &left = save.top();
+			left.push_back(ConditionOp(expr == -OPERATOR_AND ? CONDITION_JUMP_IF_FALSE : CONDITION_JUMP_IF_TRUE, (int)right.size()));
+			left.insert(left.end(), right.begin(), right.end());
 		}
-		else if (expr == -OPERATOR_OR)
-		{ 
-			// OR the top two items on the stack
-			if (save.size() < 2) return false;
-			bool right = save.top(); save.pop();
-			bool left = save.top(); save.pop();
-			save.push(left || right);
+		else if (expr > 0)
+		{
+			vector<ConditionOp> load;
+			load.push_back(ConditionOp(CONDITION_LOAD, expr));
+			save.push(load);
 		}
-		else  // operator
-			save.push(GetBool(expr));
+		else
+			return false;  // unmatched parenthesis
 	}
 	if (save.size() != 1) return false;
-	result = save.top();
+	expression.m_code = save.top();
 	return true;
 }
 
+bool CGUIInfoManager::RunBooleanExpression(const vector<ConditionOp> &code)
+{
+	bool result = false;
+	for (unsigned int i = 0; i < code.size(); i++)
+	{
+		const ConditionOp &op = code[i];
+		switch (op.op)
+		{
+			case CONDITION_LOAD:
+				result = GetBool(op.arg);
+				break;
+			case CONDITION_NOT:
+				result = !result;
+				break;
+			case CONDITION_JUMP_IF_FALSE:
+				if (!result)
+					i += op.arg;
+				break;
+			case CONDITION_JUMP_IF_TRUE:
+				if (result)
+					i += op.arg;
+				break;
+		}
+	}
+	return result;
+}
+
 int CGUIInfoManager::TranslateBooleanExpression(const CStdString &expression)
 {
 	CCombinedValue comb;
@@ -274,9 +350,8 @@ int CGUIInfoManager::TranslateBooleanExpression(const CStdString &expression)
 		save.pop();
 	}
 
-	// test evaluate
-	bool test;
-	if (!EvaluateBooleanExpression(comb, test, WINDOW_INVALID))
+	// compile, an expression that doesn't compile evaluates to false
+	if (!CompileBooleanExpression(comb))
 		CLog::Log(LOGERROR, "Error evaluating boolean expression %s", expression.c_str());
 	// success - add to our combined values
 	m_CombinedValues.push_back(comb);
@@ -299,6 +374,34 @@ CStdString CGUIInfoManager::GetLabel(int info, int contextWindow)
 		 case SYSTEM_FPS:
 			strLabel.Format("%02.2f", m_fps);
 			break;
+		case SYSTEM_DRAW_CALLS:
+			strLabel.Format("%u", g_spriteBatch.GetDrawCalls());
+			break;
+		case SYSTEM_VERTICES:
+			strLabel.Format("%u", g_spriteBatch.GetVertices());
+			break;
+		case SYSTEM_REDRAW_AREA:
+			strLabel.Format("%.0f%%", g_dirtyRegions.GetRedrawArea());
+			break;
+		case SYSTEM_FRAME_PACING:
+			strLabel = CFramePacer::GetStateName(g_framePacer.GetState());
+			break;
+		case SYSTEM_CONDITION_EVALUATIONS:
+			strLabel.Format("%u", m_iLastLookups - m_iLastCacheHits);
+			break;
+		case SYSTEM_CONDITION_CACHE_HITS:
+			strLabel.Format("%.0f%%", m_iLastLookups ? 100.0f * m_iLastCacheHits / m_iLastLookups : 0.0f);
+			break;
+		case SYSTEM_LABEL_FORMATS:
+			strLabel.Format("%u", m_iLastLabelFormats);
+			break;
+		case SYSTEM_TEXTURE_MEMORY:
+		case SYSTEM_TEXTURE_UNUSED_MEMORY:
+		case SYSTEM_TEXTURE_HITS:
+		case SYSTEM_TEXTURE_LOADS:
+		case SYSTEM_TEXTURE_EVICTIONS:
+			strLabel.Format(info == SYSTEM_TEXTURE_MEMORY || info == SYSTEM_TEXTURE_UNUSED_MEMORY ? "%uKB" : "%u", GetTextureStat(info));
+			break;
 		case SYSTEM_CPU_TEMPERATURE:
 		case SYSTEM_GPU_TEMPERATURE:
 			return GetSystemHeatInfo(info);
@@ -327,13 +430,109 @@ CStdString CGUIInfoManager::GetLabel(int info, int contextWindow)
 	return strLabel;
 }
 
+unsigned int CGUIInfoManager::GetLabelVersion(int info)
+{
+	LabelVersion &version = m_labelVersions[info];
+	if (version.iFrame == m_iFrameNumber)
+		return version.iVersion;
+
+	version.iFrame = m_iFrameNumber;
+	__int64 iValue = GetLabelValue(info);
+	if (iValue != version.iValue || !version.iVersion)
+	{
+		version.iValue = iValue;
+		version.iVersion++;
+	}
+	return version.iVersion;
+}
+
+// A number that changes whenever GetLabel(info) would return something else,
+// much cheaper to get than the label itself
+__int64 CGUIInfoManager::GetLabelValue(int info)
+{
+	switch (info)
+	{
+		case SYSTEM_DATE:
+		case SYSTEM_TIME:
+		{
+			SYSTEMTIME time;
+			GetLocalTime(&time);
+			if (info == SYSTEM_DATE)
+				return time.wYear * 10000 + time.wMonth * 100 + time.wDay;
+			return time.wHour * 60 + time.wMinute;
+		}
+		case SYSTEM_FPS:
+			return (__int64)(m_fps * 100.0f);
+		case SYSTEM_DRAW_CALLS:
+			return g_spriteBatch.GetDrawCalls();
+		case SYSTEM_VERTICES:
+			return g_spriteBatch.GetVertices();
+		case SYSTEM_REDRAW_AREA:
+			return (__int64)(g_dirtyRegions.GetRedrawArea() + 0.5f);
+		case SYSTEM_FRAME_PACING:
+			return g_framePacer.GetState();
+		case SYSTEM_CONDITION_EVALUATIONS:
+		case SYSTEM_CONDITION_CACHE_HITS:
+			return ((__int64)m_iLastLookups << 32) | m_iLastCacheHits;
+		case SYSTEM_LABEL_FORMATS:
+			return m_iLastLabelFormats;
+		case SYSTEM_TEXTURE_MEMORY:
+		case SYSTEM_TEXTURE_UNUSED_MEMORY:
+		case SYSTEM_TEXTURE_HITS:
+		case SYSTEM_TEXTURE_LOADS:
+		case SYSTEM_TEXTURE_EVICTIONS:
+			return GetTextureStat(info);
+
+		// Asking the hardware costs more than formatting, poll these once a second
+		case SYSTEM_CPU_TEMPERATURE:
+		case SYSTEM_GPU_TEMPERATURE:
+		case SYSTEM_FREE_MEMORY:
+			return GetTickCount() / 1000;
+
+		case PLAYER_TIME:
+		case PLAYER_TIME_REMAINING:
+		case PLAYER_DURATION:
+			if (!g_application.IsPlaying())
+				return -1;
+			return ((__int64)GetTotalPlayTime() << 32) | (GetPlayTime() / 1000);
+	}
+
+	// Everything else doesn't change while a label shows it
+	return 0;
+}
+
 // checks the condition and returns it as necessary.  Currently used
 // for toggle button controls and visibility of images.
 bool CGUIInfoManager::GetBool(int condition)
 {
 	bool bReturn = false;
-	
-	if ( condition == SYSTEM_ALWAYS_TRUE)
+
+	if (!condition)
+		return false;
+	if (condition < 0)
+		return !GetBool(-condition);
+
+	m_iLookups++;
+
+	if (condition >= COMBINED_VALUES_START)
+	{
+		unsigned int index = condition - COMBINED_VALUES_START;
+		if (index >= m_CombinedValues.size())
+			return false;
+
+		// cache return value
+		CCombinedValue &comb = m_CombinedValues[index];
+		if (comb.m_cache.iGeneration == m_iCacheGeneration)
+		{
+			m_iCacheHits++;
+			return comb.m_cache.bResult;
+		}
+
+		bReturn = RunBooleanExpression(comb.m_code);
+		comb.m_cache.iGeneration = m_iCacheGeneration;
+		comb.m_cache.bResult = bReturn;
+	}
+	else if ( condition == SYSTEM_ALWAYS_TRUE)
 		bReturn = true;
 	else if (condition == SYSTEM_ALWAYS_FALSE)
 		bReturn = false;
@@ -342,10 +541,16 @@ bool CGUIInfoManager::GetBool(int condition)
 	else if (condition >= MULTI_INFO_START && condition <= MULTI_INFO_END)
 	{
 		// cache return value
-		bool result = GetMultiInfoBool(m_multiInfo[condition - MULTI_INFO_START]);
-//		if (!item)
-//			CacheBool(condition1, contextWindow, result); //TODO
-		return result;
+		CachedBool &cache = m_multiInfoCache[condition - MULTI_INFO_START];
+		if (cache.iGeneration == m_iCacheGeneration)
+		{
+			m_iCacheHits++;
+			return cache.bResult;
+		}
+
+		bReturn = GetMultiInfoBool(m_multiInfo[condition - MULTI_INFO_START]);
+		cache.iGeneration = m_iCacheGeneration;
+		cache.bResult = bReturn;
 	}
 	else if (g_application.IsPlaying())
 	{
@@ -360,6 +565,81 @@ bool CGUIInfoManager::GetBool(int condition)
 	return bReturn;
 }
 
+void CGUIInfoManager::BeginFrame()
+{
+	m_iLastLookups = m_iLookups;
+	m_iLastCacheHits = m_iCacheHits;
+	m_iTotalLookups += m_iLookups;
+	m_iTotalCacheHits += m_iCacheHits;
+	m_iFrames++;
+
+	m_iLookups = 0;
+	m_iCacheHits = 0;
+
+	m_iLastLabelLookups = m_iLabelLookups;
+	m_iLastLabelFormats = m_iLabelFormats;
+	m_iTotalLabelLookups += m_iLabelLookups;
+	m_iTotalLabelFormats += m_iLabelFormats;
+	m_iLabelLookups = 0;
+	m_iLabelFormats = 0;
+
+	m_iFrameNumber++;
+	ResetCache();
+}
+
+void CGUIInfoManager::GetConditionStats(ConditionStats& stats) const
+{
+	stats.iLookups = m_iLastLookups;
+	stats.iEvaluations = m_iLastLookups - m_iLastCacheHits;
+	stats.fCacheHits = m_iLastLookups ? 100.0f * m_iLastCacheHits / m_iLastLookups : 0.0f;
+	stats.fLookupsPerFrame = m_iFrames ? (float)m_iTotalLookups / m_iFrames : 0.0f;
+	stats.fEvaluationsPerFrame = m_iFrames ? (float)(m_iTotalLookups - m_iTotalCacheHits) / m_iFrames : 0.0f;
+}
+
+void CGUIInfoManager::GetLabelStats(LabelStats& stats) const
+{
+	stats.iLookups = m_iLastLabelLookups;
+	stats.iFormats = m_iLastLabelFormats;
+	stats.fLookupsPerFrame = m_iFrames ? (float)m_iTotalLabelLookups / m_iFrames : 0.0f;
+	stats.fFormatsPerFrame = m_iFrames ? (float)m_iTotalLabelFormats / m_iFrames : 0.0f;
+}
+
+void CGUIInfoManager::ResetStats()
+{
+	ConditionStats stats;
+	GetConditionStats(stats);
+	LabelStats labelStats;
+	GetLabelStats(labelStats);
+	if (m_iFrames)
+	{
+		CLog::Log(LOGNOTICE, "CGUIInfoManager: %u frames, avg %.1f condition lookups per frame of which %.1f evaluated, %.0f%% answered from the cache",
+			m_iFrames, stats.fLookupsPerFrame, stats.fEvaluationsPerFrame,
+			stats.fLookupsPerFrame > 0.0f ? 100.0f * (stats.fLookupsPerFrame - stats.fEvaluationsPerFrame) / stats.fLookupsPerFrame : 0.0f);
+		CLog::Log(LOGNOTICE, "CGUIInfoManager: avg %.1f info labels per frame of which %.2f formatted",
+			labelStats.fLookupsPerFrame, labelStats.fFormatsPerFrame);
+	}
+
+	InfoTableStats tableStats;
+	m_infoStrings.GetStats(tableStats);
+	if (tableStats.iLookups)
+	{
+		CLog::Log(LOGNOTICE, "CGUIInfoManager: %u info string(s) translated, %u of them shared the id of an earlier one, %u distinct",
+			tableStats.iLookups, tableStats.iHits, tableStats.iEntries);
+	}
+	m_infoStrings.ResetStats();
+
+	m_iLastLookups = 0;
+	m_iLastCacheHits = 0;
+	m_iFrames = 0;
+	m_iTotalLookups = 0;
+	m_iTotalCacheHits = 0;
+
+	m_iLastLabelLookups = 0;
+	m_iLastLabelFormats = 0;
+	m_iTotalLabelLookups = 0;
+	m_iTotalLabelFormats = 0;
+}
+
 void CGUIInfoManager::UpdateFPS()
 {
 	m_frameCounter++;
@@ -376,12 +656,15 @@ void CGUIInfoManager::UpdateFPS()
 
 int CGUIInfoManager::AddMultiInfo(const GUIInfo &info)
 {
-	// check to see if we have this info already
-	for (unsigned int i = 0; i < m_multiInfo.size(); i++)
-	if (m_multiInfo[i] == info)
-		return (int)i + MULTI_INFO_START;
+	// check to see if we have this info already, the flags are part of data1
+	unsigned int data1 = info.GetData1() | info.GetInfoFlag();
+	int offset = 0;
+	if (m_multiInfoIndex.Find(info.m_info, data1, info.GetData2(), offset))
+		return offset + MULTI_INFO_START;
 	// return the new offset
 	m_multiInfo.push_back(info);
+	m_multiInfoCache.push_back(CachedBool());
+	m_multiInfoIndex.Add(info.m_info, data1, info.GetData2(), (int)m_multiInfo.size() - 1);
 	return (int)m_multiInfo.size() + MULTI_INFO_START - 1;
 }
 
@@ -500,6 +783,23 @@ CStdString CGUIInfoManager::GetTime(bool bSeconds)
 	return text;
 }
 
+// The texture manager's counters, memory in KB
+unsigned int CGUIInfoManager::GetTextureStat(int info)
+{
+	TextureStats stats;
+	g_TextureManager.GetStats(stats);
+
+	switch (info)
+	{
+		case SYSTEM_TEXTURE_MEMORY:        return stats.iMemoryUsage / 1024;
+		case SYSTEM_TEXTURE_UNUSED_MEMORY: return stats.iUnusedMemory / 1024;
+		case SYSTEM_TEXTURE_HITS:          return stats.iHits;
+		case SYSTEM_TEXTURE_LOADS:         return stats.iLoads;
+		case SYSTEM_TEXTURE_EVICTIONS:     return stats.iEvictions;
+	}
+	return 0;
+}
+
 CStdString CGUIInfoManager::GetSystemHeatInfo(int info)
 {
 	CStdString strTemp;
@@ -24,8 +24,11 @@
 #include "..\utils\StdString.h"
 #include "..\utils\Stdafx.h"
 #include "..\utils\TimeUtils.h"
+#include "InfoStringTable.h"
 
 #include <list>
+#include <map>
+#include <vector>
 
 #define KB  (1024)          // 1 KiloByte (1KB)   1024 Byte (2^10 Byte)
 #define MB  (1024*KB)       // 1 MegaByte (1MB)   1024 KB (2^10 KB)
@@ -50,6 +53,18 @@
 #define SYSTEM_FPS                  123
 #define SYSTEM_ALWAYS_TRUE          125   // useful for <visible fade="10" start="hidden">true</visible>, to fade in a control
 #define SYSTEM_ALWAYS_FALSE         126   // used for <visible fade="10">false</visible>, to fade out a control (ie not particularly useful!)
+#define SYSTEM_DRAW_CALLS           127   // draw calls of the GUI sprite batch in the last frame
+#define SYSTEM_VERTICES             128
+#define SYSTEM_REDRAW_AREA          129   // percent of the screen the GUI redrew in the last frame
+#define SYSTEM_FRAME_PACING         130   // active, idle or video
+#define SYSTEM_CONDITION_EVALUATIONS 131  // conditions evaluated in the last frame
+#define SYSTEM_CONDITION_CACHE_HITS 132   // percent of condition lookups in the last frame answered from the cache
+#define SYSTEM_LABEL_FORMATS        133   // info labels formatted in the last frame
+#define SYSTEM_TEXTURE_MEMORY       134   // KB used by GUI textures
+#define SYSTEM_TEXTURE_UNUSED_MEMORY 135  // KB of those kept for reuse
+#define SYSTEM_TEXTURE_HITS         136   // texture loads served from memory
+#define SYSTEM_TEXTURE_LOADS        137   // texture loads from disk
+#define SYSTEM_TEXTURE_EVICTIONS    138   // textures freed to stay within the budget
 #define SYSTEM_FREE_MEMORY          648
 
 // The multiple information vector
@@ -88,6 +103,23 @@ private:
 	int m_data2;
 };
 
+struct ConditionStats
+{
+	unsigned int iLookups;        // GetBool() calls in the last frame
+	unsigned int iEvaluations;    // of those, not answered from the cache
+	float fCacheHits;             // percent of the lookups answered from the cache
+	float fLookupsPerFrame;       // averages since the last reset
+	float fEvaluationsPerFrame;
+};
+
+struct LabelStats
+{
+	unsigned int iLookups;        // info labels asked for in the last frame
+	unsigned int iFormats;        // of those, formatted again because something they show changed
+	float fLookupsPerFrame;       // averages since the last reset
+	float fFormatsPerFrame;
+};
+
 class CGUIInfoManager
 {
 public:
@@ -99,10 +131,28 @@ public:
 
 	CStdString GetLabel(int info, int contextWindow = 0);
 	bool GetBool(int condition1);
+
+	// Changes whenever the text GetLabel() returns for info may have changed, checked once per frame
+	unsigned int GetLabelVersion(int info);
+
+	// Counts an info label being asked for, and whether it had to be formatted
+	void CountLabel(bool bFormatted) { m_iLabelLookups++; if (bFormatted) m_iLabelFormats++; };
 	void UpdateFPS();
 
-	void SetShowCodec(bool showcodec) { m_playerShowCodec = showcodec; };
-	void ToggleShowCodec() { m_playerShowCodec = !m_playerShowCodec; };
+	// Conditions are evaluated at most once per frame, BeginFrame() starts the next one
+	void BeginFrame();
+
+	// Something a condition depends on changed mid frame, evaluate them again
+	void ResetCache() { m_iCacheGeneration++; };
+
+	void GetConditionStats(ConditionStats& stats) const;
+	void GetLabelStats(LabelStats& stats) const;
+
+	// Logs and clears the condition and label stats
+	void ResetStats();
+
+	void SetShowCodec(bool showcodec) { m_playerShowCodec = showcodec; ResetCache(); };
+	void ToggleShowCodec() { m_playerShowCodec = !m_playerShowCodec; ResetCache(); };
 
 	inline float GetFPS() const { return m_fps; };
 
@@ -113,6 +163,8 @@ protected:
 	CStdString GetTime(bool bSeconds = false);
 	CStdString GetDate(bool bNumbersOnly = false);
 	CStdString GetSystemHeatInfo(int info);
+	unsigned int GetTextureStat(int info);
+	__int64 GetLabelValue(int info);
 
 	__int64 GetPlayTime() const;  // in ms
 	CStdString GetCurrentPlayTime(TIME_FORMAT format = TIME_FORMAT_GUESS) const;
@@ -130,12 +182,39 @@ private:
 	unsigned int m_frameCounter;
 	unsigned int m_lastFPSTime;
 
+	// A condition result and the cache generation it was evaluated in
+	struct CachedBool
+	{
+		CachedBool() { iGeneration = 0; bResult = false; }
+		unsigned int iGeneration;
+		bool bResult;
+	};
+
+	// Compiled conditions run on a single result register. An AND or OR
+	// jumps over its right hand side once the left one decides it.
+	enum ConditionOpCode
+	{
+		CONDITION_LOAD = 0,           // result = GetBool(arg)
+		CONDITION_NOT,                // result = !result
+		CONDITION_JUMP_IF_FALSE,      // skip arg ops if !result
+		CONDITION_JUMP_IF_TRUE        // skip arg ops if result
+	};
+
+	struct ConditionOp
+	{
+		ConditionOp(ConditionOpCode code, int argument = 0) { op = code; arg = argument; }
+		ConditionOpCode op;
+		int arg;
+	};
+
 	class CCombinedValue
 	{
 	public:
 		CStdString m_info;    // the text expression
 		int m_id;             // the id used to identify this expression
 		std::list<int> m_postfix;  // the postfix binary expression
+		std::vector<ConditionOp> m_code; // m_postfix compiled
+		CachedBool m_cache;
 		CCombinedValue& operator=(const CCombinedValue& mSrc);
 	};
 	
@@ -143,10 +222,45 @@ private:
 
 	int GetOperator(const char ch);
 	int TranslateBooleanExpression(const CStdString &expression);
-	bool EvaluateBooleanExpression(const CCombinedValue &expression, bool &result, int contextWindow);
+	bool CompileBooleanExpression(CCombinedValue &expression);
+	bool RunBooleanExpression(const std::vector<ConditionOp> &code);
 
 	// Array of multiple information mapped to a single integer lookup
 	std::vector<GUIInfo> m_multiInfo;
+	std::vector<CachedBool> m_multiInfoCache;
+	CInfoTupleIndex m_multiInfoIndex;  // offsets into m_multiInfo
+
+	// Every string translated so far with the id it was given
+	CInfoStringTable m_infoStrings;
+
+	unsigned int m_iCacheGeneration;
+	unsigned int m_iFrameNumber;
+
+	// What each label showed when its version last changed
+	struct LabelVersion
+	{
+		LabelVersion() { iFrame = 0; iValue = 0; iVersion = 0; }
+		unsigned int iFrame;        // frame the value was last checked in
+		__int64 iValue;
+		unsigned int iVersion;
+	};
+	std::map<int, LabelVersion> m_labelVersions;
+
+	unsigned int m_iLabelLookups;
+	unsigned int m_iLabelFormats;
+	unsigned int m_iLastLabelLookups;
+	unsigned int m_iLastLabelFormats;
+	unsigned __int64 m_iTotalLabelLookups;
+	unsigned __int64 m_iTotalLabelFormats;
+
+	// Condition lookups, this frame, the last one and since the last reset
+	unsigned int m_iLookups;
+	unsigned int m_iCacheHits;
+	unsigned int m_iLastLookups;
+	unsigned int m_iLastCacheHits;
+	unsigned int m_iFrames;
+	unsigned __int64 m_iTotalLookups;
+	unsigned __int64 m_iTotalCacheHits;
 };
 
 extern CGUIInfoManager g_infoManager;
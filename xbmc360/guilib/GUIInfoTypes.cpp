@@ -62,6 +62,7 @@ void CGUIInfoBool::Parse(const CStdString &info)
 
 CGUIInfoLabel::CGUIInfoLabel()
 {
+	m_formatted = false;
 }
 
 CGUIInfoLabel::CGUIInfoLabel(const CStdString &label, const CStdString &fallback, int context)
@@ -78,6 +79,7 @@ void CGUIInfoLabel::SetLabel(const CStdString &label, const CStdString &fallback
 void CGUIInfoLabel::Parse(const CStdString &label, int context)
 {
 	m_info.clear();
+	m_formatted = false;
 	// Step 1: Replace all $LOCALIZE[number] with the real string
 	CStdString work = label;//ReplaceLocalize(label); //MARTY FXIME
 	// Step 2: Replace all $ADDON[id number] with the real string
@@ -146,14 +148,23 @@ void CGUIInfoLabel::Parse(const CStdString &label, int context)
 	m_info.push_back(CInfoPortion(0, work, ""));
 }
 
-CStdString CGUIInfoLabel::GetLabel(int contextWindow, bool preferImage) const
+const CStdString &CGUIInfoLabel::GetLabel(int contextWindow, bool preferImage, bool *changed) const
 {
+	bool bFormat = IsOutdated();
+	g_infoManager.CountLabel(bFormat);
+	if (changed)
+		*changed = false;
+	if (!bFormat)
+		return m_label;
+
 	CStdString label;
 	for (unsigned int i = 0; i < m_info.size(); i++)
 	{
 		const CInfoPortion &portion = m_info[i];
 		if (portion.m_info)
 		{
+			portion.m_version = g_infoManager.GetLabelVersion(portion.m_info);
+
 			CStdString infoLabel;
 //			if (preferImage) //FIXME MARTY
 //				infoLabel = g_infoManager.GetImage(portion.m_info, contextWindow);
@@ -169,8 +180,28 @@ CStdString CGUIInfoLabel::GetLabel(int contextWindow, bool preferImage) const
 		}
 	}
 	if (label.IsEmpty())  // empty label, use the fallback
-		return m_fallback;
-	return label;
+		label = m_fallback;
+
+	if (changed)
+		*changed = !m_formatted || label != m_label;
+	m_label = label;
+	m_formatted = true;
+	return m_label;
+}
+
+// True once one of the infos has a new version since the label was formatted
+bool CGUIInfoLabel::IsOutdated() const
+{
+	if (!m_formatted)
+		return true;
+
+	for (unsigned int i = 0; i < m_info.size(); i++)
+	{
+		const CInfoPortion &portion = m_info[i];
+		if (portion.m_info && g_infoManager.GetLabelVersion(portion.m_info) != portion.m_version)
+			return true;
+	}
+	return false;
 }
 
 bool CGUIInfoLabel::IsConstant() const
@@ -184,6 +215,7 @@ CGUIInfoLabel::CInfoPortion::CInfoPortion(int info, const CStdString &prefix, co
 	m_prefix = prefix;
 	m_postfix = postfix;
 	m_escaped = escaped;
+	m_version = 0;
 	// filter our prefix and postfix for comma's
 	m_prefix.Replace("$COMMA", ",");
 	m_postfix.Replace("$COMMA", ",");
@@ -45,11 +45,19 @@ public:
 	void SetLabel(const CStdString &label, const CStdString &fallback, int context = 0);
 
 
-	CStdString GetLabel(int contextWindow, bool preferImage = false) const;
+	/*!
+	 \brief The label with its infos filled in.
+
+	 The label is only formatted again once one of its infos reports a new
+	 version, until then the text from last time is returned.
+	 \param changed set to whether the text differs from the last call
+	 */
+	const CStdString &GetLabel(int contextWindow, bool preferImage = false, bool *changed = NULL) const;
 	bool IsConstant() const;
 
 private:
 	void Parse(const CStdString &label, int context);
+	bool IsOutdated() const;
 	
 	class CInfoPortion
 	{
@@ -59,6 +67,7 @@ private:
 		int m_info;
 		CStdString m_prefix;
 		CStdString m_postfix;
+		mutable unsigned int m_version;  // of m_info when the label was last formatted
 	private:
 		bool m_escaped;
   };
@@ -66,6 +75,9 @@ private:
 
 	CStdString m_fallback;	
 	std::vector<CInfoPortion> m_info;
+
+	mutable CStdString m_label;      // as formatted last
+	mutable bool m_formatted;
 };
 
 #endif //H_CGUIINFOTYPES
\ No newline at end of file
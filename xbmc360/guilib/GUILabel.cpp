@@ -20,28 +20,31 @@
 
 #include "GUILabel.h"
 #include "..\utils\Log.h"
+#include "..\utils\StringUtils.h"
 
-CGUILabel::CGUILabel(float posX, float posY, float width, float height, const CLabelInfo& labelInfo/*, CGUILabel::OVER_FLOW overflow*/)
+CGUILabel::CGUILabel(float posX, float posY, float width, float height, const CLabelInfo& labelInfo, CGUILabel::OVER_FLOW overflow)
 {
 	m_label = labelInfo;
 	m_strText = "";
 
 	m_iPosX = posX;
 	m_iPosY = posY;
+	m_fWidth = width;
+	m_overflow = overflow;
 }
 
 CGUILabel::~CGUILabel(void)
 {
 }
 
-void CGUILabel::SetText(CStdString strText)
+void CGUILabel::SetText(const CStdString& strText)
 {
-	m_strText = strText;
-}
+	if (strText == m_strText)
+		return;
 
-CStdString CGUILabel::GetText()
-{
-	return m_strText;
+	m_strText = strText;
+	CStringUtils::StringtoWString(m_strText, m_wstrText);
+	m_layoutRef = CTextLayoutCache::Ref();
 }
 
 void CGUILabel::SetPosition(float fPosX, float fPosY)
@@ -58,5 +61,7 @@ void CGUILabel::Render()
 		return;
 	}
 
-	m_label.font->DrawText(m_iPosX + m_label.offsetX, m_iPosY + m_label.offsetY, m_label.dwTextColor, m_strText, m_label.dwAlign );
+	// The font keeps the layout, an unchanged label draws it again without a lookup
+	m_label.font->DrawText(m_iPosX + m_label.offsetX, m_iPosY + m_label.offsetY, m_label.dwTextColor, m_wstrText, m_label.dwAlign,
+		m_fWidth - m_label.offsetX, m_overflow, &m_layoutRef );
 }
\ No newline at end of file
@@ -46,11 +46,16 @@ public:
 class CGUILabel
 {
 public:
-	CGUILabel(float posX, float posY, float width, float height, const CLabelInfo& labelInfo/*, CGUILabel::OVER_FLOW overflow*/);
+	// Lines wider than the label are drawn past it unless it's told otherwise
+	enum OVER_FLOW { OVER_FLOW_NONE = GLYPH_OVERFLOW_NONE,
+	                 OVER_FLOW_TRUNCATE = GLYPH_OVERFLOW_TRUNCATE,
+	                 OVER_FLOW_WRAP = GLYPH_OVERFLOW_WRAP };
+
+	CGUILabel(float posX, float posY, float width, float height, const CLabelInfo& labelInfo, CGUILabel::OVER_FLOW overflow = OVER_FLOW_NONE);
 	virtual ~CGUILabel(void);
 
-	void SetText(CStdString strText);
-	CStdString GetText();
+	void SetText(const CStdString& strText);
+	const CStdString& GetText() const { return m_strText; }
 	void SetPosition(float fPosX, float fPosY);
 	void Render();
 
@@ -58,8 +63,12 @@ private:
 	CLabelInfo m_label;
 
 	CStdString m_strText;
+	std::wstring m_wstrText;   // m_strText converted once, it's drawn every frame
+	CTextLayoutCache::Ref m_layoutRef;  // layout of m_wstrText, reset with the text
 	float m_iPosX;
 	float m_iPosY;
+	float m_fWidth;
+	OVER_FLOW m_overflow;
 };
 
 #endif //GUILIB_GUILABEL_H
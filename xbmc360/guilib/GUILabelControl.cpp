@@ -24,7 +24,7 @@ using namespace std;
 
 CGUILabelControl::CGUILabelControl(int parentID, int controlID, float posX, float posY, float width, float height, const CLabelInfo& labelInfo, bool wrapMultiLine, bool bHasPath)
     : CGUIControl(parentID, controlID, posX, posY, width, height)
-    , m_label(posX, posY, width, height, labelInfo/*, wrapMultiLine ? CGUILabel::OVER_FLOW_WRAP : CGUILabel::OVER_FLOW_TRUNCATE*/) //MARTY FIXME WIP
+    , m_label(posX, posY, width, height, labelInfo, wrapMultiLine ? CGUILabel::OVER_FLOW_WRAP : CGUILabel::OVER_FLOW_NONE)
 {
 }
 
@@ -40,7 +40,11 @@ void CGUILabelControl::Render()
 
 	m_label.Render();
 
-	m_label.SetText(m_infoLabel.GetLabel(m_parentID));
+	// Only hand the label over when its text actually changed
+	bool bChanged;
+	const CStdString &strLabel = m_infoLabel.GetLabel(m_parentID, false, &bChanged);
+	if (bChanged)
+		m_label.SetText(strLabel);
 
 	CGUIControl::Render();
 }
@@ -62,6 +66,7 @@ bool CGUILabelControl::OnMessage(CGUIMessage& message)
 void CGUILabelControl::SetLabel(CStdString strText)
 {
 	m_label.SetText(strText);
+	MarkDirty();
 }
 
 void CGUILabelControl::SetInfo(const CGUIInfoLabel &infoLabel)
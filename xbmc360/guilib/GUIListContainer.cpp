@@ -0,0 +1,311 @@
+#include "GUIListContainer.h"
+#include "GUIWindowManager.h"
+#include "..\utils\Log.h"
+
+CGUIListContainer::ItemView::ItemView(float width, float height, float thumbWidth, const CLabelInfo& labelInfo)
+	: label(0, 0, width - thumbWidth, height, labelInfo, CGUILabel::OVER_FLOW_TRUNCATE)
+	, thumb(0, 0, thumbWidth, height, CTextureInfo())
+{
+}
+
+CGUIListContainer::CGUIListContainer(int parentID, int controlID, float posX, float posY, float width, float height,
+                                     float itemWidth, float itemHeight, float thumbWidth,
+                                     const CTextureInfo& textureFocus, const CTextureInfo& textureNoFocus, const CLabelInfo& labelInfo)
+	: CGUIControl(parentID, controlID, posX, posY, width, height)
+	, m_imgFocus(posX, posY, itemWidth, itemHeight, textureFocus)
+	, m_imgNoFocus(posX, posY, itemWidth, itemHeight, textureNoFocus)
+{
+	ControlType = GUICONTAINER_LIST;
+
+	m_itemWidth = itemWidth > 0 ? itemWidth : width;
+	m_itemHeight = itemHeight > 0 ? itemHeight : 32;
+	m_thumbWidth = thumbWidth;
+
+	// A list has one column, a panel as many as fit
+	m_layout.SetLayout((int)(width / m_itemWidth), (int)(height / m_itemHeight), LISTCONTAINER_PREFETCH_ROWS);
+
+	m_bUpdateViews = false;
+	m_bNoFocusTexture = !textureNoFocus.filename.IsEmpty();
+	m_iBinds = 0;
+
+	m_views.reserve(m_layout.GetViewCount());
+	for (unsigned int i = 0; i < m_layout.GetViewCount(); i++)
+		m_views.push_back(new ItemView(m_itemWidth, m_itemHeight, m_thumbWidth, labelInfo));
+
+	m_unbound.reserve(m_views.size());
+	m_bound.reserve(m_views.size());
+}
+
+CGUIListContainer::~CGUIListContainer(void)
+{
+	for (unsigned int i = 0; i < m_views.size(); i++)
+		delete m_views[i];
+}
+
+void CGUIListContainer::Render()
+{
+	if (!IsVisible()) return;
+
+	if (!m_bAllocated) return;
+
+	UpdateViews();
+
+	int iColumns = m_layout.GetColumns();
+	int iOffset = m_layout.GetOffset();
+	int iEnd = (iOffset + m_layout.GetRows()) * iColumns;
+	if (iEnd > (int)m_items.size())
+		iEnd = m_items.size();
+
+	for (int i = iOffset * iColumns; i < iEnd; i++)
+	{
+		ItemView* pView = m_views[m_layout.GetView(i)];
+		float posX = m_posX + (i % iColumns) * m_itemWidth;
+		float posY = m_posY + (i / iColumns - iOffset) * m_itemHeight;
+
+		if (i == m_layout.GetSelected() && HasFocus())
+		{
+			m_imgFocus.Update(posX, posY);
+			m_imgFocus.Render();
+		}
+		else if (m_bNoFocusTexture)
+		{
+			m_imgNoFocus.Update(posX, posY);
+			m_imgNoFocus.Render();
+		}
+
+		if (m_thumbWidth > 0)
+		{
+			pView->thumb.Update(posX, posY);
+			pView->thumb.Render();
+		}
+
+		pView->label.SetPosition(posX + m_thumbWidth, posY);
+		pView->label.Render();
+	}
+
+	CGUIControl::Render();
+}
+
+bool CGUIListContainer::OnAction(const CAction &action)
+{
+	switch (action.GetID())
+	{
+		case ACTION_PAGE_UP:
+			MoveSelection(-m_layout.GetRows() * m_layout.GetColumns());
+			return true;
+
+		case ACTION_PAGE_DOWN:
+			MoveSelection(m_layout.GetRows() * m_layout.GetColumns());
+			return true;
+
+		case ACTION_SELECT_ITEM:
+		{
+			if (m_layout.GetSelected() < (int)m_items.size())
+			{
+				CGUIMessage msg(GUI_MSG_CLICKED, m_parentID, m_controlID, ACTION_SELECT_ITEM, m_layout.GetSelected());
+				g_windowManager.SendMessage(msg);
+			}
+			return true;
+		}
+	}
+
+	return CGUIControl::OnAction(action);
+}
+
+bool CGUIListContainer::OnMessage(CGUIMessage& message)
+{
+	if (message.GetControlId() == GetID())
+	{
+		if (message.GetMessage() == GUI_MSG_ITEM_SELECTED)
+		{
+			message.SetParam1(m_layout.GetSelected());
+			return true;
+		}
+	}
+
+	return CGUIControl::OnMessage(message);
+}
+
+void CGUIListContainer::OnUp()
+{
+	if (m_layout.MoveUp())
+		OnSelectionChanged();
+	else
+		CGUIControl::OnUp();
+}
+
+void CGUIListContainer::OnDown()
+{
+	if (m_layout.MoveDown())
+		OnSelectionChanged();
+	else
+		CGUIControl::OnDown();
+}
+
+void CGUIListContainer::OnLeft()
+{
+	if (m_layout.MoveLeft())
+		OnSelectionChanged();
+	else
+		CGUIControl::OnLeft();
+}
+
+void CGUIListContainer::OnRight()
+{
+	if (m_layout.MoveRight())
+		OnSelectionChanged();
+	else
+		CGUIControl::OnRight();
+}
+
+void CGUIListContainer::AllocResources()
+{
+	CGUIControl::AllocResources();
+
+	m_imgFocus.AllocResources();
+	if (m_bNoFocusTexture)
+		m_imgNoFocus.AllocResources();
+
+	// Thumbs are read for the bound items only
+	for (unsigned int i = 0; i < m_views.size(); i++)
+	{
+		if (m_layout.GetViewItem(i) >= 0)
+			Bind(m_views[i], m_layout.GetViewItem(i));
+	}
+	m_bUpdateViews = true;
+}
+
+void CGUIListContainer::FreeResources()
+{
+	CGUIControl::FreeResources();
+
+	m_imgFocus.FreeResources();
+	m_imgNoFocus.FreeResources();
+
+	for (unsigned int i = 0; i < m_views.size(); i++)
+		m_views[i]->thumb.FreeResources();
+
+	if (m_iBinds)
+		CLog::Log(LOGDEBUG, "CGUIListContainer %i: %u view(s) showed %u item(s) in %u bind(s)", GetID(), m_views.size(), m_items.size(), m_iBinds);
+	m_iBinds = 0;
+}
+
+unsigned int CGUIListContainer::GetTextureMemory() const
+{
+	unsigned int iMemory = m_imgFocus.GetMemoryUsage() + m_imgNoFocus.GetMemoryUsage();
+	for (unsigned int i = 0; i < m_views.size(); i++)
+		iMemory += m_views[i]->thumb.GetMemoryUsage();
+	return iMemory;
+}
+
+void CGUIListContainer::Reserve(int iItems)
+{
+	m_items.reserve(iItems);
+}
+
+void CGUIListContainer::AddItem(CGUIListItem* pItem)
+{
+	// Views are bound once, when the list is drawn next
+	m_items.push_back(pItem);
+	m_layout.SetItemCount(m_items.size());
+	m_bUpdateViews = true;
+}
+
+void CGUIListContainer::Clear()
+{
+	for (unsigned int i = 0; i < m_views.size(); i++)
+		Unbind(m_views[i]);
+
+	m_items.clear();
+	m_layout.Reset();
+	m_bUpdateViews = true;
+	MarkDirty();
+}
+
+void CGUIListContainer::ItemChanged(int iItem)
+{
+	int iFirst, iLast;
+	m_layout.GetShownItems(iFirst, iLast);
+	if (iItem < iFirst || iItem > iLast)
+		return;
+
+	Bind(m_views[m_layout.GetView(iItem)], iItem);
+	MarkDirty();
+}
+
+CGUIListItem* CGUIListContainer::GetSelectedListItem() const
+{
+	if (m_layout.GetSelected() < (int)m_items.size())
+		return m_items[m_layout.GetSelected()];
+	return NULL;
+}
+
+void CGUIListContainer::SelectItem(int iItem)
+{
+	if (iItem < 0 || iItem >= (int)m_items.size())
+		return;
+
+	MoveSelection(iItem - m_layout.GetSelected());
+}
+
+void CGUIListContainer::MoveSelection(int iOffset)
+{
+	if (m_layout.MoveSelection(iOffset))
+		OnSelectionChanged();
+}
+
+void CGUIListContainer::OnSelectionChanged()
+{
+	m_bUpdateViews = true;
+	MarkDirty();
+}
+
+// Binds the views to the rows on screen and the prefetched ones around them
+void CGUIListContainer::UpdateViews()
+{
+	if (!m_bUpdateViews)
+		return;
+	m_bUpdateViews = false;
+
+	bool bShownChanged = m_layout.UpdateViews(m_unbound, m_bound);
+
+	for (unsigned int i = 0; i < m_unbound.size(); i++)
+		Unbind(m_views[m_unbound[i]]);
+
+	for (unsigned int i = 0; i < m_bound.size(); i++)
+		Bind(m_views[m_bound[i]], m_layout.GetViewItem(m_bound[i]));
+
+	// Views that kept their item may have scrolled on or off screen, that only matters to a load still to come
+	int iFirst, iLast;
+	m_layout.GetShownItems(iFirst, iLast);
+	for (int i = iFirst; i <= iLast; i++)
+		m_views[m_layout.GetView(i)]->thumb.SetVisible(m_layout.IsItemOnScreen(i));
+
+	if (!bShownChanged)
+		return;
+
+	CGUIMessage msg(GUI_MSG_ITEMS_SHOWN, m_parentID, m_controlID, iFirst, iLast);
+	SendWindowMessage(msg);
+}
+
+void CGUIListContainer::Bind(ItemView* pView, int iItem)
+{
+	const CGUIListItem* pItem = m_items[iItem];
+
+	pView->label.SetText(pItem->GetLabel());
+
+	// Thumbs of the prefetched rows are read after the ones on screen
+	pView->thumb.FreeResources();
+	pView->thumb.SetFileName(pItem->GetThumbnailImage());
+	pView->thumb.SetVisible(m_layout.IsItemOnScreen(iItem));
+	if (m_bAllocated && m_thumbWidth > 0 && pItem->HasThumbnail())
+		pView->thumb.AllocResources();
+
+	m_iBinds++;
+}
+
+void CGUIListContainer::Unbind(ItemView* pView)
+{
+	pView->label.SetText("");
+	pView->thumb.FreeResources();
+}
@@ -0,0 +1,101 @@
+#ifndef GUILIB_GUILISTCONTAINER_H
+#define GUILIB_GUILISTCONTAINER_H
+
+#include "GUIControl.h"
+#include "GUIListItem.h"
+#include "GUILabel.h"
+#include "GUID3DTexture.h"
+#include "ListLayout.h"
+
+#include <vector>
+
+// Rows given views beyond the visible ones on each side, so scrolling finds them ready
+#define LISTCONTAINER_PREFETCH_ROWS 2
+
+/*!
+ \brief A list, or a panel with several items per row, that only builds
+ views for the items on screen.
+
+ The items are only pointed to. Views, a label and a thumb each, exist for
+ the visible rows plus LISTCONTAINER_PREFETCH_ROWS on either side, item i
+ is shown by view i % views. Scrolling binds the views of items that went
+ out of range to the items that came into it, so a directory of 50,000
+ items costs the same per frame and in video memory as one of 50. Which
+ views to bind is worked out by CListLayout, tools/ListBench measures it.
+
+ Whenever the range of items with views changes the parent window gets
+ GUI_MSG_ITEMS_SHOWN, it should fill in thumbs for those items only.
+ */
+class CGUIListContainer : public CGUIControl
+{
+public:
+	CGUIListContainer(int parentID, int controlID, float posX, float posY, float width, float height,
+		float itemWidth, float itemHeight, float thumbWidth,
+		const CTextureInfo& textureFocus, const CTextureInfo& textureNoFocus, const CLabelInfo& labelInfo);
+	virtual ~CGUIListContainer(void);
+
+	virtual void Render();
+	virtual bool OnAction(const CAction &action);
+	virtual bool OnMessage(CGUIMessage& message);
+	virtual void OnUp();
+	virtual void OnDown();
+	virtual void OnLeft();
+	virtual void OnRight();
+
+	virtual void AllocResources();
+	virtual void FreeResources();
+	virtual unsigned int GetTextureMemory() const;
+
+	// The items stay the caller's, they must outlive the list or be taken out with Clear()
+	void Reserve(int iItems);
+	void AddItem(CGUIListItem* pItem);
+	void Clear();
+
+	// The item's label or thumb changed
+	void ItemChanged(int iItem);
+
+	int GetNumItems() const { return (int)m_items.size(); };
+	CGUIListItem* GetListItem(int iItem) const { return m_items[iItem]; };
+	int GetSelectedItem() const { return m_layout.GetSelected(); };
+	CGUIListItem* GetSelectedListItem() const;
+	void SelectItem(int iItem);
+
+	// Items that have views, iFirst > iLast when there are none
+	void GetShownItems(int& iFirst, int& iLast) const { m_layout.GetShownItems(iFirst, iLast); };
+	bool IsItemOnScreen(int iItem) const { return m_layout.IsItemOnScreen(iItem); };
+
+protected:
+	struct ItemView
+	{
+		ItemView(float width, float height, float thumbWidth, const CLabelInfo& labelInfo);
+
+		CGUILabel label;
+		CGUID3DTexture thumb;
+	};
+
+	void MoveSelection(int iOffset);
+	void OnSelectionChanged();
+	void UpdateViews();
+	void Bind(ItemView* pView, int iItem);
+	void Unbind(ItemView* pView);
+
+	std::vector<CGUIListItem*> m_items;
+	std::vector<ItemView*> m_views;  // one per view of m_layout
+
+	CListLayout m_layout;
+	std::vector<unsigned int> m_unbound;  // reused by every UpdateViews()
+	std::vector<unsigned int> m_bound;
+	bool m_bUpdateViews;
+
+	float m_itemWidth;
+	float m_itemHeight;
+	float m_thumbWidth;
+
+	CGUID3DTexture m_imgFocus;
+	CGUID3DTexture m_imgNoFocus;
+	bool m_bNoFocusTexture;
+
+	unsigned int m_iBinds;       // views bound to another item
+};
+
+#endif //GUILIB_GUILISTCONTAINER_H
@@ -29,11 +29,16 @@ public:
 	CGUIListItem(void);
 	~CGUIListItem(void);
 
-	CStdString GetLabel() { return m_strLabel; };
+	const CStdString& GetLabel() const { return m_strLabel; };
+
+	void SetThumbnailImage(const CStdString& strThumb) { m_strThumbnailImage = strThumb; };
+	const CStdString& GetThumbnailImage() const { return m_strThumbnailImage; };
+	bool HasThumbnail() const { return !m_strThumbnailImage.IsEmpty(); };
 
 	bool m_bIsFolder; // Is item a folder or a file
 protected:
 	CStdString m_strLabel;
+	CStdString m_strThumbnailImage;
 };
 
 #endif //GUILIB_GUILISTITEM_H
\ No newline at end of file
@@ -17,6 +17,7 @@
 #define GUI_MSG_LABEL_ADD       12  // Add label control (for controls supporting more then 1 label)
 #define GUI_MSG_LABEL_SET		13  // Set the label of a control
 #define GUI_MSG_ITEM_SELECTED   15  // Ask control 2 return the selected item
+#define GUI_MSG_ITEMS_SHOWN     16  // A list built views for other items, param1/param2 = first/last item it has views for
 #define GUI_MSG_EXECUTE			20  // User has clicked on a button with <execute> tag
 
 #define GUI_MSG_USER         1000
@@ -0,0 +1,478 @@
+#include "GUISkinCache.h"
+#include "..\utils\SingleLock.h"
+#include "..\utils\Log.h"
+
+#include <stdio.h>
+
+CGUISkinCache g_skinCache;
+
+// Strings longer than this mean the file is broken
+#define SKINCACHE_MAX_STRING 4096
+
+// Appends values to the compiled form in memory, written with a single fwrite
+class CSkinCacheWriter
+{
+public:
+	void Write(DWORD dwValue) { Write(&dwValue, sizeof(dwValue)); }
+	void Write(int iValue) { Write(&iValue, sizeof(iValue)); }
+	void Write(float fValue) { Write(&fValue, sizeof(fValue)); }
+	void Write(bool bValue) { Write((DWORD)(bValue ? 1 : 0)); }
+	void Write(__int64 iValue) { Write(&iValue, sizeof(iValue)); }
+	void Write(unsigned __int64 iValue) { Write(&iValue, sizeof(iValue)); }
+
+	void Write(const CStdString& strValue)
+	{
+		Write((DWORD)strValue.size());
+		Write(strValue.c_str(), strValue.size());
+	}
+
+	void Write(const CTextureInfo& texture)
+	{
+		Write(texture.useLarge);
+		Write(texture.border.left);
+		Write(texture.border.top);
+		Write(texture.border.right);
+		Write(texture.border.bottom);
+		Write(texture.orientation);
+		Write(texture.diffuse);
+		Write(texture.filename);
+	}
+
+	void Write(const InfoLabelDesc& label)
+	{
+		Write(label.strLabel);
+		Write(label.strFallback);
+	}
+
+	void Write(const void* pData, unsigned int iSize)
+	{
+		const BYTE* pBytes = (const BYTE*)pData;
+		m_data.insert(m_data.end(), pBytes, pBytes + iSize);
+	}
+
+	const std::vector<BYTE>& GetData() const { return m_data; }
+
+private:
+	std::vector<BYTE> m_data;
+};
+
+// Reads values back, any read past the end fails this and all further reads
+class CSkinCacheReader
+{
+public:
+	CSkinCacheReader(const BYTE* pData, unsigned int iSize)
+	{
+		m_pPos = pData;
+		m_pEnd = pData + iSize;
+		m_bOK = true;
+	}
+
+	bool IsOK() const { return m_bOK; }
+
+	bool Read(DWORD& dwValue) { return Read(&dwValue, sizeof(dwValue)); }
+	bool Read(int& iValue) { return Read(&iValue, sizeof(iValue)); }
+	bool Read(float& fValue) { return Read(&fValue, sizeof(fValue)); }
+	bool Read(__int64& iValue) { return Read(&iValue, sizeof(iValue)); }
+	bool Read(unsigned __int64& iValue) { return Read(&iValue, sizeof(iValue)); }
+
+	bool Read(bool& bValue)
+	{
+		DWORD dwValue = 0;
+		Read(dwValue);
+		bValue = dwValue != 0;
+		return m_bOK;
+	}
+
+	bool Read(CStdString& strValue)
+	{
+		DWORD dwSize = 0;
+		if (!Read(dwSize) || dwSize > SKINCACHE_MAX_STRING || (unsigned int)(m_pEnd - m_pPos) < dwSize)
+			return m_bOK = false;
+
+		strValue.assign((const char*)m_pPos, dwSize);
+		m_pPos += dwSize;
+		return true;
+	}
+
+	bool Read(CTextureInfo& texture)
+	{
+		Read(texture.useLarge);
+		Read(texture.border.left);
+		Read(texture.border.top);
+		Read(texture.border.right);
+		Read(texture.border.bottom);
+		Read(texture.orientation);
+		Read(texture.diffuse);
+		Read(texture.filename);
+		return m_bOK;
+	}
+
+	bool Read(InfoLabelDesc& label)
+	{
+		Read(label.strLabel);
+		Read(label.strFallback);
+		return m_bOK;
+	}
+
+	// Element count of a list, bounded by what's left of the file
+	bool ReadCount(DWORD& dwCount)
+	{
+		if (!Read(dwCount) || dwCount > (DWORD)(m_pEnd - m_pPos))
+			return m_bOK = false;
+		return true;
+	}
+
+	bool Read(void* pData, unsigned int iSize)
+	{
+		if (!m_bOK || (unsigned int)(m_pEnd - m_pPos) < iSize)
+			return m_bOK = false;
+
+		memcpy(pData, m_pPos, iSize);
+		m_pPos += iSize;
+		return true;
+	}
+
+private:
+	const BYTE* m_pPos;
+	const BYTE* m_pEnd;
+	bool m_bOK;
+};
+
+static void WriteControl(CSkinCacheWriter& writer, const ControlDesc& control)
+{
+	writer.Write(control.iType);
+	writer.Write(control.dwID);
+	writer.Write(control.posX);
+	writer.Write(control.posY);
+	writer.Write(control.width);
+	writer.Write(control.height);
+	writer.Write(control.minWidth);
+	writer.Write(control.up);
+	writer.Write(control.down);
+	writer.Write(control.left);
+	writer.Write(control.right);
+	writer.Write(control.strVisible);
+
+	writer.Write(control.dwTextColor);
+	writer.Write(control.textOffsetX);
+	writer.Write(control.textOffsetY);
+	writer.Write(control.dwAlign);
+	writer.Write(control.strFont);
+
+	writer.Write((DWORD)control.clickActions.size());
+	for (unsigned int i = 0; i < control.clickActions.size(); i++)
+		writer.Write(control.clickActions[i]);
+
+	writer.Write(control.textureFocus);
+	writer.Write(control.textureNoFocus);
+	writer.Write(control.textureUp);
+	writer.Write(control.textureDown);
+	writer.Write(control.textureUpFocus);
+	writer.Write(control.textureDownFocus);
+	writer.Write(control.texture);
+	writer.Write(control.textureFile);
+
+	writer.Write((DWORD)control.infoLabels.size());
+	for (unsigned int i = 0; i < control.infoLabels.size(); i++)
+		writer.Write(control.infoLabels[i]);
+	writer.Write(control.strLabel);
+
+	writer.Write(control.iSubType);
+	writer.Write(control.bReverse);
+	writer.Write(control.spinWidth);
+	writer.Write(control.spinHeight);
+
+	writer.Write(control.itemWidth);
+	writer.Write(control.itemHeight);
+	writer.Write(control.thumbWidth);
+}
+
+static bool ReadControl(CSkinCacheReader& reader, ControlDesc& control)
+{
+	reader.Read(control.iType);
+	reader.Read(control.dwID);
+	reader.Read(control.posX);
+	reader.Read(control.posY);
+	reader.Read(control.width);
+	reader.Read(control.height);
+	reader.Read(control.minWidth);
+	reader.Read(control.up);
+	reader.Read(control.down);
+	reader.Read(control.left);
+	reader.Read(control.right);
+	reader.Read(control.strVisible);
+
+	reader.Read(control.dwTextColor);
+	reader.Read(control.textOffsetX);
+	reader.Read(control.textOffsetY);
+	reader.Read(control.dwAlign);
+	reader.Read(control.strFont);
+
+	DWORD dwCount = 0;
+	if (!reader.ReadCount(dwCount))
+		return false;
+	control.clickActions.resize(dwCount);
+	for (unsigned int i = 0; i < dwCount; i++)
+		reader.Read(control.clickActions[i]);
+
+	reader.Read(control.textureFocus);
+	reader.Read(control.textureNoFocus);
+	reader.Read(control.textureUp);
+	reader.Read(control.textureDown);
+	reader.Read(control.textureUpFocus);
+	reader.Read(control.textureDownFocus);
+	reader.Read(control.texture);
+	reader.Read(control.textureFile);
+
+	if (!reader.ReadCount(dwCount))
+		return false;
+	control.infoLabels.resize(dwCount);
+	for (unsigned int i = 0; i < dwCount; i++)
+		reader.Read(control.infoLabels[i]);
+	reader.Read(control.strLabel);
+
+	reader.Read(control.iSubType);
+	reader.Read(control.bReverse);
+	reader.Read(control.spinWidth);
+	reader.Read(control.spinHeight);
+
+	reader.Read(control.itemWidth);
+	reader.Read(control.itemHeight);
+	reader.Read(control.thumbWidth);
+
+	return reader.IsOK();
+}
+
+CGUISkinCache::CGUISkinCache(void)
+{
+	m_iHits = 0;
+	m_iMisses = 0;
+	m_iStale = 0;
+	m_dwHitTime = 0;
+	m_dwMissTime = 0;
+}
+
+CGUISkinCache::~CGUISkinCache(void)
+{
+}
+
+bool CGUISkinCache::Load(const CStdString& strFile, WindowDesc& desc)
+{
+	DWORD dwStart = GetTickCount();
+	CStdString strCacheFile = GetCacheFile(strFile);
+
+	FILE* fd = fopen(strCacheFile.c_str(), "rb");
+	if (!fd)
+		return false;
+
+	std::vector<BYTE> data;
+	fseek(fd, 0, SEEK_END);
+	long iSize = ftell(fd);
+	fseek(fd, 0, SEEK_SET);
+	if (iSize > 0)
+	{
+		data.resize(iSize);
+		if (fread(&data[0], iSize, 1, fd) != 1)
+			data.clear();
+	}
+	fclose(fd);
+
+	CSkinCacheReader reader(data.empty() ? NULL : &data[0], data.size());
+
+	DWORD dwMagic = 0, dwVersion = 0;
+	if (!reader.Read(dwMagic) || !reader.Read(dwVersion) || dwMagic != SKINCACHE_MAGIC || dwVersion != SKINCACHE_VERSION)
+	{
+		CLog::Log(LOGDEBUG, "CGUISkinCache: %s is not a compiled window of this version", strCacheFile.c_str());
+		return false;
+	}
+
+	desc = WindowDesc();
+
+	DWORD dwCount = 0;
+	if (!reader.ReadCount(dwCount))
+		return false;
+
+	for (unsigned int i = 0; i < dwCount; i++)
+	{
+		CStdString strSource;
+		__int64 iSourceSize = 0, iCurrentSize = 0;
+		unsigned __int64 iModified = 0, iCurrentModified = 0;
+		if (!reader.Read(strSource) || !reader.Read(iSourceSize) || !reader.Read(iModified))
+			break;
+
+		GetIdentity(strSource, iCurrentSize, iCurrentModified);
+		if (iSourceSize != iCurrentSize || iModified != iCurrentModified)
+		{
+			CLog::Log(LOGDEBUG, "CGUISkinCache: %s changed since %s was compiled", strSource.c_str(), strCacheFile.c_str());
+
+			CSingleLock lock(m_critSection);
+			m_iStale++;
+			return false;
+		}
+		desc.sources.push_back(strSource);
+	}
+
+	reader.Read(desc.dwDefaultControl);
+	reader.Read(desc.strVisible);
+
+	if (!reader.ReadCount(dwCount))
+		return false;
+
+	desc.controls.resize(dwCount);
+	for (unsigned int i = 0; i < dwCount; i++)
+	{
+		if (!ReadControl(reader, desc.controls[i]))
+			break;
+	}
+
+	if (!reader.IsOK())
+	{
+		CLog::Log(LOGWARNING, "CGUISkinCache: %s is truncated", strCacheFile.c_str());
+		return false;
+	}
+
+	DWORD dwTime = GetTickCount() - dwStart;
+
+	CSingleLock lock(m_critSection);
+	m_iHits++;
+	m_dwHitTime += dwTime;
+
+	CLog::Log(LOGDEBUG, "CGUISkinCache: loaded %u control(s) from %s in %u ms", dwCount, strCacheFile.c_str(), dwTime);
+	return true;
+}
+
+bool CGUISkinCache::Save(const CStdString& strFile, const WindowDesc& desc, DWORD dwParseTime)
+{
+	CStdString strCacheFile = GetCacheFile(strFile);
+	CStdString strDirectory = GetDirectory(strCacheFile);
+	{
+		CSingleLock lock(m_critSection);
+		m_iMisses++;
+		m_dwMissTime += dwParseTime;
+
+		if (m_unwritable.find(strDirectory) != m_unwritable.end())
+			return false;
+	}
+
+	CSkinCacheWriter writer;
+	writer.Write((DWORD)SKINCACHE_MAGIC);
+	writer.Write((DWORD)SKINCACHE_VERSION);
+
+	writer.Write((DWORD)desc.sources.size());
+	for (unsigned int i = 0; i < desc.sources.size(); i++)
+	{
+		__int64 iSize = 0;
+		unsigned __int64 iModified = 0;
+		GetIdentity(desc.sources[i], iSize, iModified);
+
+		writer.Write(desc.sources[i]);
+		writer.Write(iSize);
+		writer.Write(iModified);
+	}
+
+	writer.Write(desc.dwDefaultControl);
+	writer.Write(desc.strVisible);
+
+	writer.Write((DWORD)desc.controls.size());
+	for (unsigned int i = 0; i < desc.controls.size(); i++)
+		WriteControl(writer, desc.controls[i]);
+
+	// Write to a temp file first so a half written window is never picked up.
+	// Windows are loaded on more than one thread, each writes its own.
+	CStdString strTemp;
+	strTemp.Format("%s.%u.tmp", strCacheFile.c_str(), (unsigned int)GetCurrentThreadId());
+
+	FILE* fd = fopen(strTemp.c_str(), "wb");
+	if (!fd)
+	{
+		// Likely a skin on read only media, every other window would fail the same way
+		CSingleLock lock(m_critSection);
+		if (m_unwritable.insert(strDirectory).second)
+			CLog::Log(LOGWARNING, "CGUISkinCache: unable to write %s, windows in %s won't be compiled", strTemp.c_str(), strDirectory.c_str());
+		return false;
+	}
+
+	const std::vector<BYTE>& data = writer.GetData();
+	bool bResult = fwrite(&data[0], data.size(), 1, fd) == 1;
+	fclose(fd);
+
+	if (bResult)
+	{
+		// Another thread may be replacing the same window, the last one wins
+		CSingleLock lock(m_critSection);
+		DeleteFile(strCacheFile.c_str());
+		bResult = MoveFile(strTemp.c_str(), strCacheFile.c_str()) != FALSE;
+	}
+
+	if (!bResult)
+	{
+		CLog::Log(LOGERROR, "CGUISkinCache: failed writing %s", strCacheFile.c_str());
+		DeleteFile(strTemp.c_str());
+		return false;
+	}
+
+	CLog::Log(LOGDEBUG, "CGUISkinCache: compiled %s, reading the XML took %u ms", strCacheFile.c_str(), dwParseTime);
+	return true;
+}
+
+void CGUISkinCache::GetStats(SkinCacheStats& stats) const
+{
+	CSingleLock lock(m_critSection);
+
+	stats.iHits = m_iHits;
+	stats.iMisses = m_iMisses;
+	stats.iStale = m_iStale;
+	stats.fHitTime = m_iHits ? (float)m_dwHitTime / m_iHits : 0.0f;
+	stats.fMissTime = m_iMisses ? (float)m_dwMissTime / m_iMisses : 0.0f;
+}
+
+void CGUISkinCache::Reset()
+{
+	CSingleLock lock(m_critSection);
+
+	SkinCacheStats stats;
+	GetStats(stats);
+	if (stats.iHits || stats.iMisses)
+	{
+		CLog::Log(LOGNOTICE, "CGUISkinCache: %u window(s) loaded compiled in avg %.1f ms, %u read from XML in avg %.1f ms (%u of them were out of date)",
+			stats.iHits, stats.fHitTime, stats.iMisses, stats.fMissTime, stats.iStale);
+	}
+
+	m_iHits = 0;
+	m_iMisses = 0;
+	m_iStale = 0;
+	m_dwHitTime = 0;
+	m_dwMissTime = 0;
+	m_unwritable.clear();
+}
+
+CStdString CGUISkinCache::GetCacheFile(const CStdString& strFile)
+{
+	int iExtension = strFile.ReverseFind('.');
+	if (iExtension < 0)
+		return strFile + SKINCACHE_EXTENSION;
+
+	return strFile.Left(iExtension) + SKINCACHE_EXTENSION;
+}
+
+// Including the trailing separator
+CStdString CGUISkinCache::GetDirectory(const CStdString& strFile)
+{
+	int iSeparator = strFile.ReverseFind('\\');
+	return strFile.Left(iSeparator + 1);
+}
+
+// A file that doesn't exist has size -1, so a window notices it being added
+void CGUISkinCache::GetIdentity(const CStdString& strFile, __int64& iSize, unsigned __int64& iModified)
+{
+	WIN32_FILE_ATTRIBUTE_DATA data;
+	if (!GetFileAttributesEx(strFile.c_str(), GetFileExInfoStandard, &data))
+	{
+		iSize = -1;
+		iModified = 0;
+		return;
+	}
+
+	iSize = ((__int64)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+	iModified = ((unsigned __int64)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+}
@@ -0,0 +1,84 @@
+#ifndef GUILIB_GUISKINCACHE_H
+#define GUILIB_GUISKINCACHE_H
+
+#include "GUIControlFactory.h"
+#include "..\utils\CriticalSection.h"
+#include "..\utils\StdString.h"
+
+#include <vector>
+#include <set>
+
+// Compiled windows are written next to the skin file they were read from
+#define SKINCACHE_EXTENSION ".xbs"
+#define SKINCACHE_MAGIC     0x58534B42 // 'XSKB'
+#define SKINCACHE_VERSION   3
+
+// A window as read from its skin file
+struct WindowDesc
+{
+	WindowDesc()
+	{
+		dwDefaultControl = 0;
+	}
+
+	DWORD dwDefaultControl;
+	CStdString strVisible;           // visibility condition
+	vector<ControlDesc> controls;
+
+	vector<CStdString> sources;      // files the window was read from, once one changes it's compiled again
+};
+
+struct SkinCacheStats
+{
+	unsigned int iHits;
+	unsigned int iMisses;            // windows read from XML
+	unsigned int iStale;             // of those, had a compiled form that was out of date
+	float fHitTime;                  // average ms to load a compiled window
+	float fMissTime;                 // average ms to read a window from XML
+};
+
+/*!
+ \brief Keeps windows in a compiled binary form, so loading one doesn't
+ parse XML.
+
+ The compiled form is a flat copy of the window's WindowDesc, written the
+ first time the window is read from XML. It records size and modification
+ time of every source file and is only used while they all still match.
+ */
+class CGUISkinCache
+{
+public:
+	CGUISkinCache(void);
+	virtual ~CGUISkinCache(void);
+
+	// Reads the compiled form of strFile, false when there is none or it's out of date
+	bool Load(const CStdString& strFile, WindowDesc& desc);
+
+	// Writes the compiled form of strFile, dwParseTime is the time reading the XML took in ms
+	bool Save(const CStdString& strFile, const WindowDesc& desc, DWORD dwParseTime);
+
+	void GetStats(SkinCacheStats& stats) const;
+
+	// Logs and clears the stats, directories that couldn't be written are tried again
+	void Reset();
+
+private:
+	static CStdString GetCacheFile(const CStdString& strFile);
+	static CStdString GetDirectory(const CStdString& strFile);
+	static void GetIdentity(const CStdString& strFile, __int64& iSize, unsigned __int64& iModified);
+
+	CCriticalSection m_critSection;
+
+	unsigned int m_iHits;
+	unsigned int m_iMisses;
+	unsigned int m_iStale;
+	DWORD m_dwHitTime;
+	DWORD m_dwMissTime;
+
+	// Skin directories on read only media, nothing is written there until the next Reset()
+	std::set<CStdString> m_unwritable;
+};
+
+extern CGUISkinCache g_skinCache;
+
+#endif //GUILIB_GUISKINCACHE_H
@@ -114,6 +114,12 @@ void CGUISpinControl::FreeResources()
 //	m_imgspinDownFocus.FreeResources();
 }
 
+unsigned int CGUISpinControl::GetTextureMemory() const
+{
+	return m_imgspinUp.GetTextureMemory() + m_imgspinUpFocus.GetTextureMemory() +
+	       m_imgspinDown.GetTextureMemory() + m_imgspinDownFocus.GetTextureMemory();
+}
+
 void CGUISpinControl::SetPosition(float posX, float posY)
 {
 	m_imgspinDownFocus.SetPosition(posX, posY);
@@ -26,6 +26,7 @@ public:
 	virtual void Render();
 	virtual void AllocResources();
 	virtual void FreeResources();
+	virtual unsigned int GetTextureMemory() const;
 
 	virtual void SetPosition(float posX, float posY);
 	virtual bool OnAction(const CAction &action);
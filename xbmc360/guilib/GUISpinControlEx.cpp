@@ -61,6 +61,11 @@ void CGUISpinControlEx::FreeResources()
 //	m_focus.FreeResources();
 }
 
+unsigned int CGUISpinControlEx::GetTextureMemory() const
+{
+	return CGUISpinControl::GetTextureMemory() + m_buttonControl.GetTextureMemory() + m_focus.GetMemoryUsage();
+}
+
 const CStdString CGUISpinControlEx::GetCurrentLabel() const
 {
 	return CGUISpinControl::GetLabel();
@@ -18,6 +18,7 @@ public:
 
 	virtual void AllocResources();
 	virtual void FreeResources();
+	virtual unsigned int GetTextureMemory() const;
 
 	virtual int GetXPosition() const { return m_buttonControl.GetXPosition();};
 	virtual int GetYPosition() const { return m_buttonControl.GetYPosition();};
@@ -12,4 +12,7 @@
 
 #define GUI_MSG_LOAD_SKIN               GUI_MSG_USER + 11
 
+//  The video thumb loader made a thumb, strParam = item path, label = thumb
+#define GUI_MSG_THUMB_LOADED            GUI_MSG_USER + 12
+
 #endif //GUILIB_USERMESSAGE_H
\ No newline at end of file
@@ -52,6 +52,9 @@ void CGUIVideoControl::Render()
 		g_graphicsContext.SetViewWindow(rc);
 
 		g_renderManager.RenderUpdate(false);
+
+		// Every frame is a new picture, the renderer draws it past the sprite batch
+		MarkDirty();
 	}
 
 	CGUIControl::Render();
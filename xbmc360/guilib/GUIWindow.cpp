@@ -3,6 +3,13 @@
 #include "..\Application.h"
 #include "GUIWindowManager.h"
 #include "GUIControlFactory.h"
+#include "GUISkinCache.h"
+#include "GUIWindowRetention.h"
+#include "GUIWindowLoader.h"
+#include "GUIInfoManager.h"
+#include "SkinInfo.h"
+#include "ShaderManager.h"
+#include "SpriteBatch.h"
 
 #include "GUID3DTexture.h"
 
@@ -25,6 +32,7 @@ CGUIWindow::CGUIWindow(int id, const CStdString &xmlFile)
 
 CGUIWindow::~CGUIWindow(void)
 {
+	g_windowRetention.Release(this);
 }
 
 bool CGUIWindow::Initialize()
@@ -75,8 +83,23 @@ bool CGUIWindow::OnMessage(CGUIMessage& message)
 		case GUI_MSG_WINDOW_INIT:
 		{
 			CLog::Log(LOGDEBUG, "------ Window Init () ------", m_xmlFile.c_str());
+
+			LARGE_INTEGER start, end, frequency;
+			QueryPerformanceCounter(&start);
+			bool bWarm = m_windowLoaded;
+
+			// While open the window isn't charged against the retention budget
+			g_windowRetention.Release(this);
+
 			if (m_dynamicResourceAlloc || !m_WindowAllocated) AllocResources();
 			OnInitWindow();
+
+			if (m_loadOnDemand)
+			{
+				QueryPerformanceCounter(&end);
+				QueryPerformanceFrequency(&frequency);
+				g_windowRetention.ReportActivation(this, bWarm, (float)(1000.0 * (end.QuadPart - start.QuadPart) / frequency.QuadPart));
+			}
 			return true;
 		}
 		break;
@@ -91,27 +114,36 @@ bool CGUIWindow::OnMessage(CGUIMessage& message)
 		break;
 	}
 
-	ivecControls i;
+	std::pair<LOOKUPCONTROLS::iterator, LOOKUPCONTROLS::iterator> range = m_lookup.Find(message.GetControlId());
+	LOOKUPCONTROLS::iterator i;
 	// Send to the visible matching control first
-	for (i = m_vecControls.begin();i != m_vecControls.end(); ++i)
+	for (i = range.first; i != range.second; ++i)
 	{
-		CGUIControl* pControl = *i;
-		if (pControl && message.GetControlId() == pControl->GetID() && pControl->IsVisible())
+		CGUIControl* pControl = i->second;
+		if (pControl && pControl->IsVisible())
 		{
 			if (pControl->OnMessage(message))
+			{
+				if (message.GetMessage() == GUI_MSG_SETFOCUS && pControl->HasFocus())
+					m_lookup.SetFocused(pControl);
 				return true;
+			}
 		}
 	}
 
 	// Unhandled - send to all matching invisible controls as well
 	bool handled(false);
-	for (i = m_vecControls.begin();i != m_vecControls.end(); ++i)
+	for (i = range.first; i != range.second; ++i)
 	{
-		CGUIControl* pControl = *i;
-		if (pControl && message.GetControlId() == pControl->GetID() && !pControl->IsVisible())
+		CGUIControl* pControl = i->second;
+		if (pControl && !pControl->IsVisible())
 		{
 			if (pControl->OnMessage(message))
+			{
+				if (message.GetMessage() == GUI_MSG_SETFOCUS && pControl->HasFocus())
+					m_lookup.SetFocused(pControl);
 				handled = true;
+			}
 		}
 	}
 
@@ -121,6 +153,7 @@ bool CGUIWindow::OnMessage(CGUIMessage& message)
 void CGUIWindow::AddControl(CGUIControl* pControl)
 {
 	m_vecControls.push_back(pControl);
+	m_lookup.Add(pControl);
 }
 
 void CGUIWindow::InsertControl(CGUIControl *control, const CGUIControl *insertPoint)
@@ -134,6 +167,7 @@ void CGUIWindow::InsertControl(CGUIControl *control, const CGUIControl *insertPo
 		i++;
 	}
 	m_vecControls.insert(i, control);
+	m_lookup.Add(control);
 }
 
 void CGUIWindow::RemoveControl(DWORD dwId)
@@ -145,6 +179,7 @@ void CGUIWindow::RemoveControl(DWORD dwId)
 		if (pControl->GetID() == dwId)
 		{
 			m_vecControls.erase(i);
+			m_lookup.Remove(pControl);
 			return ;
 		}
 		++i;
@@ -228,9 +263,10 @@ bool CGUIWindow::OnBack(int actionID)
 
 void CGUIWindow::ClearBackground()
 {
+	// Queued like the controls, so it can be clipped to the part of the screen that is redrawn
 	DWORD color = m_clearBackground;
 	if (color)
-		g_graphicsContext.Clear(color);
+		g_spriteBatch.AddRect(0, 0, (float)g_graphicsContext.GetWidth(), (float)g_graphicsContext.GetHeight(), color);
 }
 
 void CGUIWindow::OnWindowLoaded()
@@ -240,6 +276,8 @@ void CGUIWindow::OnWindowLoaded()
 
 void CGUIWindow::AllocResources(bool forceLoad /*= FALSE */)
 {
+	DWORD dwShaderTimeSaved = g_shaderManager.GetTimeSaved();
+
 	// load skin xml file
 	if (m_xmlFile.size() && (forceLoad || m_loadOnDemand || !m_windowLoaded)) Load(m_xmlFile);
 
@@ -259,26 +297,49 @@ void CGUIWindow::AllocResources(bool forceLoad /*= FALSE */)
 			pControl->AllocResources();
 	}
 
+	dwShaderTimeSaved = g_shaderManager.GetTimeSaved() - dwShaderTimeSaved;
+	if (dwShaderTimeSaved)
+		CLog::Log(LOGDEBUG, "%s: shared shaders saved %u ms of compiling", m_xmlFile.c_str(), dwShaderTimeSaved);
+
 	m_WindowAllocated = true;
 }
 
 void CGUIWindow::FreeResources(bool forceUnload /*= FALSE */)
 {
 	m_WindowAllocated = false;
-	ivecControls i;
-	for (i = m_vecControls.begin();i != m_vecControls.end(); ++i)
+
+	// Recently closed windows may stay loaded, see CGUIWindowRetention
+	bool bRetain = m_loadOnDemand && !forceUnload && m_windowLoaded && g_windowRetention.Retain(this);
+
+	if (!bRetain || !g_windowRetention.GetRetainTextures())
 	{
-		CGUIControl* pControl = *i;
-		pControl->FreeResources();
+		ivecControls i;
+		for (i = m_vecControls.begin();i != m_vecControls.end(); ++i)
+		{
+			CGUIControl* pControl = *i;
+			pControl->FreeResources();
+		}
 	}
 	//g_TextureManager.Dump();
 	// unload the skin
-	if (m_loadOnDemand || forceUnload) ClearAll();
+	if ((m_loadOnDemand && !bRetain) || forceUnload) ClearAll();
+}
+
+unsigned int CGUIWindow::GetMemoryUsage(bool bTextures) const
+{
+	unsigned int iMemoryUsage = m_vecControls.size() * WINDOWRETENTION_CONTROL_SIZE;
+	if (bTextures)
+	{
+		for (unsigned int i = 0; i < m_vecControls.size(); i++)
+			iMemoryUsage += m_vecControls[i]->GetTextureMemory();
+	}
+	return iMemoryUsage;
 }
 
 void CGUIWindow::ClearAll()
 {
 //	OnWindowUnload();
+	g_windowRetention.Release(this);
 
 	for (int i = 0; i < (int)m_vecControls.size(); ++i)
 	{
@@ -287,41 +348,27 @@ void CGUIWindow::ClearAll()
 	}
 
 	m_vecControls.erase(m_vecControls.begin(), m_vecControls.end());
+	m_lookup.Clear();
 	m_windowLoaded = false;
 	m_dynamicResourceAlloc = true;
 }
 
 int CGUIWindow::GetFocusedControlID() const
 {
-	for (int i = 0;i < (int)m_vecControls.size(); ++i)
-	{
-		const CGUIControl* pControl = m_vecControls[i];
-		if (pControl->HasFocus() ) return pControl->GetID();
-	}
+	const CGUIControl* pControl = GetFocusedControl();
+	if (pControl) return pControl->GetID();
 	return -1;
 }
 
 CGUIControl *CGUIWindow::GetFocusedControl() const
 {
-	for (int i = 0;i < (int)m_vecControls.size(); ++i)
-	{
-		const CGUIControl* control = m_vecControls[i];
-		if (control->HasFocus())
-		{
-			return (CGUIControl *)control;
-		}
-	}
-	return NULL;
+	// Focus normally moves through GUI_MSG_SETFOCUS, which tells m_lookup
+	return m_lookup.GetFocused(m_vecControls);
 }
 
 const CGUIControl* CGUIWindow::GetControl(int iControl) const
 {
-	for (int i = 0;i < (int)m_vecControls.size(); ++i)
-	{
-		const CGUIControl* pControl = m_vecControls[i];
-		if (pControl->GetID() == iControl) return pControl;
-	}
-	return NULL;
+	return m_lookup.Get(iControl);
 }
 
 void CGUIWindow::SaveControlStates()
@@ -350,28 +397,67 @@ void CGUIWindow::RestoreControlStates()
 
 bool CGUIWindow::LoadXML(const CStdString &strPath, const CStdString &strLowerPath)
 {
-	TiXmlDocument xmlDoc;
+	// The window loader may have read it already
+	WindowDesc desc;
+	if (g_windowLoader.GetDesc(GetID(), desc))
+		return Load(desc);
+
+	if (!ReadDesc(g_graphicsContext.GetMediaDir() + strPath, desc))
+	{
+		SetID(WINDOW_INVALID);
+		return false;
+	}
 
-	CStdString strPathroot = g_graphicsContext.GetMediaDir();
-	CStdString strPathFull;
-	strPathFull = strPathroot + strPath;
+	return Load(desc);
+}
+
+CStdString CGUIWindow::GetSkinFile() const
+{
+	if (m_xmlFile.IsEmpty())
+		return m_xmlFile;
+	return g_graphicsContext.GetMediaDir() + m_xmlFile;
+}
+
+bool CGUIWindow::ReadDesc(const CStdString &strPathFull, WindowDesc &desc)
+{
+	if (g_skinCache.Load(strPathFull, desc))
+		return true;
+
+	DWORD dwStart = GetTickCount();
+	TiXmlDocument xmlDoc;
 
 	if ( !xmlDoc.LoadFile(strPathFull)/* && !xmlDoc.LoadFile(CStdString(strPath).ToLower()) && !xmlDoc.LoadFile(strLowerPath)*/)
 	{
-		CLog::Log(LOGERROR, "unable to load:%s, Line %d\n%s", strPath.c_str(), xmlDoc.ErrorRow(), xmlDoc.ErrorDesc());
-		SetID(WINDOW_INVALID);
+		CLog::Log(LOGERROR, "unable to load:%s, Line %d\n%s", strPathFull.c_str(), xmlDoc.ErrorRow(), xmlDoc.ErrorDesc());
 		return false;
 	}
 
-	return Load(xmlDoc);
+	if (!Parse(xmlDoc, desc))
+		return false;
+
+	desc.sources.push_back(strPathFull);
+	g_SkinInfo.GetIncludeFiles(desc.sources);
+	g_skinCache.Save(strPathFull, desc, GetTickCount() - dwStart);
+
+	return true;
 }
 
-bool CGUIWindow::Load(TiXmlDocument &xmlDoc)
+bool CGUIWindow::Load(const WindowDesc &desc)
 {
 	m_saveLastControl = true;
-	m_dwDefaultFocusControlID = 0;
-	m_visibleCondition = 0;
+	m_dwDefaultFocusControlID = desc.dwDefaultControl;
+	m_visibleCondition = desc.strVisible.IsEmpty() ? 0 : g_infoManager.TranslateString(desc.strVisible);
 
+	for (unsigned int i = 0; i < desc.controls.size(); i++)
+		LoadControl(desc.controls[i]);
+
+	m_windowLoaded = true;
+	OnWindowLoaded();
+	return true;
+}
+
+bool CGUIWindow::Parse(TiXmlDocument &xmlDoc, WindowDesc &desc)
+{
 	TiXmlElement* pRootElement = xmlDoc.RootElement();
 	if (strcmpi(pRootElement->Value(), "window"))
 	{
@@ -384,7 +470,7 @@ bool CGUIWindow::Load(TiXmlDocument &xmlDoc)
 //	g_graphicsContext.SetScalingResolution(/*m_coordsRes, m_needsScaling*/ true);
 
 	// Resolve any includes that may be present
-//	g_SkinInfo.ResolveIncludes(pRootElement);
+	g_SkinInfo.ResolveIncludes(pRootElement);
 	// now load in the skin file
 //	SetDefaults();	
 	
@@ -415,11 +501,11 @@ bool CGUIWindow::Load(TiXmlDocument &xmlDoc)
 	//		if (always && strcmpi(always, "true") == 0)
 	//		m_saveLastControl = false;
 			
-			m_dwDefaultFocusControlID = atoi(pChild->FirstChild()->Value());
+			desc.dwDefaultControl = atoi(pChild->FirstChild()->Value());
 		}
 		else if (strValue == "visible" && pChild->FirstChild())
 		{
-			CGUIControlFactory::GetConditionalVisibility(pRootElement, m_visibleCondition);
+			CGUIControlFactory::GetConditionalVisibility(pRootElement, desc.strVisible);
 		}
 		else if (strValue == "animation" && pChild->FirstChild())
 		{
@@ -470,14 +556,16 @@ bool CGUIWindow::Load(TiXmlDocument &xmlDoc)
 		else if (strValue == "controls")
 		{
 			// resolve any includes within controls tag (such as whole <control> includes)
-//			g_SkinInfo.ResolveIncludes(pChild);
+			g_SkinInfo.ResolveIncludes(pChild);
 
 			TiXmlElement *pControl = pChild->FirstChildElement();
 			while (pControl)
 			{
 				if (strcmpi(pControl->Value(), "control") == 0)
 				{
-					LoadControl(pControl);
+					ControlDesc control;
+					CGUIControlFactory::Parse(pControl, control);
+					desc.controls.push_back(control);
 				}
 				pControl = pControl->NextSiblingElement();
 			}
@@ -492,12 +580,10 @@ bool CGUIWindow::Load(TiXmlDocument &xmlDoc)
 		pChild = pChild->NextSiblingElement();
 	}
 
-	m_windowLoaded = true;
-	OnWindowLoaded();
 	return true;
 }
 
-void CGUIWindow::LoadControl(TiXmlElement* pControl)
+void CGUIWindow::LoadControl(const ControlDesc& desc)
 {
 	// get control type
 	CGUIControlFactory factory;
@@ -512,7 +598,7 @@ void CGUIWindow::LoadControl(TiXmlElement* pControl)
 		rect.bottom = rect.top + pGroup->GetHeight();
 	}
 */
-	CGUIControl* pGUIControl = factory.Create(GetID(), rect, pControl);
+	CGUIControl* pGUIControl = factory.Create(GetID(), desc);
 	if (pGUIControl)
 	{
 	/*	float maxX = pGUIControl->GetXPosition() + pGUIControl->GetWidth();
@@ -6,6 +6,8 @@
 #include "GUIControl.h"
 #include "GUIMessage.h"
 #include "key.h"
+#include "GUISkinCache.h"
+#include "ControlLookup.h"
 
 class CGUIWindow
 {
@@ -31,11 +33,22 @@ public:
 	virtual void FreeResources(bool forceUnload = false);
 
 	void ClearAll();
+
+	// Estimated memory the loaded controls use, with their textures if bTextures
+	unsigned int GetMemoryUsage(bool bTextures) const;
+
 	const CGUIControl* GetControl(int iControl) const;
 	int GetFocusedControlID() const;
 	CGUIControl *GetFocusedControl() const;
 
 	bool GetLoadOnDemand() { return m_loadOnDemand; }
+	bool IsLoaded() const { return m_windowLoaded; }
+
+	// Skin file with the media dir in front, empty if the window has none
+	CStdString GetSkinFile() const;
+
+	// Reads a skin file from its compiled form or the XML, safe on any thread
+	static bool ReadDesc(const CStdString &strPathFull, WindowDesc &desc);
 
 	virtual void Render();
 	
@@ -72,8 +85,9 @@ protected:
 	CStdString m_xmlFile;
 
 	virtual bool LoadXML(const CStdString& strPath, const CStdString &strLowerPath);  ///< Loads from the given file
-	bool Load(TiXmlDocument &xmlDoc);   	
-	void LoadControl(TiXmlElement* pControl);
+	bool Load(const WindowDesc &desc);
+	static bool Parse(TiXmlDocument &xmlDoc, WindowDesc &desc);
+	void LoadControl(const ControlDesc& desc);
 
 	void OnWindowLoaded();
 
@@ -92,6 +106,10 @@ protected:
 
 	vector<CGUIControl*> m_vecControls;
 	typedef std::vector<CGUIControl*>::iterator ivecControls;
+
+	// m_vecControls by id and the focused one, kept up to date by Add/Insert/RemoveControl
+	typedef CControlLookup<CGUIControl> LOOKUPCONTROLS;
+	LOOKUPCONTROLS m_lookup;
 	
 	DWORD m_dwDefaultFocusControlID;
 
@@ -0,0 +1,304 @@
+#include "GUIWindowLoader.h"
+#include "GUIWindow.h"
+#include "Key.h"
+#include "..\utils\SingleLock.h"
+#include "..\utils\Log.h"
+
+CGUIWindowLoader g_windowLoader;
+
+WindowLoadJob::WindowLoadJob()
+{
+	iWindowID = WINDOW_INVALID;
+	bSpeculative = false;
+	iGeneration = 0;
+	bSuccess = false;
+	dwQueued = 0;
+	dwRequested = 0;
+	dwReadTime = 0;
+}
+
+// class CGUIWindowLoader
+CGUIWindowLoader::CGUIWindowLoader()
+{
+	m_pActive = NULL;
+	m_iGeneration = 0;
+
+	m_iRequested = 0;
+	m_iSpeculative = 0;
+	m_iHits = 0;
+	m_iWasted = 0;
+	m_iRead = 0;
+	m_iFailed = 0;
+	m_iWaited = 0;
+	m_iTotalReadTime = 0;
+	m_iTotalWaitTime = 0;
+}
+
+CGUIWindowLoader::~CGUIWindowLoader()
+{
+	Stop();
+}
+
+void CGUIWindowLoader::Start()
+{
+	if (m_ThreadHandle != NULL)
+		return;
+
+	Create();
+}
+
+void CGUIWindowLoader::Stop()
+{
+	StopThread();
+	Clear();
+}
+
+void CGUIWindowLoader::Prepare(int iWindowID, const CStdString& strPath, bool bSpeculative)
+{
+	CSingleLock lock(m_critSection);
+
+	DWORD dwNow = GetTickCount();
+
+	bool bQueued = false;
+	WindowLoadJob* pJob = Find(m_done, iWindowID, false);
+	if (!pJob)
+	{
+		pJob = Find(m_queue, iWindowID, false);
+		bQueued = pJob != NULL;
+	}
+	if (!pJob && m_pActive && m_pActive->iWindowID == iWindowID)
+		pJob = m_pActive;
+
+	if (pJob)
+	{
+		if (bSpeculative)
+			return;
+
+		// Guessed right, the window is (being) read already
+		m_iRequested++;
+		if (pJob->bSpeculative)
+		{
+			pJob->bSpeculative = false;
+			pJob->dwRequested = dwNow;
+			m_iHits++;
+		}
+
+		// It goes before the windows that were only guessed at
+		if (bQueued)
+		{
+			Find(m_queue, iWindowID, true);
+			m_queue.push_front(pJob);
+		}
+		return;
+	}
+
+	pJob = new WindowLoadJob;
+	pJob->iWindowID = iWindowID;
+	pJob->strPath = strPath;
+	pJob->bSpeculative = bSpeculative;
+	pJob->iGeneration = m_iGeneration;
+	pJob->dwQueued = dwNow;
+	pJob->dwRequested = bSpeculative ? 0 : dwNow;
+
+	if (bSpeculative)
+	{
+		m_iSpeculative++;
+		m_queue.push_back(pJob);
+		TrimSpeculative();
+	}
+	else
+	{
+		m_iRequested++;
+		m_queue.push_front(pJob);
+	}
+
+	m_jobEvent.Set();
+}
+
+bool CGUIWindowLoader::IsPending(int iWindowID)
+{
+	CSingleLock lock(m_critSection);
+	return (m_pActive && m_pActive->iWindowID == iWindowID) || Find(m_queue, iWindowID, false) != NULL;
+}
+
+bool CGUIWindowLoader::GetDesc(int iWindowID, WindowDesc& desc)
+{
+	CSingleLock lock(m_critSection);
+
+	WindowLoadJob* pJob = Find(m_done, iWindowID, true);
+	if (!pJob)
+		return false;
+
+	// A failed read is done again by the window, which reports the error
+	bool bSuccess = pJob->bSuccess;
+	if (bSuccess)
+		desc = pJob->desc;
+
+	if (pJob->dwRequested)
+	{
+		m_iWaited++;
+		m_iTotalWaitTime += GetTickCount() - pJob->dwRequested;
+	}
+
+	delete pJob;
+	return bSuccess;
+}
+
+void CGUIWindowLoader::Clear()
+{
+	CSingleLock lock(m_critSection);
+
+	// A window being read now is dropped when it's done
+	m_iGeneration++;
+
+	for (unsigned int i = 0; i < m_queue.size(); i++)
+		delete m_queue[i];
+	for (unsigned int i = 0; i < m_done.size(); i++)
+		delete m_done[i];
+
+	m_queue.clear();
+	m_done.clear();
+}
+
+void CGUIWindowLoader::GetStats(WindowLoaderStats& stats) const
+{
+	CSingleLock lock(m_critSection);
+
+	stats.iRequested = m_iRequested;
+	stats.iSpeculative = m_iSpeculative;
+	stats.iHits = m_iHits;
+	stats.iWasted = m_iWasted;
+	stats.iFailed = m_iFailed;
+	stats.fReadTime = m_iRead ? (float)m_iTotalReadTime / m_iRead : 0.0f;
+	stats.fWaitTime = m_iWaited ? (float)m_iTotalWaitTime / m_iWaited : 0.0f;
+}
+
+void CGUIWindowLoader::Reset()
+{
+	CSingleLock lock(m_critSection);
+
+	WindowLoaderStats stats;
+	GetStats(stats);
+	if (stats.iRequested || stats.iSpeculative)
+	{
+		CLog::Log(LOGNOTICE, "CGUIWindowLoader: %u window(s) read in avg %.1f ms (%u failed), %u activated after avg %.1f ms, %u of %u speculative read(s) used, %u dropped",
+			m_iRead, stats.fReadTime, stats.iFailed, stats.iRequested, stats.fWaitTime, stats.iHits, stats.iSpeculative, stats.iWasted);
+	}
+
+	m_iRequested = 0;
+	m_iSpeculative = 0;
+	m_iHits = 0;
+	m_iWasted = 0;
+	m_iRead = 0;
+	m_iFailed = 0;
+	m_iWaited = 0;
+	m_iTotalReadTime = 0;
+	m_iTotalWaitTime = 0;
+}
+
+void CGUIWindowLoader::OnStartup()
+{
+	// Same as the texture loader, the activated window waits for both
+	SetPriority(THREAD_PRIORITY_BELOW_NORMAL);
+	SetName("CGUIWindowLoader");
+}
+
+void CGUIWindowLoader::Process()
+{
+	while (!m_bStop)
+	{
+		WindowLoadJob* pJob = GetNextJob();
+		if (!pJob)
+		{
+			m_jobEvent.WaitMSec(500);
+			continue;
+		}
+
+		DWORD dwStart = GetTickCount();
+		pJob->bSuccess = CGUIWindow::ReadDesc(pJob->strPath, pJob->desc);
+		pJob->dwReadTime = GetTickCount() - dwStart;
+
+		JobDone(pJob);
+	}
+}
+
+WindowLoadJob* CGUIWindowLoader::GetNextJob()
+{
+	CSingleLock lock(m_critSection);
+
+	if (m_queue.empty())
+		return NULL;
+
+	WindowLoadJob* pJob = m_queue.front();
+	m_queue.pop_front();
+	m_pActive = pJob;
+
+	return pJob;
+}
+
+void CGUIWindowLoader::JobDone(WindowLoadJob* pJob)
+{
+	CSingleLock lock(m_critSection);
+
+	m_pActive = NULL;
+
+	// Read from a skin that was unloaded meanwhile
+	if (pJob->iGeneration != m_iGeneration)
+	{
+		delete pJob;
+		return;
+	}
+
+	if (pJob->bSuccess) m_iRead++;
+	else m_iFailed++;
+	m_iTotalReadTime += pJob->dwReadTime;
+
+	CLog::Log(LOGDEBUG, "CGUIWindowLoader: read window %i in %u ms%s", pJob->iWindowID, pJob->dwReadTime, pJob->bSpeculative ? " ahead of time" : "");
+
+	m_done.push_back(pJob);
+	TrimSpeculative();
+}
+
+// Drops the oldest speculative reads until at most WINDOWLOADER_MAX_PREPARED are kept
+void CGUIWindowLoader::TrimSpeculative()
+{
+	unsigned int iSpeculative = 0;
+	for (unsigned int i = 0; i < m_done.size(); i++)
+		if (m_done[i]->bSpeculative) iSpeculative++;
+	for (unsigned int i = 0; i < m_queue.size(); i++)
+		if (m_queue[i]->bSpeculative) iSpeculative++;
+
+	std::deque<WindowLoadJob*>* queues[2] = { &m_done, &m_queue };
+	for (int q = 0; q < 2 && iSpeculative > WINDOWLOADER_MAX_PREPARED; q++)
+	{
+		std::deque<WindowLoadJob*>& queue = *queues[q];
+		std::deque<WindowLoadJob*>::iterator it = queue.begin();
+		while (it != queue.end() && iSpeculative > WINDOWLOADER_MAX_PREPARED)
+		{
+			if ((*it)->bSpeculative)
+			{
+				delete *it;
+				it = queue.erase(it);
+				iSpeculative--;
+				m_iWasted++;
+			}
+			else
+				++it;
+		}
+	}
+}
+
+WindowLoadJob* CGUIWindowLoader::Find(std::deque<WindowLoadJob*>& queue, int iWindowID, bool bRemove)
+{
+	for (std::deque<WindowLoadJob*>::iterator it = queue.begin(); it != queue.end(); ++it)
+	{
+		WindowLoadJob* pJob = *it;
+		if (pJob->iWindowID == iWindowID)
+		{
+			if (bRemove)
+				queue.erase(it);
+			return pJob;
+		}
+	}
+	return NULL;
+}
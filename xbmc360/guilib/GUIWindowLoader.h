@@ -0,0 +1,118 @@
+#ifndef GUILIB_GUIWINDOWLOADER_H
+#define GUILIB_GUIWINDOWLOADER_H
+
+#include "..\utils\Stdafx.h"
+#include "..\utils\Thread.h"
+#include "..\utils\CriticalSection.h"
+#include "..\utils\StdString.h"
+#include "GUISkinCache.h"
+
+#include <deque>
+
+// "GUI.WindowPreload" in settings.xml
+#define WINDOWPRELOAD_OFF    0 // windows are read when they are activated
+#define WINDOWPRELOAD_ASYNC  1 // read in the background, the current window stays until they're ready
+#define WINDOWPRELOAD_LIKELY 2 // also read the windows the focused button opens
+
+// Speculatively read windows kept waiting, the oldest is dropped first
+#define WINDOWLOADER_MAX_PREPARED 4
+
+struct WindowLoadJob
+{
+	WindowLoadJob();
+
+	int iWindowID;
+	CStdString strPath;         // skin file with the media dir in front
+	bool bSpeculative;          // nobody asked for the window yet
+	unsigned int iGeneration;   // skin the job was queued for
+
+	bool bSuccess;
+	WindowDesc desc;
+
+	DWORD dwQueued;             // tick count when queued
+	DWORD dwRequested;          // tick count when the window was activated
+	DWORD dwReadTime;           // ms spent on the worker
+};
+
+struct WindowLoaderStats
+{
+	unsigned int iRequested;      // windows activated before they were loaded
+	unsigned int iSpeculative;    // windows read because they were likely next
+	unsigned int iHits;           // activated windows a speculative read was already started for
+	unsigned int iWasted;         // speculative reads dropped unused
+	unsigned int iFailed;
+	float fReadTime;              // average ms reading a window on the worker
+	float fWaitTime;              // average ms from activation to the window being read
+};
+
+/*!
+ \brief Reads skin files of windows off the GUI thread.
+
+ Activating a window that isn't loaded only queues its skin file here, the
+ current window keeps rendering until the worker has its WindowDesc ready
+ and the window manager switches. Creating the controls from it stays on
+ the GUI thread, their textures are read in the background already.
+
+ Windows the user is likely to open next can be prepared before they are
+ activated, those only wait behind windows that were actually activated.
+ */
+class CGUIWindowLoader : public CThread
+{
+public:
+	CGUIWindowLoader();
+	virtual ~CGUIWindowLoader();
+
+	void Start();
+	void Stop();
+	bool IsStarted() const { return m_ThreadHandle != NULL; }
+
+	// A second request for a queued window only moves it to the front
+	void Prepare(int iWindowID, const CStdString& strPath, bool bSpeculative);
+
+	// Queued or still being read
+	bool IsPending(int iWindowID);
+
+	// Takes the description read for the window, false when there is none (yet)
+	bool GetDesc(int iWindowID, WindowDesc& desc);
+
+	// The skin is unloaded, drops everything read from it
+	void Clear();
+
+	void GetStats(WindowLoaderStats& stats) const;
+
+	// Logs and clears the stats
+	void Reset();
+
+protected:
+	virtual void OnStartup();
+	virtual void Process();
+
+private:
+	WindowLoadJob* GetNextJob();
+	void JobDone(WindowLoadJob* pJob);
+	void TrimSpeculative();
+
+	static WindowLoadJob* Find(std::deque<WindowLoadJob*>& queue, int iWindowID, bool bRemove);
+
+	std::deque<WindowLoadJob*> m_queue;
+	std::deque<WindowLoadJob*> m_done;
+	WindowLoadJob* m_pActive;     // job being read, owned by the worker
+	unsigned int m_iGeneration;
+
+	CCriticalSection m_critSection;
+	CEvent m_jobEvent;
+
+	unsigned int m_iRequested;
+	unsigned int m_iSpeculative;
+	unsigned int m_iHits;
+	unsigned int m_iWasted;
+	unsigned int m_iRead;
+	unsigned int m_iFailed;
+	unsigned int m_iWaited;
+	unsigned __int64 m_iTotalReadTime;
+	unsigned __int64 m_iTotalWaitTime;
+};
+
+extern CGUIWindowLoader g_windowLoader;
+
+#endif //GUILIB_GUIWINDOWLOADER_H
@@ -1,17 +1,33 @@
 #include "GraphicContext.h"
 #include "GUIWindowManager.h"
 #include "GUIDialog.h"
+#include "GUIButtonControl.h"
+#include "GUIWindowLoader.h"
+#include "GUIUserMessage.h"
 #include "..\utils\Log.h"
 #include "..\utils\SingleLock.h"
 #include "GUIAudioManager.h"
+#include "DirtyRegions.h"
+#include "..\utils\Util.h"
+#include "..\ButtonTranslator.h"
 
 using namespace std;
 
 CGUIWindowManager g_windowManager;
 
 CGUIWindowManager::CGUIWindowManager(void)
+	: m_threadMessages(THREADMESSAGES_SIZE, CGUIMessage(0, 0, 0))
 {
 	m_initialized = false;
+	m_dispatchBatch.reserve(THREADMESSAGES_SIZE);
+	m_bDispatching = false;
+	m_iCoalesced = 0;
+	m_iOverflowed = 0;
+	m_iPreload = WINDOWPRELOAD_LIKELY;
+	m_iPendingWindow = WINDOW_INVALID;
+	m_bPendingSwap = false;
+	m_iPredictedWindow = WINDOW_INVALID;
+	m_iPredictedControl = 0;
 }
 
 CGUIWindowManager::~CGUIWindowManager(void)
@@ -26,34 +42,126 @@ void CGUIWindowManager::Initialize()
 
 void CGUIWindowManager::SendThreadMessage(CGUIMessage& message)
 {
-	CSingleLock lock(m_critSection);
+	if (m_threadMessages.Push(message))
+		return;
+
+	if (!IsStateMessage(message))
+	{
+		CLog::Log(LOGERROR, "CGUIWindowManager: %u thread messages waiting, dropping message %i", m_threadMessages.GetDepth(), message.GetMessage());
+		return;
+	}
 
-	CGUIMessage* msg = new CGUIMessage(message);
-	m_vecThreadMessages.push_back( pair<CGUIMessage*,int>(msg,0) );
+	// Windows would keep showing a player that is gone
+	CLog::Log(LOGWARNING, "CGUIWindowManager: %u thread messages waiting, queueing message %i beside them", m_threadMessages.GetDepth(), message.GetMessage());
+	CSingleLock lock(m_critSection);
+	m_overflow.push_back(message);
+	m_iOverflowed++;
 }
 
 void CGUIWindowManager::DispatchThreadMessages()
 {
-	CSingleLock lock(m_critSection);
-	vector< pair<CGUIMessage*,int> > messages(m_vecThreadMessages);
-	m_vecThreadMessages.erase(m_vecThreadMessages.begin(), m_vecThreadMessages.end());
-	lock.Leave();
+	// A message handler dispatching again gets the rest with the next frame
+	if (m_bDispatching)
+		return;
+	m_bDispatching = true;
+
+	// Take what's waiting now, an announcement sent twice before we got to it is only sent once
+	CGUIMessage msg(0, 0, 0);
+	while (m_threadMessages.Pop(msg))
+		AddToBatch(msg);
+
+	// State changes that didn't fit go last, they were sent after the ring filled up
+	{
+		CSingleLock lock(m_critSection);
+		for (unsigned int i = 0; i < m_overflow.size(); i++)
+			AddToBatch(m_overflow[i]);
+		m_overflow.clear();
+	}
+
+	for (unsigned int i = 0; i < m_dispatchBatch.size(); i++)
+		SendMessage(m_dispatchBatch[i]);
+
+	m_dispatchBatch.clear();
+	m_bDispatching = false;
+}
+
+void CGUIWindowManager::AddToBatch(const CGUIMessage& message)
+{
+	bool bDuplicate = false;
+	if (CanCoalesce(message))
+	{
+		for (unsigned int i = 0; i < m_dispatchBatch.size() && !bDuplicate; i++)
+			bDuplicate = IsSameMessage(m_dispatchBatch[i], message);
+	}
+
+	if (bDuplicate)
+		m_iCoalesced++;
+	else
+		m_dispatchBatch.push_back(message);
+}
+
+// Only messages announcing something that is done, like a thumb the video
+// thumb loader made for the same item twice, handling one twice in a row
+// changes nothing. Events and state changes are always delivered.
+bool CGUIWindowManager::CanCoalesce(const CGUIMessage& message)
+{
+	if (message.GetLPVOID())
+		return false;
 
-	while ( messages.size() > 0 )
+	switch (message.GetMessage())
 	{
-		vector< pair<CGUIMessage*,int> >::iterator it = messages.begin();
-		CGUIMessage* pMsg = it->first;
-		int window = it->second;
-		// first remove the message from the queue,
-		// else the message could be processed more then once
-		it = messages.erase(it);
+		case GUI_MSG_THUMB_LOADED:
+			return true;
+	}
+	return false;
+}
 
-//		if (window) //TODO
-  //		SendMessage( *pMsg, window );
- //		else
-			SendMessage( *pMsg );
-		delete pMsg;
+// Messages telling windows the player changed state, the GUI goes wrong without them
+bool CGUIWindowManager::IsStateMessage(const CGUIMessage& message)
+{
+	switch (message.GetMessage())
+	{
+		case GUI_MSG_PLAYBACK_ENDED:
+		case GUI_MSG_PLAYBACK_STOPPED:
+			return true;
 	}
+	return false;
+}
+
+bool CGUIWindowManager::IsSameMessage(const CGUIMessage& left, const CGUIMessage& right)
+{
+	return left.GetMessage() == right.GetMessage() &&
+		left.GetSenderId() == right.GetSenderId() &&
+		left.GetControlId() == right.GetControlId() &&
+		left.GetParam1() == right.GetParam1() &&
+		left.GetParam2() == right.GetParam2() &&
+		left.GetLPVOID() == right.GetLPVOID() &&
+		left.GetLabel() == right.GetLabel() &&
+		left.GetStringParam() == right.GetStringParam();
+}
+
+void CGUIWindowManager::GetThreadMessageStats(MessageRingStats& stats, unsigned int& iCoalesced) const
+{
+	m_threadMessages.GetStats(stats);
+	iCoalesced = m_iCoalesced;
+}
+
+void CGUIWindowManager::ResetThreadMessageStats()
+{
+	MessageRingStats stats;
+	unsigned int iCoalesced;
+	GetThreadMessageStats(stats, iCoalesced);
+	if (stats.iPushed || stats.iDropped)
+	{
+		CLog::Log(LOGNOTICE, "CGUIWindowManager: %u thread message(s), %u coalesced, %u dropped, at most %u waiting, dispatched after avg %.2f ms, max %.2f ms",
+			stats.iPushed, iCoalesced, stats.iDropped - m_iOverflowed, stats.iMaxDepth, stats.fLatency, stats.fMaxLatency);
+	}
+	if (m_iOverflowed)
+		CLog::Log(LOGNOTICE, "CGUIWindowManager: %u state change message(s) found the ring full", m_iOverflowed);
+
+	m_threadMessages.ResetStats();
+	m_iCoalesced = 0;
+	m_iOverflowed = 0;
 }
 
 bool CGUIWindowManager::SendMessage(CGUIMessage& message)
@@ -207,6 +315,14 @@ void CGUIWindowManager::PreviousWindow()
 {
 	// Deactivate any window
 	CLog::Log(LOGDEBUG,"CGUIWindowManager::PreviousWindow: Deactivate");
+
+	// Going back while an activated window is still being read only cancels it
+	if (m_iPendingWindow != WINDOW_INVALID)
+	{
+		CLog::Log(LOGDEBUG, "CGUIWindowManager::PreviousWindow: cancelled activating window %i", m_iPendingWindow);
+		m_iPendingWindow = WINDOW_INVALID;
+		return;
+	}
 	
 	int currentWindow = GetActiveWindow();
 	CGUIWindow *pCurrentWindow = GetWindow(currentWindow);
@@ -363,6 +479,38 @@ void CGUIWindowManager::ActivateWindow(int iWindowID, bool swappingWindows)
 		return;
 	}
 
+	// Activated again while it's still being read
+	if (iWindowID == m_iPendingWindow)
+		return;
+
+	// A window activated while another one is still being read replaces it
+	m_iPendingWindow = WINDOW_INVALID;
+
+	// Keep the current window on screen while the new one's skin file is read,
+	// unless there is nothing to show yet or the skin was just reloaded
+	CGUIWindow *pCurrentWindow = GetWindow(GetActiveWindow());
+	if (m_iPreload != WINDOWPRELOAD_OFF && g_windowLoader.IsStarted() && !pNewWindow->IsLoaded() &&
+		pCurrentWindow && pCurrentWindow->IsLoaded())
+	{
+		CStdString strSkinFile = pNewWindow->GetSkinFile();
+		if (!strSkinFile.IsEmpty())
+		{
+			g_windowLoader.Prepare(iWindowID, strSkinFile, false);
+			m_iPendingWindow = iWindowID;
+			m_bPendingSwap = swappingWindows;
+			return;
+		}
+	}
+
+	ActivateLoadedWindow(iWindowID, swappingWindows);
+}
+
+void CGUIWindowManager::ActivateLoadedWindow(int iWindowID, bool swappingWindows)
+{
+	CGUIWindow *pNewWindow = GetWindow(iWindowID);
+	if (!pNewWindow)
+		return;
+
 	// Deactivate any window
 	int currentWindow = GetActiveWindow();
 	CGUIWindow *pWindow = GetWindow(currentWindow);
@@ -428,8 +576,18 @@ void CGUIWindowManager::RenderDialogs()
 	{
 		CGUIDialog *pDialog = (CGUIDialog *)m_activeDialogs[i];
 		if (pDialog->IsRunning())
+		{
 			pDialog->Render();
+			m_renderedWindows.push_back(pDialog);
+		}
 	}
+
+	// Controls of a window that went away don't report the area they covered
+	if (m_renderedWindows != m_lastRenderedWindows)
+		g_dirtyRegions.MarkAllDirty();
+
+	m_lastRenderedWindows.swap(m_renderedWindows);
+	m_renderedWindows.clear();
 }
 
 void CGUIWindowManager::Render_Internal()
@@ -437,26 +595,84 @@ void CGUIWindowManager::Render_Internal()
 	CSingleLock lock(g_graphicsContext);
 	CGUIWindow* pWindow = GetWindow(GetActiveWindow());
 	
+	m_renderedWindows.clear();
 	if (pWindow)
 	{
 		pWindow->ClearBackground();
 		pWindow->Render();
+		m_renderedWindows.push_back(pWindow);
 	}
 }
 
 void CGUIWindowManager::FrameMove()
 {
 	CSingleLock lock(g_graphicsContext);
+
+	// Switch once the window loader has read the activated window
+	if (m_iPendingWindow != WINDOW_INVALID && !g_windowLoader.IsPending(m_iPendingWindow))
+	{
+		int iWindowID = m_iPendingWindow;
+		m_iPendingWindow = WINDOW_INVALID;
+		ActivateLoadedWindow(iWindowID, m_bPendingSwap);
+	}
+
 	CGUIWindow* pWindow = GetWindow(GetActiveWindow());
 	
 	if (pWindow)
+	{
+		if (m_iPreload == WINDOWPRELOAD_LIKELY && g_windowLoader.IsStarted())
+			PrepareLikelyWindows(pWindow);
 		pWindow->FrameMove();
+	}
 
 	// Update any dialogs
 	for (iDialog it = m_activeDialogs.begin(); it != m_activeDialogs.end(); ++it)
 		(*it)->FrameMove();
 }
 
+// Reads the windows the focused button opens ahead of time, pressing it is likely next
+void CGUIWindowManager::PrepareLikelyWindows(CGUIWindow* pWindow)
+{
+	const CGUIControl* pControl = pWindow->GetFocusedControl();
+	int iControl = pControl ? pControl->GetID() : 0;
+	if (pWindow->GetID() == m_iPredictedWindow && iControl == m_iPredictedControl)
+		return;
+
+	m_iPredictedWindow = pWindow->GetID();
+	m_iPredictedControl = iControl;
+
+	if (!pControl || pControl->GetControlType() != CGUIControl::GUICONTROL_BUTTON)
+		return;
+
+	const vector<CStdString>& clickActions = ((const CGUIButtonControl*)pControl)->GetClickActions();
+	for (unsigned int i = 0; i < clickActions.size(); i++)
+	{
+		CGUIWindow* pTarget = GetWindow(GetTargetWindow(clickActions[i]));
+		if (!pTarget || pTarget->IsDialog() || pTarget->IsLoaded())
+			continue;
+
+		CStdString strSkinFile = pTarget->GetSkinFile();
+		if (!strSkinFile.IsEmpty())
+			g_windowLoader.Prepare(pTarget->GetID(), strSkinFile, true);
+	}
+}
+
+// Window an ActivateWindow() or ReplaceWindow() click action opens
+int CGUIWindowManager::GetTargetWindow(const CStdString& strAction)
+{
+	CStdString strFunction, strParam;
+	CUtil::SplitExecFunction(strAction, strFunction, strParam);
+	if (strFunction.CompareNoCase("activatewindow") != 0 && strFunction.CompareNoCase("replacewindow") != 0)
+		return WINDOW_INVALID;
+
+	// The path after the comma doesn't matter for the skin file
+	int iPos = strParam.Find(",");
+	if (iPos >= 0)
+		strParam = strParam.Left(iPos);
+
+	return g_buttonTranslator.TranslateWindowString(strParam.c_str());
+}
+
 void CGUIWindowManager::AddToWindowHistory(int newWindowID)
 {
 	// Check the window stack to see if this window is in our history,
@@ -489,6 +705,11 @@ void CGUIWindowManager::ClearWindowHistory()
 
 void CGUIWindowManager::DeInitialize()
 {
+	// Whatever the window loader read came from the skin going away
+	m_iPendingWindow = WINDOW_INVALID;
+	m_iPredictedWindow = WINDOW_INVALID;
+	g_windowLoader.Clear();
+
 	for (WindowMap::iterator it = m_mapWindows.begin(); it != m_mapWindows.end(); it++)
 	{
 		CGUIWindow* pWindow = (*it).second;
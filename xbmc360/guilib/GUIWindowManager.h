@@ -3,6 +3,7 @@
 
 #include "..\utils\Stdafx.h"
 #include "..\utils\CriticalSection.h"
+#include "..\utils\MessageRing.h"
 #include "IMsgTargetCallback.h"
 #include "GUIWindow.h"
 #include "GUIMessage.h"
@@ -11,6 +12,9 @@
 #include <stack>
 #include <vector>
 
+// Messages other threads may have waiting for the GUI thread
+#define THREADMESSAGES_SIZE 64
+
 class CGUIWindowManager
 {
 public:
@@ -27,6 +31,11 @@ public:
 	bool Initialized() const { return m_initialized; };
 	void SendThreadMessage(CGUIMessage& message);
 	void DispatchThreadMessages();
+
+	void GetThreadMessageStats(MessageRingStats& stats, unsigned int& iCoalesced) const;
+
+	// Logs and clears the thread message stats
+	void ResetThreadMessageStats();
 	bool SendMessage(CGUIMessage& message);
 	void Add(CGUIWindow* pWindow);
 	void LoadNotOnDemandWindows();
@@ -42,8 +51,14 @@ public:
 	void AddModeless(CGUIWindow* pDialog);
 	void RemoveDialog(DWORD dwID);
 	void ChangeActiveWindow(int iNewID);
+
+	// A window that isn't loaded is read by the window loader first, the
+	// current window stays active until it's ready, see GUIWindowLoader.h
 	void ActivateWindow(int iWindowID, bool swappingWindows = false);
 
+	// "GUI.WindowPreload", one of WINDOWPRELOAD_*
+	void SetPreload(int iPreload) { m_iPreload = iPreload; }
+
 	// OnAction() runs through our active dialogs and windows and sends the message
 	// off to the callbacks (application, python, playlist player) and to the
 	// currently focused window(s).  Returns true only if the message is handled.
@@ -64,20 +79,46 @@ public:
 
 private:
 	void Render_Internal();
+	void ActivateLoadedWindow(int iWindowID, bool swappingWindows);
+	void PrepareLikelyWindows(CGUIWindow* pWindow);
+	static int GetTargetWindow(const CStdString& strAction);
+
 	typedef std::map<int, CGUIWindow *> WindowMap;
 	WindowMap m_mapWindows;
 
 	std::stack<int> m_windowHistory;
 
 	std::vector <CGUIWindow*> m_activeDialogs;
-	std::vector < std::pair<CGUIMessage*,int> > m_vecThreadMessages;
 	typedef std::vector<CGUIWindow*>::iterator iDialog;
 
+	static bool CanCoalesce(const CGUIMessage& message);
+	static bool IsStateMessage(const CGUIMessage& message);
+	static bool IsSameMessage(const CGUIMessage& left, const CGUIMessage& right);
+	void AddToBatch(const CGUIMessage& message);
+
+	CMessageRing<CGUIMessage> m_threadMessages;
+	std::vector<CGUIMessage> m_dispatchBatch;  // reserved up front, reused by every dispatch
+	bool m_bDispatching;
+	unsigned int m_iCoalesced;                 // thread messages dropped as duplicates
+
+	// State changes that found the ring full, they must never be dropped
+	std::vector<CGUIMessage> m_overflow;
+	unsigned int m_iOverflowed;                // counted as dropped by the ring as well
 	CCriticalSection m_critSection;
 
 	bool m_initialized;
 
+	int m_iPreload;
+	int m_iPendingWindow;        // activated, waiting for the window loader
+	bool m_bPendingSwap;
+	int m_iPredictedWindow;      // window and control the likely next windows were prepared for
+	int m_iPredictedControl;
+
 	vector <IMsgTargetCallback*> m_vecMsgTargets;
+
+	// Windows and dialogs drawn in this and the last frame, when they differ everything is redrawn
+	std::vector<CGUIWindow*> m_renderedWindows;
+	std::vector<CGUIWindow*> m_lastRenderedWindows;
 };
 
 extern CGUIWindowManager g_windowManager;
@@ -0,0 +1,149 @@
+#include "GUIWindowRetention.h"
+#include "GUIWindow.h"
+#include "GraphicContext.h"
+#include "..\utils\SingleLock.h"
+#include "..\utils\Log.h"
+
+CGUIWindowRetention g_windowRetention;
+
+CGUIWindowRetention::CGUIWindowRetention(void)
+{
+	m_iBudget = WINDOWRETENTION_DEFAULT_BUDGET * 1024 * 1024;
+	m_bRetainTextures = false;
+	m_iMemoryUsage = 0;
+
+	m_iEvictions = 0;
+	m_iColdActivations = 0;
+	m_iWarmActivations = 0;
+	m_fColdTime = 0.0;
+	m_fWarmTime = 0.0;
+}
+
+CGUIWindowRetention::~CGUIWindowRetention(void)
+{
+}
+
+void CGUIWindowRetention::SetBudget(unsigned int iBytes)
+{
+	CSingleLock lock(g_graphicsContext);
+
+	m_iBudget = iBytes;
+	Evict(0);
+}
+
+void CGUIWindowRetention::SetRetainTextures(bool bRetain)
+{
+	CSingleLock lock(g_graphicsContext);
+
+	// Windows resident now were charged with or without textures, start over
+	m_bRetainTextures = bRetain;
+	Evict(m_iBudget + 1);
+}
+
+bool CGUIWindowRetention::Retain(CGUIWindow* pWindow)
+{
+	CSingleLock lock(g_graphicsContext);
+
+	Release(pWindow);
+
+	unsigned int iMemoryUsage = pWindow->GetMemoryUsage(m_bRetainTextures);
+	if (iMemoryUsage > m_iBudget)
+		return false;
+
+	Evict(iMemoryUsage);
+
+	ResidentWindow resident;
+	resident.pWindow = pWindow;
+	resident.iMemoryUsage = iMemoryUsage;
+	m_lru.push_front(resident);
+	m_iMemoryUsage += iMemoryUsage;
+
+	CLog::Log(LOGDEBUG, "CGUIWindowRetention: window %i stays loaded, %u KB, %u KB of %u KB used",
+		pWindow->GetID(), iMemoryUsage / 1024, m_iMemoryUsage / 1024, m_iBudget / 1024);
+	return true;
+}
+
+void CGUIWindowRetention::Release(CGUIWindow* pWindow)
+{
+	CSingleLock lock(g_graphicsContext);
+
+	for (std::list<ResidentWindow>::iterator it = m_lru.begin(); it != m_lru.end(); ++it)
+	{
+		if (it->pWindow == pWindow)
+		{
+			m_iMemoryUsage -= it->iMemoryUsage;
+			m_lru.erase(it);
+			return;
+		}
+	}
+}
+
+void CGUIWindowRetention::ReportActivation(CGUIWindow* pWindow, bool bWarm, float fTime)
+{
+	CSingleLock lock(g_graphicsContext);
+
+	if (bWarm)
+	{
+		m_iWarmActivations++;
+		m_fWarmTime += fTime;
+	}
+	else
+	{
+		m_iColdActivations++;
+		m_fColdTime += fTime;
+	}
+
+	CLog::Log(LOGDEBUG, "CGUIWindowRetention: window %i activated %s in %.1f ms", pWindow->GetID(), bWarm ? "warm" : "cold", fTime);
+}
+
+void CGUIWindowRetention::GetStats(WindowRetentionStats& stats) const
+{
+	CSingleLock lock(g_graphicsContext);
+
+	stats.iResident = m_lru.size();
+	stats.iMemoryUsage = m_iMemoryUsage;
+	stats.iBudget = m_iBudget;
+	stats.iEvictions = m_iEvictions;
+	stats.iColdActivations = m_iColdActivations;
+	stats.iWarmActivations = m_iWarmActivations;
+	stats.fColdTime = m_iColdActivations ? (float)(m_fColdTime / m_iColdActivations) : 0.0f;
+	stats.fWarmTime = m_iWarmActivations ? (float)(m_fWarmTime / m_iWarmActivations) : 0.0f;
+}
+
+void CGUIWindowRetention::Reset()
+{
+	CSingleLock lock(g_graphicsContext);
+
+	WindowRetentionStats stats;
+	GetStats(stats);
+	if (stats.iColdActivations || stats.iWarmActivations)
+	{
+		CLog::Log(LOGNOTICE, "CGUIWindowRetention: %u cold activation(s) in avg %.1f ms, %u warm in avg %.1f ms, %u window(s) unloaded to stay within %u KB",
+			stats.iColdActivations, stats.fColdTime, stats.iWarmActivations, stats.fWarmTime, stats.iEvictions, stats.iBudget / 1024);
+	}
+
+	// The windows themselves are unloaded by whoever deletes them
+	m_lru.clear();
+	m_iMemoryUsage = 0;
+
+	m_iEvictions = 0;
+	m_iColdActivations = 0;
+	m_iWarmActivations = 0;
+	m_fColdTime = 0.0;
+	m_fWarmTime = 0.0;
+}
+
+// Unloads the windows closed longest ago until iBytesNeeded more fit the budget
+void CGUIWindowRetention::Evict(unsigned int iBytesNeeded)
+{
+	while (!m_lru.empty() && m_iMemoryUsage + iBytesNeeded > m_iBudget)
+	{
+		ResidentWindow resident = m_lru.back();
+		m_lru.pop_back();
+		m_iMemoryUsage -= resident.iMemoryUsage;
+		m_iEvictions++;
+
+		CLog::Log(LOGDEBUG, "CGUIWindowRetention: unloading window %i, %u KB", resident.pWindow->GetID(), resident.iMemoryUsage / 1024);
+		resident.pWindow->FreeResources(true);
+	}
+}
@@ -0,0 +1,87 @@
+#ifndef GUILIB_GUIWINDOWRETENTION_H
+#define GUILIB_GUIWINDOWRETENTION_H
+
+#include "..\utils\Stdafx.h"
+
+#include <list>
+
+class CGUIWindow;
+
+// Memory closed windows may keep, in MB, "GUI.WindowRetentionBudget" in settings.xml
+#define WINDOWRETENTION_DEFAULT_BUDGET 8
+
+// Estimated size of a control with its strings and label layouts, in bytes
+#define WINDOWRETENTION_CONTROL_SIZE 1024
+
+struct WindowRetentionStats
+{
+	unsigned int iResident;       // closed windows that kept their controls
+	unsigned int iMemoryUsage;    // bytes those are estimated to use
+	unsigned int iBudget;
+	unsigned int iEvictions;      // windows unloaded to stay within the budget
+	unsigned int iColdActivations; // window had to be loaded first
+	unsigned int iWarmActivations; // window was still resident
+	float fColdTime;              // average ms from activation to the window being ready
+	float fWarmTime;
+};
+
+/*!
+ \brief Decides which closed windows keep their controls.
+
+ A window that is loaded on demand normally deletes its controls when it
+ is closed and loads its skin file again the next time. Instead it offers
+ itself here, and stays loaded while all closed windows fit the budget.
+ When they don't, the ones closed longest ago are unloaded first.
+
+ With "GUI.RetainWindowTextures" they keep their textures too, which is
+ charged against the budget as well.
+ */
+class CGUIWindowRetention
+{
+public:
+	CGUIWindowRetention(void);
+	virtual ~CGUIWindowRetention(void);
+
+	void SetBudget(unsigned int iBytes);
+	void SetRetainTextures(bool bRetain);
+	bool GetRetainTextures() const { return m_bRetainTextures; }
+
+	// Called as the window is closed, true when it may keep its controls
+	bool Retain(CGUIWindow* pWindow);
+
+	// The window was opened again or unloaded, it no longer counts against the budget
+	void Release(CGUIWindow* pWindow);
+
+	// fTime is the time from activation to the window being ready, in ms
+	void ReportActivation(CGUIWindow* pWindow, bool bWarm, float fTime);
+
+	void GetStats(WindowRetentionStats& stats) const;
+
+	// Logs and clears the stats
+	void Reset();
+
+private:
+	struct ResidentWindow
+	{
+		CGUIWindow* pWindow;
+		unsigned int iMemoryUsage;
+	};
+
+	void Evict(unsigned int iBytesNeeded);
+
+	unsigned int m_iBudget;
+	bool m_bRetainTextures;
+
+	std::list<ResidentWindow> m_lru;   // most recently closed first
+	unsigned int m_iMemoryUsage;
+
+	unsigned int m_iEvictions;
+	unsigned int m_iColdActivations;
+	unsigned int m_iWarmActivations;
+	double m_fColdTime;
+	double m_fWarmTime;
+};
+
+extern CGUIWindowRetention g_windowRetention;
+
+#endif //GUILIB_GUIWINDOWRETENTION_H
@@ -0,0 +1,383 @@
+#include "GlyphCache.h"
+
+#include <string.h>
+#include <math.h>
+
+CGlyphCache::CGlyphCache(int iWidth, int iHeight)
+{
+	m_iWidth = iWidth;
+	m_iHeight = iHeight;
+	m_pixels.assign(iWidth * iHeight, 0);
+
+	m_iGeneration = 0;
+
+	m_iDirtyTop = 0;
+	m_iDirtyBottom = iHeight;
+
+	m_iHits = 0;
+	m_iMisses = 0;
+	m_iResets = 0;
+	m_iLayouts = 0;
+}
+
+CGlyphCache::~CGlyphCache(void)
+{
+	Reset();
+}
+
+int CGlyphCache::LoadFace(const std::string& strPath)
+{
+	for (size_t i = 0; i < m_facePaths.size(); i++)
+	{
+		if (m_facePaths[i] == strPath)
+			return (int)i;
+	}
+
+	CTrueTypeFont* pFace = new CTrueTypeFont();
+	if (!pFace->Load(strPath))
+	{
+		delete pFace;
+		return -1;
+	}
+
+	m_faces.push_back(pFace);
+	m_facePaths.push_back(strPath);
+	return (int)m_faces.size() - 1;
+}
+
+void CGlyphCache::Clear()
+{
+	if (!m_glyphs.empty())
+		m_iResets++;
+
+	m_glyphs.clear();
+	m_shelves.clear();
+	memset(&m_pixels[0], 0, m_pixels.size());
+	m_iGeneration++;
+
+	m_iDirtyTop = 0;
+	m_iDirtyBottom = m_iHeight;
+}
+
+void CGlyphCache::Reset()
+{
+	Clear();
+
+	for (size_t i = 0; i < m_faces.size(); i++)
+		delete m_faces[i];
+	m_faces.clear();
+	m_facePaths.clear();
+}
+
+bool CGlyphCache::Layout(int iFace, float fSize, unsigned int dwStyle, int iAlign, float fMaxWidth, int iOverflow,
+                         const std::wstring& strText, TextLayout& layout)
+{
+	m_iLayouts++;
+
+	layout.quads.clear();
+	layout.lineWidths.clear();
+	layout.fWidth = layout.fHeight = 0.0f;
+	layout.bTruncated = false;
+	layout.iGeneration = m_iGeneration;
+
+	if (iFace < 0 || iFace >= (int)m_faces.size())
+		return true;
+
+	const CTrueTypeFont* pFace = m_faces[iFace];
+	float fScale = pFace->GetScale(fSize);
+	int iEmbolden = (dwStyle & GLYPH_STYLE_BOLD) ? CTrueTypeFont::GetEmbolden(fSize) : 0;
+	float fLineHeight = GetLineHeight(iFace, fSize);
+	float fBaseline = floorf(pFace->GetAscent() * fScale + 0.5f);
+
+	std::vector<std::wstring> lines;
+	layout.bTruncated = BreakLines(pFace, fScale, iEmbolden, fMaxWidth, iOverflow, strText, lines);
+
+	for (size_t iLine = 0; iLine < lines.size(); iLine++)
+	{
+		const std::wstring& strLine = lines[iLine];
+		float fLineWidth = GetLineWidth(pFace, fScale, iEmbolden, strLine, 0, strLine.size());
+		layout.lineWidths.push_back(fLineWidth);
+		if (fLineWidth > layout.fWidth)
+			layout.fWidth = fLineWidth;
+
+		float x = 0.0f;
+		if (iAlign != GLYPH_ALIGN_LEFT)
+			x -= iAlign == GLYPH_ALIGN_RIGHT ? fLineWidth : fLineWidth / 2;
+
+		unsigned int iPrevious = 0;
+		for (size_t i = 0; i < strLine.size(); i++)
+		{
+			if (strLine[i] == L'\r')
+				continue;
+
+			unsigned int iGlyph = pFace->GetGlyphIndex(strLine[i]);
+			if (iPrevious)
+				x += pFace->GetKerning(iPrevious, iGlyph) * fScale;
+
+			const GlyphInfo* pInfo = GetGlyph(iFace, fSize, dwStyle, iGlyph);
+			if (!pInfo)
+				return false;
+
+			// Glyphs start on whole pixels so they're drawn texel for pixel
+			if (pInfo->iWidth > 0)
+			{
+				GlyphQuad quad;
+				quad.fPosX = floorf(x + 0.5f) + pInfo->iOffsetX;
+				quad.fPosY = fBaseline + pInfo->iOffsetY;
+				quad.fWidth = (float)pInfo->iWidth;
+				quad.fHeight = (float)pInfo->iHeight;
+				quad.u1 = (float)pInfo->iX / m_iWidth;
+				quad.v1 = (float)pInfo->iY / m_iHeight;
+				quad.u2 = (float)(pInfo->iX + pInfo->iWidth) / m_iWidth;
+				quad.v2 = (float)(pInfo->iY + pInfo->iHeight) / m_iHeight;
+				layout.quads.push_back(quad);
+			}
+
+			x += pFace->GetAdvance(iGlyph) * fScale + iEmbolden;
+			iPrevious = iGlyph;
+		}
+
+		fBaseline += fLineHeight;
+	}
+
+	layout.fHeight = lines.size() * fLineHeight;
+
+	return true;
+}
+
+bool CGlyphCache::BreakLines(const CTrueTypeFont* pFace, float fScale, int iEmbolden, float fMaxWidth, int iOverflow,
+                             const std::wstring& strText, std::vector<std::wstring>& lines)
+{
+	bool bTruncated = false;
+
+	size_t iStart = 0;
+	while (iStart <= strText.size())
+	{
+		size_t iEnd = strText.find(L'\n', iStart);
+		if (iEnd == std::wstring::npos)
+			iEnd = strText.size();
+
+		if (fMaxWidth <= 0.0f || iOverflow == GLYPH_OVERFLOW_NONE ||
+		    GetLineWidth(pFace, fScale, iEmbolden, strText, iStart, iEnd) <= fMaxWidth)
+		{
+			lines.push_back(strText.substr(iStart, iEnd - iStart));
+		}
+		else if (iOverflow == GLYPH_OVERFLOW_TRUNCATE)
+		{
+			// As much as fits in front of the ellipsis
+			static const std::wstring strEllipsis = L"...";
+			float fEllipsis = GetLineWidth(pFace, fScale, iEmbolden, strEllipsis, 0, strEllipsis.size());
+
+			float fWidth = 0.0f;
+			unsigned int iPrevious = 0;
+			size_t iCut = iStart;
+			for (; iCut < iEnd; iCut++)
+			{
+				unsigned int iGlyph = pFace->GetGlyphIndex(strText[iCut]);
+				float fAdvance = pFace->GetAdvance(iGlyph) * fScale + iEmbolden;
+				if (iPrevious)
+					fAdvance += pFace->GetKerning(iPrevious, iGlyph) * fScale;
+				if (fWidth + fAdvance + fEllipsis > fMaxWidth)
+					break;
+
+				fWidth += fAdvance;
+				iPrevious = iGlyph;
+			}
+
+			lines.push_back(strText.substr(iStart, iCut - iStart) + strEllipsis);
+			bTruncated = true;
+		}
+		else
+		{
+			// Greedy, every line takes as many words as fit
+			size_t iLineStart = iStart;
+			while (iLineStart < iEnd)
+			{
+				size_t iBreak = std::wstring::npos;
+				float fWidth = 0.0f;
+				unsigned int iPrevious = 0;
+				size_t i = iLineStart;
+				for (; i < iEnd; i++)
+				{
+					if (strText[i] == L' ')
+						iBreak = i;
+
+					unsigned int iGlyph = pFace->GetGlyphIndex(strText[i]);
+					if (iPrevious)
+						fWidth += pFace->GetKerning(iPrevious, iGlyph) * fScale;
+					fWidth += pFace->GetAdvance(iGlyph) * fScale + iEmbolden;
+					iPrevious = iGlyph;
+
+					// A line gets at least one character, however narrow the width
+					if (i > iLineStart && fWidth > fMaxWidth)
+						break;
+				}
+
+				if (i == iEnd)
+				{
+					lines.push_back(strText.substr(iLineStart, iEnd - iLineStart));
+					break;
+				}
+
+				// The space a line is broken at isn't drawn on either line
+				size_t iLineEnd = (iBreak != std::wstring::npos && iBreak > iLineStart) ? iBreak : i;
+				lines.push_back(strText.substr(iLineStart, iLineEnd - iLineStart));
+
+				iLineStart = iLineEnd;
+				while (iLineStart < iEnd && strText[iLineStart] == L' ')
+					iLineStart++;
+			}
+		}
+
+		iStart = iEnd + 1;
+	}
+
+	return bTruncated;
+}
+
+float CGlyphCache::GetLineHeight(int iFace, float fSize)
+{
+	if (iFace < 0 || iFace >= (int)m_faces.size())
+		return 0.0f;
+
+	const CTrueTypeFont* pFace = m_faces[iFace];
+	return floorf((pFace->GetAscent() - pFace->GetDescent() + pFace->GetLineGap()) * pFace->GetScale(fSize) + 0.5f);
+}
+
+float CGlyphCache::GetLineWidth(const CTrueTypeFont* pFace, float fScale, int iEmbolden, const std::wstring& strText, size_t iStart, size_t iEnd)
+{
+	float fWidth = 0.0f;
+	unsigned int iPrevious = 0;
+
+	for (size_t i = iStart; i < iEnd; i++)
+	{
+		if (strText[i] == L'\r')
+			continue;
+
+		unsigned int iGlyph = pFace->GetGlyphIndex(strText[i]);
+		if (iPrevious)
+			fWidth += pFace->GetKerning(iPrevious, iGlyph) * fScale;
+		fWidth += pFace->GetAdvance(iGlyph) * fScale + iEmbolden;
+		iPrevious = iGlyph;
+	}
+
+	return fWidth;
+}
+
+const CGlyphCache::GlyphInfo* CGlyphCache::GetGlyph(int iFace, float fSize, unsigned int dwStyle, unsigned int iGlyph)
+{
+	unsigned long long iKey = ((unsigned long long)iFace << 48) | ((unsigned long long)(dwStyle & 0xFF) << 40) |
+		((unsigned long long)((unsigned int)(fSize * 4.0f + 0.5f) & 0xFFFF) << 16) | (iGlyph & 0xFFFF);
+
+	std::map<unsigned long long, GlyphInfo>::iterator it = m_glyphs.find(iKey);
+	if (it != m_glyphs.end())
+	{
+		m_iHits++;
+		return &it->second;
+	}
+
+	GlyphBitmap bitmap;
+	const CTrueTypeFont* pFace = m_faces[iFace];
+	if (!pFace->Rasterize(iGlyph, pFace->GetScale(fSize), dwStyle, bitmap))
+		bitmap.iWidth = bitmap.iHeight = 0;
+
+	GlyphInfo info;
+	info.iX = info.iY = 0;
+	info.iWidth = bitmap.iWidth;
+	info.iHeight = bitmap.iHeight;
+	info.iOffsetX = bitmap.iOffsetX;
+	info.iOffsetY = bitmap.iOffsetY;
+
+	if (info.iWidth > 0 && info.iHeight > 0)
+	{
+		if (!Insert(info.iWidth, info.iHeight, info.iX, info.iY))
+		{
+			// Never going to fit, draw nothing rather than emptying the page forever
+			if (!m_glyphs.empty())
+				return NULL;
+			info.iWidth = info.iHeight = 0;
+		}
+
+		for (int y = 0; y < info.iHeight; y++)
+			memcpy(&m_pixels[(info.iY + y) * m_iWidth + info.iX], &bitmap.pixels[y * bitmap.iWidth], info.iWidth);
+
+		if (info.iHeight > 0)
+		{
+			if (m_iDirtyTop >= m_iDirtyBottom)
+			{
+				m_iDirtyTop = info.iY;
+				m_iDirtyBottom = info.iY + info.iHeight;
+			}
+			else
+			{
+				if (info.iY < m_iDirtyTop)
+					m_iDirtyTop = info.iY;
+				if (info.iY + info.iHeight > m_iDirtyBottom)
+					m_iDirtyBottom = info.iY + info.iHeight;
+			}
+		}
+	}
+
+	m_iMisses++;
+	return &(m_glyphs[iKey] = info);
+}
+
+bool CGlyphCache::Insert(int iWidth, int iHeight, int& iX, int& iY)
+{
+	int iCellWidth = iWidth + GLYPHCACHE_PADDING;
+	int iCellHeight = iHeight + GLYPHCACHE_PADDING;
+
+	// The lowest shelf the glyph fits on without wasting too much of its height
+	Shelf* pBest = NULL;
+	for (size_t i = 0; i < m_shelves.size(); i++)
+	{
+		Shelf& shelf = m_shelves[i];
+		if (shelf.iHeight < iCellHeight || shelf.iHeight > iCellHeight + iCellHeight / 4 + 2 ||
+		    shelf.iUsed + iCellWidth > m_iWidth)
+			continue;
+
+		if (!pBest || shelf.iHeight < pBest->iHeight)
+			pBest = &shelf;
+	}
+
+	if (!pBest)
+	{
+		int iShelfY = m_shelves.empty() ? GLYPHCACHE_PADDING : m_shelves.back().iY + m_shelves.back().iHeight;
+		if (iShelfY + iCellHeight > m_iHeight || GLYPHCACHE_PADDING + iCellWidth > m_iWidth)
+			return false;
+
+		Shelf shelf;
+		shelf.iY = iShelfY;
+		shelf.iHeight = iCellHeight;
+		shelf.iUsed = GLYPHCACHE_PADDING;
+		m_shelves.push_back(shelf);
+		pBest = &m_shelves.back();
+	}
+
+	iX = pBest->iUsed;
+	iY = pBest->iY;
+	pBest->iUsed += iCellWidth;
+
+	return true;
+}
+
+bool CGlyphCache::GetDirtyRows(int& iTop, int& iBottom) const
+{
+	iTop = m_iDirtyTop;
+	iBottom = m_iDirtyBottom;
+	return iTop < iBottom;
+}
+
+void CGlyphCache::ClearDirty()
+{
+	m_iDirtyTop = m_iDirtyBottom = 0;
+}
+
+void CGlyphCache::GetStats(GlyphCacheStats& stats) const
+{
+	stats.iGlyphs = m_glyphs.size();
+	stats.iHits = m_iHits;
+	stats.iMisses = m_iMisses;
+	stats.iResets = m_iResets;
+	stats.iLayouts = m_iLayouts;
+}
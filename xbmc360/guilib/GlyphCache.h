@@ -0,0 +1,149 @@
+#ifndef GUILIB_GLYPHCACHE_H
+#define GUILIB_GLYPHCACHE_H
+
+// Kept free of Xbox headers, tools/FontPreview builds it on Linux
+
+#include "TrueTypeFont.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+// Transparent texels between glyphs, so filtering never reaches a neighbour
+#define GLYPHCACHE_PADDING 1
+
+// Horizontal placement of every line of a text relative to its x position
+#define GLYPH_ALIGN_LEFT    0
+#define GLYPH_ALIGN_RIGHT   1
+#define GLYPH_ALIGN_CENTER  2
+
+// What happens to lines wider than the width a text is laid out in
+#define GLYPH_OVERFLOW_NONE     0 // drawn past it
+#define GLYPH_OVERFLOW_TRUNCATE 1 // cut short and ended with "..."
+#define GLYPH_OVERFLOW_WRAP     2 // broken at spaces, or anywhere in words too long for a line
+
+// A glyph's part of the page, what to draw where for one character
+struct GlyphQuad
+{
+	float fPosX;
+	float fPosY;
+	float fWidth;
+	float fHeight;
+	float u1, v1;
+	float u2, v2;
+};
+
+// A text ready to be drawn, positions are relative to where it's drawn
+struct TextLayout
+{
+	std::vector<GlyphQuad> quads;
+	std::vector<float> lineWidths;
+	float fWidth;
+	float fHeight;
+	bool bTruncated;
+	unsigned int iGeneration;  // of the page the quads point into
+};
+
+struct GlyphCacheStats
+{
+	unsigned int iGlyphs;
+	unsigned int iHits;
+	unsigned int iMisses;      // glyphs rendered
+	unsigned int iResets;      // times the page ran full and was emptied
+	unsigned int iLayouts;
+};
+
+/*!
+ \brief Renders the glyphs of every font and size into one 8 bit coverage
+ page and lays out text as quads into it.
+
+ A glyph is rendered the first time it's drawn in a size and style, and then
+ stays in the page until the page runs full. All fonts share the page so
+ the text of a whole frame can be drawn with a single texture. Pixels that
+ changed since the last ClearDirty() have to be copied to that texture
+ before the quads are drawn.
+ */
+class CGlyphCache
+{
+public:
+	CGlyphCache(int iWidth, int iHeight);
+	virtual ~CGlyphCache(void);
+
+	// Returns the face id, faces are shared by path. -1 when the file isn't a usable font.
+	int LoadFace(const std::string& strPath);
+
+	// Drops every glyph, the page has to be uploaded again
+	void Clear();
+
+	// Drops glyphs and faces
+	void Reset();
+
+	/*!
+	 \brief Lays out a text relative to the top left of its first line, or its top
+	 right/center depending on iAlign. Lines are split at '\n'.
+	 \param fMaxWidth width iOverflow applies to, 0 for none
+	 \return false when the page ran full. Quads from this page that weren't drawn yet
+	         have to be drawn before calling Clear() and laying the text out again.
+	 */
+	bool Layout(int iFace, float fSize, unsigned int dwStyle, int iAlign, float fMaxWidth, int iOverflow,
+	            const std::wstring& strText, TextLayout& layout);
+
+	float GetLineHeight(int iFace, float fSize);
+
+	// Goes up every time the page is emptied, layouts of an older generation are no longer valid
+	unsigned int GetGeneration() const { return m_iGeneration; }
+
+	const unsigned char* GetPixels() const { return &m_pixels[0]; }
+	int GetWidth() const { return m_iWidth; }
+	int GetHeight() const { return m_iHeight; }
+
+	// Rows [iTop, iBottom) changed since the last ClearDirty()
+	bool GetDirtyRows(int& iTop, int& iBottom) const;
+	void ClearDirty();
+
+	void GetStats(GlyphCacheStats& stats) const;
+
+private:
+	struct GlyphInfo
+	{
+		int iX, iY;             // in the page
+		int iWidth, iHeight;
+		int iOffsetX, iOffsetY; // from the pen on the baseline
+	};
+
+	struct Shelf
+	{
+		int iY;
+		int iHeight;
+		int iUsed;
+	};
+
+	const GlyphInfo* GetGlyph(int iFace, float fSize, unsigned int dwStyle, unsigned int iGlyph);
+	bool Insert(int iWidth, int iHeight, int& iX, int& iY);
+	float GetLineWidth(const CTrueTypeFont* pFace, float fScale, int iEmbolden, const std::wstring& strText, size_t iStart, size_t iEnd);
+	bool BreakLines(const CTrueTypeFont* pFace, float fScale, int iEmbolden, float fMaxWidth, int iOverflow,
+	                const std::wstring& strText, std::vector<std::wstring>& lines);
+
+	int m_iWidth;
+	int m_iHeight;
+	std::vector<unsigned char> m_pixels;
+
+	std::vector<CTrueTypeFont*> m_faces;
+	std::vector<std::string> m_facePaths;
+
+	// face, style, size in quarter pixels and glyph index
+	std::map<unsigned long long, GlyphInfo> m_glyphs;
+	std::vector<Shelf> m_shelves;
+
+	unsigned int m_iGeneration;
+
+	int m_iDirtyTop;
+	int m_iDirtyBottom;
+
+	unsigned int m_iHits;
+	unsigned int m_iMisses;
+	unsigned int m_iResets;
+	unsigned int m_iLayouts;
+};
+
+#endif //GUILIB_GLYPHCACHE_H
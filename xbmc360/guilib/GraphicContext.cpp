@@ -19,6 +19,7 @@
  */
 
 #include "GraphicContext.h"
+#include "SpriteBatch.h"
 
 CGraphicContext g_graphicsContext;
 
@@ -79,6 +80,7 @@ void CGraphicContext::SetViewWindow(const RECT& rc)
 		d3dRC.x2 = m_videoRect.right;
 		d3dRC.y1 = m_videoRect.top;
 		d3dRC.y2 = m_videoRect.bottom;
+		g_spriteBatch.Flush();
 		Get3DDevice()->Clear( 1, &d3dRC, D3DCLEAR_TARGET, 0x00010001, 1.0f, 0L );
     }
 	Unlock();
@@ -129,6 +131,9 @@ void CGraphicContext::Clear(DWORD color)
 	Lock();
 
 	if (!m_pd3dDevice) return;
+
+	// Queued quads belong before the clear
+	g_spriteBatch.Flush();
 	//Not trying to clear the zbuffer when there is none is 7 fps faster (pal resolution)
 	if ((!m_pd3dParams) || (m_pd3dParams->EnableAutoDepthStencil == TRUE))
 		m_pd3dDevice->Clear( 0L, NULL, D3DCLEAR_TARGET | D3DCLEAR_ZBUFFER, color, 1.0f, 0L );
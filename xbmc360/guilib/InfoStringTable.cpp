@@ -0,0 +1,133 @@
+#include "InfoStringTable.h"
+
+#include "../utils/Fnv.h"
+
+#include <ctype.h>
+
+static std::string ToLower(const std::string& str)
+{
+	std::string strLower(str);
+	for (unsigned int i = 0; i < strLower.size(); i++)
+		strLower[i] = (char)tolower((unsigned char)strLower[i]);
+	return strLower;
+}
+
+// class CInfoStringTable
+CInfoStringTable::CInfoStringTable(void)
+{
+	m_iLookups = 0;
+	m_iHits = 0;
+}
+
+CInfoStringTable::~CInfoStringTable(void)
+{
+}
+
+bool CInfoStringTable::Find(const std::string& strInfo, int& id)
+{
+	std::string strLower(ToLower(strInfo));
+
+	m_iLookups++;
+	std::pair<MAPENTRIES::iterator, MAPENTRIES::iterator> range = m_entries.equal_range(Hash(strLower));
+	for (MAPENTRIES::iterator it = range.first; it != range.second; ++it)
+	{
+		if (it->second.strInfo == strLower)
+		{
+			m_iHits++;
+			id = it->second.id;
+			return true;
+		}
+	}
+	return false;
+}
+
+void CInfoStringTable::Add(const std::string& strInfo, int id)
+{
+	Entry entry;
+	entry.strInfo = ToLower(strInfo);
+	entry.id = id;
+
+	m_entries.insert(MAPENTRIES::value_type(Hash(entry.strInfo), entry));
+}
+
+void CInfoStringTable::Clear()
+{
+	m_entries.clear();
+}
+
+void CInfoStringTable::GetStats(InfoTableStats& stats) const
+{
+	stats.iLookups = m_iLookups;
+	stats.iHits = m_iHits;
+	stats.iEntries = (unsigned int)m_entries.size();
+}
+
+void CInfoStringTable::ResetStats()
+{
+	m_iLookups = 0;
+	m_iHits = 0;
+}
+
+unsigned int CInfoStringTable::Hash(const std::string& strInfo)
+{
+	// Info strings are compared lowercase
+	return CFnv::HashLower(strInfo.c_str(), (unsigned int)strInfo.size());
+}
+
+// class CInfoTupleIndex
+CInfoTupleIndex::CInfoTupleIndex(void)
+{
+	m_iLookups = 0;
+	m_iHits = 0;
+}
+
+CInfoTupleIndex::~CInfoTupleIndex(void)
+{
+}
+
+bool CInfoTupleIndex::Find(int info, unsigned int data1, int data2, int& offset)
+{
+	m_iLookups++;
+	std::pair<MAPENTRIES::iterator, MAPENTRIES::iterator> range = m_entries.equal_range(Hash(info, data1, data2));
+	for (MAPENTRIES::iterator it = range.first; it != range.second; ++it)
+	{
+		const Entry& entry = it->second;
+		if (entry.info == info && entry.data1 == data1 && entry.data2 == data2)
+		{
+			m_iHits++;
+			offset = entry.offset;
+			return true;
+		}
+	}
+	return false;
+}
+
+void CInfoTupleIndex::Add(int info, unsigned int data1, int data2, int offset)
+{
+	Entry entry;
+	entry.info = info;
+	entry.data1 = data1;
+	entry.data2 = data2;
+	entry.offset = offset;
+
+	m_entries.insert(MAPENTRIES::value_type(Hash(info, data1, data2), entry));
+}
+
+void CInfoTupleIndex::Clear()
+{
+	m_entries.clear();
+}
+
+void CInfoTupleIndex::GetStats(InfoTableStats& stats) const
+{
+	stats.iLookups = m_iLookups;
+	stats.iHits = m_iHits;
+	stats.iEntries = (unsigned int)m_entries.size();
+}
+
+unsigned int CInfoTupleIndex::Hash(int info, unsigned int data1, int data2)
+{
+	unsigned int iHash = CFnv::HashValue((unsigned int)info);
+	iHash = CFnv::HashValue(data1, iHash);
+	return CFnv::HashValue((unsigned int)data2, iHash);
+}
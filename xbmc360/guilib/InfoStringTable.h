@@ -0,0 +1,89 @@
+#ifndef GUILIB_INFOSTRINGTABLE_H
+#define GUILIB_INFOSTRINGTABLE_H
+
+// Kept free of Xbox headers, tools/InfoBench builds it on Linux
+
+#include <map>
+#include <string>
+
+struct InfoTableStats
+{
+	unsigned int iLookups;
+	unsigned int iHits;        // found, added before
+	unsigned int iEntries;
+};
+
+/*!
+ \brief Ids given to the info strings a skin uses, so a condition or label
+ that was translated before isn't parsed again.
+
+ Strings are compared lowercase and kept in a multimap keyed by their
+ FNV-1a hash, a lookup compares only the few strings sharing its hash.
+ */
+class CInfoStringTable
+{
+public:
+	CInfoStringTable(void);
+	virtual ~CInfoStringTable(void);
+
+	// False when the string wasn't added yet
+	bool Find(const std::string& strInfo, int& id);
+	void Add(const std::string& strInfo, int id);
+
+	void Clear();
+
+	void GetStats(InfoTableStats& stats) const;
+	void ResetStats();
+
+	static unsigned int Hash(const std::string& strInfo);
+
+private:
+	struct Entry
+	{
+		std::string strInfo;   // lowercase
+		int id;
+	};
+
+	typedef std::multimap<unsigned int, Entry> MAPENTRIES;
+	MAPENTRIES m_entries;
+
+	unsigned int m_iLookups;
+	unsigned int m_iHits;
+};
+
+/*!
+ \brief Offsets of info/data tuples, the multi infos of CGUIInfoManager,
+ hashed the same way.
+ */
+class CInfoTupleIndex
+{
+public:
+	CInfoTupleIndex(void);
+	virtual ~CInfoTupleIndex(void);
+
+	bool Find(int info, unsigned int data1, int data2, int& offset);
+	void Add(int info, unsigned int data1, int data2, int offset);
+
+	void Clear();
+
+	void GetStats(InfoTableStats& stats) const;
+
+	static unsigned int Hash(int info, unsigned int data1, int data2);
+
+private:
+	struct Entry
+	{
+		int info;
+		unsigned int data1;
+		int data2;
+		int offset;
+	};
+
+	typedef std::multimap<unsigned int, Entry> MAPENTRIES;
+	MAPENTRIES m_entries;
+
+	unsigned int m_iLookups;
+	unsigned int m_iHits;
+};
+
+#endif //GUILIB_INFOSTRINGTABLE_H
@@ -35,6 +35,8 @@
 #define ACTION_MOVE_RIGHT              2
 #define ACTION_MOVE_UP                 3
 #define ACTION_MOVE_DOWN               4
+#define ACTION_PAGE_UP                 5
+#define ACTION_PAGE_DOWN               6
 
 #define ACTION_SELECT_ITEM             7
 #define ACTION_PREVIOUS_MENU          10
@@ -0,0 +1,145 @@
+#include "ListLayout.h"
+
+CListLayout::CListLayout(void)
+{
+	SetLayout(1, 1, 0);
+}
+
+CListLayout::~CListLayout(void)
+{
+}
+
+void CListLayout::SetLayout(int iColumns, int iRows, int iPrefetchRows)
+{
+	m_iColumns = iColumns < 1 ? 1 : iColumns;
+	m_iRows = iRows < 1 ? 1 : iRows;
+	m_iPrefetchRows = iPrefetchRows < 0 ? 0 : iPrefetchRows;
+
+	// The views are all there will ever be, however many items are added
+	m_viewItems.assign((m_iRows + 2 * m_iPrefetchRows) * m_iColumns, -1);
+	Reset();
+}
+
+void CListLayout::Reset()
+{
+	m_viewItems.assign(m_viewItems.size(), -1);
+	m_iItems = 0;
+	m_iOffset = 0;
+	m_iSelected = 0;
+	m_iShownFirst = 0;
+	m_iShownLast = -1;
+}
+
+bool CListLayout::MoveUp()
+{
+	if (m_iSelected < m_iColumns)
+		return false;
+
+	MoveSelection(-m_iColumns);
+	return true;
+}
+
+bool CListLayout::MoveDown()
+{
+	// A short last row is still a row, go to its last item when there's none below
+	if ((m_iSelected / m_iColumns + 1) * m_iColumns >= m_iItems)
+		return false;
+
+	MoveSelection(m_iColumns);
+	return true;
+}
+
+bool CListLayout::MoveLeft()
+{
+	if (m_iColumns == 1 || m_iSelected % m_iColumns == 0)
+		return false;
+
+	MoveSelection(-1);
+	return true;
+}
+
+bool CListLayout::MoveRight()
+{
+	if (m_iColumns == 1 || m_iSelected % m_iColumns == m_iColumns - 1 || m_iSelected + 1 >= m_iItems)
+		return false;
+
+	MoveSelection(1);
+	return true;
+}
+
+bool CListLayout::MoveSelection(int iOffset)
+{
+	int iSelected = m_iSelected + iOffset;
+	if (iSelected >= m_iItems)
+		iSelected = m_iItems - 1;
+	if (iSelected < 0)
+		iSelected = 0;
+
+	if (iSelected == m_iSelected)
+		return false;
+	m_iSelected = iSelected;
+
+	// Scroll just far enough to keep the selected row on screen
+	int iRow = m_iSelected / m_iColumns;
+	if (iRow < m_iOffset)
+		m_iOffset = iRow;
+	else if (iRow >= m_iOffset + m_iRows)
+		m_iOffset = iRow - m_iRows + 1;
+
+	return true;
+}
+
+bool CListLayout::IsItemOnScreen(int iItem) const
+{
+	int iRow = iItem / m_iColumns;
+	return iRow >= m_iOffset && iRow < m_iOffset + m_iRows;
+}
+
+bool CListLayout::UpdateViews(std::vector<unsigned int>& unbound, std::vector<unsigned int>& bound)
+{
+	unbound.clear();
+	bound.clear();
+
+	int iFirst = (m_iOffset - m_iPrefetchRows) * m_iColumns;
+	if (iFirst < 0)
+		iFirst = 0;
+	int iLast = (m_iOffset + m_iRows + m_iPrefetchRows) * m_iColumns - 1;
+	if (iLast >= m_iItems)
+		iLast = m_iItems - 1;
+
+	for (unsigned int i = 0; i < m_viewItems.size(); i++)
+	{
+		if (m_viewItems[i] >= 0 && (m_viewItems[i] < iFirst || m_viewItems[i] > iLast))
+		{
+			m_viewItems[i] = -1;
+			unbound.push_back(i);
+		}
+	}
+
+	// The items in range use different views, there are as many views as the range can hold
+	for (int i = iFirst; i <= iLast; i++)
+	{
+		unsigned int iView = GetView(i);
+		if (m_viewItems[iView] != i)
+		{
+			m_viewItems[iView] = i;
+			bound.push_back(iView);
+		}
+	}
+
+	// Views bound again right away aren't unbound
+	unsigned int iKept = 0;
+	for (unsigned int i = 0; i < unbound.size(); i++)
+	{
+		if (m_viewItems[unbound[i]] < 0)
+			unbound[iKept++] = unbound[i];
+	}
+	unbound.resize(iKept);
+
+	if (iFirst == m_iShownFirst && iLast == m_iShownLast)
+		return false;
+
+	m_iShownFirst = iFirst;
+	m_iShownLast = iLast;
+	return true;
+}
@@ -0,0 +1,75 @@
+#ifndef GUILIB_LISTLAYOUT_H
+#define GUILIB_LISTLAYOUT_H
+
+// Kept free of Xbox headers, tools/ListBench builds it on Linux
+
+#include <vector>
+
+/*!
+ \brief Selection, scrolling and view recycling of a list or panel, the
+ part of CGUIListContainer that doesn't draw.
+
+ There are (rows + 2 * prefetch rows) * columns views and item i is shown
+ by view i % views. UpdateViews() tells which views have to be bound to
+ another item, that depends on the rows scrolled and never on the number
+ of items.
+ */
+class CListLayout
+{
+public:
+	CListLayout(void);
+	virtual ~CListLayout(void);
+
+	// Forgets the items and the views they had
+	void SetLayout(int iColumns, int iRows, int iPrefetchRows);
+
+	// Items are only ever appended, Reset() drops them
+	void SetItemCount(int iItems) { m_iItems = iItems; };
+	int GetItemCount() const { return m_iItems; };
+	void Reset();
+
+	int GetColumns() const { return m_iColumns; };
+	int GetRows() const { return m_iRows; };
+	int GetOffset() const { return m_iOffset; };
+	int GetSelected() const { return m_iSelected; };
+
+	// False when there's no item that way, the control passes the focus on then
+	bool MoveUp();
+	bool MoveDown();
+	bool MoveLeft();
+	bool MoveRight();
+
+	// Clamped to the items, false when the selection stayed
+	bool MoveSelection(int iOffset);
+
+	bool IsItemOnScreen(int iItem) const;
+
+	unsigned int GetViewCount() const { return m_viewItems.size(); };
+	unsigned int GetView(int iItem) const { return iItem % m_viewItems.size(); };
+	int GetViewItem(unsigned int iView) const { return m_viewItems[iView]; };
+
+	/*!
+	 \brief Binds the views to the rows on screen and the prefetched ones.
+	 \param unbound views that lost their item and didn't get another
+	 \param bound views that now show another item
+	 \return true when the range of items with views changed
+	 */
+	bool UpdateViews(std::vector<unsigned int>& unbound, std::vector<unsigned int>& bound);
+
+	// Items that have views, iFirst > iLast when there are none
+	void GetShownItems(int& iFirst, int& iLast) const { iFirst = m_iShownFirst; iLast = m_iShownLast; };
+
+private:
+	std::vector<int> m_viewItems;  // item shown by each view, -1 for none
+
+	int m_iColumns;
+	int m_iRows;                   // rows on screen
+	int m_iPrefetchRows;
+	int m_iItems;
+	int m_iOffset;                 // first row on screen
+	int m_iSelected;
+	int m_iShownFirst;
+	int m_iShownLast;
+};
+
+#endif //GUILIB_LISTLAYOUT_H
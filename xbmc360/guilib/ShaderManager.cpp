@@ -0,0 +1,412 @@
+#include "ShaderManager.h"
+#include "GraphicContext.h"
+#include "..\utils\Log.h"
+#include "..\utils\SingleLock.h"
+#include "..\utils\Fnv.h"
+
+#include <stdio.h>
+
+CGUIShaderManager g_shaderManager;
+
+namespace BuiltinShaders
+{
+//-------------------------------------------------------------------------------------
+// Vertex shader
+// We use the register semantic here to directly define the input register
+// matWVP.  Conversely, we could let the HLSL compiler decide and check the
+// constant table.
+//-------------------------------------------------------------------------------------
+const char* g_strTextureVertexShader =
+	" float4x4 matWVP : register(c0);              "
+	"                                              "
+	" struct VS_IN                                 "
+	" {                                            "
+	"     float4 ObjPos   : POSITION;              "  // Object space position
+	"     float2 TexCoord : TEXCOORD;              "
+	" };                                           "
+	"                                              "
+	" struct VS_OUT                                "
+	" {                                            "
+	"     float4 ProjPos  : POSITION;              "  // Projected space position
+	"     float2 TexCoord : TEXCOORD;              "
+	" };                                           "
+	"                                              "
+	" VS_OUT main( VS_IN In )                      "
+	" {                                            "
+	"     VS_OUT Out;                              "
+	"     Out.ProjPos = mul( matWVP, In.ObjPos );  "  // Transform vertex into
+	"     Out.TexCoord = In.TexCoord;              "
+	"     return Out;                              "
+	" }                                            ";
+
+//-------------------------------------------------------------------------------------
+// Pixel shader
+//-------------------------------------------------------------------------------------
+const char* g_strTexturePixelShader =
+	" struct PS_IN                                 "
+	" {                                            "
+	"     float2 TexCoord : TEXCOORD;              "
+	" };                                           "  // the vertex shader
+	"                                              "
+	" sampler detail;                              "
+	"                                              "
+	" float4 main( PS_IN In ) : COLOR              "
+	" {                                            "
+	"     return tex2D( detail, In.TexCoord );     "  // Output color
+	" }                                            ";
+
+//-------------------------------------------------------------------------------------
+// Sprite shaders, the texture is modulated by a per vertex color
+//-------------------------------------------------------------------------------------
+const char* g_strSpriteVertexShader =
+	" float4x4 matWVP : register(c0);              "
+	"                                              "
+	" struct VS_IN                                 "
+	" {                                            "
+	"     float4 ObjPos   : POSITION;              "
+	"     float4 Color    : COLOR;                 "
+	"     float2 TexCoord : TEXCOORD;              "
+	" };                                           "
+	"                                              "
+	" struct VS_OUT                                "
+	" {                                            "
+	"     float4 ProjPos  : POSITION;              "
+	"     float4 Color    : COLOR;                 "
+	"     float2 TexCoord : TEXCOORD;              "
+	" };                                           "
+	"                                              "
+	" VS_OUT main( VS_IN In )                      "
+	" {                                            "
+	"     VS_OUT Out;                              "
+	"     Out.ProjPos = mul( matWVP, In.ObjPos );  "
+	"     Out.Color = In.Color;                    "
+	"     Out.TexCoord = In.TexCoord;              "
+	"     return Out;                              "
+	" }                                            ";
+
+const char* g_strSpritePixelShader =
+	" struct PS_IN                                 "
+	" {                                            "
+	"     float4 Color    : COLOR;                 "
+	"     float2 TexCoord : TEXCOORD;              "
+	" };                                           "
+	"                                              "
+	" sampler detail;                              "
+	"                                              "
+	" float4 main( PS_IN In ) : COLOR              "
+	" {                                            "
+	"     return tex2D( detail, In.TexCoord ) * In.Color; "
+	" }                                            ";
+
+struct ShaderSource
+{
+	const char* strKey;
+	bool bVertex;
+	const char* strProfile;
+	const char* strSource;
+};
+
+const ShaderSource g_sources[] =
+{
+	{ SHADER_TEXTURE_VS, true,  "vs_2_0", g_strTextureVertexShader },
+	{ SHADER_TEXTURE_PS, false, "ps_2_0", g_strTexturePixelShader },
+	{ SHADER_SPRITE_VS,  true,  "vs_2_0", g_strSpriteVertexShader },
+	{ SHADER_SPRITE_PS,  false, "ps_2_0", g_strSpritePixelShader },
+};
+
+const ShaderSource* Find(const CStdString& strKey)
+{
+	for (unsigned int i = 0; i < sizeof(g_sources) / sizeof(g_sources[0]); i++)
+	{
+		if (strKey == g_sources[i].strKey)
+			return &g_sources[i];
+	}
+	return NULL;
+}
+}
+
+CGUIShaderManager::CGUIShaderManager(void)
+{
+	m_bBlobLoaded = false;
+	m_bBlobChanged = false;
+	m_iCompiled = 0;
+	m_iLoaded = 0;
+	m_iShared = 0;
+	m_dwCompileTime = 0;
+	m_dwTimeSaved = 0;
+}
+
+CGUIShaderManager::~CGUIShaderManager(void)
+{
+}
+
+IDirect3DVertexShader9* CGUIShaderManager::GetVertexShader(const CStdString& strKey)
+{
+	return (IDirect3DVertexShader9*)GetShader(strKey, true);
+}
+
+IDirect3DPixelShader9* CGUIShaderManager::GetPixelShader(const CStdString& strKey)
+{
+	return (IDirect3DPixelShader9*)GetShader(strKey, false);
+}
+
+IUnknown* CGUIShaderManager::GetShader(const CStdString& strKey, bool bVertex)
+{
+	CSingleLock lock(m_critSection);
+
+	LPDIRECT3DDEVICE9 pDevice = g_graphicsContext.Get3DDevice();
+	if (!pDevice)
+		return NULL;
+
+	std::map<CStdString, ShaderEntry>::iterator it = m_shaders.find(strKey);
+	if (it != m_shaders.end())
+	{
+		m_iShared++;
+		m_dwTimeSaved += it->second.dwCompileTime;
+
+		it->second.pShader->AddRef();
+		return it->second.pShader;
+	}
+
+	DWORD dwStart = GetTickCount();
+
+	BlobEntry* pCode = NULL;
+	bool bCompiled = false;
+	if (!GetCode(strKey, bVertex, pCode, bCompiled))
+		return NULL;
+
+	IUnknown* pShader = NULL;
+	HRESULT hr;
+	if (bVertex)
+		hr = pDevice->CreateVertexShader((DWORD*)&pCode->code[0], (IDirect3DVertexShader9**)&pShader);
+	else
+		hr = pDevice->CreatePixelShader((DWORD*)&pCode->code[0], (IDirect3DPixelShader9**)&pShader);
+
+	if (FAILED(hr) || !pShader)
+	{
+		CLog::Log(LOGERROR, "CGUIShaderManager: unable to create shader %s (0x%08x)", strKey.c_str(), hr);
+
+		// Don't trust the microcode again, it's rebuilt from source next time
+		if (!bCompiled)
+		{
+			m_blob.erase(strKey);
+			m_bBlobChanged = true;
+		}
+		return NULL;
+	}
+
+	if (!bCompiled)
+	{
+		DWORD dwTime = GetTickCount() - dwStart;
+		if (pCode->dwCompileTime > dwTime)
+			m_dwTimeSaved += pCode->dwCompileTime - dwTime;
+		m_iLoaded++;
+	}
+
+	ShaderEntry& entry = m_shaders[strKey];
+	entry.pShader = pShader;
+	entry.dwCompileTime = pCode->dwCompileTime;
+
+	// One reference stays with us, so the next user gets the same shader
+	pShader->AddRef();
+	return pShader;
+}
+
+bool CGUIShaderManager::GetCode(const CStdString& strKey, bool bVertex, BlobEntry*& pCode, bool& bCompiled)
+{
+	const BuiltinShaders::ShaderSource* pSource = BuiltinShaders::Find(strKey);
+	if (!pSource || pSource->bVertex != bVertex)
+	{
+		CLog::Log(LOGERROR, "CGUIShaderManager: unknown %s shader %s", bVertex ? "vertex" : "pixel", strKey.c_str());
+		return false;
+	}
+
+	if (!m_bBlobLoaded)
+		LoadBlob();
+
+	DWORD dwHash = Hash(pSource->strSource, pSource->strProfile);
+
+	std::map<CStdString, BlobEntry>::iterator it = m_blob.find(strKey);
+	if (it != m_blob.end() && it->second.dwSourceHash == dwHash && !it->second.code.empty())
+	{
+		pCode = &it->second;
+		bCompiled = false;
+		return true;
+	}
+
+	DWORD dwStart = GetTickCount();
+
+	ID3DXBuffer* pShaderCode = NULL;
+	ID3DXBuffer* pErrorMsg = NULL;
+
+	HRESULT hr = D3DXCompileShader(pSource->strSource,
+	                               (UINT)strlen(pSource->strSource),
+	                               NULL,
+	                               NULL,
+	                               "main",
+	                               pSource->strProfile,
+	                               0,
+	                               &pShaderCode,
+	                               &pErrorMsg,
+	                               NULL);
+
+	if (FAILED(hr) || !pShaderCode)
+	{
+		CLog::Log(LOGERROR, "CGUIShaderManager: unable to compile %s: %s", strKey.c_str(),
+			pErrorMsg ? (const char*)pErrorMsg->GetBufferPointer() : "unknown error");
+
+		if (pShaderCode)
+			pShaderCode->Release();
+		if (pErrorMsg)
+			pErrorMsg->Release();
+		return false;
+	}
+
+	BlobEntry& entry = m_blob[strKey];
+	entry.dwSourceHash = dwHash;
+	entry.dwCompileTime = GetTickCount() - dwStart;
+
+	BYTE* pData = (BYTE*)pShaderCode->GetBufferPointer();
+	entry.code.assign(pData, pData + pShaderCode->GetBufferSize());
+
+	pShaderCode->Release();
+	if (pErrorMsg)
+		pErrorMsg->Release();
+
+	m_iCompiled++;
+	m_dwCompileTime += entry.dwCompileTime;
+	m_bBlobChanged = true;
+
+	CLog::Log(LOGDEBUG, "CGUIShaderManager: compiled %s in %u ms", strKey.c_str(), entry.dwCompileTime);
+
+	pCode = &entry;
+	bCompiled = true;
+	return true;
+}
+
+DWORD CGUIShaderManager::GetTimeSaved()
+{
+	CSingleLock lock(m_critSection);
+	return m_dwTimeSaved;
+}
+
+void CGUIShaderManager::LogStats(const char* strWhen)
+{
+	CSingleLock lock(m_critSection);
+
+	CLog::Log(LOGNOTICE, "CGUIShaderManager (%s): %u program(s) compiled in %u ms, %u loaded precompiled, %u request(s) shared, %u ms of compiling saved",
+		strWhen, m_iCompiled, m_dwCompileTime, m_iLoaded, m_iShared, m_dwTimeSaved);
+}
+
+void CGUIShaderManager::Cleanup()
+{
+	CSingleLock lock(m_critSection);
+
+	for (std::map<CStdString, ShaderEntry>::iterator it = m_shaders.begin(); it != m_shaders.end(); it++)
+		it->second.pShader->Release();
+	m_shaders.clear();
+
+	if (m_bBlobChanged)
+		SaveBlob();
+
+	LogStats("shutdown");
+}
+
+bool CGUIShaderManager::LoadBlob()
+{
+	m_bBlobLoaded = true;
+	m_blob.clear();
+
+	FILE* fd = fopen(SHADER_BLOB_FILE, "rb");
+	if (!fd)
+	{
+		CLog::Log(LOGDEBUG, "CGUIShaderManager: no precompiled shaders, compiling from source");
+		return false;
+	}
+
+	ShaderBlobHeader header;
+	if (fread(&header, sizeof(header), 1, fd) != 1 ||
+	    header.dwMagic != SHADER_BLOB_MAGIC || header.dwVersion != SHADER_BLOB_VERSION)
+	{
+		CLog::Log(LOGWARNING, "CGUIShaderManager: %s is not a valid shader blob", SHADER_BLOB_FILE);
+		fclose(fd);
+		return false;
+	}
+
+	for (DWORD i = 0; i < header.dwCount; i++)
+	{
+		ShaderBlobEntry blobEntry;
+		if (fread(&blobEntry, sizeof(blobEntry), 1, fd) != 1 || blobEntry.dwSize == 0 || blobEntry.dwSize > 64 * 1024)
+			break;
+
+		BlobEntry entry;
+		entry.dwSourceHash = blobEntry.dwSourceHash;
+		entry.dwCompileTime = blobEntry.dwCompileTime;
+		entry.code.resize(blobEntry.dwSize);
+
+		if (fread(&entry.code[0], blobEntry.dwSize, 1, fd) != 1)
+			break;
+
+		blobEntry.szKey[SHADER_BLOB_KEYSIZE - 1] = 0;
+		m_blob[blobEntry.szKey] = entry;
+	}
+	fclose(fd);
+
+	CLog::Log(LOGDEBUG, "CGUIShaderManager: loaded %u precompiled program(s)", (unsigned int)m_blob.size());
+	return true;
+}
+
+bool CGUIShaderManager::SaveBlob()
+{
+	// Write to a temp file first so a half written blob is never picked up
+	CStdString strTemp = SHADER_BLOB_FILE ".tmp";
+	FILE* fd = fopen(strTemp.c_str(), "wb");
+	if (!fd)
+	{
+		CLog::Log(LOGERROR, "CGUIShaderManager: unable to write %s", strTemp.c_str());
+		return false;
+	}
+
+	ShaderBlobHeader header;
+	header.dwMagic = SHADER_BLOB_MAGIC;
+	header.dwVersion = SHADER_BLOB_VERSION;
+	header.dwCount = m_blob.size();
+
+	bool bResult = fwrite(&header, sizeof(header), 1, fd) == 1;
+
+	for (std::map<CStdString, BlobEntry>::iterator it = m_blob.begin(); bResult && it != m_blob.end(); it++)
+	{
+		ShaderBlobEntry blobEntry;
+		memset(&blobEntry, 0, sizeof(blobEntry));
+		strncpy(blobEntry.szKey, it->first.c_str(), SHADER_BLOB_KEYSIZE - 1);
+		blobEntry.dwSourceHash = it->second.dwSourceHash;
+		blobEntry.dwCompileTime = it->second.dwCompileTime;
+		blobEntry.dwSize = it->second.code.size();
+
+		bResult = fwrite(&blobEntry, sizeof(blobEntry), 1, fd) == 1 &&
+		          fwrite(&it->second.code[0], blobEntry.dwSize, 1, fd) == 1;
+	}
+	fclose(fd);
+
+	if (bResult)
+	{
+		DeleteFile(SHADER_BLOB_FILE);
+		bResult = MoveFile(strTemp.c_str(), SHADER_BLOB_FILE) != FALSE;
+	}
+
+	if (!bResult)
+	{
+		CLog::Log(LOGERROR, "CGUIShaderManager: failed writing %s", SHADER_BLOB_FILE);
+		DeleteFile(strTemp.c_str());
+		return false;
+	}
+
+	m_bBlobChanged = false;
+	return true;
+}
+
+DWORD CGUIShaderManager::Hash(const char* strSource, const char* strProfile)
+{
+	// Any change in source or profile means a rebuild
+	return CFnv::HashString(strProfile, CFnv::HashString(strSource));
+}
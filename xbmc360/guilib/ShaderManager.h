@@ -0,0 +1,102 @@
+#ifndef GUILIB_SHADERMANAGER_H
+#define GUILIB_SHADERMANAGER_H
+
+#include "..\utils\Stdafx.h"
+#include "..\utils\StdString.h"
+#include "..\utils\CriticalSection.h"
+
+#include <map>
+#include <vector>
+
+// Keys of the built in programs
+#define SHADER_TEXTURE_VS  "texture.vs" // transforms by matWVP in c0, passes one texcoord
+#define SHADER_TEXTURE_PS  "texture.ps" // samples sampler 0
+#define SHADER_SPRITE_VS   "sprite.vs"  // as texture.vs, also passes a diffuse color
+#define SHADER_SPRITE_PS   "sprite.ps"  // sampler 0 modulated by the diffuse color
+
+// Precompiled microcode, rewritten whenever a program had to be compiled
+#define SHADER_BLOB_FILE     "D:\\media\\shaders.xsb"
+#define SHADER_BLOB_MAGIC    0x58534842 // 'XSHB'
+#define SHADER_BLOB_VERSION  1
+#define SHADER_BLOB_KEYSIZE  32
+
+// Header of the blob file, followed by dwCount entries
+struct ShaderBlobHeader
+{
+	DWORD dwMagic;
+	DWORD dwVersion;
+	DWORD dwCount;
+};
+
+// One program in the blob file, followed by dwSize bytes of microcode
+struct ShaderBlobEntry
+{
+	char szKey[SHADER_BLOB_KEYSIZE];
+	DWORD dwSourceHash;  // hash of the HLSL source and profile the code was built from
+	DWORD dwCompileTime; // time the compile took in ms, used to account the time saved
+	DWORD dwSize;
+};
+
+/*!
+ \brief Hands out shared vertex and pixel shaders by key.
+
+ Each program is created once, from the blob file if it holds up to date
+ microcode, otherwise by compiling the HLSL source. Returned shaders are
+ AddRef'ed, callers Release them as usual.
+ */
+class CGUIShaderManager
+{
+public:
+	CGUIShaderManager(void);
+	virtual ~CGUIShaderManager(void);
+
+	IDirect3DVertexShader9* GetVertexShader(const CStdString& strKey);
+	IDirect3DPixelShader9* GetPixelShader(const CStdString& strKey);
+
+	// Time not spent compiling since startup, in ms
+	DWORD GetTimeSaved();
+
+	void LogStats(const char* strWhen);
+
+	// Releases the shaders and writes the blob if it changed
+	void Cleanup();
+
+private:
+	struct ShaderEntry
+	{
+		IUnknown* pShader;
+		DWORD dwCompileTime;
+	};
+
+	struct BlobEntry
+	{
+		DWORD dwSourceHash;
+		DWORD dwCompileTime;
+		std::vector<BYTE> code;
+	};
+
+	IUnknown* GetShader(const CStdString& strKey, bool bVertex);
+	bool GetCode(const CStdString& strKey, bool bVertex, BlobEntry*& pCode, bool& bCompiled);
+
+	bool LoadBlob();
+	bool SaveBlob();
+
+	static DWORD Hash(const char* strSource, const char* strProfile);
+
+	std::map<CStdString, ShaderEntry> m_shaders;
+	std::map<CStdString, BlobEntry> m_blob;
+
+	CCriticalSection m_critSection;
+	bool m_bBlobLoaded;
+	bool m_bBlobChanged;
+
+	unsigned int m_iCompiled;  // programs compiled from source
+	unsigned int m_iLoaded;    // programs created from the blob
+	unsigned int m_iShared;    // requests served by an existing shader
+	DWORD m_dwCompileTime;
+	DWORD m_dwTimeSaved;
+};
+
+extern CGUIShaderManager g_shaderManager;
+
+#endif //GUILIB_SHADERMANAGER_H
@@ -30,7 +30,35 @@ CSkinInfo::CSkinInfo()
 CSkinInfo::~CSkinInfo()
 {}
 
+void CSkinInfo::Load(const CStdString& strSkinDir)
+{
+	m_strSkinDir = strSkinDir;
+
+	m_includes.ClearIncludes();
+	m_includes.LoadIncludes(GetSkinPath("Includes.xml"));
+}
+
+void CSkinInfo::Unload()
+{
+	m_includes.ClearIncludes();
+}
+
+CStdString CSkinInfo::GetSkinPath(const CStdString& strFile) const
+{
+	return m_strSkinDir + "\\" + strFile;
+}
+
+void CSkinInfo::ResolveIncludes(TiXmlElement *node, const CStdString &type)
+{
+	m_includes.ResolveIncludes(node, type);
+}
+
 bool CSkinInfo::ResolveConstant(const CStdString &constant, float &value) const
 {
 	return m_includes.ResolveConstant(constant, value);
 }
+
+void CSkinInfo::GetIncludeFiles(std::vector<CStdString> &files) const
+{
+	m_includes.GetFiles(files);
+}
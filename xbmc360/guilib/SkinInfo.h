@@ -34,9 +34,21 @@ public:
 	CSkinInfo();
 	~CSkinInfo();
 
+	// Reads the includes of the skin in strSkinDir
+	void Load(const CStdString& strSkinDir);
+	void Unload();
+
+	// Path of a file in the skin folder
+	CStdString GetSkinPath(const CStdString& strFile) const;
+
+	void ResolveIncludes(TiXmlElement *node, const CStdString &type = "");
 	bool ResolveConstant(const CStdString &constant, float &value) const;
 
+	// Files windows read through includes depend on as well
+	void GetIncludeFiles(std::vector<CStdString> &files) const;
+
 protected:
+	CStdString m_strSkinDir;
 	CGUIIncludes m_includes;
 };
 
@@ -0,0 +1,560 @@
+#include "SpriteBatch.h"
+#include "GraphicContext.h"
+#include "ShaderManager.h"
+#include "..\utils\Log.h"
+#include "..\utils\SingleLock.h"
+#include "..\utils\Fnv.h"
+
+#include <algorithm>
+#include <math.h>
+
+CGUISpriteBatch g_spriteBatch;
+
+static int GridCell(float fOffset, float fCellSize, int iCells)
+{
+	int iCell = (int)(fOffset / fCellSize);
+	if (iCell < 0)
+		return 0;
+	if (iCell >= iCells)
+		return iCells - 1;
+	return iCell;
+}
+
+bool CGUISpriteBatch::QuadOrder::operator()(const SpriteQuad* left, const SpriteQuad* right) const
+{
+	if (left->iLayer != right->iLayer)
+		return left->iLayer < right->iLayer;
+	if (left->bAlphaBlend != right->bAlphaBlend)
+		return !left->bAlphaBlend;
+	if (left->pTexture != right->pTexture)
+		return left->pTexture < right->pTexture;
+	return left->iOrder < right->iOrder;
+}
+
+CGUISpriteBatch::CGUISpriteBatch(void)
+{
+	m_pVB = NULL;
+	m_pIB = NULL;
+	m_pVertexDecl = NULL;
+	m_pVertexShader = NULL;
+	m_pPixelShader = NULL;
+	m_pWhiteTexture = NULL;
+	m_bFailed = false;
+
+	m_bClip = false;
+	m_bFlushed = false;
+
+	m_iRegionQuads = 0;
+	m_dwRegionHash = FNV_OFFSET_BASIS;
+
+	m_iFrame = 0;
+	m_iCursor = 0;
+	m_bNoOverwrite = true;
+
+	m_iDrawCalls = 0;
+	m_iVertices = 0;
+	m_iQuadCount = 0;
+	m_iOverlapTests = 0;
+	m_iLastDrawCalls = 0;
+	m_iLastVertices = 0;
+	m_iLastQuads = 0;
+	m_iLastOverlapTests = 0;
+
+	m_iStalls = 0;
+	m_iTotalDrawCalls = 0;
+	m_iTotalQuads = 0;
+	m_iTotalOverlapTests = 0;
+	m_iSortTicks = 0;
+
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	m_iFrequency = frequency.QuadPart;
+}
+
+CGUISpriteBatch::~CGUISpriteBatch(void)
+{
+}
+
+void CGUISpriteBatch::AddQuad(LPDIRECT3DTEXTURE9 pTexture, float fPosX, float fPosY, float fWidth, float fHeight, DWORD dwColor, bool bAlphaBlend)
+{
+	static const FRECT uv = { 0.0f, 0.0f, 1.0f, 1.0f };
+	AddQuad(pTexture, uv, fPosX, fPosY, fWidth, fHeight, dwColor, bAlphaBlend);
+}
+
+void CGUISpriteBatch::AddQuad(LPDIRECT3DTEXTURE9 pTexture, const FRECT& uv, float fPosX, float fPosY, float fWidth, float fHeight, DWORD dwColor, bool bAlphaBlend)
+{
+	if (!pTexture || fWidth <= 0 || fHeight <= 0 || (dwColor & 0xFF000000) == 0)
+		return;
+
+	CSingleLock lock(g_graphicsContext);
+
+	SpriteQuad quad;
+	quad.pTexture = pTexture;
+	quad.bAlphaBlend = bAlphaBlend || (dwColor & 0xFF000000) != 0xFF000000;
+	quad.dwColor = dwColor;
+	quad.x1 = fPosX;
+	quad.y1 = fPosY;
+	quad.x2 = fPosX + fWidth;
+	quad.y2 = fPosY + fHeight;
+	quad.u1 = uv.left;
+	quad.v1 = uv.top;
+	quad.u2 = uv.right;
+	quad.v2 = uv.bottom;
+	quad.iLayer = 0;
+	quad.iOrder = m_quads.size();
+
+	m_quads.push_back(quad);
+
+	// Everything that changes how the quad looks, field by field to leave out the padding
+	m_dwRegionHash = CFnv::Hash(&quad.pTexture, sizeof(quad.pTexture), m_dwRegionHash);
+	m_dwRegionHash = CFnv::Hash(&quad.bAlphaBlend, sizeof(quad.bAlphaBlend), m_dwRegionHash);
+	m_dwRegionHash = CFnv::Hash(&quad.dwColor, sizeof(quad.dwColor), m_dwRegionHash);
+	m_dwRegionHash = CFnv::Hash(&quad.x1, 8 * sizeof(float), m_dwRegionHash);
+	if (m_iRegionQuads++ == 0)
+	{
+		m_region.left = quad.x1;
+		m_region.top = quad.y1;
+		m_region.right = quad.x2;
+		m_region.bottom = quad.y2;
+	}
+	else
+	{
+		if (quad.x1 < m_region.left) m_region.left = quad.x1;
+		if (quad.y1 < m_region.top) m_region.top = quad.y1;
+		if (quad.x2 > m_region.right) m_region.right = quad.x2;
+		if (quad.y2 > m_region.bottom) m_region.bottom = quad.y2;
+	}
+}
+
+void CGUISpriteBatch::AddRect(float fPosX, float fPosY, float fWidth, float fHeight, DWORD dwColor)
+{
+	CSingleLock lock(g_graphicsContext);
+
+	if (!m_pWhiteTexture && !CreateWhiteTexture())
+		return;
+
+	AddQuad(m_pWhiteTexture, fPosX, fPosY, fWidth, fHeight, dwColor);
+}
+
+void CGUISpriteBatch::SetClip(const FRECT* pClip)
+{
+	CSingleLock lock(g_graphicsContext);
+
+	m_bClip = pClip != NULL;
+	if (pClip)
+		m_clip = *pClip;
+}
+
+void CGUISpriteBatch::Discard()
+{
+	CSingleLock lock(g_graphicsContext);
+
+	m_quads.clear();
+}
+
+void CGUISpriteBatch::ResetRegion()
+{
+	CSingleLock lock(g_graphicsContext);
+
+	m_iRegionQuads = 0;
+	m_dwRegionHash = FNV_OFFSET_BASIS;
+}
+
+bool CGUISpriteBatch::GetRegion(DWORD& dwHash, FRECT& bounds) const
+{
+	if (!m_iRegionQuads)
+		return false;
+
+	dwHash = m_dwRegionHash;
+	bounds = m_region;
+	return true;
+}
+
+void CGUISpriteBatch::Flush()
+{
+	g_graphicsContext.Lock();
+
+	m_bFlushed = true;
+
+	// Quads outside the clip wouldn't change a pixel
+	if (m_bClip)
+	{
+		unsigned int iKept = 0;
+		for (unsigned int i = 0; i < m_quads.size(); i++)
+		{
+			const SpriteQuad& quad = m_quads[i];
+			if (quad.x1 < m_clip.right && m_clip.left < quad.x2 && quad.y1 < m_clip.bottom && m_clip.top < quad.y2)
+				m_quads[iKept++] = quad;
+		}
+		m_quads.resize(iKept);
+	}
+
+	if (m_quads.empty() || (!m_pVB && !Create()))
+	{
+		m_quads.clear();
+		g_graphicsContext.Unlock();
+		return;
+	}
+
+	LPDIRECT3DDEVICE9 pDevice = g_graphicsContext.Get3DDevice();
+	if (m_bClip)
+	{
+		RECT rc;
+		rc.left = (LONG)floorf(m_clip.left);
+		rc.top = (LONG)floorf(m_clip.top);
+		rc.right = (LONG)ceilf(m_clip.right);
+		rc.bottom = (LONG)ceilf(m_clip.bottom);
+		pDevice->SetScissorRect(&rc);
+		pDevice->SetRenderState(D3DRS_SCISSORTESTENABLE, TRUE);
+	}
+
+	LARGE_INTEGER start, end;
+	QueryPerformanceCounter(&start);
+
+	AssignLayers();
+	std::sort(m_sorted.begin(), m_sorted.end(), QuadOrder());
+
+	QueryPerformanceCounter(&end);
+	m_iSortTicks += end.QuadPart - start.QuadPart;
+
+	for (unsigned int iStart = 0; iStart < m_sorted.size(); iStart += SPRITEBATCH_MAX_QUADS)
+	{
+		unsigned int iCount = m_sorted.size() - iStart;
+		if (iCount > SPRITEBATCH_MAX_QUADS)
+			iCount = SPRITEBATCH_MAX_QUADS;
+
+		Draw(m_sorted, iStart, iCount);
+	}
+
+	if (m_bClip)
+		pDevice->SetRenderState(D3DRS_SCISSORTESTENABLE, FALSE);
+
+	m_iQuadCount += m_quads.size();
+	m_quads.clear();
+
+	g_graphicsContext.Unlock();
+}
+
+// A quad has to stay behind every earlier quad it overlaps, unless both
+// are drawn by the same call anyway. Anything else may be reordered.
+void CGUISpriteBatch::AssignLayers()
+{
+	// The grid spans what was queued, not the screen, quads may be off it
+	FRECT bounds = { m_quads[0].x1, m_quads[0].y1, m_quads[0].x2, m_quads[0].y2 };
+	for (unsigned int i = 1; i < m_quads.size(); i++)
+	{
+		const SpriteQuad& quad = m_quads[i];
+		if (quad.x1 < bounds.left) bounds.left = quad.x1;
+		if (quad.y1 < bounds.top) bounds.top = quad.y1;
+		if (quad.x2 > bounds.right) bounds.right = quad.x2;
+		if (quad.y2 > bounds.bottom) bounds.bottom = quad.y2;
+	}
+	float fCellWidth = (bounds.right - bounds.left) / SPRITEBATCH_GRID_COLUMNS;
+	float fCellHeight = (bounds.bottom - bounds.top) / SPRITEBATCH_GRID_ROWS;
+
+	for (int i = 0; i < SPRITEBATCH_GRID_COLUMNS * SPRITEBATCH_GRID_ROWS; i++)
+		m_cells[i].clear();
+	m_tested.assign(m_quads.size(), -1);
+	m_sorted.resize(m_quads.size());
+
+	for (unsigned int i = 0; i < m_quads.size(); i++)
+	{
+		SpriteQuad& quad = m_quads[i];
+
+		int iLeft = GridCell(quad.x1 - bounds.left, fCellWidth, SPRITEBATCH_GRID_COLUMNS);
+		int iRight = GridCell(quad.x2 - bounds.left, fCellWidth, SPRITEBATCH_GRID_COLUMNS);
+		int iTop = GridCell(quad.y1 - bounds.top, fCellHeight, SPRITEBATCH_GRID_ROWS);
+		int iBottom = GridCell(quad.y2 - bounds.top, fCellHeight, SPRITEBATCH_GRID_ROWS);
+
+		for (int y = iTop; y <= iBottom; y++)
+		{
+			for (int x = iLeft; x <= iRight; x++)
+			{
+				std::vector<int>& cell = m_cells[y * SPRITEBATCH_GRID_COLUMNS + x];
+				for (unsigned int k = 0; k < cell.size(); k++)
+				{
+					// Quads spanning several cells are met more than once
+					int j = cell[k];
+					if (m_tested[j] == (int)i)
+						continue;
+					m_tested[j] = i;
+
+					m_iOverlapTests++;
+					const SpriteQuad& earlier = m_quads[j];
+					if (!Overlaps(quad, earlier))
+						continue;
+
+					int iLayer = earlier.iLayer + (SameState(quad, earlier) ? 0 : 1);
+					if (iLayer > quad.iLayer)
+						quad.iLayer = iLayer;
+				}
+				cell.push_back(i);
+			}
+		}
+		m_sorted[i] = &quad;
+	}
+}
+
+void CGUISpriteBatch::Draw(std::vector<SpriteQuad*>& quads, unsigned int iStart, unsigned int iCount)
+{
+	LPDIRECT3DDEVICE9 pDevice = g_graphicsContext.Get3DDevice();
+
+	// Stay within this frame's half of the buffer
+	unsigned int iHalfStart = (m_iFrame & 1) * SPRITEBATCH_MAX_QUADS;
+	if (m_iCursor + iCount > iHalfStart + SPRITEBATCH_MAX_QUADS)
+	{
+		// Out of space, start over and let the lock wait for the GPU
+		m_iCursor = iHalfStart;
+		m_bNoOverwrite = false;
+		m_iStalls++;
+	}
+
+	SpriteVertex* pVertices = NULL;
+	if (FAILED(m_pVB->Lock(m_iCursor * 4 * sizeof(SpriteVertex), iCount * 4 * sizeof(SpriteVertex),
+	                       (void**)&pVertices, m_bNoOverwrite ? D3DLOCK_NOOVERWRITE : 0)))
+	{
+		CLog::Log(LOGERROR, "CGUISpriteBatch: unable to lock vertex buffer");
+		return;
+	}
+
+	for (unsigned int i = 0; i < iCount; i++)
+	{
+		const SpriteQuad& quad = *quads[iStart + i];
+		SpriteVertex* v = pVertices + i * 4;
+
+		v[0].Position[0] = quad.x1; v[0].Position[1] = quad.y1; v[0].Position[2] = 0.0f;
+		v[0].TexCoord[0] = quad.u1; v[0].TexCoord[1] = quad.v1;
+		v[1].Position[0] = quad.x2; v[1].Position[1] = quad.y1; v[1].Position[2] = 0.0f;
+		v[1].TexCoord[0] = quad.u2; v[1].TexCoord[1] = quad.v1;
+		v[2].Position[0] = quad.x1; v[2].Position[1] = quad.y2; v[2].Position[2] = 0.0f;
+		v[2].TexCoord[0] = quad.u1; v[2].TexCoord[1] = quad.v2;
+		v[3].Position[0] = quad.x2; v[3].Position[1] = quad.y2; v[3].Position[2] = 0.0f;
+		v[3].TexCoord[0] = quad.u2; v[3].TexCoord[1] = quad.v2;
+		v[0].Color = v[1].Color = v[2].Color = v[3].Color = quad.dwColor;
+	}
+	m_pVB->Unlock();
+
+	// Screen space orthographic projection, world and view are identity
+	D3DXMATRIX matWVP;
+	D3DXMatrixOrthoOffCenterLH(&matWVP, 0, (float)g_graphicsContext.GetWidth(), (float)g_graphicsContext.GetHeight(), 0, 0.0f, 1.0f);
+	pDevice->SetVertexShaderConstantF(0, (FLOAT*)&matWVP, 4);
+
+	pDevice->SetSamplerState(0, D3DSAMP_MAGFILTER, D3DTEXF_ANISOTROPIC);
+	pDevice->SetSamplerState(0, D3DSAMP_MINFILTER, D3DTEXF_ANISOTROPIC);
+	pDevice->SetSamplerState(0, D3DSAMP_MIPFILTER, D3DTEXF_LINEAR);
+
+	pDevice->SetVertexDeclaration(m_pVertexDecl);
+	pDevice->SetStreamSource(0, m_pVB, 0, sizeof(SpriteVertex));
+	pDevice->SetIndices(m_pIB);
+	pDevice->SetVertexShader(m_pVertexShader);
+	pDevice->SetPixelShader(m_pPixelShader);
+
+	bool bAlphaBlend = false;
+	pDevice->SetRenderState(D3DRS_ALPHABLENDENABLE, FALSE);
+
+	// One draw call for every run of quads sharing texture and blend state
+	unsigned int iRun = 0;
+	while (iRun < iCount)
+	{
+		const SpriteQuad& first = *quads[iStart + iRun];
+		unsigned int iRunEnd = iRun + 1;
+		while (iRunEnd < iCount && SameState(first, *quads[iStart + iRunEnd]))
+			iRunEnd++;
+
+		if (first.bAlphaBlend != bAlphaBlend)
+		{
+			bAlphaBlend = first.bAlphaBlend;
+			pDevice->SetRenderState(D3DRS_ALPHABLENDENABLE, bAlphaBlend);
+			if (bAlphaBlend)
+			{
+				pDevice->SetRenderState(D3DRS_SRCBLEND, D3DBLEND_SRCALPHA);
+				pDevice->SetRenderState(D3DRS_DESTBLEND, D3DBLEND_INVSRCALPHA);
+			}
+		}
+
+		pDevice->SetTexture(0, first.pTexture);
+		pDevice->DrawIndexedPrimitive(D3DPT_TRIANGLELIST, m_iCursor * 4, iRun * 4, (iRunEnd - iRun) * 4, iRun * 6, (iRunEnd - iRun) * 2);
+
+		m_iDrawCalls++;
+		m_iVertices += (iRunEnd - iRun) * 4;
+		iRun = iRunEnd;
+	}
+
+	pDevice->SetTexture(0, NULL);
+	pDevice->SetRenderState(D3DRS_ALPHABLENDENABLE, FALSE);
+	pDevice->SetStreamSource(NULL, NULL, NULL, NULL);
+	pDevice->SetIndices(NULL);
+
+	m_iCursor += iCount;
+}
+
+void CGUISpriteBatch::EndFrame()
+{
+	CSingleLock lock(g_graphicsContext);
+
+	Flush();
+
+	m_bClip = false;
+	m_bFlushed = false;
+
+	m_iLastDrawCalls = m_iDrawCalls;
+	m_iLastVertices = m_iVertices;
+	m_iLastQuads = m_iQuadCount;
+	m_iLastOverlapTests = m_iOverlapTests;
+	m_iTotalDrawCalls += m_iDrawCalls;
+	m_iTotalQuads += m_iQuadCount;
+	m_iTotalOverlapTests += m_iOverlapTests;
+
+	m_iDrawCalls = 0;
+	m_iVertices = 0;
+	m_iQuadCount = 0;
+	m_iOverlapTests = 0;
+
+	// Next frame writes to the other half, the GPU is done with it by now
+	m_iFrame++;
+	m_iCursor = (m_iFrame & 1) * SPRITEBATCH_MAX_QUADS;
+	m_bNoOverwrite = true;
+}
+
+bool CGUISpriteBatch::Create()
+{
+	if (m_bFailed)
+		return false;
+
+	LPDIRECT3DDEVICE9 pDevice = g_graphicsContext.Get3DDevice();
+	if (!pDevice)
+		return false;
+
+	m_pVertexShader = g_shaderManager.GetVertexShader(SHADER_SPRITE_VS);
+	m_pPixelShader = g_shaderManager.GetPixelShader(SHADER_SPRITE_PS);
+
+	static const D3DVERTEXELEMENT9 VertexElements[4] =
+	{
+		{ 0,  0, D3DDECLTYPE_FLOAT3,   D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_POSITION, 0 },
+		{ 0, 12, D3DDECLTYPE_D3DCOLOR, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_COLOR,    0 },
+		{ 0, 16, D3DDECLTYPE_FLOAT2,   D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_TEXCOORD, 0 },
+		D3DDECL_END()
+	};
+	pDevice->CreateVertexDeclaration(VertexElements, &m_pVertexDecl);
+
+	// Two halves, one per frame in flight
+	pDevice->CreateVertexBuffer(2 * SPRITEBATCH_MAX_QUADS * 4 * sizeof(SpriteVertex),
+	                            D3DUSAGE_WRITEONLY, NULL, D3DPOOL_DEFAULT, &m_pVB, NULL);
+
+	// The indices never change, quad i uses vertices 4i to 4i+3
+	pDevice->CreateIndexBuffer(SPRITEBATCH_MAX_QUADS * 6 * sizeof(WORD),
+	                           D3DUSAGE_WRITEONLY, D3DFMT_INDEX16, D3DPOOL_MANAGED, &m_pIB, NULL);
+
+	WORD* pIndices = NULL;
+	if (m_pIB && SUCCEEDED(m_pIB->Lock(0, 0, (void**)&pIndices, 0)))
+	{
+		for (WORD i = 0; i < SPRITEBATCH_MAX_QUADS; i++)
+		{
+			pIndices[i * 6 + 0] = i * 4 + 0;
+			pIndices[i * 6 + 1] = i * 4 + 1;
+			pIndices[i * 6 + 2] = i * 4 + 2;
+			pIndices[i * 6 + 3] = i * 4 + 2;
+			pIndices[i * 6 + 4] = i * 4 + 1;
+			pIndices[i * 6 + 5] = i * 4 + 3;
+		}
+		m_pIB->Unlock();
+	}
+	else
+		pIndices = NULL;
+
+	if (!m_pVB || !pIndices || !m_pVertexDecl || !m_pVertexShader || !m_pPixelShader)
+	{
+		CLog::Log(LOGERROR, "CGUISpriteBatch: unable to create rendering objects");
+		Release();
+		m_bFailed = true;
+		return false;
+	}
+
+	m_iCursor = (m_iFrame & 1) * SPRITEBATCH_MAX_QUADS;
+	return true;
+}
+
+bool CGUISpriteBatch::CreateWhiteTexture()
+{
+	LPDIRECT3DDEVICE9 pDevice = g_graphicsContext.Get3DDevice();
+	if (!pDevice)
+		return false;
+
+	if (FAILED(pDevice->CreateTexture(1, 1, 1, 0, D3DFMT_LIN_A8R8G8B8, D3DPOOL_MANAGED, &m_pWhiteTexture, NULL)))
+	{
+		CLog::Log(LOGERROR, "CGUISpriteBatch: unable to create fill texture");
+		m_pWhiteTexture = NULL;
+		return false;
+	}
+
+	D3DLOCKED_RECT lr;
+	if (SUCCEEDED(m_pWhiteTexture->LockRect(0, &lr, NULL, 0)))
+	{
+		*(DWORD*)lr.pBits = 0xFFFFFFFF;
+		m_pWhiteTexture->UnlockRect(0);
+	}
+	return true;
+}
+
+void CGUISpriteBatch::Release()
+{
+	g_graphicsContext.Lock();
+
+	m_quads.clear();
+
+	if (m_iFrame)
+	{
+		CLog::Log(LOGNOTICE, "CGUISpriteBatch: %u frame(s), avg %u quad(s) in %u draw call(s) per frame, ran out of vertex space %u time(s)",
+			m_iFrame, (unsigned int)(m_iTotalQuads / m_iFrame), (unsigned int)(m_iTotalDrawCalls / m_iFrame), m_iStalls);
+		CLog::Log(LOGNOTICE, "CGUISpriteBatch: ordering quads took avg %.3f ms and %u overlap test(s) per frame",
+			1000.0 * m_iSortTicks / m_iFrequency / m_iFrame, (unsigned int)(m_iTotalOverlapTests / m_iFrame));
+	}
+
+	if (m_pVB)
+	{
+		m_pVB->Release();
+		m_pVB = NULL;
+	}
+
+	if (m_pIB)
+	{
+		m_pIB->Release();
+		m_pIB = NULL;
+	}
+
+	if (m_pVertexDecl)
+	{
+		m_pVertexDecl->Release();
+		m_pVertexDecl = NULL;
+	}
+
+	if (m_pVertexShader)
+	{
+		m_pVertexShader->Release();
+		m_pVertexShader = NULL;
+	}
+
+	if (m_pPixelShader)
+	{
+		m_pPixelShader->Release();
+		m_pPixelShader = NULL;
+	}
+
+	if (m_pWhiteTexture)
+	{
+		m_pWhiteTexture->Release();
+		m_pWhiteTexture = NULL;
+	}
+
+	g_graphicsContext.Unlock();
+}
+
+bool CGUISpriteBatch::SameState(const SpriteQuad& left, const SpriteQuad& right)
+{
+	return left.pTexture == right.pTexture && left.bAlphaBlend == right.bAlphaBlend;
+}
+
+bool CGUISpriteBatch::Overlaps(const SpriteQuad& left, const SpriteQuad& right)
+{
+	return left.x1 < right.x2 && right.x1 < left.x2 && left.y1 < right.y2 && right.y1 < left.y2;
+}
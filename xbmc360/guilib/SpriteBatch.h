@@ -0,0 +1,153 @@
+#ifndef GUILIB_SPRITEBATCH_H
+#define GUILIB_SPRITEBATCH_H
+
+#include "..\utils\Stdafx.h"
+#include "GUITexture.h"
+
+#include <vector>
+
+// Quads per frame half of the vertex buffer, a frame drawing more waits for the GPU
+#define SPRITEBATCH_MAX_QUADS 2048
+
+// Cells the quads of a flush are bucketed in, only quads sharing a cell are tested for overlap
+#define SPRITEBATCH_GRID_COLUMNS 16
+#define SPRITEBATCH_GRID_ROWS    9
+
+/*!
+ \brief Collects the textured quads of a frame and draws them with as few
+ draw calls as possible.
+
+ Quads are kept in one vertex buffer, split in two halves that are used on
+ alternate frames so we never write to vertices the GPU may still read.
+ On Flush() quads are grouped by blend state and texture. A quad is only
+ moved in front of an earlier one when they don't overlap, so the result
+ looks the same as drawing them in submission order. Overlaps are found
+ through a coarse grid over the queued quads, so a quad is only compared
+ with the ones near it.
+
+ Anything that draws to the device directly (video, screensavers) has to
+ call Flush() first.
+
+ The batch also tells controls what they queued: the bounds and a hash of
+ the quads added since ResetRegion(), that's how a control notices it
+ looks different than in the last frame.
+ */
+class CGUISpriteBatch
+{
+public:
+	CGUISpriteBatch(void);
+	virtual ~CGUISpriteBatch(void);
+
+	// dwColor modulates the texture, quads that aren't fully opaque are always blended
+	void AddQuad(LPDIRECT3DTEXTURE9 pTexture, float fPosX, float fPosY, float fWidth, float fHeight, DWORD dwColor = 0xFFFFFFFF, bool bAlphaBlend = false);
+
+	// Draws the uv part of the texture, e.g. an image in an atlas page
+	void AddQuad(LPDIRECT3DTEXTURE9 pTexture, const FRECT& uv, float fPosX, float fPosY, float fWidth, float fHeight, DWORD dwColor = 0xFFFFFFFF, bool bAlphaBlend = false);
+
+	// Fills a rectangle with dwColor, e.g. a window background
+	void AddRect(float fPosX, float fPosY, float fWidth, float fHeight, DWORD dwColor);
+
+	// Draws everything collected so far
+	void Flush();
+
+	// Only quads overlapping pClip are drawn on EndFrame(), and only inside it. NULL draws everything.
+	void SetClip(const FRECT* pClip);
+
+	// Drops the quads of this frame, nothing will be drawn
+	void Discard();
+
+	// Called once per frame before EndScene()
+	void EndFrame();
+
+	// Something flushed this frame before EndFrame(), what is on screen isn't only our quads
+	bool WasFlushed() const { return m_bFlushed; }
+
+	// Bounds and hash of the quads added since ResetRegion(), false when none were
+	void ResetRegion();
+	bool GetRegion(DWORD& dwHash, FRECT& bounds) const;
+
+	void Release();
+
+	// Counts of the last completed frame
+	unsigned int GetDrawCalls() const { return m_iLastDrawCalls; }
+	unsigned int GetVertices() const { return m_iLastVertices; }
+	unsigned int GetQuads() const { return m_iLastQuads; }
+	unsigned int GetOverlapTests() const { return m_iLastOverlapTests; }
+
+private:
+	struct SpriteVertex
+	{
+		float Position[3];
+		DWORD Color;
+		float TexCoord[2];
+	};
+
+	struct SpriteQuad
+	{
+		LPDIRECT3DTEXTURE9 pTexture;
+		bool bAlphaBlend;
+		DWORD dwColor;
+		float x1, y1, x2, y2;
+		float u1, v1, u2, v2;
+		int iLayer;
+		int iOrder;
+	};
+
+	struct QuadOrder
+	{
+		bool operator()(const SpriteQuad* left, const SpriteQuad* right) const;
+	};
+
+	bool Create();
+	bool CreateWhiteTexture();
+	void AssignLayers();
+	void Draw(std::vector<SpriteQuad*>& quads, unsigned int iStart, unsigned int iCount);
+
+	static bool SameState(const SpriteQuad& left, const SpriteQuad& right);
+	static bool Overlaps(const SpriteQuad& left, const SpriteQuad& right);
+
+	IDirect3DVertexBuffer9*       m_pVB;
+	IDirect3DIndexBuffer9*        m_pIB;
+	IDirect3DVertexDeclaration9*  m_pVertexDecl;
+	IDirect3DVertexShader9*       m_pVertexShader;
+	IDirect3DPixelShader9*        m_pPixelShader;
+	LPDIRECT3DTEXTURE9            m_pWhiteTexture;
+	bool m_bFailed;
+
+	std::vector<SpriteQuad> m_quads;
+	std::vector<SpriteQuad*> m_sorted;
+	std::vector<int> m_cells[SPRITEBATCH_GRID_COLUMNS * SPRITEBATCH_GRID_ROWS];  // quads touching the cell
+	std::vector<int> m_tested;  // the last quad that was tested against this one
+
+	bool m_bClip;
+	FRECT m_clip;
+	bool m_bFlushed;
+
+	unsigned int m_iRegionQuads;
+	DWORD m_dwRegionHash;
+	FRECT m_region;
+
+	unsigned int m_iFrame;
+	unsigned int m_iCursor;     // next free quad in the vertex buffer
+	bool m_bNoOverwrite;        // cursor is in a part the GPU is done with
+
+	unsigned int m_iDrawCalls;
+	unsigned int m_iVertices;
+	unsigned int m_iQuadCount;
+	unsigned int m_iOverlapTests;
+	unsigned int m_iLastDrawCalls;
+	unsigned int m_iLastVertices;
+	unsigned int m_iLastQuads;
+	unsigned int m_iLastOverlapTests;
+
+	unsigned int m_iStalls;     // times a frame ran out of vertex buffer space
+	unsigned __int64 m_iTotalDrawCalls;
+	unsigned __int64 m_iTotalQuads;
+	unsigned __int64 m_iTotalOverlapTests;
+	__int64 m_iSortTicks;       // spent ordering quads in Flush(), all frames
+	__int64 m_iFrequency;
+};
+
+extern CGUISpriteBatch g_spriteBatch;
+
+#endif //GUILIB_SPRITEBATCH_H
@@ -0,0 +1,135 @@
+#include "TextLayoutCache.h"
+
+bool CTextLayoutCache::Key::operator<(const Key& right) const
+{
+	if (iFace != right.iFace) return iFace < right.iFace;
+	if (iSize != right.iSize) return iSize < right.iSize;
+	if (dwStyle != right.dwStyle) return dwStyle < right.dwStyle;
+	if (iAlign != right.iAlign) return iAlign < right.iAlign;
+	if (iOverflow != right.iOverflow) return iOverflow < right.iOverflow;
+	if (iMaxWidth != right.iMaxWidth) return iMaxWidth < right.iMaxWidth;
+	return GetText() < right.GetText();
+}
+
+CTextLayoutCache::CTextLayoutCache(CGlyphCache& glyphs, unsigned int iMaxEntries)
+	: m_glyphs(glyphs)
+{
+	m_iMaxEntries = iMaxEntries;
+	m_iEpoch = 1;
+
+	m_iHits = 0;
+	m_iMisses = 0;
+	m_iStale = 0;
+	m_iEvictions = 0;
+}
+
+CTextLayoutCache::~CTextLayoutCache(void)
+{
+}
+
+const TextLayout* CTextLayoutCache::Get(Ref& ref)
+{
+	if (!ref.pEntry || ref.iEpoch != m_iEpoch || ref.pEntry->layout.iGeneration != m_glyphs.GetGeneration())
+		return NULL;
+
+	m_lru.splice(m_lru.begin(), m_lru, ref.pEntry->lru);
+	m_iHits++;
+	return &ref.pEntry->layout;
+}
+
+const TextLayout* CTextLayoutCache::Get(int iFace, float fSize, unsigned int dwStyle, int iAlign, float fMaxWidth, int iOverflow,
+                                        const std::wstring& strText, Ref* pRef)
+{
+	Key key;
+	key.iFace = iFace;
+	key.iSize = (unsigned int)(fSize * 4.0f + 0.5f);
+	key.dwStyle = dwStyle;
+	key.iAlign = iAlign;
+	// Width only matters to texts that overflow it
+	key.iOverflow = fMaxWidth > 0.0f ? iOverflow : GLYPH_OVERFLOW_NONE;
+	key.iMaxWidth = key.iOverflow != GLYPH_OVERFLOW_NONE ? (unsigned int)(fMaxWidth * 4.0f + 0.5f) : 0;
+	key.pText = &strText;
+
+	MAPLAYOUTS::iterator it = m_layouts.find(key);
+	if (it != m_layouts.end())
+	{
+		Entry& entry = it->second;
+		m_lru.splice(m_lru.begin(), m_lru, entry.lru);
+
+		if (entry.layout.iGeneration == m_glyphs.GetGeneration())
+		{
+			m_iHits++;
+			SetRef(pRef, entry);
+			return &entry.layout;
+		}
+
+		m_iStale++;
+		if (!m_glyphs.Layout(iFace, fSize, dwStyle, iAlign, fMaxWidth, key.iOverflow, strText, entry.layout))
+		{
+			// Half laid out, it mustn't pass for current
+			m_lru.erase(entry.lru);
+			m_layouts.erase(it);
+			m_iEpoch++;
+			return NULL;
+		}
+
+		SetRef(pRef, entry);
+		return &entry.layout;
+	}
+
+	m_iMisses++;
+
+	TextLayout layout;
+	if (!m_glyphs.Layout(iFace, fSize, dwStyle, iAlign, fMaxWidth, key.iOverflow, strText, layout))
+		return NULL;
+
+	if (m_layouts.size() >= m_iMaxEntries && !m_lru.empty())
+	{
+		m_layouts.erase(*m_lru.back());
+		m_lru.pop_back();
+		m_iEvictions++;
+		m_iEpoch++;
+	}
+
+	// Only a stored key owns its text
+	key.strText = strText;
+	key.pText = NULL;
+	it = m_layouts.insert(MAPLAYOUTS::value_type(key, Entry())).first;
+	it->second.layout.quads.swap(layout.quads);
+	it->second.layout.lineWidths.swap(layout.lineWidths);
+	it->second.layout.fWidth = layout.fWidth;
+	it->second.layout.fHeight = layout.fHeight;
+	it->second.layout.bTruncated = layout.bTruncated;
+	it->second.layout.iGeneration = layout.iGeneration;
+
+	m_lru.push_front(&it->first);
+	it->second.lru = m_lru.begin();
+
+	SetRef(pRef, it->second);
+	return &it->second.layout;
+}
+
+void CTextLayoutCache::SetRef(Ref* pRef, Entry& entry)
+{
+	if (pRef)
+	{
+		pRef->pEntry = &entry;
+		pRef->iEpoch = m_iEpoch;
+	}
+}
+
+void CTextLayoutCache::Clear()
+{
+	m_layouts.clear();
+	m_lru.clear();
+	m_iEpoch++;
+}
+
+void CTextLayoutCache::GetStats(TextLayoutStats& stats) const
+{
+	stats.iEntries = m_layouts.size();
+	stats.iHits = m_iHits;
+	stats.iMisses = m_iMisses;
+	stats.iStale = m_iStale;
+	stats.iEvictions = m_iEvictions;
+}
@@ -0,0 +1,100 @@
+#ifndef GUILIB_TEXTLAYOUTCACHE_H
+#define GUILIB_TEXTLAYOUTCACHE_H
+
+// Kept free of Xbox headers, tools/FontPreview builds it on Linux
+
+#include "GlyphCache.h"
+
+#include <list>
+#include <map>
+#include <string>
+
+// Distinct texts kept laid out, the least recently drawn one goes first
+#define TEXTLAYOUTCACHE_MAX_ENTRIES 512
+
+struct TextLayoutStats
+{
+	unsigned int iEntries;
+	unsigned int iHits;
+	unsigned int iMisses;      // texts laid out for the first time
+	unsigned int iStale;       // laid out again because the glyph page was emptied
+	unsigned int iEvictions;
+};
+
+/*!
+ \brief Remembers how texts were laid out, so drawing a label that didn't
+ change since the last frame is a lookup.
+
+ Entries are keyed by everything that affects the layout: font, size,
+ style, alignment, width, overflow and the text itself. A changed text or
+ font simply is a different key. Layouts point into the glyph page, they
+ are laid out again when the page was emptied since.
+ */
+class CTextLayoutCache
+{
+	struct Entry;
+
+public:
+	// Kept by a label between frames, it gets its layout back without a lookup
+	struct Ref
+	{
+		Ref() { pEntry = NULL; iEpoch = 0; }
+
+		Entry* pEntry;
+		unsigned int iEpoch;
+	};
+
+	CTextLayoutCache(CGlyphCache& glyphs, unsigned int iMaxEntries = TEXTLAYOUTCACHE_MAX_ENTRIES);
+	virtual ~CTextLayoutCache(void);
+
+	// NULL when the glyph page ran full, see CGlyphCache::Layout(). pRef is set to the layout returned.
+	const TextLayout* Get(int iFace, float fSize, unsigned int dwStyle, int iAlign, float fMaxWidth, int iOverflow,
+	                      const std::wstring& strText, Ref* pRef = NULL);
+
+	// The layout ref was set to, NULL when it was dropped or the glyph page was emptied since
+	const TextLayout* Get(Ref& ref);
+
+	void Clear();
+
+	void GetStats(TextLayoutStats& stats) const;
+
+private:
+	struct Key
+	{
+		int iFace;
+		unsigned int iSize;        // quarter pixels
+		unsigned int dwStyle;
+		int iAlign;
+		int iOverflow;
+		unsigned int iMaxWidth;    // quarter pixels
+		std::wstring strText;
+		const std::wstring* pText; // the caller's text while looking up, strText once stored
+
+		const std::wstring& GetText() const { return pText ? *pText : strText; }
+		bool operator<(const Key& right) const;
+	};
+
+	struct Entry
+	{
+		TextLayout layout;
+		std::list<const Key*>::iterator lru;
+	};
+
+	typedef std::map<Key, Entry> MAPLAYOUTS;
+
+	void SetRef(Ref* pRef, Entry& entry);
+
+	CGlyphCache& m_glyphs;
+	unsigned int m_iMaxEntries;
+
+	MAPLAYOUTS m_layouts;
+	std::list<const Key*> m_lru;    // most recently drawn first, keys live in m_layouts
+	unsigned int m_iEpoch;          // changes whenever an entry is dropped, refs of an older epoch are looked up again
+
+	unsigned int m_iHits;
+	unsigned int m_iMisses;
+	unsigned int m_iStale;
+	unsigned int m_iEvictions;
+};
+
+#endif //GUILIB_TEXTLAYOUTCACHE_H
@@ -0,0 +1,312 @@
+#include "TextureBundle.h"
+#include "GraphicContext.h"
+#include "..\utils\Log.h"
+#include "..\utils\SingleLock.h"
+
+#include <xgraphics.h>
+
+// Bytes per row of linear data and the number of rows, DXT rows are 4 texels high
+static void GetRowLayout(const TextureBundleEntry& entry, DWORD& dwRowSize, DWORD& dwRows)
+{
+	switch (entry.dwFormat)
+	{
+		case TEXTUREBUNDLE_FMT_DXT1:
+			dwRowSize = ((entry.dwWidth + 3) / 4) * 8;
+			dwRows = (entry.dwHeight + 3) / 4;
+			break;
+		case TEXTUREBUNDLE_FMT_DXT5:
+			dwRowSize = ((entry.dwWidth + 3) / 4) * 16;
+			dwRows = (entry.dwHeight + 3) / 4;
+			break;
+		default:
+			dwRowSize = entry.dwWidth * 4;
+			dwRows = entry.dwHeight;
+			break;
+	}
+}
+
+CTextureBundle::CTextureBundle(void)
+{
+	m_fd = NULL;
+}
+
+CTextureBundle::~CTextureBundle(void)
+{
+	Close();
+}
+
+bool CTextureBundle::Open(const CStdString& strPath)
+{
+	Close();
+
+	CSingleLock lock(m_critSection);
+
+	FILE* fd = fopen(strPath.c_str(), "rb");
+	if (!fd)
+		return false;
+
+	fseek(fd, 0, SEEK_END);
+	DWORD dwFileSize = ftell(fd);
+	fseek(fd, 0, SEEK_SET);
+
+	TextureBundleHeader header;
+	if (fread(&header, sizeof(header), 1, fd) != 1 ||
+	    header.dwMagic != TEXTUREBUNDLE_MAGIC || header.dwVersion != TEXTUREBUNDLE_VERSION ||
+	    header.dwDataOffset < sizeof(header) + header.dwCount * sizeof(TextureBundleEntry) ||
+	    header.dwDataOffset > dwFileSize)
+	{
+		CLog::Log(LOGWARNING, "CTextureBundle: %s is not a valid texture bundle", strPath.c_str());
+		fclose(fd);
+		return false;
+	}
+
+	std::vector<TextureBundleEntry> entries(header.dwCount);
+	if (header.dwCount && fread(&entries[0], sizeof(TextureBundleEntry), header.dwCount, fd) != header.dwCount)
+	{
+		CLog::Log(LOGWARNING, "CTextureBundle: %s is truncated", strPath.c_str());
+		fclose(fd);
+		return false;
+	}
+
+	for (DWORD i = 0; i < header.dwCount; i++)
+	{
+		TextureBundleEntry& entry = entries[i];
+		entry.szName[TEXTUREBUNDLE_NAMESIZE - 1] = '\0';
+		m_names.push_back(entry.szName);
+
+		if (entry.dwFlags & TEXTUREBUNDLE_FLAG_ATLAS)
+		{
+			if (entry.dwPage >= header.dwCount || (entries[entry.dwPage].dwFlags & TEXTUREBUNDLE_FLAG_ATLAS) ||
+			    entry.dwX + entry.dwWidth > entries[entry.dwPage].dwWidth ||
+			    entry.dwY + entry.dwHeight > entries[entry.dwPage].dwHeight)
+			{
+				CLog::Log(LOGWARNING, "CTextureBundle: skipping broken atlas image %s in %s", entry.szName, strPath.c_str());
+				continue;
+			}
+
+			m_entries[entry.szName] = entry;
+			continue;
+		}
+
+		DWORD dwRowSize, dwRows;
+		GetRowLayout(entry, dwRowSize, dwRows);
+
+		if (entry.dwWidth == 0 || entry.dwHeight == 0 || entry.dwOffset < header.dwDataOffset ||
+		    entry.dwOffset + entry.dwSize > dwFileSize || entry.dwSize < dwRowSize * dwRows)
+		{
+			CLog::Log(LOGWARNING, "CTextureBundle: skipping broken entry %s in %s", entry.szName, strPath.c_str());
+			continue;
+		}
+
+		m_entries[entry.szName] = entry;
+	}
+
+	m_fd = fd;
+	m_strPath = strPath;
+
+	CLog::Log(LOGNOTICE, "CTextureBundle: opened %s with %u texture(s)", strPath.c_str(), (unsigned int)m_entries.size());
+
+	return true;
+}
+
+void CTextureBundle::Close()
+{
+	CSingleLock lock(m_critSection);
+
+	if (m_fd)
+		fclose(m_fd);
+	m_fd = NULL;
+
+	m_entries.clear();
+	m_names.clear();
+	m_strPath.Empty();
+}
+
+bool CTextureBundle::IsOpen()
+{
+	CSingleLock lock(m_critSection);
+	return m_fd != NULL;
+}
+
+bool CTextureBundle::HasFile(const CStdString& strName)
+{
+	TextureBundleEntry entry;
+	return Find(strName, entry);
+}
+
+bool CTextureBundle::GetAtlasImage(const CStdString& strName, CStdString& strPage, FRECT& uv)
+{
+	CSingleLock lock(m_critSection);
+
+	TextureBundleEntry entry;
+	if (!Find(strName, entry) || !(entry.dwFlags & TEXTUREBUNDLE_FLAG_ATLAS))
+		return false;
+
+	TextureBundleEntry page;
+	if (!Find(m_names[entry.dwPage], page))
+		return false;
+
+	strPage = page.szName;
+	uv.left = (float)entry.dwX / page.dwWidth;
+	uv.top = (float)entry.dwY / page.dwHeight;
+	uv.right = (float)(entry.dwX + entry.dwWidth) / page.dwWidth;
+	uv.bottom = (float)(entry.dwY + entry.dwHeight) / page.dwHeight;
+
+	return true;
+}
+
+bool CTextureBundle::ReadTexture(const CStdString& strName, TextureBundleEntry& entry, BYTE** ppData)
+{
+	*ppData = NULL;
+
+	CSingleLock lock(m_critSection);
+
+	// Atlas images have no data, their page is loaded instead
+	if (!Find(strName, entry) || (entry.dwFlags & TEXTUREBUNDLE_FLAG_ATLAS))
+		return false;
+
+	BYTE* pData = new BYTE[entry.dwSize];
+	if (fseek(m_fd, entry.dwOffset, SEEK_SET) != 0 || fread(pData, entry.dwSize, 1, m_fd) != 1)
+	{
+		CLog::Log(LOGWARNING, "CTextureBundle: failed reading %s from %s", entry.szName, m_strPath.c_str());
+		delete[] pData;
+		return false;
+	}
+
+	*ppData = pData;
+	return true;
+}
+
+bool CTextureBundle::CreateTexture(const TextureBundleEntry& entry, const BYTE* pData, LPDIRECT3DTEXTURE9* ppTexture)
+{
+	D3DLOCKED_RECT lr;
+	if (!AllocTexture(entry, ppTexture, lr))
+		return false;
+
+	if (entry.dwFlags & TEXTUREBUNDLE_FLAG_TILED)
+	{
+		memcpy(lr.pBits, pData, entry.dwSize);
+	}
+	else
+	{
+		DWORD dwRowSize, dwRows;
+		GetRowLayout(entry, dwRowSize, dwRows);
+
+		for (DWORD y = 0; y < dwRows; y++)
+			memcpy((BYTE*)lr.pBits + y * lr.Pitch, pData + y * dwRowSize, dwRowSize);
+	}
+
+	(*ppTexture)->UnlockRect(0);
+
+	return true;
+}
+
+bool CTextureBundle::LoadTexture(const CStdString& strName, LPDIRECT3DTEXTURE9* ppTexture, D3DXIMAGE_INFO& info)
+{
+	TextureBundleEntry entry;
+	if (!Find(strName, entry) || (entry.dwFlags & TEXTUREBUNDLE_FLAG_ATLAS))
+		return false;
+
+	if (!(entry.dwFlags & TEXTUREBUNDLE_FLAG_TILED))
+	{
+		// Linear rows need the texture's pitch, read them in one go and copy
+		BYTE* pData = NULL;
+		if (!ReadTexture(strName, entry, &pData))
+			return false;
+
+		bool bResult = CreateTexture(entry, pData, ppTexture);
+		delete[] pData;
+
+		info.Width = entry.dwWidth;
+		info.Height = entry.dwHeight;
+		return bResult;
+	}
+
+	D3DLOCKED_RECT lr;
+	if (!AllocTexture(entry, ppTexture, lr))
+		return false;
+
+	bool bResult;
+	{
+		CSingleLock lock(m_critSection);
+		bResult = m_fd && fseek(m_fd, entry.dwOffset, SEEK_SET) == 0 && fread(lr.pBits, entry.dwSize, 1, m_fd) == 1;
+	}
+
+	(*ppTexture)->UnlockRect(0);
+
+	if (!bResult)
+	{
+		CLog::Log(LOGWARNING, "CTextureBundle: failed reading %s from %s", entry.szName, m_strPath.c_str());
+		(*ppTexture)->Release();
+		*ppTexture = NULL;
+		return false;
+	}
+
+	info.Width = entry.dwWidth;
+	info.Height = entry.dwHeight;
+
+	return true;
+}
+
+bool CTextureBundle::Find(const CStdString& strName, TextureBundleEntry& entry)
+{
+	CSingleLock lock(m_critSection);
+
+	if (!m_fd)
+		return false;
+
+	std::map<CStdString, TextureBundleEntry>::iterator it = m_entries.find(Normalize(strName));
+	if (it == m_entries.end())
+		return false;
+
+	entry = it->second;
+	return true;
+}
+
+bool CTextureBundle::AllocTexture(const TextureBundleEntry& entry, LPDIRECT3DTEXTURE9* ppTexture, D3DLOCKED_RECT& lr)
+{
+	bool bTiled = (entry.dwFlags & TEXTUREBUNDLE_FLAG_TILED) != 0;
+
+	D3DFORMAT format;
+	switch (entry.dwFormat)
+	{
+		case TEXTUREBUNDLE_FMT_DXT1: format = bTiled ? D3DFMT_DXT1 : D3DFMT_LIN_DXT1; break;
+		case TEXTUREBUNDLE_FMT_DXT5: format = bTiled ? D3DFMT_DXT5 : D3DFMT_LIN_DXT5; break;
+		default:                     format = bTiled ? D3DFMT_A8R8G8B8 : D3DFMT_LIN_A8R8G8B8; break;
+	}
+
+	// One level, the GUI draws textures at their own size
+	if (g_graphicsContext.Get3DDevice()->CreateTexture(entry.dwWidth, entry.dwHeight, 1, 0, format, D3DPOOL_MANAGED, ppTexture, NULL) != D3D_OK)
+		return false;
+
+	if (bTiled)
+	{
+		// The packer only tiles textures whose layout it knows, make sure the GPU agrees
+		XGTEXTURE_DESC desc;
+		XGGetTextureDesc(*ppTexture, 0, &desc);
+		if (desc.SlicePitch != entry.dwSize)
+		{
+			CLog::Log(LOGWARNING, "CTextureBundle: %s is %u bytes, the texture needs %u", entry.szName, entry.dwSize, desc.SlicePitch);
+			(*ppTexture)->Release();
+			*ppTexture = NULL;
+			return false;
+		}
+	}
+
+	if ((*ppTexture)->LockRect(0, &lr, NULL, 0) != D3D_OK)
+	{
+		(*ppTexture)->Release();
+		*ppTexture = NULL;
+		return false;
+	}
+
+	return true;
+}
+
+CStdString CTextureBundle::Normalize(const CStdString& strName)
+{
+	CStdString strNormalized = strName;
+	strNormalized.ToLower();
+	strNormalized.Replace('/', '\\');
+	return strNormalized;
+}
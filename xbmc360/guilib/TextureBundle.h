@@ -0,0 +1,97 @@
+#ifndef GUILIB_TEXTUREBUNDLE_H
+#define GUILIB_TEXTUREBUNDLE_H
+
+#include "..\utils\Stdafx.h"
+#include "..\utils\StdString.h"
+#include "..\utils\CriticalSection.h"
+#include "GUITexture.h"
+
+#include <stdio.h>
+#include <map>
+#include <vector>
+
+// Skin textures packed by tools/TexturePacker, looked for in the skin's media folder.
+// The layout is big endian and has to match the packer.
+#define TEXTUREBUNDLE_FILE      "Textures.xbt"
+#define TEXTUREBUNDLE_MAGIC     0x58425458 // 'XBTX'
+#define TEXTUREBUNDLE_VERSION   2
+#define TEXTUREBUNDLE_NAMESIZE  64
+#define TEXTUREBUNDLE_ALIGN     4096       // texture data starts on page boundaries
+
+// Texel formats, the data is already in GPU byte order
+#define TEXTUREBUNDLE_FMT_ARGB  0          // 32 bit A8R8G8B8
+#define TEXTUREBUNDLE_FMT_DXT1  1
+#define TEXTUREBUNDLE_FMT_DXT5  2
+
+// Data is tiled the way the GPU reads it, otherwise rows are stored linear
+#define TEXTUREBUNDLE_FLAG_TILED 0x00000001
+// No data of its own, the image is the dwWidth x dwHeight rectangle at dwX,dwY of entry dwPage
+#define TEXTUREBUNDLE_FLAG_ATLAS 0x00000002
+
+// Start of the file, followed by dwCount entries sorted by name
+struct TextureBundleHeader
+{
+	DWORD dwMagic;
+	DWORD dwVersion;
+	DWORD dwCount;
+	DWORD dwDataOffset; // first texture, the index fits before it
+};
+
+struct TextureBundleEntry
+{
+	char szName[TEXTUREBUNDLE_NAMESIZE]; // relative to the media folder, lower case with '\\'
+	DWORD dwFormat;
+	DWORD dwFlags;
+	DWORD dwWidth;
+	DWORD dwHeight;
+	DWORD dwOffset;                      // from the start of the file, TEXTUREBUNDLE_ALIGN aligned
+	DWORD dwSize;
+	DWORD dwPage;                        // atlas images only, index of the page entry
+	DWORD dwX;
+	DWORD dwY;
+};
+
+/*!
+ \brief Reads textures from a packed skin bundle.
+
+ Textures in the bundle are stored in the layout the GPU uses, so loading
+ one is a read into the locked texture without any decoding.
+ */
+class CTextureBundle
+{
+public:
+	CTextureBundle(void);
+	virtual ~CTextureBundle(void);
+
+	bool Open(const CStdString& strPath);
+	void Close();
+	bool IsOpen();
+
+	bool HasFile(const CStdString& strName);
+
+	// Small images are packed into shared pages, returns the page and the image's part of it
+	bool GetAtlasImage(const CStdString& strName, CStdString& strPage, FRECT& uv);
+
+	// Reads the data of a texture, ppData is allocated with new[]. Doesn't need the device.
+	bool ReadTexture(const CStdString& strName, TextureBundleEntry& entry, BYTE** ppData);
+
+	// Creates a texture from data returned by ReadTexture()
+	static bool CreateTexture(const TextureBundleEntry& entry, const BYTE* pData, LPDIRECT3DTEXTURE9* ppTexture);
+
+	// Reads tiled data straight into the texture
+	bool LoadTexture(const CStdString& strName, LPDIRECT3DTEXTURE9* ppTexture, D3DXIMAGE_INFO& info);
+
+private:
+	bool Find(const CStdString& strName, TextureBundleEntry& entry);
+	static bool AllocTexture(const TextureBundleEntry& entry, LPDIRECT3DTEXTURE9* ppTexture, D3DLOCKED_RECT& lr);
+	static CStdString Normalize(const CStdString& strName);
+
+	std::map<CStdString, TextureBundleEntry> m_entries;
+	std::vector<CStdString> m_names;     // in file order, atlas images refer to pages by index
+	CStdString m_strPath;
+	FILE* m_fd;
+
+	CCriticalSection m_critSection;
+};
+
+#endif //GUILIB_TEXTUREBUNDLE_H
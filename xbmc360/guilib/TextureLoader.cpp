@@ -0,0 +1,360 @@
+#include "TextureLoader.h"
+#include "..\ThumbnailCache.h"
+#include "..\utils\SingleLock.h"
+#include "..\utils\Log.h"
+
+#include <xgraphics.h>
+#include <stdio.h>
+
+TextureLoadJob::TextureLoadJob()
+{
+	priority = TEXTURE_PRIORITY_PRELOAD;
+	bSuccess = false;
+	bThumb = false;
+	bDecoded = false;
+	bBundle = false;
+	memset(&entry, 0, sizeof(entry));
+	pData = NULL;
+	dwSize = 0;
+	iWidth = 0;
+	iHeight = 0;
+	iPitch = 0;
+	dwQueued = 0;
+	dwReadTime = 0;
+}
+
+TextureLoadJob::~TextureLoadJob()
+{
+	delete[] pData;
+}
+
+// class CGUITextureLoader
+CGUITextureLoader::CGUITextureLoader()
+{
+	m_pBundle = NULL;
+	m_iRead = 0;
+	m_iFailed = 0;
+	m_iCancelled = 0;
+	m_iTotalReadTime = 0;
+	m_iTotalWaitTime = 0;
+}
+
+CGUITextureLoader::~CGUITextureLoader()
+{
+	Stop();
+}
+
+void CGUITextureLoader::Start()
+{
+	if (m_ThreadHandle != NULL)
+		return;
+
+	Create();
+}
+
+void CGUITextureLoader::Stop()
+{
+	StopThread();
+
+	CSingleLock lock(m_critSection);
+
+	m_iCancelled += m_visible.size() + m_preload.size();
+
+	for (unsigned int i = 0; i < m_visible.size(); i++)
+		delete m_visible[i];
+	for (unsigned int i = 0; i < m_preload.size(); i++)
+		delete m_preload[i];
+	for (unsigned int i = 0; i < m_done.size(); i++)
+		delete m_done[i];
+
+	m_visible.clear();
+	m_preload.clear();
+	m_done.clear();
+}
+
+void CGUITextureLoader::SetBundle(CTextureBundle* pBundle)
+{
+	CSingleLock lock(m_critSection);
+	m_pBundle = pBundle;
+}
+
+void CGUITextureLoader::Request(const CStdString& strName, const CStdString& strPath, TexturePriority priority)
+{
+	CSingleLock lock(m_critSection);
+
+	// Already being read or waiting for upload
+	if (m_strActive == strName || Find(m_done, strName, false) || Find(m_visible, strName, false))
+		return;
+
+	TextureLoadJob* pJob = Find(m_preload, strName, priority == TEXTURE_PRIORITY_VISIBLE);
+	if (pJob)
+	{
+		// Now on screen, it goes before everything that isn't
+		if (priority == TEXTURE_PRIORITY_VISIBLE)
+		{
+			pJob->priority = priority;
+			m_visible.push_back(pJob);
+		}
+		return;
+	}
+
+	pJob = new TextureLoadJob;
+	pJob->strName = strName;
+	pJob->strPath = strPath;
+	pJob->priority = priority;
+	pJob->dwQueued = GetTickCount();
+
+	if (priority == TEXTURE_PRIORITY_VISIBLE)
+		m_visible.push_back(pJob);
+	else
+		m_preload.push_back(pJob);
+
+	m_jobEvent.Set();
+}
+
+void CGUITextureLoader::Prioritize(const CStdString& strName)
+{
+	CSingleLock lock(m_critSection);
+
+	TextureLoadJob* pJob = Find(m_preload, strName, true);
+	if (!pJob)
+		return;
+
+	pJob->priority = TEXTURE_PRIORITY_VISIBLE;
+	m_visible.push_back(pJob);
+}
+
+void CGUITextureLoader::Cancel(const CStdString& strName)
+{
+	CSingleLock lock(m_critSection);
+
+	// A file that is being read is dropped by the texture manager once it's done
+	TextureLoadJob* pJob = Find(m_visible, strName, true);
+	if (!pJob) pJob = Find(m_preload, strName, true);
+	if (!pJob) pJob = Find(m_done, strName, true);
+
+	if (pJob)
+	{
+		m_iCancelled++;
+		delete pJob;
+	}
+}
+
+TextureLoadJob* CGUITextureLoader::GetResult()
+{
+	CSingleLock lock(m_critSection);
+
+	if (m_done.empty())
+		return NULL;
+
+	TextureLoadJob* pJob = m_done.front();
+	m_done.pop_front();
+
+	// The worker may be waiting for room
+	if (m_done.size() == TEXTURELOADER_MAX_DONE - 1)
+		m_jobEvent.Set();
+
+	return pJob;
+}
+
+unsigned int CGUITextureLoader::GetQueued()
+{
+	CSingleLock lock(m_critSection);
+	return m_visible.size() + m_preload.size() + m_done.size() + (m_strActive.IsEmpty() ? 0 : 1);
+}
+
+void CGUITextureLoader::OnStartup()
+{
+	// Below the render thread, but visible textures shouldn't lag too far behind
+	SetPriority(THREAD_PRIORITY_BELOW_NORMAL);
+	SetName("CGUITextureLoader");
+}
+
+void CGUITextureLoader::Process()
+{
+	while (!m_bStop)
+	{
+		TextureLoadJob* pJob = GetNextJob();
+		if (!pJob)
+		{
+			m_jobEvent.WaitMSec(500);
+			continue;
+		}
+
+		DWORD dwStart = GetTickCount();
+		Read(pJob);
+		pJob->dwReadTime = GetTickCount() - dwStart;
+
+		JobDone(pJob);
+	}
+}
+
+void CGUITextureLoader::OnExit()
+{
+	unsigned int iTotal = m_iRead + m_iFailed;
+
+	CLog::Log(LOGNOTICE, "CGUITextureLoader: read %u texture(s) (%u failed, %u cancelled), avg %u ms reading, %u ms queued",
+		iTotal, m_iFailed, m_iCancelled,
+		iTotal ? (unsigned int)(m_iTotalReadTime / iTotal) : 0,
+		iTotal ? (unsigned int)(m_iTotalWaitTime / iTotal) : 0);
+}
+
+TextureLoadJob* CGUITextureLoader::GetNextJob()
+{
+	CSingleLock lock(m_critSection);
+
+	// Don't read further ahead than the uploads can keep up with
+	if (m_done.size() >= TEXTURELOADER_MAX_DONE)
+		return NULL;
+
+	TextureLoadJob* pJob = NULL;
+	if (!m_visible.empty())
+	{
+		pJob = m_visible.front();
+		m_visible.pop_front();
+	}
+	else if (!m_preload.empty())
+	{
+		pJob = m_preload.front();
+		m_preload.pop_front();
+	}
+
+	if (pJob)
+		m_strActive = pJob->strName;
+
+	return pJob;
+}
+
+void CGUITextureLoader::JobDone(TextureLoadJob* pJob)
+{
+	CSingleLock lock(m_critSection);
+
+	m_strActive.Empty();
+
+	if (pJob->bSuccess) m_iRead++;
+	else m_iFailed++;
+
+	m_iTotalReadTime += pJob->dwReadTime;
+	m_iTotalWaitTime += GetTickCount() - pJob->dwQueued - pJob->dwReadTime;
+
+	// Failed jobs are handed on too, so the texture stops waiting for them
+	m_done.push_back(pJob);
+}
+
+void CGUITextureLoader::Read(TextureLoadJob* pJob)
+{
+	CTextureBundle* pBundle;
+	{
+		CSingleLock lock(m_critSection);
+		pBundle = m_pBundle;
+	}
+
+	// Bundle data is ready for the GPU, nothing to decode
+	if (pBundle && pBundle->ReadTexture(pJob->strName, pJob->entry, &pJob->pData))
+	{
+		pJob->bBundle = true;
+		pJob->dwSize = pJob->entry.dwSize;
+		pJob->iWidth = pJob->entry.dwWidth;
+		pJob->iHeight = pJob->entry.dwHeight;
+		pJob->bSuccess = true;
+		return;
+	}
+
+	if (CThumbnailCache::IsThumbFile(pJob->strPath))
+	{
+		// Cached thumbs are raw pixels, only the copy into the texture is left
+		pJob->bThumb = true;
+		pJob->bSuccess = CThumbnailCache::Read(pJob->strPath, &pJob->pData, pJob->iWidth, pJob->iHeight, pJob->iPitch);
+		return;
+	}
+
+	FILE* fd = fopen(pJob->strPath.c_str(), "rb");
+	if (!fd)
+		return;
+
+	fseek(fd, 0, SEEK_END);
+	long lSize = ftell(fd);
+	fseek(fd, 0, SEEK_SET);
+
+	if (lSize <= 0)
+	{
+		fclose(fd);
+		return;
+	}
+
+	pJob->pData = new BYTE[lSize];
+	pJob->dwSize = lSize;
+	if (fread(pJob->pData, lSize, 1, fd) != 1)
+	{
+		fclose(fd);
+		return;
+	}
+	fclose(fd);
+
+	// Parsing the header doesn't need the device, so broken files are caught here
+	D3DXIMAGE_INFO info;
+	if (D3DXGetImageInfoFromFileInMemory(pJob->pData, pJob->dwSize, &info) != D3D_OK)
+		return;
+
+	pJob->iWidth = info.Width;
+	pJob->iHeight = info.Height;
+	pJob->bSuccess = true;
+
+	// DDS files are already in a texture format, they're only copied
+	if (info.ImageFileFormat != D3DXIFF_DDS)
+		Decode(pJob);
+}
+
+// Decodes the file read into pJob->pData to pixels, so that creating the
+// texture is no more than a copy like it is for thumbs. The image keeps
+// its file data for the render thread if it can't be decoded here.
+bool CGUITextureLoader::Decode(TextureLoadJob* pJob)
+{
+	// A texture header over plain memory, D3DX decodes into it without the device
+	D3DTexture header;
+	UINT iBaseSize, iMipSize;
+	XGSetTextureHeader(pJob->iWidth, pJob->iHeight, 1, 0, D3DFMT_LIN_A8R8G8B8, 0, 0, XGHEADER_CONTIGUOUS_MIP_OFFSET, 0,
+		&header, &iBaseSize, &iMipSize);
+
+	BYTE* pPixels = new BYTE[iBaseSize];
+	XGOffsetResourceAddress(&header, pPixels);
+
+	LPDIRECT3DSURFACE9 pSurface = NULL;
+	bool bResult = header.GetSurfaceLevel(0, &pSurface) == D3D_OK &&
+		D3DXLoadSurfaceFromFileInMemory(pSurface, NULL, NULL, pJob->pData, pJob->dwSize, NULL, D3DX_DEFAULT, 0, NULL) == D3D_OK;
+
+	if (pSurface)
+		pSurface->Release();
+
+	D3DLOCKED_RECT lr;
+	if (!bResult || header.LockRect(0, &lr, NULL, D3DLOCK_READONLY) != D3D_OK)
+	{
+		CLog::Log(LOGDEBUG, "CGUITextureLoader: %s is decoded on the render thread", pJob->strPath.c_str());
+		delete[] pPixels;
+		return false;
+	}
+
+	pJob->iPitch = lr.Pitch;
+	header.UnlockRect(0);
+
+	delete[] pJob->pData;
+	pJob->pData = pPixels;
+	pJob->dwSize = iBaseSize;
+	pJob->bDecoded = true;
+	return true;
+}
+
+TextureLoadJob* CGUITextureLoader::Find(std::deque<TextureLoadJob*>& queue, const CStdString& strName, bool bRemove)
+{
+	for (std::deque<TextureLoadJob*>::iterator it = queue.begin(); it != queue.end(); ++it)
+	{
+		TextureLoadJob* pJob = *it;
+		if (pJob->strName == strName)
+		{
+			if (bRemove)
+				queue.erase(it);
+			return pJob;
+		}
+	}
+	return NULL;
+}
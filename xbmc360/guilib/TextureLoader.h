@@ -0,0 +1,104 @@
+#ifndef GUILIB_TEXTURELOADER_H
+#define GUILIB_TEXTURELOADER_H
+
+#include "..\utils\Stdafx.h"
+#include "..\utils\Thread.h"
+#include "..\utils\CriticalSection.h"
+#include "..\utils\StdString.h"
+#include "TextureBundle.h"
+
+#include <deque>
+
+// Finished jobs waiting for upload, the worker waits when the render thread falls behind
+#define TEXTURELOADER_MAX_DONE 8
+
+enum TexturePriority
+{
+	TEXTURE_PRIORITY_PRELOAD = 0, // textures of controls that aren't shown yet
+	TEXTURE_PRIORITY_VISIBLE      // textures of controls currently on screen
+};
+
+struct TextureLoadJob
+{
+	TextureLoadJob();
+	~TextureLoadJob();
+
+	CStdString strName;         // name the texture manager knows the texture by
+	CStdString strPath;
+	TexturePriority priority;
+
+	bool bSuccess;
+	bool bThumb;                // pData holds decoded pixels of a cached thumb
+	bool bDecoded;              // pData holds the file decoded to A8R8G8B8 pixels
+	bool bBundle;               // pData holds texture data from the skin bundle
+	TextureBundleEntry entry;   // bundle textures only
+	BYTE* pData;                // file contents, thumb pixels or bundle data
+	DWORD dwSize;
+	int iWidth;
+	int iHeight;
+	int iPitch;                 // thumbs and decoded files only
+
+	DWORD dwQueued;             // tick count when requested
+	DWORD dwReadTime;           // ms spent on the worker
+};
+
+/*!
+ \brief Reads texture files off the render thread.
+
+ The worker reads the file and decodes what can be decoded without the
+ device, the texture manager creates the textures from the finished jobs
+ in a bounded slice of each frame. Visible textures are always read before
+ preloaded ones.
+ */
+class CGUITextureLoader : public CThread
+{
+public:
+	CGUITextureLoader();
+	virtual ~CGUITextureLoader();
+
+	void Start();
+	void Stop();
+
+	// Textures found in the bundle are read from it instead of their files
+	void SetBundle(CTextureBundle* pBundle);
+
+	// A second request for a queued texture only raises its priority
+	void Request(const CStdString& strName, const CStdString& strPath, TexturePriority priority);
+	void Prioritize(const CStdString& strName);
+	void Cancel(const CStdString& strName);
+
+	// Oldest finished job or NULL, the caller deletes it
+	TextureLoadJob* GetResult();
+
+	unsigned int GetQueued();
+
+protected:
+	virtual void OnStartup();
+	virtual void Process();
+	virtual void OnExit();
+
+private:
+	TextureLoadJob* GetNextJob();
+	void JobDone(TextureLoadJob* pJob);
+	void Read(TextureLoadJob* pJob);
+	bool Decode(TextureLoadJob* pJob);
+
+	static TextureLoadJob* Find(std::deque<TextureLoadJob*>& queue, const CStdString& strName, bool bRemove);
+
+	std::deque<TextureLoadJob*> m_visible;
+	std::deque<TextureLoadJob*> m_preload;
+	std::deque<TextureLoadJob*> m_done;
+	CStdString m_strActive;
+	CTextureBundle* m_pBundle;
+
+	CCriticalSection m_critSection;
+	CEvent m_jobEvent;
+
+	unsigned int m_iRead;
+	unsigned int m_iFailed;
+	unsigned int m_iCancelled;
+	unsigned __int64 m_iTotalReadTime;
+	unsigned __int64 m_iTotalWaitTime;
+};
+
+#endif //GUILIB_TEXTURELOADER_H
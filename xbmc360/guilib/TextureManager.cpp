@@ -22,12 +22,18 @@
 #include "GraphicContext.h"
 #include "..\utils\Log.h"
 #include "..\utils\SingleLock.h"
+#include "..\utils\Fnv.h"
+#include "..\ThumbnailCache.h"
+
+#include <xgraphics.h>
 
 CGUITextureManager g_TextureManager;
 
 CTexture::CTexture()
 {
 	m_iWidth = m_iHeight=0;
+	m_pTexture = NULL;
+	m_iMemoryUsage = 0;
 }
 
 CTexture::CTexture(LPDIRECT3DTEXTURE9 pTexture,int iWidth, int iHeight)
@@ -36,6 +42,18 @@ CTexture::CTexture(LPDIRECT3DTEXTURE9 pTexture,int iWidth, int iHeight)
 	m_iHeight = iHeight;
 
 	m_pTexture = pTexture;
+
+	// Add up all mip levels
+	m_iMemoryUsage = 0;
+	if (m_pTexture)
+	{
+		for (DWORD i = 0; i < m_pTexture->GetLevelCount(); i++)
+		{
+			D3DSURFACE_DESC desc;
+			if (m_pTexture->GetLevelDesc(i, &desc) == D3D_OK)
+				m_iMemoryUsage += desc.Width * desc.Height * XGBitsPerPixelFromFormat(desc.Format) / 8;
+		}
+	}
 }
 
 CTexture::~CTexture()
@@ -58,6 +76,7 @@ void CTexture::FreeTexture()
 	if (m_pTexture)
 		m_pTexture->Release();
 	m_pTexture=NULL;
+	m_iMemoryUsage = 0;
 }
 
 void CTexture::Flush()
@@ -71,11 +90,21 @@ void CTexture::Flush()
 CTextureMap::CTextureMap()
 {
 	m_strTextureName = "";
+	m_iReferenceCount = 0;
+	m_bPending = false;
+	m_pAtlas = NULL;
+	m_uv.left = m_uv.top = 0.0f;
+	m_uv.right = m_uv.bottom = 1.0f;
 }
 
 CTextureMap::CTextureMap(const CStdString& strTextureName)
 {
 	m_strTextureName = strTextureName;
+	m_iReferenceCount = 0;
+	m_bPending = false;
+	m_pAtlas = NULL;
+	m_uv.left = m_uv.top = 0.0f;
+	m_uv.right = m_uv.bottom = 1.0f;
 }
 
 CTextureMap::~CTextureMap()
@@ -95,45 +124,63 @@ const CStdString& CTextureMap:: GetName() const
 
 int CTextureMap::size() const
 {
+	if (m_pAtlas) return m_pAtlas->size();
 	return  m_vecTexures.size();
 }
 
 LPDIRECT3DTEXTURE9 CTextureMap::GetTexture(/*int iPicture, int& iWidth, int& iHeight*/)
 {
 //	if (iPicture < 0 || iPicture >= (int)m_vecTexures.size()) return NULL;
-  
+	if (m_pAtlas) return m_pAtlas->GetTexture();
+	if (m_vecTexures.empty()) return NULL;
+
 	CTexture* pTexture = m_vecTexures[/*iPicture*/0];
 	return pTexture->GetTexture(/*iWidth, iHeight*/);
 }
 
+void CTextureMap::SetAtlas(CTextureMap* pAtlas, const FRECT& uv)
+{
+	m_pAtlas = pAtlas;
+	m_uv = uv;
+}
+
 void CTextureMap::Add(CTexture* pTexture)
 {
 	m_vecTexures.push_back(pTexture);
 }
 
-bool CTextureMap::IsEmpty() const //MARTY FIXME 
+bool CTextureMap::IsEmpty() const
+{
+	return m_iReferenceCount == 0;
+}
+
+void CTextureMap::Flush()
 {
-/*	int iRef = 0;
-	for (int i = 0; i < (int)m_vecTexures.size(); ++i)
-	{
-		iRef += m_vecTexures[i]->GetRef();
-	}
-	return (iRef == 0);
-*/
-	int iRef = 0;
 	for (int i = 0; i < (int)m_vecTexures.size(); ++i)
 	{
-		iRef ++;
+		m_vecTexures[i]->Flush();
 	}
-	return (iRef != 0);
 }
 
-void CTextureMap::Flush()
+void CTextureMap::AddRef()
+{
+	m_iReferenceCount++;
+}
+
+void CTextureMap::Release()
+{
+	if (m_iReferenceCount > 0)
+		m_iReferenceCount--;
+}
+
+unsigned int CTextureMap::GetMemoryUsage() const
 {
+	unsigned int iMemoryUsage = 0;
 	for (int i = 0; i < (int)m_vecTexures.size(); ++i)
 	{
-		m_vecTexures[i]->Flush();
+		iMemoryUsage += m_vecTexures[i]->GetMemoryUsage();
 	}
+	return iMemoryUsage;
 }
 
 //-----------------------------------------------------------------------------
@@ -141,6 +188,20 @@ void CTextureMap::Flush()
 CGUITextureManager::CGUITextureManager(void)
 {
 	m_strMediaDir = "";
+	m_iBudget = TEXTURE_DEFAULT_BUDGET * 1024 * 1024;
+	m_iMemoryUsage = 0;
+	m_iUnusedMemory = 0;
+	m_iHits = 0;
+	m_iLoads = 0;
+	m_iEvictions = 0;
+	m_iAtlasImages = 0;
+	m_bLoaderRunning = false;
+	m_iPending = 0;
+	m_iUploads = 0;
+	m_dwUploadTime = 0;
+	memset(m_sources, 0, sizeof(m_sources));
+
+	m_loader.SetBundle(&m_bundle);
 }
 
 CGUITextureManager::~CGUITextureManager(void)
@@ -150,42 +211,348 @@ CGUITextureManager::~CGUITextureManager(void)
 void CGUITextureManager::SetTexturePath(const CStdString& strMediaPath)
 {
 	m_strMediaDir = strMediaPath;
+
+	// Skins that ship a bundle load from it, anything missing there from the loose files
+	m_bundle.Open(m_strMediaDir + "media\\" TEXTUREBUNDLE_FILE);
 }
 
-LPDIRECT3DTEXTURE9 CGUITextureManager::GetTexture(const CStdString& strTextureName/*, int iItem, int& iWidth, int& iHeight*/)
+void CGUITextureManager::SetBudget(unsigned int iBytes)
 {
-	for (int i=0; i < (int)m_vecTextures.size(); ++i)
+	CSingleLock lock(g_graphicsContext);
+
+	m_iBudget = iBytes;
+	Evict(0);
+}
+
+CTextureMap* CGUITextureManager::Find(const CStdString& strTextureName)
+{
+	pair<MAPTEXTURES::iterator, MAPTEXTURES::iterator> range = m_mapTextures.equal_range(Hash(strTextureName));
+	for (MAPTEXTURES::iterator it = range.first; it != range.second; ++it)
 	{
-		CTextureMap *pMap=m_vecTextures[i];
-		if (pMap->GetName() == strTextureName)
-		{
-			return  pMap->GetTexture(/*iItem, iWidth, iHeight*/);
-		}
+		if (it->second->GetName() == strTextureName)
+			return it->second;
+	}
+	return NULL;
+}
+
+unsigned int CGUITextureManager::GetMemoryUsage(const CStdString& strTextureName)
+{
+	CSingleLock lock(g_graphicsContext);
+
+	CTextureMap* pMap = Find(strTextureName);
+	if (!pMap)
+		return 0;
+
+	CTextureMap* pAtlas = pMap->GetAtlas();
+	if (pAtlas)
+	{
+		const FRECT& uv = pMap->GetUV();
+		return (unsigned int)(pAtlas->GetMemoryUsage() * (uv.right - uv.left) * (uv.bottom - uv.top));
+	}
+
+	return pMap->GetMemoryUsage();
+}
+
+LPDIRECT3DTEXTURE9 CGUITextureManager::GetTexture(const CStdString& strTextureName/*, int iItem, int& iWidth, int& iHeight*/, FRECT* pUV)
+{
+	CSingleLock lock(g_graphicsContext);
+
+	CTextureMap* pMap = Find(strTextureName);
+	if (pMap)
+	{
+		if (pUV)
+			*pUV = pMap->GetUV();
+		return pMap->GetTexture(/*iItem, iWidth, iHeight*/);
 	}
+
 	return NULL;
 }
 
+CTextureMap* CGUITextureManager::LoadAtlasImage(const CStdString& strTextureName, TexturePriority priority, bool bAsync)
+{
+	CStdString strPage;
+	FRECT uv;
+	if (!m_bundle.GetAtlasImage(strTextureName, strPage, uv))
+		return NULL;
+
+	// The image's reference to its page is the one taken here
+	if (bAsync ? !LoadAsync(strPage, priority) : !Load(strPage, 0))
+		return NULL;
+
+	CTextureMap* pMap = new CTextureMap(strTextureName);
+	pMap->SetAtlas(Find(strPage), uv);
+	m_mapTextures.insert(MAPTEXTURES::value_type(Hash(strTextureName), pMap));
+	m_iAtlasImages++;
+
+	return pMap;
+}
+
 int CGUITextureManager::Load(const CStdString& strTextureName, DWORD dwColorKey)
 {
+	CSingleLock lock(g_graphicsContext);
+
 	// first check of texture exists...
-	for (int i=0; i < (int)m_vecTextures.size(); ++i)
+	CTextureMap* pMap = Find(strTextureName);
+	if (pMap && pMap->GetAtlas())
 	{
-		CTextureMap *pMap = m_vecTextures[i];
-		if (pMap->GetName() == strTextureName)
+		// The page may still be on its way from the background loader
+		if (!pMap->IsLoaded())
 		{
+			CStdString strPage = pMap->GetAtlas()->GetName();
+			if (!Load(strPage, 0))
+				return 0;
+			ReleaseTexture(strPage);
+		}
+		pMap->AddRef();
+		m_iHits++;
+		return pMap->size();
+	}
+
+	if (!pMap)
+	{
+		pMap = LoadAtlasImage(strTextureName, TEXTURE_PRIORITY_VISIBLE, false);
+		if (pMap)
+		{
+			pMap->AddRef();
 			return pMap->size();
 		}
 	}
-  
+
+	if (pMap && pMap->IsLoaded())
+	{
+		if (pMap->IsEmpty())
+		{
+			// back in use, it can't be evicted anymore
+			m_unused.erase(pMap->m_itUnused);
+			m_iUnusedMemory -= pMap->GetMemoryUsage();
+		}
+		pMap->AddRef();
+		m_iHits++;
+		return pMap->size();
+	}
+
 	LPDIRECT3DTEXTURE9 pTexture;
+	D3DXIMAGE_INFO info;
+	bool bBundle = false;
+	DWORD dwStart = GetTickCount();
+
+	if (m_bundle.LoadTexture(strTextureName, &pTexture, info))
+		bBundle = true;
+	else if (!LoadFile(GetTexturePath(strTextureName), &pTexture, info))
+		return NULL;
+
+	if (pMap)
+	{
+		// Still loading in the background or failed there, we can't wait for it
+		if (pMap->IsPending())
+		{
+			m_loader.Cancel(strTextureName);
+			pMap->SetPending(false);
+			m_iPending--;
+		}
+	}
+	else
+	{
+		pMap = new CTextureMap(strTextureName);
+		m_mapTextures.insert(MAPTEXTURES::value_type(Hash(strTextureName), pMap));
+	}
+
+	AddTexture(pMap, pTexture, info, bBundle ? TEXTURE_SOURCE_BUNDLE : TEXTURE_SOURCE_FILE, GetTickCount() - dwStart);
+	pMap->AddRef();
+
+	return 1;
+}
+
+bool CGUITextureManager::LoadAsync(const CStdString& strTextureName, TexturePriority priority)
+{
+	if (!m_bLoaderRunning)
+		return Load(strTextureName, 0) > 0;
+
+	CSingleLock lock(g_graphicsContext);
+
+	CTextureMap* pMap = Find(strTextureName);
+	if (pMap)
+	{
+		if (pMap->IsLoaded())
+		{
+			if (pMap->IsEmpty())
+			{
+				m_unused.erase(pMap->m_itUnused);
+				m_iUnusedMemory -= pMap->GetMemoryUsage();
+			}
+			m_iHits++;
+		}
+		else if (pMap->IsPending() && priority == TEXTURE_PRIORITY_VISIBLE)
+			Prioritize(strTextureName);
+
+		pMap->AddRef();
+		return true;
+	}
+
+	pMap = LoadAtlasImage(strTextureName, priority, true);
+	if (pMap)
+	{
+		pMap->AddRef();
+		return true;
+	}
+
+	pMap = new CTextureMap(strTextureName);
+	pMap->SetPending(true);
+	pMap->AddRef();
+	m_mapTextures.insert(MAPTEXTURES::value_type(Hash(strTextureName), pMap));
+	m_iPending++;
+
+	m_loader.Request(strTextureName, GetTexturePath(strTextureName), priority);
+
+	return true;
+}
+
+bool CGUITextureManager::IsLoading(const CStdString& strTextureName)
+{
+	CSingleLock lock(g_graphicsContext);
+
+	CTextureMap* pMap = Find(strTextureName);
+	return pMap && pMap->IsPending();
+}
+
+void CGUITextureManager::Prioritize(const CStdString& strTextureName)
+{
+	CSingleLock lock(g_graphicsContext);
+
+	// Atlas images wait for their page
+	CTextureMap* pMap = Find(strTextureName);
+	if (pMap && pMap->GetAtlas())
+		m_loader.Prioritize(pMap->GetAtlas()->GetName());
+	else
+		m_loader.Prioritize(strTextureName);
+}
+
+void CGUITextureManager::ProcessUploads(DWORD dwTimeSlice)
+{
+	if (!m_bLoaderRunning)
+		return;
+
+	CSingleLock lock(g_graphicsContext);
+
+	DWORD dwStart = GetTickCount();
+
+	TextureLoadJob* pJob;
+	while ((pJob = m_loader.GetResult()) != NULL)
+	{
+		Upload(pJob);
+		delete pJob;
+
+		if (GetTickCount() - dwStart >= dwTimeSlice)
+			break;
+	}
+
+	m_dwUploadTime += GetTickCount() - dwStart;
+}
+
+void CGUITextureManager::Upload(TextureLoadJob* pJob)
+{
+	// Released or loaded synchronously while it was being read
+	CTextureMap* pMap = Find(pJob->strName);
+	if (!pMap || !pMap->IsPending())
+		return;
+
+	pMap->SetPending(false);
+	m_iPending--;
+
+	LPDIRECT3DTEXTURE9 pTexture = NULL;
+	D3DXIMAGE_INFO info;
+	bool bLoaded = false;
+	DWORD dwStart = GetTickCount();
+
+	if (pJob->bSuccess)
+	{
+		if (pJob->bBundle)
+		{
+			bLoaded = CTextureBundle::CreateTexture(pJob->entry, pJob->pData, &pTexture);
+			info.Width = pJob->iWidth;
+			info.Height = pJob->iHeight;
+
+			// A bundle out of step with the GPU shouldn't cost the skin its image
+			if (!bLoaded)
+			{
+				pJob->bBundle = false;
+				bLoaded = LoadFile(pJob->strPath, &pTexture, info);
+			}
+		}
+		else if (pJob->bThumb || pJob->bDecoded)
+		{
+			// Decoded on the worker, only the copy into the texture is left
+			bLoaded = CreatePixelTexture(pJob->pData, pJob->iWidth, pJob->iHeight, pJob->iPitch, &pTexture);
+			info.Width = pJob->iWidth;
+			info.Height = pJob->iHeight;
+		}
+		else
+		{
+			// DDS files, and images the worker couldn't decode
+			bLoaded = D3DXCreateTextureFromFileInMemoryEx(g_graphicsContext.Get3DDevice(), pJob->pData, pJob->dwSize,
+				D3DX_DEFAULT, D3DX_DEFAULT, D3DX_DEFAULT, 0, D3DFMT_UNKNOWN, D3DPOOL_MANAGED,
+				D3DX_DEFAULT, D3DX_DEFAULT, 0, &info, NULL, &pTexture) == D3D_OK;
+		}
+	}
+
+	if (!bLoaded)
+	{
+		// The map stays without a texture until its references are released
+		CLog::Log(LOGWARNING, "Texture manager unable to load %s in the background", pJob->strPath.c_str());
+		return;
+	}
+
+	AddTexture(pMap, pTexture, info, pJob->bBundle ? TEXTURE_SOURCE_BUNDLE : TEXTURE_SOURCE_FILE,
+		pJob->dwReadTime + GetTickCount() - dwStart);
+	m_iUploads++;
+}
+
+void CGUITextureManager::AddTexture(CTextureMap* pMap, LPDIRECT3DTEXTURE9 pTexture, const D3DXIMAGE_INFO& info, TextureSource source, DWORD dwLoadTime)
+{
+	CTexture* pclsTexture = new CTexture(pTexture, info.Width, info.Height);
+	pMap->Add(pclsTexture);
+
+	m_iLoads++;
+	m_iMemoryUsage += pclsTexture->GetMemoryUsage();
+
+	m_sources[source].iLoads++;
+	m_sources[source].iLoadTime += dwLoadTime;
+	m_sources[source].iMemory += pclsTexture->GetMemoryUsage();
+}
+
+void CGUITextureManager::StartLoader()
+{
+	m_loader.Start();
+	m_bLoaderRunning = true;
+}
+
+void CGUITextureManager::StopLoader()
+{
+	if (!m_bLoaderRunning)
+		return;
+
+	m_bLoaderRunning = false;
+	m_loader.Stop();
+
+	CSingleLock lock(g_graphicsContext);
+	CLog::Log(LOGNOTICE, "Texture manager: %u texture(s) created from background loads in %u ms",
+		m_iUploads, m_dwUploadTime);
+}
+
+CStdString CGUITextureManager::GetTexturePath(const CStdString& strTextureName)
+{
+	if (strTextureName.c_str()[1] == ':')
+		return strTextureName;
+
 	CStdString strPath = m_strMediaDir;
 	strPath+="media\\";
 	strPath+=strTextureName;
-	if (strTextureName.c_str()[1] == ':')
-		strPath=strTextureName;
+	return strPath;
+}
 
+bool CGUITextureManager::LoadFile(const CStdString& strPath, LPDIRECT3DTEXTURE9* ppTexture, D3DXIMAGE_INFO& info)
+{
 	// normal picture
-	D3DXIMAGE_INFO info;
 /*	if ( D3DXCreateTextureFromFileEx(g_graphicsContext.Get3DDevice(), strPath.c_str(),
 		 D3DX_DEFAULT, D3DX_DEFAULT, 1, 0, D3DFMT_LIN_A8R8G8B8, D3DPOOL_MANAGED,
 		 D3DX_FILTER_NONE , D3DX_FILTER_NONE, dwColorKey, &info, NULL, &pTexture)!=D3D_OK)
@@ -194,50 +561,236 @@ int CGUITextureManager::Load(const CStdString& strTextureName, DWORD dwColorKey)
 		return NULL;
 	}
 */
-	if ( D3DXCreateTextureFromFile(g_graphicsContext.Get3DDevice(), strPath.c_str(), &pTexture)!=D3D_OK)
+	if (CThumbnailCache::IsThumbFile(strPath))
+	{
+		// cached thumbs are stored in the texture format already
+		if (!LoadThumb(strPath, ppTexture, info))
+		{
+			CLog::Log(LOGWARNING, "Texture manager unable to load thumb: %s \n", strPath.c_str());
+			return false;
+		}
+	}
+	else if ( D3DXCreateTextureFromFileEx(g_graphicsContext.Get3DDevice(), strPath.c_str(),
+		 D3DX_DEFAULT, D3DX_DEFAULT, D3DX_DEFAULT, 0, D3DFMT_UNKNOWN, D3DPOOL_MANAGED,
+		 D3DX_DEFAULT, D3DX_DEFAULT, 0, &info, NULL, ppTexture)!=D3D_OK)
 	{
 		CLog::Log(LOGWARNING, "Texture manager unable to find file: %s \n", strPath.c_str());
-		return NULL;
+		return false;
 	}
 
-	CTextureMap* pMap = new CTextureMap(strTextureName);
-	CTexture* pclsTexture = new CTexture(pTexture, info.Width, info.Height);
-	pMap->Add(pclsTexture);
-	m_vecTextures.push_back(pMap);
-
-	return 1;
+	return true;
 }
 
-void CGUITextureManager::Flush()
+void CGUITextureManager::ReleaseTexture(const CStdString& strTextureName)
 {
 	CSingleLock lock(g_graphicsContext);
 
-	ivecTextures i;
-	i = m_vecTextures.begin();
-	while (i != m_vecTextures.end())
+	CTextureMap* pMap = Find(strTextureName);
+	if (!pMap || pMap->IsEmpty())
+		return;
+
+	pMap->Release();
+	if (pMap->IsEmpty() && pMap->GetAtlas())
+	{
+		// Cheap to set up again, only the page is worth keeping around
+		CStdString strPage = pMap->GetAtlas()->GetName();
+		Delete(pMap);
+		ReleaseTexture(strPage);
+	}
+	else if (pMap->IsEmpty() && !pMap->IsLoaded())
 	{
-		CTextureMap* pMap = *i;
-		pMap->Flush();
-		if (pMap->IsEmpty() )
+		// Nothing worth keeping, drop the background load if it's still queued
+		if (pMap->IsPending())
 		{
-			delete pMap;
-			i = m_vecTextures.erase(i);
+			m_loader.Cancel(strTextureName);
+			m_iPending--;
 		}
-		else
+		Delete(pMap);
+	}
+	else if (pMap->IsEmpty())
+	{
+		// keep it around in case it is needed again soon
+		pMap->m_itUnused = m_unused.insert(m_unused.end(), pMap);
+		m_iUnusedMemory += pMap->GetMemoryUsage();
+		Evict(0);
+	}
+}
+
+void CGUITextureManager::Evict(unsigned int iBytesNeeded)
+{
+	while (!m_unused.empty() && m_iUnusedMemory + iBytesNeeded > m_iBudget)
+	{
+		CTextureMap* pMap = m_unused.front();
+		m_unused.pop_front();
+		m_iUnusedMemory -= pMap->GetMemoryUsage();
+
+		CLog::Log(LOGDEBUG, "Texture manager evicting %s (%u bytes)", pMap->GetName().c_str(), pMap->GetMemoryUsage());
+
+		m_iEvictions++;
+		Delete(pMap);
+	}
+}
+
+void CGUITextureManager::Delete(CTextureMap* pMap)
+{
+	pair<MAPTEXTURES::iterator, MAPTEXTURES::iterator> range = m_mapTextures.equal_range(Hash(pMap->GetName()));
+	for (MAPTEXTURES::iterator it = range.first; it != range.second; ++it)
+	{
+		if (it->second == pMap)
 		{
-			i++;
+			m_mapTextures.erase(it);
+			break;
 		}
 	}
+
+	m_iMemoryUsage -= pMap->GetMemoryUsage();
+
+	// Quads queued this frame may still point at the texture, it goes when the frame is drawn
+	if (pMap->GetAtlas())
+	{
+		m_iAtlasImages--;
+		delete pMap;
+	}
+	else if (pMap->IsLoaded())
+		m_deleted.push_back(pMap);
+	else
+		delete pMap;
+}
+
+void CGUITextureManager::EndFrame()
+{
+	CSingleLock lock(g_graphicsContext);
+
+	for (unsigned int i = 0; i < m_deleted.size(); i++)
+		delete m_deleted[i];
+	m_deleted.clear();
+}
+
+void CGUITextureManager::GetStats(TextureStats& stats)
+{
+	CSingleLock lock(g_graphicsContext);
+
+	stats.iTextures = m_mapTextures.size();
+	stats.iUnused = m_unused.size();
+	stats.iMemoryUsage = m_iMemoryUsage;
+	stats.iUnusedMemory = m_iUnusedMemory;
+	stats.iBudget = m_iBudget;
+	stats.iHits = m_iHits;
+	stats.iLoads = m_iLoads;
+	stats.iEvictions = m_iEvictions;
+	stats.iAtlasImages = m_iAtlasImages;
+	stats.iPending = m_iPending;
+	stats.iUploads = m_iUploads;
+	stats.iUploadTime = m_dwUploadTime;
+}
+
+void CGUITextureManager::Dump()
+{
+	CSingleLock lock(g_graphicsContext);
+
+	for (MAPTEXTURES::iterator it = m_mapTextures.begin(); it != m_mapTextures.end(); ++it)
+	{
+		CTextureMap* pMap = it->second;
+		CLog::Log(LOGDEBUG, "  texture:%s refs:%i bytes:%u", pMap->GetName().c_str(), pMap->GetReferenceCount(), pMap->GetMemoryUsage());
+	}
+
+	CLog::Log(LOGDEBUG, "Texture manager: %u texture(s) using %u KB, %u unreferenced using %u of %u KB, %u hit(s), %u load(s), %u eviction(s), %u pending, %u atlas image(s)",
+		(unsigned int)m_mapTextures.size(), m_iMemoryUsage / 1024, (unsigned int)m_unused.size(), m_iUnusedMemory / 1024,
+		m_iBudget / 1024, m_iHits, m_iLoads, m_iEvictions, m_iPending, m_iAtlasImages);
+
+	// Both paths side by side, a bundle should load faster without using more memory
+	static const char* strSources[] = { "bundle", "files" };
+	for (int i = 0; i < TEXTURE_SOURCE_COUNT; i++)
+	{
+		const SourceStats& source = m_sources[i];
+		if (!source.iLoads)
+			continue;
+
+		CLog::Log(LOGDEBUG, "Texture manager: %u load(s) from %s, avg %u ms and %u KB per texture",
+			source.iLoads, strSources[i], source.iLoadTime / source.iLoads, source.iMemory / 1024 / source.iLoads);
+	}
+}
+
+DWORD CGUITextureManager::Hash(const CStdString& strTextureName)
+{
+	// Texture names are case sensitive
+	return CFnv::Hash(strTextureName.c_str(), strTextureName.size());
+}
+
+bool CGUITextureManager::LoadThumb(const CStdString& strPath, LPDIRECT3DTEXTURE9* ppTexture, D3DXIMAGE_INFO& info)
+{
+	BYTE* pData = NULL;
+	int iWidth, iHeight, iPitch;
+
+	if (!CThumbnailCache::Read(strPath, &pData, iWidth, iHeight, iPitch))
+		return false;
+
+	bool bResult = CreatePixelTexture(pData, iWidth, iHeight, iPitch, ppTexture);
+	delete[] pData;
+
+	info.Width = iWidth;
+	info.Height = iHeight;
+
+	return bResult;
+}
+
+bool CGUITextureManager::CreatePixelTexture(const BYTE* pData, int iWidth, int iHeight, int iPitch, LPDIRECT3DTEXTURE9* ppTexture)
+{
+	if (D3DXCreateTexture(g_graphicsContext.Get3DDevice(), iWidth, iHeight, 1, 0, D3DFMT_LIN_A8R8G8B8, D3DPOOL_MANAGED, ppTexture) != D3D_OK)
+		return false;
+
+	D3DLOCKED_RECT lr;
+	if ((*ppTexture)->LockRect(0, &lr, NULL, 0) != D3D_OK)
+	{
+		(*ppTexture)->Release();
+		*ppTexture = NULL;
+		return false;
+	}
+
+	for (int y = 0; y < iHeight; y++)
+		memcpy((BYTE*)lr.pBits + y * lr.Pitch, pData + y * iPitch, iWidth * 4);
+
+	(*ppTexture)->UnlockRect(0);
+
+	return true;
+}
+
+void CGUITextureManager::Flush()
+{
+	CSingleLock lock(g_graphicsContext);
+
+	// free every texture that isn't referenced
+	while (!m_unused.empty())
+	{
+		CTextureMap* pMap = m_unused.front();
+		m_unused.pop_front();
+		m_iUnusedMemory -= pMap->GetMemoryUsage();
+		Delete(pMap);
+	}
 }
 
 void CGUITextureManager::Cleanup()
 {
-	ivecTextures i;
-	i = m_vecTextures.begin();
-	while (i != m_vecTextures.end())
+	CSingleLock lock(g_graphicsContext);
+
+	Dump();
+
+	for (MAPTEXTURES::iterator it = m_mapTextures.begin(); it != m_mapTextures.end(); ++it)
 	{
-		CTextureMap* pMap=*i;
+		CTextureMap* pMap = it->second;
+		if (!pMap->IsEmpty())
+			CLog::Log(LOGDEBUG, "Texture manager: %s still has %i reference(s)", pMap->GetName().c_str(), pMap->GetReferenceCount());
 		delete pMap;
-		i=m_vecTextures.erase(i);
 	}
-}
+	m_mapTextures.clear();
+	m_unused.clear();
+
+	for (unsigned int i = 0; i < m_deleted.size(); i++)
+		delete m_deleted[i];
+	m_deleted.clear();
+
+	m_iMemoryUsage = 0;
+	m_iUnusedMemory = 0;
+	m_iPending = 0;
+	m_iAtlasImages = 0;
+}
\ No newline at end of file
@@ -23,10 +23,21 @@
 
 #include "..\utils\Stdafx.h"
 #include "..\utils\stdstring.h"
+#include "TextureLoader.h"
+#include "TextureBundle.h"
+#include "GUITexture.h"
 #include <vector>
+#include <map>
+#include <list>
 
 using namespace std;
 
+// Default for unreferenced textures kept around for reuse, in MB
+#define TEXTURE_DEFAULT_BUDGET 64
+
+// Time per frame the render thread may spend creating textures read in the background, in ms
+#define TEXTURE_UPLOAD_TIMESLICE 4
+
 class CTexture
 {
 public:
@@ -36,6 +47,7 @@ public:
 
 
     LPDIRECT3DTEXTURE9  GetTexture(/*int& iWidth, int& iHeight*/);
+	unsigned int        GetMemoryUsage() const { return m_iMemoryUsage; }
 	
 	void FreeTexture();
 	void Flush(); 
@@ -44,6 +56,7 @@ protected:
     LPDIRECT3DTEXTURE9  m_pTexture;
 	int					m_iWidth;
 	int					m_iHeight;
+	unsigned int		m_iMemoryUsage;
 };
 
 class CTextureMap
@@ -56,13 +69,53 @@ class CTextureMap
 	const CStdString&   GetName() const;
     int                 size() const;
     LPDIRECT3DTEXTURE9  GetTexture(/*int iPicture, int& iWidth, int& iHeight*/);
+	const FRECT&        GetUV() const { return m_uv; }
     void                Add(CTexture* pTexture);
 	bool				IsEmpty() const;
 	void				Flush();
 
+	// A map is created pending when loaded in the background, it has no
+	// texture until the upload is done, or at all if the load failed
+	bool				IsLoaded() const { return m_pAtlas ? m_pAtlas->IsLoaded() : !m_vecTexures.empty(); }
+	bool				IsPending() const { return m_pAtlas ? m_pAtlas->IsPending() : m_bPending; }
+	void				SetPending(bool bPending) { m_bPending = bPending; }
+
+	// An image packed into an atlas page has no texture of its own, it
+	// uses the uv part of the page and holds a reference to it
+	void				SetAtlas(CTextureMap* pAtlas, const FRECT& uv);
+	CTextureMap*		GetAtlas() const { return m_pAtlas; }
+
+	void				AddRef();
+	void				Release();
+	int					GetReferenceCount() const { return m_iReferenceCount; }
+	unsigned int		GetMemoryUsage() const;
+
+	// Position in the manager's list of unreferenced textures
+	list<CTextureMap*>::iterator m_itUnused;
+
 protected:  
     CStdString          m_strTextureName;
     vector<CTexture*>   m_vecTexures;
+	int                 m_iReferenceCount;
+	bool                m_bPending;
+	CTextureMap*        m_pAtlas;
+	FRECT               m_uv;
+};
+
+struct TextureStats
+{
+	unsigned int iTextures;       // textures in memory
+	unsigned int iUnused;         // of those not referenced by any control
+	unsigned int iMemoryUsage;    // bytes used by all textures
+	unsigned int iUnusedMemory;   // bytes used by unreferenced textures
+	unsigned int iBudget;         // bytes unreferenced textures may use
+	unsigned int iHits;           // loads served from memory
+	unsigned int iLoads;          // loads from disk
+	unsigned int iEvictions;      // textures freed to stay within the budget
+	unsigned int iAtlasImages;    // images drawn from a shared atlas page
+	unsigned int iPending;        // background loads not uploaded yet
+	unsigned int iUploads;        // textures created from background loads
+	unsigned int iUploadTime;     // ms the render thread spent on those
 };
 
 class CGUITextureManager
@@ -72,19 +125,100 @@ public:
 	virtual ~CGUITextureManager(void);
 
 	void SetTexturePath(const CStdString& strMediaPath);
-	LPDIRECT3DTEXTURE9 GetTexture(const CStdString& strTextureName/*, int iItem, int& iWidth, int& iHeight*/);
+	void SetBudget(unsigned int iBytes);
+
+	// pUV receives the part of the texture the image uses, all of it unless it's in an atlas
+	LPDIRECT3DTEXTURE9 GetTexture(const CStdString& strTextureName/*, int iItem, int& iWidth, int& iHeight*/, FRECT* pUV = NULL);
+
+	// Each successful Load() adds a reference that has to be given back with ReleaseTexture()
 	int Load(const CStdString& strTextureName, DWORD dwColorKey);
+	void ReleaseTexture(const CStdString& strTextureName);
+
+	// Bytes of video memory the texture uses, its share of the page for atlas images
+	unsigned int GetMemoryUsage(const CStdString& strTextureName);
+
+	// Like Load() but reads the file in the background, GetTexture() returns NULL
+	// while IsLoading(). Falls back to Load() when the loader isn't running.
+	bool LoadAsync(const CStdString& strTextureName, TexturePriority priority);
+	bool IsLoading(const CStdString& strTextureName);
+	void Prioritize(const CStdString& strTextureName);
+
+	// Creates the textures read in the background, called by the render thread
+	// once per frame. Stops after dwTimeSlice ms but always creates one texture.
+	void ProcessUploads(DWORD dwTimeSlice);
+
+	// Frees the textures deleted during the frame, called after the sprite batch's EndFrame()
+	void EndFrame();
+
+	void StartLoader();
+	void StopLoader();
+
+	void GetStats(TextureStats& stats);
+	void Dump();
 
 	void Flush();
 	void Cleanup();
 
 protected:
+	CStdString GetTexturePath(const CStdString& strTextureName);
+	bool LoadFile(const CStdString& strPath, LPDIRECT3DTEXTURE9* ppTexture, D3DXIMAGE_INFO& info);
+	bool LoadThumb(const CStdString& strPath, LPDIRECT3DTEXTURE9* ppTexture, D3DXIMAGE_INFO& info);
+	bool CreatePixelTexture(const BYTE* pData, int iWidth, int iHeight, int iPitch, LPDIRECT3DTEXTURE9* ppTexture);
+	void Upload(TextureLoadJob* pJob);
+
+	enum TextureSource
+	{
+		TEXTURE_SOURCE_BUNDLE = 0,
+		TEXTURE_SOURCE_FILE,
+		TEXTURE_SOURCE_COUNT
+	};
+
+	struct SourceStats
+	{
+		unsigned int iLoads;
+		unsigned int iLoadTime;   // ms, background reads included
+		unsigned int iMemory;     // bytes of the textures when created
+	};
+
+	void AddTexture(CTextureMap* pMap, LPDIRECT3DTEXTURE9 pTexture, const D3DXIMAGE_INFO& info, TextureSource source, DWORD dwLoadTime);
+
+	CTextureMap* Find(const CStdString& strTextureName);
+	CTextureMap* LoadAtlasImage(const CStdString& strTextureName, TexturePriority priority, bool bAsync);
+	void Evict(unsigned int iBytesNeeded);
+	void Delete(CTextureMap* pMap);
+
+	static DWORD Hash(const CStdString& strTextureName);
+
 	CStdString m_strMediaDir;
 
-	vector<CTextureMap*> m_vecTextures;
-	typedef   vector<CTextureMap*>::iterator ivecTextures;
+	// Textures by hash of their name, names are compared on collisions only
+	typedef multimap<DWORD, CTextureMap*> MAPTEXTURES;
+	MAPTEXTURES m_mapTextures;
+
+	// Unreferenced textures, least recently used first
+	list<CTextureMap*> m_unused;
+
+	// Deleted this frame, quads queued before may still draw them
+	vector<CTextureMap*> m_deleted;
+
+	unsigned int m_iBudget;
+	unsigned int m_iMemoryUsage;
+	unsigned int m_iUnusedMemory;
+	unsigned int m_iHits;
+	unsigned int m_iLoads;
+	unsigned int m_iEvictions;
+	unsigned int m_iAtlasImages;
+
+	CTextureBundle m_bundle;
+	SourceStats m_sources[TEXTURE_SOURCE_COUNT];
+
+	CGUITextureLoader m_loader;
+	bool m_bLoaderRunning;
+	unsigned int m_iPending;
+	unsigned int m_iUploads;
+	DWORD m_dwUploadTime;
 };
 
 extern CGUITextureManager g_TextureManager;
 
-#endif //GUILIB_TEXTUREMANAGER_H
\ No newline at end of file
+#endif //GUILIB_TEXTUREMANAGER_H
@@ -0,0 +1,788 @@
+#include "TrueTypeFont.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <algorithm>
+
+// Italic glyphs are sheared by this much, about 11 degrees
+#define TRUETYPE_ITALIC_SLANT 0.2f
+
+static unsigned int ReadU16(const unsigned char* p)
+{
+	return (p[0] << 8) | p[1];
+}
+
+static int ReadS16(const unsigned char* p)
+{
+	return (short)ReadU16(p);
+}
+
+static unsigned int ReadU32(const unsigned char* p)
+{
+	return ((unsigned int)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+CTrueTypeFont::CTrueTypeFont(void)
+{
+	memset(&m_glyf, 0, sizeof(m_glyf));
+	memset(&m_loca, 0, sizeof(m_loca));
+	memset(&m_hmtx, 0, sizeof(m_hmtx));
+	memset(&m_kern, 0, sizeof(m_kern));
+	m_iCmap = 0;
+	m_iCmapFormat = 0;
+	m_iUnitsPerEm = 0;
+	m_iGlyphs = 0;
+	m_iHMetrics = 0;
+	m_iLocFormat = 0;
+	m_iAscent = 0;
+	m_iDescent = 0;
+	m_iLineGap = 0;
+	m_iKernPairs = 0;
+}
+
+CTrueTypeFont::~CTrueTypeFont(void)
+{
+}
+
+bool CTrueTypeFont::Load(const std::string& strPath)
+{
+	FILE* fd = fopen(strPath.c_str(), "rb");
+	if (!fd)
+		return false;
+
+	fseek(fd, 0, SEEK_END);
+	long lSize = ftell(fd);
+	fseek(fd, 0, SEEK_SET);
+
+	std::vector<unsigned char> data(lSize > 0 ? lSize : 0);
+	bool bRead = !data.empty() && fread(&data[0], data.size(), 1, fd) == 1;
+	fclose(fd);
+
+	return bRead && Load(&data[0], data.size());
+}
+
+bool CTrueTypeFont::Load(const unsigned char* pData, unsigned int iSize)
+{
+	m_data.clear();
+	m_iKernPairs = 0;
+
+	if (iSize < 12)
+		return false;
+
+	unsigned int iVersion = ReadU32(pData);
+	if (iVersion != 0x00010000 && iVersion != 0x74727565) // 'true' on Mac fonts
+		return false;
+
+	m_data.assign(pData, pData + iSize);
+
+	Table head, hhea, maxp, cmap;
+	if (!FindTable("head", head) || head.iLength < 54 || !FindTable("hhea", hhea) || hhea.iLength < 36 ||
+	    !FindTable("maxp", maxp) || maxp.iLength < 6 || !FindTable("cmap", cmap) || cmap.iLength < 4 ||
+	    !FindTable("hmtx", m_hmtx) || !FindTable("loca", m_loca) || !FindTable("glyf", m_glyf))
+	{
+		m_data.clear();
+		return false;
+	}
+
+	const unsigned char* p = &m_data[0];
+
+	m_iUnitsPerEm = ReadU16(p + head.iOffset + 18);
+	m_iLocFormat = ReadS16(p + head.iOffset + 50);
+	m_iGlyphs = ReadU16(p + maxp.iOffset + 4);
+	m_iAscent = ReadS16(p + hhea.iOffset + 4);
+	m_iDescent = ReadS16(p + hhea.iOffset + 6);
+	m_iLineGap = ReadS16(p + hhea.iOffset + 8);
+	m_iHMetrics = ReadU16(p + hhea.iOffset + 34);
+
+	if (m_iUnitsPerEm == 0 || m_iHMetrics == 0 || m_iHMetrics > m_iGlyphs || m_hmtx.iLength < m_iHMetrics * 4 ||
+	    m_loca.iLength < (m_iGlyphs + 1) * (m_iLocFormat ? 4 : 2))
+	{
+		m_data.clear();
+		return false;
+	}
+
+	// Unicode, full range if the font has it
+	m_iCmap = 0;
+	unsigned int iSubtables = ReadU16(p + cmap.iOffset + 2);
+	for (unsigned int i = 0; i < iSubtables && 4 + (i + 1) * 8 <= cmap.iLength; i++)
+	{
+		const unsigned char* pRecord = p + cmap.iOffset + 4 + i * 8;
+		unsigned int iPlatform = ReadU16(pRecord);
+		unsigned int iEncoding = ReadU16(pRecord + 2);
+		unsigned int iOffset = ReadU32(pRecord + 4);
+		if (iOffset + 16 > cmap.iLength)
+			continue;
+
+		unsigned int iSubtable = cmap.iOffset + iOffset;
+		unsigned int iFormat = ReadU16(p + iSubtable);
+		unsigned int iLength = iFormat == 12 ? ReadU32(p + iSubtable + 4) : ReadU16(p + iSubtable + 2);
+		if (iOffset + iLength > cmap.iLength)
+			continue;
+
+		bool bUnicode = iPlatform == 0 || (iPlatform == 3 && (iEncoding == 1 || iEncoding == 10));
+		if (bUnicode && iFormat == 12)
+		{
+			m_iCmap = iSubtable;
+			m_iCmapFormat = iFormat;
+			break;
+		}
+		if (bUnicode && iFormat == 4 && !m_iCmap)
+		{
+			m_iCmap = iSubtable;
+			m_iCmapFormat = iFormat;
+		}
+	}
+
+	if (!m_iCmap)
+	{
+		m_data.clear();
+		return false;
+	}
+
+	// Kerning is optional, only the horizontal pairs of the first subtable are used
+	Table kern;
+	if (FindTable("kern", kern) && kern.iLength >= 18 && ReadU16(p + kern.iOffset) == 0 && ReadU16(p + kern.iOffset + 2) > 0)
+	{
+		const unsigned char* pSubtable = p + kern.iOffset + 4;
+		unsigned int iCoverage = ReadU16(pSubtable + 4);
+		unsigned int iPairs = ReadU16(pSubtable + 6);
+		if ((iCoverage >> 8) == 0 && (iCoverage & 7) == 1 && 18 + iPairs * 6 <= kern.iLength)
+		{
+			m_kern.iOffset = kern.iOffset + 18;
+			m_kern.iLength = iPairs * 6;
+			m_iKernPairs = iPairs;
+		}
+	}
+
+	return true;
+}
+
+bool CTrueTypeFont::FindTable(const char* szTag, Table& table) const
+{
+	unsigned int iTables = ReadU16(&m_data[4]);
+	if (12 + iTables * 16 > m_data.size())
+		return false;
+
+	for (unsigned int i = 0; i < iTables; i++)
+	{
+		const unsigned char* pRecord = &m_data[12 + i * 16];
+		if (memcmp(pRecord, szTag, 4) != 0)
+			continue;
+
+		table.iOffset = ReadU32(pRecord + 8);
+		table.iLength = ReadU32(pRecord + 12);
+		return table.iOffset <= m_data.size() && table.iLength <= m_data.size() - table.iOffset;
+	}
+
+	return false;
+}
+
+unsigned int CTrueTypeFont::GetGlyphIndex(unsigned int iCodepoint) const
+{
+	if (!IsLoaded())
+		return 0;
+
+	const unsigned char* p = &m_data[m_iCmap];
+
+	if (m_iCmapFormat == 12)
+	{
+		unsigned int iGroups = ReadU32(p + 12);
+		if (16 + iGroups * 12 > ReadU32(p + 4))
+			return 0;
+
+		unsigned int iLow = 0, iHigh = iGroups;
+		while (iLow < iHigh)
+		{
+			unsigned int iMid = (iLow + iHigh) / 2;
+			const unsigned char* pGroup = p + 16 + iMid * 12;
+			if (iCodepoint < ReadU32(pGroup))
+				iHigh = iMid;
+			else if (iCodepoint > ReadU32(pGroup + 4))
+				iLow = iMid + 1;
+			else
+			{
+				unsigned int iGlyph = ReadU32(pGroup + 8) + iCodepoint - ReadU32(pGroup);
+				return iGlyph < m_iGlyphs ? iGlyph : 0;
+			}
+		}
+		return 0;
+	}
+
+	// Format 4, segments of the basic multilingual plane
+	if (iCodepoint > 0xFFFF)
+		return 0;
+
+	unsigned int iLength = ReadU16(p + 2);
+	unsigned int iSegX2 = ReadU16(p + 6);
+	if (16 + iSegX2 * 4 > iLength)
+		return 0;
+
+	const unsigned char* pEndCodes = p + 14;
+	const unsigned char* pStartCodes = pEndCodes + iSegX2 + 2;
+	const unsigned char* pDeltas = pStartCodes + iSegX2;
+	const unsigned char* pRangeOffsets = pDeltas + iSegX2;
+
+	// First segment ending at or after the code point
+	unsigned int iLow = 0, iHigh = iSegX2 / 2;
+	while (iLow < iHigh)
+	{
+		unsigned int iMid = (iLow + iHigh) / 2;
+		if (ReadU16(pEndCodes + iMid * 2) < iCodepoint)
+			iLow = iMid + 1;
+		else
+			iHigh = iMid;
+	}
+
+	if (iLow >= iSegX2 / 2)
+		return 0;
+
+	unsigned int iStart = ReadU16(pStartCodes + iLow * 2);
+	if (iCodepoint < iStart)
+		return 0;
+
+	unsigned int iDelta = ReadU16(pDeltas + iLow * 2);
+	unsigned int iRangeOffset = ReadU16(pRangeOffsets + iLow * 2);
+	if (iRangeOffset == 0)
+		return (iCodepoint + iDelta) & 0xFFFF;
+
+	const unsigned char* pGlyph = pRangeOffsets + iLow * 2 + iRangeOffset + (iCodepoint - iStart) * 2;
+	if (pGlyph + 2 > p + iLength)
+		return 0;
+
+	unsigned int iGlyph = ReadU16(pGlyph);
+	return iGlyph ? (iGlyph + iDelta) & 0xFFFF : 0;
+}
+
+float CTrueTypeFont::GetScale(float fPixelSize) const
+{
+	return m_iUnitsPerEm ? fPixelSize / m_iUnitsPerEm : 0.0f;
+}
+
+int CTrueTypeFont::GetAdvance(unsigned int iGlyph) const
+{
+	if (!IsLoaded())
+		return 0;
+
+	// Glyphs past the last metric share its advance
+	if (iGlyph >= m_iHMetrics)
+		iGlyph = m_iHMetrics - 1;
+
+	return ReadU16(&m_data[m_hmtx.iOffset + iGlyph * 4]);
+}
+
+int CTrueTypeFont::GetKerning(unsigned int iLeftGlyph, unsigned int iRightGlyph) const
+{
+	if (!m_iKernPairs)
+		return 0;
+
+	unsigned int iKey = (iLeftGlyph << 16) | iRightGlyph;
+	const unsigned char* pPairs = &m_data[m_kern.iOffset];
+
+	unsigned int iLow = 0, iHigh = m_iKernPairs;
+	while (iLow < iHigh)
+	{
+		unsigned int iMid = (iLow + iHigh) / 2;
+		unsigned int iPair = ReadU32(pPairs + iMid * 6);
+		if (iPair < iKey)
+			iLow = iMid + 1;
+		else if (iPair > iKey)
+			iHigh = iMid;
+		else
+			return ReadS16(pPairs + iMid * 6 + 4);
+	}
+
+	return 0;
+}
+
+int CTrueTypeFont::GetEmbolden(float fPixelSize)
+{
+	return 1 + (int)(fPixelSize / 32.0f);
+}
+
+bool CTrueTypeFont::GetGlyphData(unsigned int iGlyph, unsigned int& iOffset, unsigned int& iLength) const
+{
+	if (iGlyph >= m_iGlyphs)
+		return false;
+
+	unsigned int iStart, iEnd;
+	const unsigned char* pLoca = &m_data[m_loca.iOffset];
+	if (m_iLocFormat)
+	{
+		iStart = ReadU32(pLoca + iGlyph * 4);
+		iEnd = ReadU32(pLoca + iGlyph * 4 + 4);
+	}
+	else
+	{
+		iStart = ReadU16(pLoca + iGlyph * 2) * 2;
+		iEnd = ReadU16(pLoca + iGlyph * 2 + 2) * 2;
+	}
+
+	if (iEnd < iStart || iEnd > m_glyf.iLength)
+		return false;
+
+	iOffset = m_glyf.iOffset + iStart;
+	iLength = iEnd - iStart;
+	return true;
+}
+
+bool CTrueTypeFont::GetOutline(unsigned int iGlyph, std::vector<OutlinePoint>& points, std::vector<unsigned int>& contourEnds, int iDepth) const
+{
+	if (iDepth > TRUETYPE_MAX_COMPONENT_DEPTH)
+		return false;
+
+	unsigned int iOffset, iLength;
+	if (!GetGlyphData(iGlyph, iOffset, iLength))
+		return false;
+
+	// Empty, e.g. a space
+	if (iLength == 0)
+		return true;
+
+	if (iLength < 10)
+		return false;
+
+	const unsigned char* p = &m_data[iOffset];
+	const unsigned char* pEnd = p + iLength;
+	int iContours = ReadS16(p);
+
+	if (iContours >= 0)
+	{
+		const unsigned char* pEndPoints = p + 10;
+		if (pEndPoints + iContours * 2 + 2 > pEnd)
+			return false;
+
+		unsigned int iPoints = iContours ? ReadU16(pEndPoints + (iContours - 1) * 2) + 1 : 0;
+		const unsigned char* q = pEndPoints + iContours * 2 + 2 + ReadU16(pEndPoints + iContours * 2);
+
+		std::vector<unsigned char> flags(iPoints);
+		for (unsigned int i = 0; i < iPoints; )
+		{
+			if (q >= pEnd)
+				return false;
+
+			unsigned char flag = *q++;
+			flags[i++] = flag;
+			if (flag & 8)
+			{
+				if (q >= pEnd)
+					return false;
+				for (unsigned int iRepeat = *q++; iRepeat > 0 && i < iPoints; iRepeat--)
+					flags[i++] = flag;
+			}
+		}
+
+		unsigned int iBase = points.size();
+		points.resize(iBase + iPoints);
+
+		// Coordinates are deltas, short ones have their sign in the flags
+		int x = 0;
+		for (unsigned int i = 0; i < iPoints; i++)
+		{
+			if (flags[i] & 2)
+			{
+				if (q >= pEnd)
+					return false;
+				x += (flags[i] & 16) ? *q : -*q;
+				q++;
+			}
+			else if (!(flags[i] & 16))
+			{
+				if (q + 2 > pEnd)
+					return false;
+				x += ReadS16(q);
+				q += 2;
+			}
+			points[iBase + i].x = (float)x;
+			points[iBase + i].bOnCurve = (flags[i] & 1) != 0;
+		}
+
+		int y = 0;
+		for (unsigned int i = 0; i < iPoints; i++)
+		{
+			if (flags[i] & 4)
+			{
+				if (q >= pEnd)
+					return false;
+				y += (flags[i] & 32) ? *q : -*q;
+				q++;
+			}
+			else if (!(flags[i] & 32))
+			{
+				if (q + 2 > pEnd)
+					return false;
+				y += ReadS16(q);
+				q += 2;
+			}
+			points[iBase + i].y = (float)y;
+		}
+
+		unsigned int iPrevious = 0;
+		for (int i = 0; i < iContours; i++)
+		{
+			unsigned int iEndPoint = ReadU16(pEndPoints + i * 2) + 1;
+			if (iEndPoint > iPoints || iEndPoint < iPrevious)
+				return false;
+			contourEnds.push_back(iBase + iEndPoint);
+			iPrevious = iEndPoint;
+		}
+
+		return true;
+	}
+
+	// Composite, other glyphs placed with an offset and an optional 2x2 transform
+	const unsigned char* q = p + 10;
+	for (;;)
+	{
+		if (q + 4 > pEnd)
+			return false;
+
+		unsigned int iFlags = ReadU16(q);
+		unsigned int iComponent = ReadU16(q + 2);
+		q += 4;
+
+		float dx, dy;
+		if (iFlags & 0x0001) // ARG_1_AND_2_ARE_WORDS
+		{
+			if (q + 4 > pEnd)
+				return false;
+			dx = (float)ReadS16(q);
+			dy = (float)ReadS16(q + 2);
+			q += 4;
+		}
+		else
+		{
+			if (q + 2 > pEnd)
+				return false;
+			dx = (float)(signed char)q[0];
+			dy = (float)(signed char)q[1];
+			q += 2;
+		}
+
+		// Matching points instead of an offset isn't used by any font we ship
+		if (!(iFlags & 0x0002)) // ARGS_ARE_XY_VALUES
+			dx = dy = 0.0f;
+
+		float a = 1.0f, b = 0.0f, c = 0.0f, d = 1.0f;
+		if (iFlags & 0x0008) // WE_HAVE_A_SCALE
+		{
+			if (q + 2 > pEnd)
+				return false;
+			a = d = ReadS16(q) / 16384.0f;
+			q += 2;
+		}
+		else if (iFlags & 0x0040) // WE_HAVE_AN_X_AND_Y_SCALE
+		{
+			if (q + 4 > pEnd)
+				return false;
+			a = ReadS16(q) / 16384.0f;
+			d = ReadS16(q + 2) / 16384.0f;
+			q += 4;
+		}
+		else if (iFlags & 0x0080) // WE_HAVE_A_TWO_BY_TWO
+		{
+			if (q + 8 > pEnd)
+				return false;
+			a = ReadS16(q) / 16384.0f;
+			b = ReadS16(q + 2) / 16384.0f;
+			c = ReadS16(q + 4) / 16384.0f;
+			d = ReadS16(q + 6) / 16384.0f;
+			q += 8;
+		}
+
+		unsigned int iBase = points.size();
+		if (!GetOutline(iComponent, points, contourEnds, iDepth + 1))
+			return false;
+
+		for (unsigned int i = iBase; i < points.size(); i++)
+		{
+			float x = points[i].x;
+			float y = points[i].y;
+			points[i].x = a * x + c * y + dx;
+			points[i].y = b * x + d * y + dy;
+		}
+
+		if (!(iFlags & 0x0020)) // MORE_COMPONENTS
+			break;
+	}
+
+	return true;
+}
+
+void CTrueTypeFont::AddLine(std::vector<Edge>& edges, float x0, float y0, float x1, float y1)
+{
+	// Horizontal edges don't change the coverage
+	if (y0 == y1)
+		return;
+
+	Edge edge = { x0, y0, x1, y1 };
+	edges.push_back(edge);
+}
+
+void CTrueTypeFont::AddQuad(std::vector<Edge>& edges, float x0, float y0, float cx, float cy, float x1, float y1)
+{
+	// Enough segments to stay within a fraction of a pixel of the curve
+	float ddx = x0 - 2 * cx + x1;
+	float ddy = y0 - 2 * cy + y1;
+	float fDeviation = ddx * ddx + ddy * ddy;
+	if (fDeviation < 0.333f)
+	{
+		AddLine(edges, x0, y0, x1, y1);
+		return;
+	}
+
+	int iSegments = 1 + (int)sqrtf(sqrtf(3.0f * fDeviation));
+	float fLastX = x0, fLastY = y0;
+	for (int i = 1; i <= iSegments; i++)
+	{
+		float t = (float)i / iSegments;
+		float u = 1.0f - t;
+		float x = u * u * x0 + 2 * u * t * cx + t * t * x1;
+		float y = u * u * y0 + 2 * u * t * cy + t * t * y1;
+		AddLine(edges, fLastX, fLastY, x, y);
+		fLastX = x;
+		fLastY = y;
+	}
+}
+
+void CTrueTypeFont::FillEdges(const std::vector<Edge>& edges, int iWidth, int iHeight, std::vector<unsigned char>& pixels)
+{
+	// Every edge adds the signed area it covers to the cells it crosses and
+	// takes it away again to their right, a running sum gives the coverage
+	std::vector<float> accumulation(iWidth * iHeight + 2, 0.0f);
+
+	for (size_t i = 0; i < edges.size(); i++)
+	{
+		const Edge& edge = edges[i];
+
+		float fDirection = 1.0f;
+		float x0 = edge.x0, y0 = edge.y0, x1 = edge.x1, y1 = edge.y1;
+		if (y0 > y1)
+		{
+			fDirection = -1.0f;
+			std::swap(x0, x1);
+			std::swap(y0, y1);
+		}
+
+		float fSlope = (x1 - x0) / (y1 - y0);
+		float x = x0;
+		if (y0 < 0.0f)
+			x -= y0 * fSlope;
+
+		int iRowEnd = (int)ceilf(y1);
+		if (iRowEnd > iHeight)
+			iRowEnd = iHeight;
+
+		for (int y = y0 > 0.0f ? (int)y0 : 0; y < iRowEnd; y++)
+		{
+			float* pRow = &accumulation[y * iWidth];
+
+			float dy = (y + 1 < y1 ? y + 1 : y1) - (y > y0 ? y : y0);
+			float xNext = x + fSlope * dy;
+			float d = dy * fDirection;
+
+			float xa = x < xNext ? x : xNext;
+			float xb = x < xNext ? xNext : x;
+			float xaFloor = floorf(xa);
+			int iXa = (int)xaFloor;
+			int iXb = (int)ceilf(xb);
+
+			if (iXb <= iXa + 1)
+			{
+				// Within one pixel, split at the middle of the segment
+				float fMid = 0.5f * (x + xNext) - xaFloor;
+				pRow[iXa] += d - d * fMid;
+				pRow[iXa + 1] += d * fMid;
+			}
+			else
+			{
+				float s = 1.0f / (xb - xa);
+				float xaFraction = xa - xaFloor;
+				float a0 = 0.5f * s * (1.0f - xaFraction) * (1.0f - xaFraction);
+				float xbFraction = xb - iXb + 1.0f;
+				float am = 0.5f * s * xbFraction * xbFraction;
+
+				pRow[iXa] += d * a0;
+				if (iXb == iXa + 2)
+				{
+					pRow[iXa + 1] += d * (1.0f - a0 - am);
+				}
+				else
+				{
+					float a1 = s * (1.5f - xaFraction);
+					pRow[iXa + 1] += d * (a1 - a0);
+					for (int xi = iXa + 2; xi < iXb - 1; xi++)
+						pRow[xi] += d * s;
+					float a2 = a1 + (iXb - iXa - 3) * s;
+					pRow[iXb - 1] += d * (1.0f - a2 - am);
+				}
+				pRow[iXb] += d * am;
+			}
+
+			x = xNext;
+		}
+	}
+
+	pixels.resize(iWidth * iHeight);
+
+	float fSum = 0.0f;
+	for (int i = 0; i < iWidth * iHeight; i++)
+	{
+		fSum += accumulation[i];
+		float fCoverage = fabsf(fSum);
+		pixels[i] = fCoverage >= 1.0f ? 255 : (unsigned char)(fCoverage * 255.0f + 0.5f);
+	}
+}
+
+bool CTrueTypeFont::Rasterize(unsigned int iGlyph, float fScale, unsigned int dwStyle, GlyphBitmap& bitmap) const
+{
+	bitmap.iWidth = bitmap.iHeight = 0;
+	bitmap.iOffsetX = bitmap.iOffsetY = 0;
+	bitmap.pixels.clear();
+
+	std::vector<OutlinePoint> points;
+	std::vector<unsigned int> contourEnds;
+	if (!IsLoaded() || !GetOutline(iGlyph, points, contourEnds, 0))
+		return false;
+
+	if (points.empty())
+		return true;
+
+	// To pixels, y down from the baseline
+	float fSlant = (dwStyle & GLYPH_STYLE_ITALIC) ? TRUETYPE_ITALIC_SLANT : 0.0f;
+	for (size_t i = 0; i < points.size(); i++)
+	{
+		points[i].x = (points[i].x + points[i].y * fSlant) * fScale;
+		points[i].y = -points[i].y * fScale;
+	}
+
+	std::vector<Edge> edges;
+	unsigned int iStart = 0;
+	for (size_t c = 0; c < contourEnds.size(); c++)
+	{
+		unsigned int iEnd = contourEnds[c];
+		unsigned int iCount = iEnd - iStart;
+		const OutlinePoint* pPoints = &points[iStart];
+		iStart = iEnd;
+
+		if (iCount < 2)
+			continue;
+
+		// Start on a point on the curve, or halfway between two control points
+		float fStartX, fStartY;
+		unsigned int iFirst, iSteps;
+		if (pPoints[0].bOnCurve)
+		{
+			fStartX = pPoints[0].x; fStartY = pPoints[0].y;
+			iFirst = 1; iSteps = iCount - 1;
+		}
+		else if (pPoints[iCount - 1].bOnCurve)
+		{
+			fStartX = pPoints[iCount - 1].x; fStartY = pPoints[iCount - 1].y;
+			iFirst = 0; iSteps = iCount - 1;
+		}
+		else
+		{
+			fStartX = 0.5f * (pPoints[0].x + pPoints[1].x); fStartY = 0.5f * (pPoints[0].y + pPoints[1].y);
+			iFirst = 1; iSteps = iCount;
+		}
+
+		float fLastX = fStartX, fLastY = fStartY;
+		float fControlX = 0.0f, fControlY = 0.0f;
+		bool bControl = false;
+
+		// Two control points in a row imply a point on the curve between them
+		for (unsigned int i = 0; i < iSteps; i++)
+		{
+			const OutlinePoint& point = pPoints[(iFirst + i) % iCount];
+			if (point.bOnCurve)
+			{
+				if (bControl)
+					AddQuad(edges, fLastX, fLastY, fControlX, fControlY, point.x, point.y);
+				else
+					AddLine(edges, fLastX, fLastY, point.x, point.y);
+				fLastX = point.x;
+				fLastY = point.y;
+				bControl = false;
+			}
+			else
+			{
+				if (bControl)
+				{
+					float fMidX = 0.5f * (fControlX + point.x);
+					float fMidY = 0.5f * (fControlY + point.y);
+					AddQuad(edges, fLastX, fLastY, fControlX, fControlY, fMidX, fMidY);
+					fLastX = fMidX;
+					fLastY = fMidY;
+				}
+				fControlX = point.x;
+				fControlY = point.y;
+				bControl = true;
+			}
+		}
+
+		if (bControl)
+			AddQuad(edges, fLastX, fLastY, fControlX, fControlY, fStartX, fStartY);
+		else
+			AddLine(edges, fLastX, fLastY, fStartX, fStartY);
+	}
+
+	if (edges.empty())
+		return true;
+
+	float fMinX = edges[0].x0, fMaxX = fMinX, fMinY = edges[0].y0, fMaxY = fMinY;
+	for (size_t i = 0; i < edges.size(); i++)
+	{
+		const Edge& edge = edges[i];
+		fMinX = std::min(fMinX, std::min(edge.x0, edge.x1));
+		fMaxX = std::max(fMaxX, std::max(edge.x0, edge.x1));
+		fMinY = std::min(fMinY, std::min(edge.y0, edge.y1));
+		fMaxY = std::max(fMaxY, std::max(edge.y0, edge.y1));
+	}
+
+	int iLeft = (int)floorf(fMinX);
+	int iTop = (int)floorf(fMinY);
+	int iWidth = (int)ceilf(fMaxX) - iLeft + 1;
+	int iHeight = (int)ceilf(fMaxY) - iTop;
+	if (iHeight <= 0)
+		return true;
+
+	for (size_t i = 0; i < edges.size(); i++)
+	{
+		edges[i].x0 -= iLeft; edges[i].x1 -= iLeft;
+		edges[i].y0 -= iTop;  edges[i].y1 -= iTop;
+	}
+
+	std::vector<unsigned char> coverage;
+	FillEdges(edges, iWidth, iHeight, coverage);
+
+	// Bold is the glyph drawn over itself shifted right
+	int iEmbolden = (dwStyle & GLYPH_STYLE_BOLD) ? GetEmbolden(fScale * m_iUnitsPerEm) : 0;
+
+	bitmap.iWidth = iWidth + iEmbolden;
+	bitmap.iHeight = iHeight;
+	bitmap.iOffsetX = iLeft;
+	bitmap.iOffsetY = iTop;
+	bitmap.pixels.assign(bitmap.iWidth * iHeight, 0);
+
+	for (int y = 0; y < iHeight; y++)
+	{
+		const unsigned char* pSource = &coverage[y * iWidth];
+		unsigned char* pDest = &bitmap.pixels[y * bitmap.iWidth];
+		for (int x = 0; x < bitmap.iWidth; x++)
+		{
+			int iValue = 0;
+			for (int i = 0; i <= iEmbolden; i++)
+			{
+				int iSourceX = x - i;
+				if (iSourceX < 0 || iSourceX >= iWidth)
+					continue;
+				iValue = iValue + pSource[iSourceX] - iValue * pSource[iSourceX] / 255;
+			}
+			pDest[x] = (unsigned char)iValue;
+		}
+	}
+
+	return true;
+}
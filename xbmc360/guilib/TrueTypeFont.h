@@ -0,0 +1,108 @@
+#ifndef GUILIB_TRUETYPEFONT_H
+#define GUILIB_TRUETYPEFONT_H
+
+// Kept free of Xbox headers, tools/FontPreview builds it on Linux
+
+#include <string>
+#include <vector>
+
+// Synthesized styles, the skin only ships regular faces
+#define GLYPH_STYLE_NORMAL  0x00000000
+#define GLYPH_STYLE_BOLD    0x00000001
+#define GLYPH_STYLE_ITALIC  0x00000002
+
+// Composite glyphs referring to composite glyphs, deeper is a broken font
+#define TRUETYPE_MAX_COMPONENT_DEPTH 8
+
+// 8 bit coverage of a glyph, iOffsetX/iOffsetY is the top left relative to the pen on the baseline
+struct GlyphBitmap
+{
+	int iWidth;
+	int iHeight;
+	int iOffsetX;
+	int iOffsetY;
+	std::vector<unsigned char> pixels;
+};
+
+/*!
+ \brief Reads the outlines of a TrueType font and renders them anti-aliased.
+
+ Only what text drawing needs: the unicode cmap, horizontal metrics,
+ kerning and the quadratic outlines. Hinting instructions are ignored.
+ */
+class CTrueTypeFont
+{
+public:
+	CTrueTypeFont(void);
+	virtual ~CTrueTypeFont(void);
+
+	bool Load(const std::string& strPath);
+	bool Load(const unsigned char* pData, unsigned int iSize);
+	bool IsLoaded() const { return !m_data.empty(); }
+
+	// 0 is the font's missing glyph
+	unsigned int GetGlyphIndex(unsigned int iCodepoint) const;
+
+	// Pixels per font unit for an em of fPixelSize pixels
+	float GetScale(float fPixelSize) const;
+
+	// In font units, descent is negative
+	int GetAscent() const { return m_iAscent; }
+	int GetDescent() const { return m_iDescent; }
+	int GetLineGap() const { return m_iLineGap; }
+	int GetAdvance(unsigned int iGlyph) const;
+	int GetKerning(unsigned int iLeftGlyph, unsigned int iRightGlyph) const;
+
+	// Pixels bold glyphs are widened by, also added to their advance
+	static int GetEmbolden(float fPixelSize);
+
+	bool Rasterize(unsigned int iGlyph, float fScale, unsigned int dwStyle, GlyphBitmap& bitmap) const;
+
+private:
+	struct Table
+	{
+		unsigned int iOffset;
+		unsigned int iLength;
+	};
+
+	struct OutlinePoint
+	{
+		float x;
+		float y;
+		bool bOnCurve;
+	};
+
+	struct Edge
+	{
+		float x0, y0;
+		float x1, y1;
+	};
+
+	bool FindTable(const char* szTag, Table& table) const;
+	bool GetGlyphData(unsigned int iGlyph, unsigned int& iOffset, unsigned int& iLength) const;
+	bool GetOutline(unsigned int iGlyph, std::vector<OutlinePoint>& points, std::vector<unsigned int>& contourEnds, int iDepth) const;
+
+	static void AddLine(std::vector<Edge>& edges, float x0, float y0, float x1, float y1);
+	static void AddQuad(std::vector<Edge>& edges, float x0, float y0, float cx, float cy, float x1, float y1);
+	static void FillEdges(const std::vector<Edge>& edges, int iWidth, int iHeight, std::vector<unsigned char>& pixels);
+
+	std::vector<unsigned char> m_data;
+
+	Table m_glyf;
+	Table m_loca;
+	Table m_hmtx;
+	Table m_kern;
+	unsigned int m_iCmap;        // offset of the cmap subtable we use
+	unsigned int m_iCmapFormat;
+
+	unsigned int m_iUnitsPerEm;
+	unsigned int m_iGlyphs;
+	unsigned int m_iHMetrics;
+	int m_iLocFormat;
+	int m_iAscent;
+	int m_iDescent;
+	int m_iLineGap;
+	unsigned int m_iKernPairs;   // format 0 pairs at m_kern.iOffset
+};
+
+#endif //GUILIB_TRUETYPEFONT_H
@@ -1,53 +1,7 @@
 #include "ScreensaverPlasma.h"
 #include "..\GraphicContext.h"
-
-namespace PlasmaScreensaverShaders
-{
-//-------------------------------------------------------------------------------------
-// Vertex shader
-// We use the register semantic here to directly define the input register
-// matWVP.  Conversely, we could let the HLSL compiler decide and check the
-// constant table.
-//-------------------------------------------------------------------------------------
-const char* g_strVertexShaderProgram =
-    " float4x4 matWVP : register(c0);              "
-    "                                              "
-    " struct VS_IN                                 "
-    " {                                            "
-    "     float4 ObjPos   : POSITION;              "  // Object space position 
-    "     float2 TexCoord : TEXCOORD;              "
-    " };                                           "
-    "                                              "
-    " struct VS_OUT                                "
-    " {                                            "
-    "     float4 ProjPos  : POSITION;              "  // Projected space position 
-    "     float2 TexCoord : TEXCOORD;              "
-    " };                                           "
-    "                                              "
-    " VS_OUT main( VS_IN In )                      "
-    " {                                            "
-    "     VS_OUT Out;                              "
-    "     Out.ProjPos = mul( matWVP, In.ObjPos );  "  // Transform vertex into
-    "     Out.TexCoord = In.TexCoord;              "
-    "     return Out;                              "
-    " }                                            ";
-
-//-------------------------------------------------------------------------------------
-// Pixel shader
-//-------------------------------------------------------------------------------------
-const char* g_strPixelShaderProgram =
-    " struct PS_IN                                 "
-    " {                                            "
-    "     float2 TexCoord : TEXCOORD;              "
-    " };                                           "  // the vertex shader
-    "                                              "
-    " sampler detail;                              "
-    "                                              "
-    " float4 main( PS_IN In ) : COLOR              "
-    " {                                            "
-    "     return tex2D( detail, In.TexCoord );     "  // Output color
-    " }                                            ";
-}
+#include "..\ShaderManager.h"
+#include "..\SpriteBatch.h"
 
 CScreensaverPlasma::CScreensaverPlasma()
 {
@@ -82,43 +36,9 @@ bool CScreensaverPlasma::Initialize()
 	m_iScreenWidth = g_graphicsContext.GetWidth();
 	m_iScreenHeight = g_graphicsContext.GetHeight();
 
-	// Compile vertex shader.
-	ID3DXBuffer* pVertexShaderCode;
-	ID3DXBuffer* pVertexErrorMsg;
-   
-	D3DXCompileShader( PlasmaScreensaverShaders::g_strVertexShaderProgram,
-                                    ( UINT )strlen( PlasmaScreensaverShaders::g_strVertexShaderProgram ),
-                                    NULL,
-                                    NULL,
-                                    "main",
-                                    "vs_2_0",
-                                    0,
-                                    &pVertexShaderCode,
-                                    &pVertexErrorMsg,
-                                    NULL );
-
-    // Create vertex shader.
-    m_pd3dDevice->CreateVertexShader( ( DWORD* )pVertexShaderCode->GetBufferPointer(),
-                                      &m_pVertexShader );
-
-    // Compile pixel shader.
-	ID3DXBuffer* pPixelShaderCode;
-    ID3DXBuffer* pPixelErrorMsg;
-
-	D3DXCompileShader( PlasmaScreensaverShaders::g_strPixelShaderProgram,
-                            ( UINT )strlen( PlasmaScreensaverShaders::g_strPixelShaderProgram ),
-                            NULL,
-                            NULL,
-                            "main",
-                            "ps_2_0",
-                            0,
-                            &pPixelShaderCode,
-                            &pPixelErrorMsg,
-                            NULL );
-
-    // Create pixel shader.
-    m_pd3dDevice->CreatePixelShader( ( DWORD* )pPixelShaderCode->GetBufferPointer(),
-                                     &m_pPixelShader );
+	// Shaders are shared by everything that draws textured quads
+	m_pVertexShader = g_shaderManager.GetVertexShader(SHADER_TEXTURE_VS);
+	m_pPixelShader = g_shaderManager.GetPixelShader(SHADER_TEXTURE_PS);
 
     // Define the vertex elements and
     // Create a vertex declaration from the element descriptions.
@@ -138,17 +58,6 @@ bool CScreensaverPlasma::Initialize()
                                                   D3DPOOL_MANAGED,
                                                   &m_pVB,
                                                   NULL );
-	if(pVertexShaderCode)
-		pVertexShaderCode->Release();
-
-	if(pVertexErrorMsg)
-		pVertexErrorMsg->Release();
-
-	if(pPixelShaderCode)
-		pPixelShaderCode->Release();
-
-	if(pPixelErrorMsg)
-		pPixelErrorMsg->Release();
 
 	m_initialized = true;
 
@@ -302,6 +211,8 @@ void CScreensaverPlasma::UpdateTexture()
 {
 	g_graphicsContext.Lock();
 
+	g_spriteBatch.Flush();
+
     // Build the world-view-projection matrix and pass it into the vertex shader
 	D3DXMATRIX matWVP = m_matWorld * m_matView * m_matProj;
     m_pd3dDevice->SetVertexShaderConstantF( 0, ( FLOAT* )&matWVP, 4 );
@@ -22,12 +22,19 @@
 
 #include "..\..\filesystem\HDDirectory.h" //TESTING
 #include "..\..\Application.h" //TESTING
-#include "..\GUISpinControlEx.h" //TESTING
-#include "..\..\FileItem.h" //TESTING
+#include "..\GUIListContainer.h"
+#include "..\..\cores\DVDPlayer\DVDMediaProbe.h"
+#include "..\..\VideoThumbLoader.h"
+#include "..\GUIUserMessage.h"
+
+#define CONTROL_LIST        1
+#define CONTROL_BTNPLAY     2
 
 CGUIWindowVideoFiles::CGUIWindowVideoFiles(void) : CGUIWindow(WINDOW_VIDEOS, "MyVideos.xml")
 {
 	m_loadOnDemand = false;
+	m_iShownFirst = 0;
+	m_iShownLast = -1;
 }
 
 CGUIWindowVideoFiles::~CGUIWindowVideoFiles(void)
@@ -40,63 +47,85 @@ bool CGUIWindowVideoFiles::OnMessage(CGUIMessage& message)
 	{
 		case GUI_MSG_WINDOW_INIT:
 		{
-			CGUISpinControlEx *pOriginalSpin;
-			pOriginalSpin = (CGUISpinControlEx*)GetControl(1);
+			CGUIListContainer* pList = (CGUIListContainer*)GetControl(CONTROL_LIST);
 
-			if(pOriginalSpin)
+			if(pList)
 			{
-				pOriginalSpin->SetPosition(420, 330);
-			
 				XFILE::CHDDirectory directory;
-				CFileItemList items;
+
+				pList->Clear();
+				m_vecItems.Clear();
+				m_iShownFirst = 0;
+				m_iShownLast = -1;
 
 				//Find all video in test video folder!
-				directory.GetDirectory("D:\\testvideos\\", items);
-			
-				for (int i = 0; i < items.Size(); ++i)
+				directory.GetDirectory("D:\\testvideos\\", m_vecItems);
+
+				// Only pointers are added, the list builds views for what it shows when it's drawn
+				pList->Reserve(m_vecItems.Size());
+				for (int i = 0; i < m_vecItems.Size(); ++i)
 				{
-					CFileItem* pItem = items[i];
+					CFileItem* pItem = m_vecItems[i];
 					if (!pItem->m_bIsFolder)
 					{
-						CStdString strFileName;
-						strFileName = pItem->GetLabel();
-
-						pOriginalSpin->AddLabel(strFileName.c_str(), i);
-						pOriginalSpin->SetNavigation(2,2,1,1);
+						pItem->SetPath("D:\\testvideos\\" + pItem->GetLabel());
+						pList->AddItem(pItem);
 					}
 				}
-				items.Clear();
 			}
 			break;
 		}
 		case GUI_MSG_WINDOW_DEINIT:
 		{
-			CGUISpinControlEx *pOriginalSpin;
-			pOriginalSpin = (CGUISpinControlEx*)GetControl(1);
+			CGUIListContainer* pList = (CGUIListContainer*)GetControl(CONTROL_LIST);
 			
-			if(pOriginalSpin)
-				pOriginalSpin->Clear();
+			if(pList)
+				pList->Clear();
+
+			// None of the items are visible anymore
+			g_mediaProbe.CancelAll();
+			g_videoThumbLoader.CancelAll();
 
+			m_vecItems.Clear();
+			m_iShownFirst = 0;
+			m_iShownLast = -1;
 			break;
 		}
 
-		case GUI_MSG_CLICKED:
+		case GUI_MSG_ITEMS_SHOWN:
 		{
-			if(message.GetControlId() == 2)
+			if(message.GetControlId() == CONTROL_LIST)
 			{
-				// Play button clicked!
-				CGUISpinControlEx *pOriginalSpin;
-				pOriginalSpin = (CGUISpinControlEx*)GetControl(1);
+				CGUIListContainer* pList = (CGUIListContainer*)GetControl(CONTROL_LIST);
 
-				if(pOriginalSpin)
-				{
-					CStdString strFileName = pOriginalSpin->GetLabel();
-					CStdString strPath = "D:\\testvideos\\";
+				if(pList)
+					OnItemsShown(pList, message.GetParam1(), message.GetParam2());
+				return true;
+			}
+			break;
+		}
+
+		case GUI_MSG_THUMB_LOADED:
+		{
+			CGUIListContainer* pList = (CGUIListContainer*)GetControl(CONTROL_LIST);
+
+			if(pList)
+				OnThumbLoaded(pList, message.GetStringParam(), message.GetLabel());
+			break;
+		}
 
-					strPath += strFileName;
+		case GUI_MSG_CLICKED:
+		{
+			if(message.GetControlId() == CONTROL_BTNPLAY || message.GetControlId() == CONTROL_LIST)
+			{
+				// Play button clicked or an item selected!
+				CGUIListContainer* pList = (CGUIListContainer*)GetControl(CONTROL_LIST);
+				CFileItem* pItem = pList ? (CFileItem*)pList->GetSelectedListItem() : NULL;
 
+				if(pItem)
+				{
 					if(!g_application.IsPlaying())
-						g_application.PlayFile(strPath);
+						g_application.PlayFile(pItem->GetPath());
 				}
 			}
 			break;
@@ -104,4 +133,73 @@ bool CGUIWindowVideoFiles::OnMessage(CGUIMessage& message)
 	}
 
 	return CGUIWindow::OnMessage(message);
-}
\ No newline at end of file
+}
+
+void CGUIWindowVideoFiles::OnItemsShown(CGUIListContainer* pList, int iFirst, int iLast)
+{
+	// Withdraw the requests of items that lost their views
+	for (int i = m_iShownFirst; i <= m_iShownLast; ++i)
+	{
+		if (i >= iFirst && i <= iLast)
+			continue;
+
+		const CFileItem* pItem = (const CFileItem*)pList->GetListItem(i);
+		g_mediaProbe.Cancel(pItem->GetPath());
+		g_videoThumbLoader.Cancel(pItem->GetPath());
+	}
+
+	// Queue media info in reverse so the first item in the list is probed first
+	for (int i = iLast; i >= iFirst; --i)
+	{
+		if (i >= m_iShownFirst && i <= m_iShownLast)
+			continue;
+
+		g_mediaProbe.Probe(((const CFileItem*)pList->GetListItem(i))->GetPath());
+	}
+
+	// Newest requests go first, so again in reverse. Prefetched items that
+	// scrolled on screen are asked for again to move them up
+	for (int i = iLast; i >= iFirst; --i)
+	{
+		if (i >= m_iShownFirst && i <= m_iShownLast && !pList->IsItemOnScreen(i))
+			continue;
+
+		UpdateThumb(pList, i);
+	}
+
+	m_iShownFirst = iFirst;
+	m_iShownLast = iLast;
+}
+
+void CGUIWindowVideoFiles::UpdateThumb(CGUIListContainer* pList, int iItem)
+{
+	CFileItem* pItem = (CFileItem*)pList->GetListItem(iItem);
+	if (pItem->HasThumbnail())
+		return;
+
+	// Items in the prefetched rows wait behind the ones on screen
+	CStdString strThumb = g_videoThumbLoader.Request(pItem->GetPath(), pList->IsItemOnScreen(iItem) ? THUMB_PRIORITY_VISIBLE : THUMB_PRIORITY_BACKGROUND);
+	if (!strThumb.IsEmpty())
+	{
+		pItem->SetThumbnailImage(strThumb);
+		pList->ItemChanged(iItem);
+	}
+}
+
+void CGUIWindowVideoFiles::OnThumbLoaded(CGUIListContainer* pList, const CStdString& strPath, const CStdString& strThumb)
+{
+	// Items without a view pick their thumb up from the cache once they're shown
+	for (int i = m_iShownFirst; i <= m_iShownLast && i < pList->GetNumItems(); ++i)
+	{
+		CFileItem* pItem = (CFileItem*)pList->GetListItem(i);
+		if (pItem->GetPath() != strPath)
+			continue;
+
+		if (!pItem->HasThumbnail())
+		{
+			pItem->SetThumbnailImage(strThumb);
+			pList->ItemChanged(i);
+		}
+		break;
+	}
+}
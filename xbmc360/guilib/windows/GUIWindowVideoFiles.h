@@ -2,6 +2,9 @@
 #define GUILIB_GUIWINDOWVIDEOFILES_H
 
 #include "..\GUIWindow.h"
+#include "..\..\FileItem.h"
+
+class CGUIListContainer;
 
 class CGUIWindowVideoFiles : public CGUIWindow
 {
@@ -10,6 +13,16 @@ public:
 	virtual ~CGUIWindowVideoFiles(void);
 
 	virtual bool OnMessage(CGUIMessage& message);
+
+protected:
+	// Thumbs and media info are only asked for the items the list has views for
+	void OnItemsShown(CGUIListContainer* pList, int iFirst, int iLast);
+	void UpdateThumb(CGUIListContainer* pList, int iItem);
+	void OnThumbLoaded(CGUIListContainer* pList, const CStdString& strPath, const CStdString& strThumb);
+
+	CFileItemList m_vecItems;
+	int m_iShownFirst;
+	int m_iShownLast;
 };
 
 #endif //GUILIB_GUIWINDOWVIDEOFILES_H
@@ -0,0 +1,55 @@
+#ifndef H_CFNV
+#define H_CFNV
+
+// Kept free of Xbox headers, tools/InfoBench builds it on Linux
+
+#include <ctype.h>
+
+#define FNV_OFFSET_BASIS 2166136261U
+#define FNV_PRIME        16777619U
+
+/*!
+ \brief 32 bit FNV-1a hashes of strings and bytes.
+
+ Each function takes the hash to continue from, so a hash over several
+ values is built by passing the result of one call to the next. Start
+ with FNV_OFFSET_BASIS. The values are stored by the thumbnail and shader
+ caches, they must not change.
+ */
+class CFnv
+{
+public:
+	static unsigned int Hash(const void* pData, unsigned int iSize, unsigned int iHash = FNV_OFFSET_BASIS)
+	{
+		const unsigned char* p = (const unsigned char*)pData;
+		for (unsigned int i = 0; i < iSize; i++)
+			iHash = (iHash ^ p[i]) * FNV_PRIME;
+		return iHash;
+	}
+
+	// Zero terminated
+	static unsigned int HashString(const char* strText, unsigned int iHash = FNV_OFFSET_BASIS)
+	{
+		for (const char* p = strText; *p; p++)
+			iHash = (iHash ^ (unsigned char)*p) * FNV_PRIME;
+		return iHash;
+	}
+
+	// Same hash for strings that only differ in the case of ASCII letters
+	static unsigned int HashLower(const char* strText, unsigned int iSize, unsigned int iHash = FNV_OFFSET_BASIS)
+	{
+		for (unsigned int i = 0; i < iSize; i++)
+			iHash = (iHash ^ (unsigned char)tolower((unsigned char)strText[i])) * FNV_PRIME;
+		return iHash;
+	}
+
+	// The four bytes of iValue, lowest first, the same on either byte order
+	static unsigned int HashValue(unsigned int iValue, unsigned int iHash = FNV_OFFSET_BASIS)
+	{
+		for (int iByte = 0; iByte < 4; iByte++)
+			iHash = (iHash ^ ((iValue >> (iByte * 8)) & 0xff)) * FNV_PRIME;
+		return iHash;
+	}
+};
+
+#endif //H_CFNV
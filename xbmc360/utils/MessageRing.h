@@ -0,0 +1,148 @@
+#ifndef H_CMESSAGERING
+#define H_CMESSAGERING
+
+#include "Stdafx.h"
+
+#include <vector>
+
+struct MessageRingStats
+{
+	unsigned int iPushed;
+	unsigned int iDropped;        // ring was full
+	unsigned int iMaxDepth;       // most messages waiting at once
+	float fLatency;               // average ms from Push() to Pop()
+	float fMaxLatency;
+};
+
+/*!
+ \brief Bounded queue of messages from any thread to one consumer thread.
+
+ The slots are allocated up front and Push() takes two interlocked
+ operations to claim one, it never waits on the consumer or on other
+ senders. Copying the message in and out is a plain assignment of T
+ though: a T holding strings or vectors, like CGUIMessage and
+ ThreadMessage, still allocates (and takes the heap lock) whenever one of
+ those members isn't empty. When the ring is full the message is dropped
+ and Push() returns false.
+
+ Only one thread may Pop(), it gets the messages in the order their
+ Push() started. A message still being copied in holds back the ones
+ after it until the next Pop().
+ */
+template<class T>
+class CMessageRing
+{
+public:
+	// iSize must be a power of two, empty is what unused slots hold
+	CMessageRing(unsigned int iSize, const T& empty)
+		: m_slots(iSize, Slot(empty))
+	{
+		ASSERT((iSize & (iSize - 1)) == 0);
+		m_lMask = iSize - 1;
+		m_lCount = 0;
+		m_lTail = 0;
+		m_lHead = 0;
+
+		LARGE_INTEGER frequency;
+		QueryPerformanceFrequency(&frequency);
+		m_iFrequency = frequency.QuadPart;
+
+		ResetStats();
+	}
+
+	bool Push(const T& item)
+	{
+		// Reserve room first, a ticket taken below is then sure to find its slot free
+		LONG lCount = InterlockedIncrement(&m_lCount);
+		if (lCount > m_lMask + 1)
+		{
+			InterlockedDecrement(&m_lCount);
+			InterlockedIncrement(&m_lDropped);
+			return false;
+		}
+		if (lCount > m_lMaxDepth)
+			m_lMaxDepth = lCount;
+
+		LONG lTicket = InterlockedIncrement(&m_lTail) - 1;
+		Slot& slot = m_slots[lTicket & m_lMask];
+		slot.item = item;
+		QueryPerformanceCounter(&slot.queued);
+
+		// Publish only once the message is completely written
+		MemoryBarrier();
+		slot.lReady = lTicket + 1;
+		InterlockedIncrement(&m_lPushed);
+		return true;
+	}
+
+	// Consumer thread only
+	bool Pop(T& item)
+	{
+		Slot& slot = m_slots[m_lHead & m_lMask];
+		if (slot.lReady != m_lHead + 1)
+			return false;
+		MemoryBarrier();
+
+		item = slot.item;
+
+		LARGE_INTEGER now;
+		QueryPerformanceCounter(&now);
+		__int64 iLatency = now.QuadPart - slot.queued.QuadPart;
+		m_iLatency += iLatency;
+		if (iLatency > m_iMaxLatency)
+			m_iMaxLatency = iLatency;
+		m_iPopped++;
+
+		m_lHead++;
+		MemoryBarrier();
+		InterlockedDecrement(&m_lCount);
+		return true;
+	}
+
+	unsigned int GetDepth() const { return m_lCount > 0 ? m_lCount : 0; }
+
+	void GetStats(MessageRingStats& stats) const
+	{
+		stats.iPushed = m_lPushed;
+		stats.iDropped = m_lDropped;
+		stats.iMaxDepth = m_lMaxDepth;
+		stats.fLatency = m_iPopped ? (float)(1000.0 * m_iLatency / m_iFrequency / m_iPopped) : 0.0f;
+		stats.fMaxLatency = (float)(1000.0 * m_iMaxLatency / m_iFrequency);
+	}
+
+	void ResetStats()
+	{
+		m_lPushed = 0;
+		m_lDropped = 0;
+		m_lMaxDepth = 0;
+		m_iPopped = 0;
+		m_iLatency = 0;
+		m_iMaxLatency = 0;
+	}
+
+private:
+	struct Slot
+	{
+		Slot(const T& empty) : item(empty) { lReady = 0; queued.QuadPart = 0; }
+		T item;
+		LARGE_INTEGER queued;
+		volatile LONG lReady;     // ticket + 1 once the message is written
+	};
+
+	std::vector<Slot> m_slots;
+	LONG m_lMask;
+
+	volatile LONG m_lCount;       // messages pushed or being pushed, not popped yet
+	volatile LONG m_lTail;        // next ticket
+	LONG m_lHead;                 // next ticket to pop
+
+	__int64 m_iFrequency;
+	volatile LONG m_lPushed;
+	volatile LONG m_lDropped;
+	volatile LONG m_lMaxDepth;
+	unsigned int m_iPopped;
+	__int64 m_iLatency;
+	__int64 m_iMaxLatency;
+};
+
+#endif //H_CMESSAGERING